@@ -0,0 +1,518 @@
+/*
+File:         bench_micro.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Microbenchmarks of the CSV reading and record parsing kernels
+              over generated in-memory corpora. Built and run with
+              make bench-micro. Results are saved as CSV and compared with a
+              baseline file, if one exists.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <csv_helper.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+#include <record_schema.h>
+
+#define BENCH_WARMUP 2
+#define BENCH_REPS 10
+#define BENCH_REPS_MAX 1000
+#define BENCH_CORPUS_BYTES (8 * 1024 * 1024)
+#define BENCH_LINE_MAX 1024
+#define BENCH_LONG_NAME_LEN 300
+#define BENCH_MANY_FIELDS 60
+#define BENCH_RESULTS_MAX 64
+#define BENCH_NAME_LEN 32
+#define NS_PER_S 1000000000.0
+
+enum corpus_kinds {CORPUS_PRODUCTS, CORPUS_QUOTES, CORPUS_FIELDS};
+
+/*
+    Generated CSV text. work is a copy of text with every newline replaced by
+    '\0', remade before every pass of a kernel, that changes lines in place.
+*/
+struct corpus
+{
+    const char *name;
+    enum corpus_kinds kind;
+    char *text;
+    size_t len;
+    char *work;
+    size_t *starts;         // Offset of every row
+    int rows;
+    int fields;             // Fields of the widest row
+};
+
+
+/*
+    One benchmarked function. A kernel with kind -1 is run on every corpus.
+*/
+struct kernel
+{
+    const char *name;
+    int kind;
+    int in_place;
+    size_t (*run)(struct corpus *c);
+};
+
+
+struct bench_result
+{
+    char kernel[BENCH_NAME_LEN];
+    char corpus[BENCH_NAME_LEN];
+    int rows;
+    size_t bytes;
+    double ns_per_row;
+    double gb_per_s;
+};
+
+// Records parsed by the parsing kernels, freed between passes
+static struct product_info *products;
+static struct quote_info *quotes;
+static int parsed_cnt;
+
+// Fixed seed, so every run uses the same corpora
+static unsigned int rand_state = 12345;
+
+static unsigned int next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 8;
+}
+
+
+/*
+    Writes one row of a corpus into line. Returns the row length.
+*/
+static int make_row(const char *name, int i, char *line)
+{
+    unsigned int r = next_rand();
+    if (strcmp(name, "products_short") == 0)
+    {
+        return snprintf(line, BENCH_LINE_MAX, "C%07d; Phone %u; %u; %u.%u; "
+                        "OS %u\n", i, r % 1000, 1000 * (1 + r % 16),
+                        5 + r % 3, r % 10, r % 20);
+    }
+    if (strcmp(name, "products_long") == 0)
+    {
+        char long_name[BENCH_LONG_NAME_LEN + 1];
+        for (int k = 0; k < BENCH_LONG_NAME_LEN; k++)
+        {
+            long_name[k] = (char)('a' + (r + (unsigned int)k * 7) % 26);
+        }
+        long_name[BENCH_LONG_NAME_LEN] = '\0';
+        return snprintf(line, BENCH_LINE_MAX, "C%07d; %s; %u; 6.1; "
+                        "Long OS name %u with build %u\n", i, long_name,
+                        1000 * (1 + r % 16), r % 20, r);
+    }
+    if (strcmp(name, "products_quoted") == 0)
+    {
+        return snprintf(line, BENCH_LINE_MAX, "C%07d; \"Phone; \"\"%u\"\"\"; "
+                        "%u; 6.1; \"OS; %u\"\n", i, r % 1000,
+                        1000 * (1 + r % 16), r % 20);
+    }
+    if (strcmp(name, "quotes") == 0)
+    {
+        return snprintf(line, BENCH_LINE_MAX, "Q%08d; C%07u; Retailer %u; "
+                        "%u; %u\n", i, r % 100000, r % 50, 1000 + r % 200000,
+                        r % 100);
+    }
+    if (strcmp(name, "quotes_malformed") == 0)
+    {
+        // Every other row has a price or stock, that is not a valid number
+        const char *bad[] = {"12x4", "-500", "", "1e9x"};
+        if (i % 2 == 0)
+        {
+            return snprintf(line, BENCH_LINE_MAX, "Q%08d; C%07u; Retailer %u; "
+                            "%s; %u\n", i, r % 100000, r % 50, bad[r % 4],
+                            r % 100);
+        }
+        return snprintf(line, BENCH_LINE_MAX, "Q%08d; C%07u; Retailer %u; "
+                        "%u; %s\n", i, r % 100000, r % 50, 1000 + r % 200000,
+                        bad[r % 4]);
+    }
+    
+    // Many fields
+    int len = 0;
+    for (int k = 0; k < BENCH_MANY_FIELDS; k++)
+    {
+        len += snprintf(line + len, (size_t)(BENCH_LINE_MAX - len), "%s%u",
+                        k ? "; " : "", (r + (unsigned int)k) % 10000);
+    }
+    *(line + len) = '\n';
+    *(line + len + 1) = '\0';
+    return len + 1;
+}
+
+
+/*
+    Fills a corpus with rows, until it has BENCH_CORPUS_BYTES of text.
+*/
+static int make_corpus(struct corpus *c)
+{
+    char line[BENCH_LINE_MAX];
+    size_t row_limit = 1024;
+    c->text = malloc(BENCH_CORPUS_BYTES + BENCH_LINE_MAX);
+    c->work = malloc(BENCH_CORPUS_BYTES + BENCH_LINE_MAX);
+    c->starts = malloc(sizeof(size_t) * row_limit);
+    if (c->text == NULL || c->work == NULL || c->starts == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    c->len = 0;
+    c->rows = 0;
+    while (c->len < BENCH_CORPUS_BYTES)
+    {
+        if ((size_t)c->rows == row_limit)
+        {
+            row_limit *= 2;
+            size_t *temp = realloc(c->starts, sizeof(size_t) * row_limit);
+            if (temp == NULL)
+            {
+                return EXIT_FAILURE;
+            }
+            c->starts = temp;
+        }
+        int len = make_row(c->name, c->rows, line);
+        memcpy(c->text + c->len, line, (size_t)len);
+        *(c->starts + c->rows) = c->len;
+        c->len += (size_t)len;
+        c->rows++;
+    }
+    c->fields = c->kind == CORPUS_FIELDS ? BENCH_MANY_FIELDS
+              : c->kind == CORPUS_PRODUCTS ? PRO_COL_CNT : QTE_COL_CNT;
+    return EXIT_SUCCESS;
+}
+
+
+static void reset_work(struct corpus *c)
+{
+    memcpy(c->work, c->text, c->len);
+    for (int i = 0; i < c->rows; i++)
+    {
+        size_t end = i + 1 < c->rows ? *(c->starts + i + 1) : c->len;
+        *(c->work + end - 1) = '\0';
+    }
+}
+
+
+static size_t run_read_line(struct corpus *c)
+{
+    FILE *fp = fmemopen(c->text, c->len, "r");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    char *line;
+    size_t sum = 0;
+    int len;
+    while ((len = read_line(fp, &line)) > 0)
+    {
+        sum += (size_t)len;
+    }
+    fclose(fp);
+    return sum;
+}
+
+
+static size_t run_get_field(struct corpus *c)
+{
+    size_t sum = 0;
+    for (int i = 0; i < c->rows; i++)
+    {
+        char *field = get_field(c->work + *(c->starts + i), c->fields);
+        sum += field != NULL ? (size_t)*field : 0;
+    }
+    return sum;
+}
+
+
+static size_t run_split_fields(struct corpus *c)
+{
+    char *fields[CSV_FIELDS_MAX];
+    size_t sum = 0;
+    for (int i = 0; i < c->rows; i++)
+    {
+        sum += (size_t)split_fields(c->work + *(c->starts + i), fields,
+                                    CSV_FIELDS_MAX);
+    }
+    return sum;
+}
+
+
+static size_t run_get_product_info(struct corpus *c)
+{
+    size_t sum = 0;
+    for (int i = 0; i < c->rows; i++)
+    {
+        sum += (size_t)get_product_info(products + i,
+                                        c->work + *(c->starts + i));
+    }
+    parsed_cnt = c->rows;
+    return sum;
+}
+
+
+static size_t run_get_quote_info(struct corpus *c)
+{
+    size_t sum = 0;
+    for (int i = 0; i < c->rows; i++)
+    {
+        sum += (size_t)get_quote_info(quotes + i, c->work + *(c->starts + i));
+    }
+    parsed_cnt = c->rows;
+    return sum;
+}
+
+
+/*
+    Frees the strings of records parsed in the last pass.
+*/
+static void free_parsed(struct corpus *c)
+{
+    for (int i = 0; i < parsed_cnt; i++)
+    {
+        if (c->kind == CORPUS_PRODUCTS)
+        {
+            acct_free((products + i)->p_code);
+            acct_free((products + i)->p_name);
+            acct_free((products + i)->p_os);
+        }
+        else
+        {
+            acct_free((quotes + i)->p_id);
+        }
+    }
+    parsed_cnt = 0;
+}
+
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NS_PER_S + (double)ts.tv_nsec;
+}
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+
+/*
+    Runs a kernel BENCH_WARMUP times untimed and reps times timed. The median
+    pass time is used.
+*/
+static void bench_kernel(struct kernel *k, struct corpus *c, int reps,
+                         struct bench_result *res)
+{
+    double times[BENCH_REPS_MAX];
+    volatile size_t sink = 0;
+    for (int r = 0; r < BENCH_WARMUP + reps; r++)
+    {
+        if (k->in_place)
+        {
+            reset_work(c);
+        }
+        double start = now_ns();
+        sink += k->run(c);
+        double end = now_ns();
+        free_parsed(c);
+        if (r >= BENCH_WARMUP)
+        {
+            times[r - BENCH_WARMUP] = end - start;
+        }
+    }
+    (void)sink;
+    
+    qsort(times, (size_t)reps, sizeof(double), compare_doubles);
+    double median = times[reps / 2];
+    snprintf(res->kernel, BENCH_NAME_LEN, "%s", k->name);
+    snprintf(res->corpus, BENCH_NAME_LEN, "%s", c->name);
+    res->rows = c->rows;
+    res->bytes = c->len;
+    res->ns_per_row = median / c->rows;
+    res->gb_per_s = (double)c->len / median;
+}
+
+
+/*
+    Finds the result of the same kernel and corpus in a baseline file. Returns
+    ns/row of the baseline or a negative value, if there is none.
+*/
+static double baseline_ns(FILE *fp, struct bench_result *res)
+{
+    if (fp == NULL)
+    {
+        return -1.0;
+    }
+    rewind(fp);
+    char kernel[BENCH_NAME_LEN];
+    char corpus[BENCH_NAME_LEN];
+    double ns;
+    char line[BENCH_LINE_MAX];
+    while (fgets(line, BENCH_LINE_MAX, fp) != NULL)
+    {
+        if (sscanf(line, "%31[^;];%31[^;];%*d;%*u;%lf", kernel, corpus,
+                   &ns) == 3 &&
+            strcmp(kernel, res->kernel) == 0 &&
+            strcmp(corpus, res->corpus) == 0)
+        {
+            return ns;
+        }
+    }
+    return -1.0;
+}
+
+
+static void print_results(struct bench_result *results, int cnt,
+                          const char *f_base)
+{
+    FILE *fp = f_base != NULL ? fopen(f_base, "r") : NULL;
+    printf("%-18s%-18s%9s%10s%8s%10s%8s\n", "Kernel", "Corpus", "Rows",
+           "ns/row", "GB/s", "Base", "Change");
+    for (int i = 0; i < cnt; i++)
+    {
+        struct bench_result *res = results + i;
+        printf("%-18s%-18s%9d%10.1f%8.3f", res->kernel, res->corpus,
+               res->rows, res->ns_per_row, res->gb_per_s);
+        double base = baseline_ns(fp, res);
+        if (base > 0.0)
+        {
+            printf("%10.1f%+7.1f%%", base,
+                   (res->ns_per_row - base) / base * 100.0);
+        }
+        putchar('\n');
+    }
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+}
+
+
+static int save_results(struct bench_result *results, int cnt,
+                        const char *f_name)
+{
+    FILE *fp = fopen(f_name, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Unable to open file \"%s\" for results.\n", f_name);
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "kernel;corpus;rows;bytes;ns_per_row;gb_per_s\n");
+    for (int i = 0; i < cnt; i++)
+    {
+        struct bench_result *res = results + i;
+        fprintf(fp, "%s;%s;%d;%zu;%.2f;%.4f\n", res->kernel, res->corpus,
+                res->rows, res->bytes, res->ns_per_row, res->gb_per_s);
+    }
+    fclose(fp);
+    return EXIT_SUCCESS;
+}
+
+
+int main(int argc, char **argv)
+{
+    int reps = BENCH_REPS;
+    const char *f_out = NULL;
+    const char *f_base = NULL;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(*(argv + i), "--reps") == 0)
+        {
+            reps = atoi(*(argv + i + 1));
+        }
+        else if (strcmp(*(argv + i), "--out") == 0)
+        {
+            f_out = *(argv + i + 1);
+        }
+        else if (strcmp(*(argv + i), "--baseline") == 0)
+        {
+            f_base = *(argv + i + 1);
+        }
+    }
+    if (reps < 1 || reps > BENCH_REPS_MAX)
+    {
+        fprintf(stderr, "Repetitions must be 1 to %d.\n", BENCH_REPS_MAX);
+        return EXIT_FAILURE;
+    }
+    set_logging_level(OFF);
+    
+    struct corpus corpora[] =
+    {
+        {.name = "products_short", .kind = CORPUS_PRODUCTS},
+        {.name = "products_long", .kind = CORPUS_PRODUCTS},
+        {.name = "products_quoted", .kind = CORPUS_PRODUCTS},
+        {.name = "quotes", .kind = CORPUS_QUOTES},
+        {.name = "quotes_malformed", .kind = CORPUS_QUOTES},
+        {.name = "many_fields", .kind = CORPUS_FIELDS}
+    };
+    struct kernel kernels[] =
+    {
+        {"read_line", -1, 0, run_read_line},
+        {"get_field", -1, 1, run_get_field},
+        {"split_fields", -1, 1, run_split_fields},
+        {"get_product_info", CORPUS_PRODUCTS, 1, run_get_product_info},
+        {"get_quote_info", CORPUS_QUOTES, 1, run_get_quote_info}
+    };
+    int corpus_cnt = (int)(sizeof(corpora) / sizeof(struct corpus));
+    int kernel_cnt = (int)(sizeof(kernels) / sizeof(struct kernel));
+    
+    struct bench_result results[BENCH_RESULTS_MAX];
+    int result_cnt = 0;
+    int return_val = EXIT_SUCCESS;
+    for (int c = 0; c < corpus_cnt && return_val == EXIT_SUCCESS; c++)
+    {
+        struct corpus *cp = corpora + c;
+        products = NULL;
+        quotes = NULL;
+        if (make_corpus(cp) == EXIT_FAILURE ||
+            (products = calloc((size_t)cp->rows,
+                               sizeof(struct product_info))) == NULL ||
+            (quotes = calloc((size_t)cp->rows,
+                             sizeof(struct quote_info))) == NULL)
+        {
+            fprintf(stderr, "Unable to allocate memory for corpus.\n");
+            return_val = EXIT_FAILURE;
+        }
+        for (int k = 0; k < kernel_cnt && return_val == EXIT_SUCCESS; k++)
+        {
+            if (kernels[k].kind == -1 || kernels[k].kind == (int)cp->kind)
+            {
+                bench_kernel(kernels + k, cp, reps, results + result_cnt);
+                result_cnt++;
+            }
+        }
+        free(cp->text);
+        free(cp->work);
+        free(cp->starts);
+        free(products);
+        free(quotes);
+    }
+    free_dictionaries();
+    if (return_val == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    print_results(results, result_cnt, f_base);
+    if (f_out != NULL && save_results(results, result_cnt, f_out) ==
+        EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
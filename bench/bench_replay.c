@@ -0,0 +1,683 @@
+/*
+File:         bench_replay.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Load replay of the interactive menu. A long mixed script of
+              searches, edits, queries, page browsing, reports and displays is
+              generated from the data files, or read from a file, and fed to
+              the program binary as user input. The binary runs on copies of
+              the data files in a temporary directory, so edits saved at exit
+              do not change them. Throughput and latency of every operation
+              are taken from the latency report, that the binary prints at
+              exit. Built and run with make bench-replay. Results are saved as
+              CSV and compared with a baseline file, if one exists.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <log_handler.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+
+#define REPLAY_OPS 5000
+#define REPLAY_OPS_MAX 10000000
+#define REPLAY_SEED 12345u
+#define REPLAY_PAGE_SIZE 20
+#define REPLAY_LINE_MAX 1024
+#define REPLAY_RESULTS_MAX 64
+#define REPLAY_NAME_LEN 32
+#define REPLAY_OP_NAME_WIDTH 16
+#define REPLAY_READ_CHUNK 4096
+#define REPLAY_TMP_DIR "/tmp/price_watch_replay.XXXXXX"
+#define REPLAY_SCRIPT_NAME "script.txt"
+#define REPLAY_REPORT_HEAD "Latency (ms)"
+#define REPLAY_TOTAL_NAME "script total"
+#define REPLAY_NO_VALUE -1.0
+#define REPLAY_MS_PER_S 1000.0
+#define NS_PER_S 1000000000.0
+
+// Menu options used in scripts, numbers of main.h menu_options
+enum replay_ops {REPLAY_SEARCH, REPLAY_EDIT_RAM, REPLAY_EDIT_RTLR,
+                 REPLAY_QUERY, REPLAY_BROWSE, REPLAY_RTLR_REPORT,
+                 REPLAY_DISPLAY, REPLAY_OP_CNT};
+
+/*
+    Share of an operation in generated scripts. Weights add up to 100, the
+    heavy whole catalog operations are rare, like in interactive use.
+*/
+static const int op_weights[REPLAY_OP_CNT] =
+{
+    [REPLAY_SEARCH] = 35,
+    [REPLAY_EDIT_RAM] = 15,
+    [REPLAY_EDIT_RTLR] = 15,
+    [REPLAY_QUERY] = 15,
+    [REPLAY_BROWSE] = 12,
+    [REPLAY_RTLR_REPORT] = 4,
+    [REPLAY_DISPLAY] = 4
+};
+
+static const char *const queries[] =
+{
+    "select retailer, count(*), avg(price) from quotes group by retailer "
+    "order by avg(price) desc",
+    "select name, ram from products where ram >= 4000 order by ram desc "
+    "limit 10",
+    "select * from quotes join products where stock > 0 order by price "
+    "limit 20",
+    "select code, min(price) from quotes where stock > 0 group by code"
+};
+
+// Operations of the latency report, that are not run by the script
+static const char *const setup_ops[] = {"load data", "save products",
+                                        "save quotes"};
+
+struct replay_result
+{
+    char op[REPLAY_NAME_LEN];
+    unsigned long long cnt;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+    double total_ms;
+    double ops_per_s;
+};
+
+static unsigned int rand_state = REPLAY_SEED;
+
+static unsigned int next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 8;
+}
+
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NS_PER_S + (double)ts.tv_nsec;
+}
+
+
+static enum replay_ops pick_op(void)
+{
+    int r = (int)(next_rand() % 100u);
+    int op = 0;
+    while (op < REPLAY_OP_CNT - 1 && r >= *(op_weights + op))
+    {
+        r -= *(op_weights + op);
+        op++;
+    }
+    return (enum replay_ops)op;
+}
+
+
+/*
+    Writes the input of one operation. Every fourth search is for a shortened
+    name, which falls back to the similar name search.
+*/
+static void write_op(FILE *fp, enum replay_ops op,
+                     struct product_data_wrapper pdw,
+                     struct quote_data_wrapper qdw)
+{
+    struct product_info *pi = pdw.data + next_rand() % pdw.lines;
+    struct quote_info *qi = qdw.data + next_rand() % qdw.lines;
+    unsigned int r = next_rand();
+    switch (op)
+    {
+        case REPLAY_SEARCH:
+            if (r % 4 == 0 && strlen(pi->p_name) > 1)
+            {
+                fprintf(fp, "%d\n%.*s\n", MENU_OPT_SRCH_PRO,
+                        (int)strlen(pi->p_name) - 1, pi->p_name);
+            }
+            else
+            {
+                fprintf(fp, "%d\n%s\n", MENU_OPT_SRCH_PRO, pi->p_name);
+            }
+            break;
+            
+        case REPLAY_EDIT_RAM:
+            fprintf(fp, "%d\n%s\n%u\n", MENU_OPT_EDIT_RAM, pi->p_code,
+                    1000 * (1 + r % 16));
+            break;
+            
+        case REPLAY_EDIT_RTLR:
+            // Names of other quotes, so the retailers stay the same set
+            fprintf(fp, "%d\n%s\n%s\n", MENU_OPT_EDIT_RTLR, qi->p_id,
+                    dict_string(DICT_RETAILER,
+                                (qdw.data + r % qdw.lines)->retailer_id));
+            break;
+            
+        case REPLAY_QUERY:
+            fprintf(fp, "%d\n%s\n", MENU_OPT_QUERY, *(queries + r %
+                    (sizeof(queries) / sizeof(*queries))));
+            break;
+            
+        case REPLAY_BROWSE:
+            // Page size, offset, no code bounds, next page and back to menu
+            fprintf(fp, "%d\n%d\n%zu\n\n\n1\n0\n", MENU_OPT_BROWSE,
+                    REPLAY_PAGE_SIZE, (size_t)r % pdw.lines);
+            break;
+            
+        case REPLAY_RTLR_REPORT:
+            fprintf(fp, "%d\n", MENU_OPT_RTLR_REPORT);
+            break;
+            
+        default:
+            fprintf(fp, "%d\n", MENU_OPT_DISP_DATA);
+            break;
+    }
+}
+
+
+/*
+    Generates a script of op_cnt operations from the records of the data
+    files, ending with exiting the program.
+*/
+static int generate_script(const char *f_script, char *f_pro, char *f_qte,
+                           int op_cnt)
+{
+    struct product_data_wrapper pdw = {0};
+    struct quote_data_wrapper qdw = {0};
+    if (read_data_products(f_pro, &pdw) == EXIT_FAILURE ||
+        read_data_quotes(f_qte, &qdw) == EXIT_FAILURE)
+    {
+        free_product_info(&pdw);
+        free_quote_info(&qdw);
+        free_dictionaries();
+        free_file_layouts();
+        return EXIT_FAILURE;
+    }
+    if (pdw.lines == 0 || qdw.lines == 0)
+    {
+        fprintf(stderr, "Data files have no products or no quotes.\n");
+        free_product_info(&pdw);
+        free_quote_info(&qdw);
+        free_dictionaries();
+        free_file_layouts();
+        return EXIT_FAILURE;
+    }
+    
+    FILE *fp = fopen(f_script, "w");
+    int return_val = fp == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
+    if (fp != NULL)
+    {
+        for (int i = 0; i < op_cnt; i++)
+        {
+            write_op(fp, pick_op(), pdw, qdw);
+        }
+        fprintf(fp, "%d\n", MENU_OPT_EXIT);
+        if (fclose(fp) != 0)
+        {
+            return_val = EXIT_FAILURE;
+        }
+    }
+    if (return_val == EXIT_FAILURE)
+    {
+        fprintf(stderr, "Unable to write script \"%s\".\n", f_script);
+    }
+    free_product_info(&pdw);
+    free_quote_info(&qdw);
+    free_dictionaries();
+    free_file_layouts();
+    return return_val;
+}
+
+
+static int copy_file(const char *f_src, const char *f_dest)
+{
+    FILE *src = fopen(f_src, "rb");
+    FILE *dest = src != NULL ? fopen(f_dest, "wb") : NULL;
+    int ok = dest != NULL;
+    char buf[REPLAY_READ_CHUNK];
+    size_t len;
+    while (ok && (len = fread(buf, 1, REPLAY_READ_CHUNK, src)) > 0)
+    {
+        ok = fwrite(buf, 1, len, dest) == len;
+    }
+    ok = ok && !ferror(src);
+    if (dest != NULL && fclose(dest) != 0)
+    {
+        ok = 0;
+    }
+    if (src != NULL)
+    {
+        fclose(src);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Unable to copy \"%s\" to \"%s\".\n", f_src, f_dest);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+    Copies a data file into the work directory with the same base name, so
+    compressed files keep their extension. Returns the name of the copy.
+*/
+static int copy_data_file(const char *f_src, const char *dir, char *f_dest)
+{
+    const char *base = strrchr(f_src, '/');
+    base = base == NULL ? f_src : base + 1;
+    snprintf(f_dest, PATH_MAX, "%s/%s", dir, base);
+    return copy_file(f_src, f_dest);
+}
+
+
+static void remove_work_dir(const char *dir)
+{
+    DIR *dp = opendir(dir);
+    if (dp != NULL)
+    {
+        char path[PATH_MAX];
+        struct dirent *de;
+        while ((de = readdir(dp)) != NULL)
+        {
+            if (strcmp(de->d_name, ".") != 0 && strcmp(de->d_name, "..") != 0)
+            {
+                snprintf(path, PATH_MAX, "%s/%s", dir, de->d_name);
+                unlink(path);
+            }
+        }
+        closedir(dp);
+    }
+    rmdir(dir);
+}
+
+
+/*
+    Runs the binary in the work directory with the script as standard input
+    and standard output discarded. Standard error is stored into a
+    dynamically allocated string.
+*/
+static int run_binary(const char *bin, const char *dir, const char *f_pro,
+                      const char *f_qte, const char *f_script, char **err_out,
+                      double *wall_s)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        fprintf(stderr, "Unable to create pipe.\n");
+        return EXIT_FAILURE;
+    }
+    double start = now_ns();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        fprintf(stderr, "Unable to start \"%s\".\n", bin);
+        close(*fds);
+        close(*(fds + 1));
+        return EXIT_FAILURE;
+    }
+    if (pid == 0)
+    {
+        int in = open(f_script, O_RDONLY);
+        int out = open("/dev/null", O_WRONLY);
+        if (in < 0 || out < 0 || chdir(dir) != 0 ||
+            dup2(in, STDIN_FILENO) < 0 || dup2(out, STDOUT_FILENO) < 0 ||
+            dup2(*(fds + 1), STDERR_FILENO) < 0)
+        {
+            _exit(EXIT_FAILURE);
+        }
+        close(*fds);
+        execl(bin, bin, "--file_products", f_pro, "--file_quotes", f_qte,
+              (char *)NULL);
+        _exit(EXIT_FAILURE);
+    }
+    
+    close(*(fds + 1));
+    size_t len = 0;
+    size_t alloc = REPLAY_READ_CHUNK;
+    char *buf = malloc(alloc);
+    ssize_t got = 1;
+    while (buf != NULL && got > 0)
+    {
+        if (alloc - len < REPLAY_READ_CHUNK)
+        {
+            char *tmp = realloc(buf, alloc * 2);
+            if (tmp == NULL)
+            {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = tmp;
+            alloc *= 2;
+        }
+        got = read(*fds, buf + len, alloc - len - 1);
+        len += got > 0 ? (size_t)got : 0;
+    }
+    close(*fds);
+    int status;
+    waitpid(pid, &status, 0);
+    *wall_s = (now_ns() - start) / NS_PER_S;
+    if (buf == NULL)
+    {
+        fprintf(stderr, "Unable to allocate memory for output of \"%s\".\n",
+                bin);
+        return EXIT_FAILURE;
+    }
+    *(buf + len) = '\0';
+    
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "\"%s\" failed while replaying the script:\n%s", bin,
+                buf);
+        free(buf);
+        return EXIT_FAILURE;
+    }
+    *err_out = buf;
+    return EXIT_SUCCESS;
+}
+
+
+static int is_setup_op(const char *op)
+{
+    for (size_t i = 0; i < sizeof(setup_ops) / sizeof(*setup_ops); i++)
+    {
+        if (strcmp(op, *(setup_ops + i)) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Reads the rows of the latency report into results. A row has the
+    operation name padded to REPLAY_OP_NAME_WIDTH and six numbers. The total
+    of the operations run by the script is added as the last result, its
+    percentiles are REPLAY_NO_VALUE, since histograms are not in the report.
+    Returns the number of results, -1 if there is no report.
+*/
+static int parse_report(char *err_out, struct replay_result *results)
+{
+    char *line = strstr(err_out, REPLAY_REPORT_HEAD);
+    if (line == NULL)
+    {
+        return -1;
+    }
+    struct replay_result total = {.op = REPLAY_TOTAL_NAME,
+                                  .p50_ms = REPLAY_NO_VALUE,
+                                  .p90_ms = REPLAY_NO_VALUE,
+                                  .p99_ms = REPLAY_NO_VALUE};
+    int cnt = 0;
+    while ((line = strchr(line, '\n')) != NULL && cnt < REPLAY_RESULTS_MAX - 1)
+    {
+        line++;
+        struct replay_result *res = results + cnt;
+        if (strlen(line) <= REPLAY_OP_NAME_WIDTH ||
+            sscanf(line + REPLAY_OP_NAME_WIDTH, "%llu%lf%lf%lf%lf%lf",
+                   &res->cnt, &res->p50_ms, &res->p90_ms, &res->p99_ms,
+                   &res->max_ms, &res->total_ms) != 6)
+        {
+            break;
+        }
+        int name_len = REPLAY_OP_NAME_WIDTH;
+        while (name_len > 0 && *(line + name_len - 1) == ' ')
+        {
+            name_len--;
+        }
+        snprintf(res->op, REPLAY_NAME_LEN, "%.*s", name_len, line);
+        res->ops_per_s = res->total_ms > 0.0 ? (double)res->cnt /
+                         res->total_ms * REPLAY_MS_PER_S : 0.0;
+        if (!is_setup_op(res->op))
+        {
+            total.cnt += res->cnt;
+            total.total_ms += res->total_ms;
+            total.max_ms = res->max_ms > total.max_ms ? res->max_ms
+                                                      : total.max_ms;
+        }
+        cnt++;
+    }
+    total.ops_per_s = total.total_ms > 0.0 ? (double)total.cnt /
+                      total.total_ms * REPLAY_MS_PER_S : 0.0;
+    *(results + cnt) = total;
+    return cnt + 1;
+}
+
+
+/*
+    Finds the result of the same operation in a baseline file. Returns ops/s
+    of the baseline or a negative value, if there is none.
+*/
+static double baseline_ops(FILE *fp, struct replay_result *res)
+{
+    if (fp == NULL)
+    {
+        return -1.0;
+    }
+    rewind(fp);
+    char op[REPLAY_NAME_LEN];
+    double ops;
+    char line[REPLAY_LINE_MAX];
+    while (fgets(line, REPLAY_LINE_MAX, fp) != NULL)
+    {
+        if (sscanf(line, "%31[^;];%*u;%lf", op, &ops) == 2 &&
+            strcmp(op, res->op) == 0)
+        {
+            return ops;
+        }
+    }
+    return -1.0;
+}
+
+
+static void print_ms(double ms)
+{
+    if (ms < 0.0)
+    {
+        printf("%10s", "-");
+    }
+    else
+    {
+        printf("%10.3f", ms);
+    }
+}
+
+
+static void print_results(struct replay_result *results, int cnt,
+                          double wall_s, const char *f_base)
+{
+    FILE *fp = f_base != NULL ? fopen(f_base, "r") : NULL;
+    printf("%-18s%9s%11s%10s%10s%10s%10s%10s%8s\n", "Operation", "Count",
+           "ops/s", "p50 ms", "p99 ms", "Max ms", "Total s", "Base",
+           "Change");
+    for (int i = 0; i < cnt; i++)
+    {
+        struct replay_result *res = results + i;
+        printf("%-18s%9llu%11.1f", res->op, res->cnt, res->ops_per_s);
+        print_ms(res->p50_ms);
+        print_ms(res->p99_ms);
+        printf("%10.3f%10.3f", res->max_ms, res->total_ms / REPLAY_MS_PER_S);
+        double base = baseline_ops(fp, res);
+        if (base > 0.0)
+        {
+            printf("%10.1f%+7.1f%%", base,
+                   (res->ops_per_s - base) / base * 100.0);
+        }
+        putchar('\n');
+    }
+    printf("Wall time %.3f s, including loading, saving and input.\n",
+           wall_s);
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+}
+
+
+static int save_results(struct replay_result *results, int cnt,
+                        const char *f_name)
+{
+    FILE *fp = fopen(f_name, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Unable to open file \"%s\" for results.\n", f_name);
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "op;count;ops_per_s;p50_ms;p90_ms;p99_ms;max_ms;total_ms\n");
+    for (int i = 0; i < cnt; i++)
+    {
+        struct replay_result *res = results + i;
+        fprintf(fp, "%s;%llu;%.1f;%.3f;%.3f;%.3f;%.3f;%.3f\n", res->op,
+                res->cnt, res->ops_per_s, res->p50_ms, res->p90_ms,
+                res->p99_ms, res->max_ms, res->total_ms);
+    }
+    fclose(fp);
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Generates or takes the script, copies the data files and runs the binary.
+    The temporary work directory is removed afterwards.
+*/
+static int replay(const char *bin, char *f_pro, char *f_qte,
+                  const char *f_script, const char *f_save, int op_cnt,
+                  char **err_out, double *wall_s)
+{
+    char dir[] = REPLAY_TMP_DIR;
+    char bin_path[PATH_MAX];
+    char script_path[PATH_MAX];
+    char pro_copy[PATH_MAX];
+    char qte_copy[PATH_MAX];
+    if (mkdtemp(dir) == NULL)
+    {
+        fprintf(stderr, "Unable to create work directory.\n");
+        return EXIT_FAILURE;
+    }
+    
+    // The binary runs in the work directory, so paths must be absolute
+    int return_val = EXIT_SUCCESS;
+    if (realpath(bin, bin_path) == NULL)
+    {
+        fprintf(stderr, "Binary \"%s\" not found.\n", bin);
+        return_val = EXIT_FAILURE;
+    }
+    else if (f_script == NULL)
+    {
+        if (f_save == NULL)
+        {
+            snprintf(script_path, PATH_MAX, "%s/%s", dir, REPLAY_SCRIPT_NAME);
+            f_save = script_path;
+        }
+        return_val = generate_script(f_save, f_pro, f_qte, op_cnt);
+        f_script = f_save;
+    }
+    if (return_val == EXIT_SUCCESS && realpath(f_script, script_path) == NULL)
+    {
+        fprintf(stderr, "Script \"%s\" not found.\n", f_script);
+        return_val = EXIT_FAILURE;
+    }
+    
+    if (return_val == EXIT_SUCCESS &&
+        copy_data_file(f_pro, dir, pro_copy) == EXIT_SUCCESS &&
+        copy_data_file(f_qte, dir, qte_copy) == EXIT_SUCCESS)
+    {
+        return_val = run_binary(bin_path, dir, pro_copy, qte_copy,
+                                script_path, err_out, wall_s);
+    }
+    else
+    {
+        return_val = EXIT_FAILURE;
+    }
+    remove_work_dir(dir);
+    return return_val;
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *bin = "./price_watch.out";
+    char *f_pro = "data/products.csv";
+    char *f_qte = "data/quotes.csv";
+    const char *f_script = NULL;
+    const char *f_save = NULL;
+    const char *f_out = NULL;
+    const char *f_base = NULL;
+    int op_cnt = REPLAY_OPS;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        char *val = *(argv + i + 1);
+        if (strcmp(*(argv + i), "--bin") == 0)
+        {
+            bin = val;
+        }
+        else if (strcmp(*(argv + i), "--file_products") == 0)
+        {
+            f_pro = val;
+        }
+        else if (strcmp(*(argv + i), "--file_quotes") == 0)
+        {
+            f_qte = val;
+        }
+        else if (strcmp(*(argv + i), "--ops") == 0)
+        {
+            op_cnt = atoi(val);
+        }
+        else if (strcmp(*(argv + i), "--seed") == 0)
+        {
+            rand_state = (unsigned int)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(*(argv + i), "--script") == 0)
+        {
+            f_script = val;
+        }
+        else if (strcmp(*(argv + i), "--save_script") == 0)
+        {
+            f_save = val;
+        }
+        else if (strcmp(*(argv + i), "--out") == 0)
+        {
+            f_out = val;
+        }
+        else if (strcmp(*(argv + i), "--baseline") == 0)
+        {
+            f_base = val;
+        }
+    }
+    if (op_cnt < 1 || op_cnt > REPLAY_OPS_MAX)
+    {
+        fprintf(stderr, "Operations must be 1 to %d.\n", REPLAY_OPS_MAX);
+        return EXIT_FAILURE;
+    }
+    set_logging_level(OFF);
+    
+    char *err_out;
+    double wall_s;
+    if (replay(bin, f_pro, f_qte, f_script, f_save, op_cnt, &err_out,
+               &wall_s) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    struct replay_result results[REPLAY_RESULTS_MAX];
+    int result_cnt = parse_report(err_out, results);
+    free(err_out);
+    if (result_cnt < 0)
+    {
+        fprintf(stderr, "No latency report in the output of \"%s\".\n", bin);
+        return EXIT_FAILURE;
+    }
+    
+    print_results(results, result_cnt, wall_s, f_base);
+    if (f_out != NULL && save_results(results, result_cnt, f_out) ==
+        EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
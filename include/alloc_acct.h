@@ -0,0 +1,171 @@
+/*
+File:         alloc_acct.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for alloc_acct.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _ALLOC_ACCT_H
+#define _ALLOC_ACCT_H
+
+#include <stdlib.h>
+#include <stddef.h>
+
+/*
+    Subsystems, that allocations are accounted to. Without ALLOC_ACCOUNTING
+    the class is ignored and the allocation functions are plain malloc, calloc,
+    realloc and free.
+*/
+enum alloc_classes
+{
+    ALLOC_LINE_BUF,
+    ALLOC_PRODUCT_STR,
+    ALLOC_QUOTE_STR,
+    ALLOC_PRODUCT_ARR,
+    ALLOC_QUOTE_ARR,
+    ALLOC_DICT,
+    ALLOC_INDEX,
+    ALLOC_HISTORY,
+    ALLOC_OTHER,
+    ALLOC_CLASS_CNT
+};
+
+/*
+Description:    Calculates the next length of an array, that is lengthened
+                according to 2*n principle. Checks that the size of the array
+                in bytes does not overflow.
+                
+Parameters:     limit - Current length of the array, 0 if not allocated.
+                min_limit - Length of a new array.
+                elem_size - Size of one element in bytes.
+                
+Return:         New length. 0 if the size would overflow size_t.
+*/
+size_t acct_grow_limit(size_t limit, size_t min_limit, size_t elem_size);
+
+
+/*
+Description:    Returns the memory in use. With ALLOC_ACCOUNTING it is the sum
+                of live bytes of all classes, otherwise malloc's count of
+                bytes in use.
+                
+Parameters:     -
+                
+Return:         Bytes in use.
+*/
+size_t acct_live_bytes(void);
+
+#ifdef ALLOC_ACCOUNTING
+
+/*
+Description:    Allocates size bytes accounted to class cls. Memory must be
+                freed with acct_free.
+                
+Parameters:     cls - Allocation class.
+                size - Number of bytes.
+                
+Return:         Pointer to memory. NULL on error.
+*/
+void *acct_malloc(enum alloc_classes cls, size_t size);
+
+
+/*
+Description:    Allocates zeroed memory for cnt elements of size bytes.
+                
+Parameters:     cls - Allocation class.
+                cnt - Number of elements.
+                size - Size of one element.
+                
+Return:         Pointer to memory. NULL on error.
+*/
+void *acct_calloc(enum alloc_classes cls, size_t cnt, size_t size);
+
+
+/*
+Description:    Resizes memory allocated with acct_malloc, acct_calloc or
+                acct_realloc. Unused capacity of the old memory is cleared.
+                
+Parameters:     cls - Allocation class, also for memory moved from another
+                      class.
+                *ptr - Pointer to memory or NULL.
+                size - New size in bytes.
+                
+Return:         Pointer to memory. NULL on error, then ptr is not freed.
+*/
+void *acct_realloc(enum alloc_classes cls, void *ptr, size_t size);
+
+
+/*
+Description:    Frees memory allocated by the accounting functions.
+                
+Parameters:     *ptr - Pointer to memory or NULL.
+                
+Return:         -
+*/
+void acct_free(void *ptr);
+
+
+/*
+Description:    Records how many bytes at the end of an allocation are reserved
+                but not in use, like the free slots of a growing array. They
+                are counted as wasted capacity until changed or the memory is
+                resized or freed.
+                
+Parameters:     *ptr - Pointer to memory.
+                unused - Number of unused bytes.
+                
+Return:         -
+*/
+void acct_set_unused(void *ptr, size_t unused);
+
+
+/*
+Description:    Writes live bytes, peak bytes, allocation counts and wasted
+                capacity of every class into the log.
+                
+Parameters:     *stage - Pointer to string naming the moment of the report.
+                
+Return:         -
+*/
+void acct_log_report(const char *stage);
+
+
+/*
+Description:    Writes the memory used by one product and one quote (strings
+                and array slot) into the log.
+                
+Parameters:     product_cnt - Number of products loaded.
+                quote_cnt - Number of quotes loaded.
+                
+Return:         -
+*/
+void acct_log_per_record(size_t product_cnt, size_t quote_cnt);
+
+
+/*
+Description:    Registers a report, that is printed to stderr and written into
+                the log when the program exits.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void acct_init(void);
+
+#else
+
+#define acct_malloc(cls, size) ((void)(cls), malloc(size))
+#define acct_calloc(cls, cnt, size) ((void)(cls), calloc(cnt, size))
+#define acct_realloc(cls, ptr, size) ((void)(cls), realloc(ptr, size))
+#define acct_free(ptr) free(ptr)
+#define acct_set_unused(ptr, unused) ((void)(ptr), (void)(unused))
+#define acct_log_report(stage) ((void)(stage))
+#define acct_log_per_record(product_cnt, quote_cnt)                           \
+    ((void)(product_cnt), (void)(quote_cnt))
+#define acct_init() ((void)0)
+
+#endif
+
+#endif
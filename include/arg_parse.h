@@ -14,14 +14,22 @@ Description:  Header file for arg_parse.c. Data struct definitions, macros
 #define MSG_MAX_LEN 128
 #define FILE_NAME_MAX_LEN 256
 #define ARG_MAX_NAME_LEN 64
+#define QTE_SOURCES_MAX 64
+#define QUERY_TEXT_MAX_LEN 1024
+#define ARG_PREFIX "--"
 
 enum argument_cases {ARG_FILE_PRO, ARG_FILE_QTE, LOG_FILE, LOG_LEVEL,
+                     ARG_FILE_HIST, ARG_HIST_ADD, ARG_FILE_DELTA,
+                     ARG_FILE_BULK, ARG_EXPORT_JSON, ARG_EXPORT_FMT,
+                     ARG_QUERY, ARG_FILE_WATCH, ARG_FILE_ALERTS,
+                     ARG_FILE_TRACE, ARG_FILE_METRICS, ARG_BEST_PRICE,
                      ARG_SUPPORTED_CNT};
 
 /*
     Description of a command line argument. arg_value denotes custom switch case
     action. arg_name is the first word of the argument typed on the CLI.
-    arg_mems denotes how many words the argument consists of.
+    arg_mems denotes how many words the argument consists of. For arguments,
+    that accept a list of values, arg_mems is the minimum amount of words.
 */
 struct argument_description
 {
@@ -38,7 +46,22 @@ struct argument
     enum log_levels log_lvl;
     char f_log[FILE_NAME_MAX_LEN];
     char f_pro[FILE_NAME_MAX_LEN];
-    char f_qte[FILE_NAME_MAX_LEN];
+    char f_qte[QTE_SOURCES_MAX][FILE_NAME_MAX_LEN]; // Files, dirs or globs
+    int f_qte_cnt;
+    char f_hist[FILE_NAME_MAX_LEN];     // Empty if price history is not used
+    int hist_add;                       // Add quotes as a history snapshot
+    char f_delta[FILE_NAME_MAX_LEN];    // Quote changes applied after reading
+    char f_bulk[FILE_NAME_MAX_LEN];     // Product bulk edits applied at start
+    char f_export[FILE_NAME_MAX_LEN];   // JSON export instead of menu, "-" is
+                                        // standard output
+    int export_fmt;                     // enum export_formats value
+    char query[QUERY_TEXT_MAX_LEN];     // Query run instead of menu
+    char f_watch[FILE_NAME_MAX_LEN];    // Empty if watch rules are not used
+    char f_alerts[FILE_NAME_MAX_LEN];   // Empty for standard output
+    char f_trace[FILE_NAME_MAX_LEN];    // Empty if tracing is off
+    char f_metrics[FILE_NAME_MAX_LEN];  // Empty if metrics are not written
+    char f_best[FILE_NAME_MAX_LEN];     // Best price report instead of menu,
+                                        // "-" is standard output
 };
 
 
@@ -74,7 +97,9 @@ Parameters:     *args - Struct which holds the argument values that the program
                 arg_mems - The number of strings the argument consists of.
                 
 Return:         The number of extra strings the argument consisted of. An extra
-                string is every string that was not the first string.
+                string is every string that was not the first string. For
+                "--file_quotes" every following string, that does not start with
+                ARG_PREFIX, is taken as a quote source.
 */
 int change_argument_value(struct argument *args, enum argument_cases arg,
                           char **arg_vec, int arg_vec_len, int cnt, int arg_mems);
@@ -0,0 +1,90 @@
+/*
+File:         async_read.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for async_read.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _ASYNC_READ_H
+#define _ASYNC_READ_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#define ASYNC_BLOCK_SIZE (256 * 1024)
+#define ASYNC_BLOCKS 4              // Block being parsed and blocks read ahead
+
+// Async reader return values
+#define ASYNC_OK            0
+#define ASYNC_UNSUPPORTED   1
+#define ASYNC_READ_ERR     -1
+
+enum async_block_states {BLOCK_FREE, BLOCK_READING, BLOCK_DONE, BLOCK_PARSED};
+
+struct uring;
+
+/*
+    Reads a regular file in blocks through io_uring. While the caller parses
+    one block, the next ASYNC_BLOCKS - 1 blocks are read by the kernel. Blocks
+    are handed out in file order, every block goes round from free to reading,
+    done and parsed.
+*/
+struct async_reader
+{
+    struct uring *ring;             // NULL when not in use
+    int fd;                         // Own duplicate of the files descriptor
+    int eof;                        // No more reads are submitted
+    int head;                       // Block handed out next
+    int parsed;                     // Block being parsed, -1 if none
+    off_t next_off;                 // File offset of the next read
+    char *data;                     // ASYNC_BLOCKS blocks
+    off_t offsets[ASYNC_BLOCKS];
+    int results[ASYNC_BLOCKS];      // Bytes read or -errno
+    enum async_block_states states[ASYNC_BLOCKS];
+};
+
+
+/*
+Description:    Starts reading a file through io_uring. Only regular files, that
+                have not been read from yet, are supported. The file is read
+                through a duplicate of its descriptor without moving the file
+                position, so the reader stays valid even if the stream is
+                closed first.
+                
+Parameters:     *ar - Pointer to async reader.
+                *p_file - Pointer to file.
+                
+Return:         ASYNC_OK or ASYNC_UNSUPPORTED, if the file is not a regular
+                file, io_uring is not available or memory could not be
+                allocated. The file can then be read as usual.
+*/
+int async_reader_open(struct async_reader *ar, FILE *p_file);
+
+
+/*
+Description:    Returns the next block of the file and starts reading the ones
+                after it. The previous block is reused, so its data must not be
+                used after this call.
+                
+Parameters:     *ar - Pointer to async reader.
+                **data - Double pointer, that will be pointed to the block.
+                
+Return:         Number of bytes in the block. 0 at the end of the file.
+                ASYNC_READ_ERR if reading failed, the error is logged.
+*/
+long async_reader_next(struct async_reader *ar, char **data);
+
+
+/*
+Description:    Waits for reads still running and frees the reader. Does nothing
+                for a reader not in use.
+                
+Parameters:     *ar - Pointer to async reader.
+                
+Return:         -
+*/
+void async_reader_close(struct async_reader *ar);
+
+#endif
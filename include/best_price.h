@@ -0,0 +1,63 @@
+/*
+File:         best_price.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for best_price.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _BEST_PRICE_H
+#define _BEST_PRICE_H
+
+#include <stdint.h>
+#include <main.h>
+
+#define BEST_THREADS_MAX 16
+#define BEST_MIN_QUOTES_PER_THREAD 65536
+#define BEST_NO_QUOTE -1
+#define BEST_STDOUT "-"
+
+/*
+Description:    Finds the cheapest quote with stock of every product code in
+                one pass over the quote array. Large quote arrays are split
+                between threads, that keep the cheapest quotes of their range
+                in their own arrays indexed by code ID, which are merged
+                afterwards. Equal prices keep the first quote, like
+                find_cheapest_quote.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                **best - Pointer to array pointer, where the dynamically
+                         allocated quote index of every code ID is stored,
+                         BEST_NO_QUOTE if the code has no quote with stock.
+                *cnt - Pointer to variable, where the number of code IDs is
+                       stored.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int find_best_prices(struct quote_data_wrapper qdw, int64_t **best,
+                     uint32_t *cnt);
+
+
+/*
+Description:    Writes the cheapest offer of every product as CSV:
+                    code; name; quote_id; retailer; price; stock
+                Products with an offer come first, in product order. Products
+                without a quote with stock are listed after them, with empty
+                offer fields. Handles log writing and error printing.
+                
+Parameters:     *f_name - Pointer to string containing output file name.
+                          BEST_STDOUT for standard output.
+                pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on write or memory allocation
+                error.
+*/
+int write_best_price_report(char *f_name, struct product_data_wrapper pdw,
+                            struct quote_data_wrapper qdw);
+
+#endif
@@ -0,0 +1,170 @@
+/*
+File:         catalog.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for catalog.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _CATALOG_H
+#define _CATALOG_H
+
+#include <stdatomic.h>
+#include <main.h>
+#include <report.h>
+#include <fuzzy_search.h>
+
+// Parts of the catalog a writer changes
+#define CATALOG_PRODUCTS    1
+#define CATALOG_QUOTES      2
+
+#define CATALOG_RETIRE_MIN_ALLOC 32
+
+/*
+    One published version of all product and quote data. A version is never
+    changed after it is published. Writers change a copy, which gets its own
+    data arrays and indexes for the parts being changed, and shares everything
+    else with the previous version. Quotes grouped by product and the trigram
+    index of product names are built when first needed. An update, that does
+    not change their data, moves them to the new version.
+*/
+struct catalog_version
+{
+    struct product_data_wrapper products;
+    struct quote_data_wrapper quotes;
+    unsigned long version;
+    _Atomic(struct quote_groups *) groups;
+    _Atomic(struct trigram_index *) names;
+};
+
+
+/*
+Description:    Publishes the first catalog version. The catalog takes over the
+                memory of both wrappers.
+                
+Parameters:     pdw - Wrapper containing product data array and its index.
+                qdw - Wrapper containing quote data array and its index.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int catalog_init(struct product_data_wrapper pdw, struct quote_data_wrapper qdw);
+
+
+/*
+Description:    Starts reading the current catalog version. Never blocks on
+                writers. The version stays valid and unchanged until
+                catalog_read_end, even if a writer publishes a new one.
+                
+Parameters:     -
+                
+Return:         Pointer to the current catalog version.
+*/
+struct catalog_version *catalog_read_begin(void);
+
+
+/*
+Description:    Ends reading a version returned by catalog_read_begin.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void catalog_read_end(void);
+
+
+/*
+Description:    Returns quotes of a version grouped by product code ID. They are
+                built on the first call for the version and kept until the
+                version is freed, so later calls cost nothing. Must be called
+                between catalog_read_begin and catalog_read_end.
+                
+Parameters:     *cv - Pointer to catalog version.
+                
+Return:         Pointer to quote groups. NULL on memory allocation error.
+*/
+struct quote_groups *catalog_quote_groups(struct catalog_version *cv);
+
+
+/*
+Description:    Returns the trigram index of product names of a version. Built
+                on the first call like catalog_quote_groups.
+                
+Parameters:     *cv - Pointer to catalog version.
+                
+Return:         Pointer to trigram index. NULL on memory allocation error.
+*/
+struct trigram_index *catalog_name_index(struct catalog_version *cv);
+
+
+/*
+Description:    Starts an update. Writers are serialized. Returns a copy of
+                the current version, where the data arrays and indexes of the
+                parts being changed are copies too, so they can be changed in
+                place. Strings shared with the previous version must be retired
+                with catalog_retire, not freed. Must be followed by
+                catalog_update_commit or catalog_update_abort, unless NULL is
+                returned.
+                Copying is what lets readers go on without a lock, but it costs
+                time and memory in the size of the copied part, not of the
+                change: an update of CATALOG_QUOTES copies the whole quote
+                array and ID index, so a single quote edit from the menu is
+                O(quotes). Batch changes (delta files, bulk edits) into one
+                update to pay the copy once.
+                
+Parameters:     parts - CATALOG_PRODUCTS and/or CATALOG_QUOTES.
+                
+Return:         Pointer to the new, unpublished version. NULL on memory
+                allocation error.
+*/
+struct catalog_version *catalog_update_begin(int parts);
+
+
+/*
+Description:    Publishes a version returned by catalog_update_begin. Memory
+                of the previous version, that is not shared with the new one, is
+                freed after all readers of the previous version are done.
+                
+Parameters:     *cv - Pointer to the new version.
+                
+Return:         -
+*/
+void catalog_update_commit(struct catalog_version *cv);
+
+
+/*
+Description:    Discards a version returned by catalog_update_begin without
+                publishing it, when nothing was changed. Its copied arrays and
+                indexes are freed and the current version stays as it was.
+                
+Parameters:     *cv - Pointer to the unpublished version.
+                
+Return:         -
+*/
+void catalog_update_abort(struct catalog_version *cv);
+
+
+/*
+Description:    Retires a string (or other memory allocated with malloc), that
+                is replaced or removed in a version being updated. Readers of
+                the previous version may still use it, so it is handed to
+                rcu_retire only after the new version is published. Outside an
+                update nothing is published, it is retired right away.
+                
+Parameters:     *ptr - Pointer to memory. NULL is ignored.
+                
+Return:         -
+*/
+void catalog_retire(void *ptr);
+
+
+/*
+Description:    Waits for readers and frees the current version with all its
+                data and every retired version.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void catalog_free(void);
+
+#endif
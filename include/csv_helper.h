@@ -10,35 +10,47 @@ Description:  Header file for csv_helper.c. Data struct definitions, macros
 #ifndef _CSV_HELPER_H
 #define _CSV_HELPER_H
 
+#include <stdio.h>
+
 #define CSV_DELIMITER ';'
+#define CSV_QUOTE '"'
+#define CSV_QUOTED_CHARS ";\"\n"  // Field is quoted, if it has one of these
 #define DYN_BUF_STEP 32
+#define CSV_BLOCK_SIZE (64 * 1024)
 
 // Errors
-#define CSV_MALLOC_ERR 1
+#define CSV_MALLOC_ERR -2
+#define CSV_READ_ERR -3
 
 /*
-Description:    Reads a line from file pointed to by *p_file and saves line to
-                a dynamic string buffer. While reading skips empty lines
-                (contain only '\n'). After file is over dynamic line buffer is
-                freed. If whole file is not read, buffer should be manually
-                freed!
+Description:    Reads a record from file pointed to by *p_file and saves it to
+                a dynamic string buffer. A record is usually one line, but a
+                newline inside a quoted field does not end it. The file is read
+                in blocks of CSV_BLOCK_SIZE, data left over from a block is
+                kept for the next call with the same file. While reading skips
+                empty lines (contain only '\n'). After file is over dynamic
+                buffers are freed. If whole file is not read, buffers should be
+                manually freed! The buffers are thread local, so different
+                threads can read different files at the same time.
                 
 Parameters:     *p_file - Pointer to file.
                 **str - Double pointer that will be pointed to the buffer string.
                 
 Return:         EOF - if file is over and no data has been read.
-                Number of chars read, if any data has been read.
+                CSV_MALLOC_ERR - if memory could not be allocated.
+                CSV_READ_ERR - if reading the file failed. Buffers are freed.
+                Number of chars in the record without the newline.
 */
 int read_line(FILE *p_file, char **str);
 
 
 /*
-Description:    Reads data line *src char-by-char until an amout (field_num - 1)
-                of CSV_DELIMITER is encountered. Removes empty spaces after
-                CSV_DELIMITER and before data to get the first chars position in
-                the desirable data field. Then goes again char-by-char until end
-                of data field (marked by CSV_DELIMITER or '\0') and adds '\0' to
-                complete the string for desirable data field.
+Description:    Finds field number field_num of data line *src. Removes empty
+                spaces after CSV_DELIMITER and before data to get the first
+                chars position in the desirable data field. The field is ended
+                with '\0'. A quoted field is unquoted in place: its quotes are
+                removed and "" is replaced by ". Fields before it are changed
+                the same way, so *src can not be used again.
                 
 Parameters:     *src - Pointer to string that contains data line.
                 field_num - A number that represents the desirable data fields
@@ -52,7 +64,37 @@ char *get_field(char *src, int field_num);
 
 
 /*
-Description:    Allows user to manually free the read buffer.
+Description:    Splits data line *src into fields in one pass. Every
+                CSV_DELIMITER outside quotes is replaced by '\0', leading
+                spaces of every field are skipped and quoted fields are
+                unquoted, so fields are the same as returned by get_field. If
+                the line has more than max_fields fields, the rest are ignored.
+                
+Parameters:     *src - Pointer to string that contains data line.
+                **fields - Array, where pointers to the fields are stored.
+                max_fields - Length of the fields array.
+                
+Return:         Number of fields.
+*/
+int split_fields(char *src, char **fields, int max_fields);
+
+
+/*
+Description:    Prints a field into a CSV file. A field with a CSV_QUOTED_CHARS
+                char or a leading space is quoted and its quotes are doubled,
+                so it is read back unchanged.
+                
+Parameters:     *fp - Pointer to file.
+                *str - Field string.
+                
+Return:         -
+*/
+void print_csv_field(FILE *fp, const char *str);
+
+
+/*
+Description:    Allows user to manually free the read buffers of the calling
+                thread.
                 
 Parameters:     -
                 
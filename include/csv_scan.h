@@ -0,0 +1,65 @@
+/*
+File:         csv_scan.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for csv_scan.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _CSV_SCAN_H
+#define _CSV_SCAN_H
+
+#include <stddef.h>
+
+/*
+    Instruction sets the scanner can use. The best one supported by the CPU is
+    picked at the first scan. Compiling with CSV_SCAN_SCALAR disables SIMD.
+*/
+enum scan_isa {SCAN_ISA_SCALAR, SCAN_ISA_SSE2, SCAN_ISA_AVX2};
+
+/*
+Description:    Finds the first byte in buf, that is a or b. Looks at 32 (AVX2)
+                or 16 (SSE2) bytes at a time. Used for finding structural
+                characters of CSV data: delimiters, newlines and quotes.
+                
+Parameters:     *buf - Pointer to data.
+                len - Length of data in bytes.
+                a, b - Bytes searched for. Can be the same byte.
+                
+Return:         Offset of the first match or len if there is none.
+*/
+size_t scan_for2(const char *buf, size_t len, char a, char b);
+
+
+/*
+    States of the record scanner. A quote opens a quoted field only at the
+    start of a field, elsewhere it is part of the field data.
+*/
+enum record_state {REC_FIELD_START, REC_IN_FIELD, REC_QUOTED, REC_QUOTE_END};
+
+/*
+Description:    Finds the newline, that ends the current record. Newlines inside
+                a quoted field do not end a record. Scanner state is kept
+                between calls, so a record can span several blocks of data.
+                
+Parameters:     *buf - Pointer to data.
+                len - Length of data in bytes.
+                delim - Field delimiter.
+                *state - Pointer to enum record_state value. REC_FIELD_START at
+                the start of a record.
+                
+Return:         Offset of the newline or len if the record does not end in buf.
+*/
+size_t scan_record_end(const char *buf, size_t len, char delim, int *state);
+
+
+/*
+Description:    Returns the instruction set used by the scanner.
+                
+Parameters:     -
+                
+Return:         enum scan_isa value.
+*/
+enum scan_isa get_scan_isa(void);
+
+#endif
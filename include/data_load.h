@@ -0,0 +1,50 @@
+/*
+File:         data_load.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for data_load.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _DATA_LOAD_H
+#define _DATA_LOAD_H
+
+#include <main.h>
+
+/*
+    Products loaded on their own thread while quotes are loaded. status is
+    EXIT_SUCCESS when the products were read and indexed.
+*/
+struct product_load_job
+{
+    char *f_name;
+    struct product_data_wrapper *pdw;
+    int status;
+    double ms;
+};
+
+
+/*
+Description:    Loads the products file and the quote sources at the same time.
+                Products are read on a separate thread and their code index is
+                built as soon as they are read, while the calling thread reads
+                the quotes and builds the quote ID index. If the thread can not
+                be started, products are loaded first on the calling thread.
+                Load times are written into the log.
+                
+Parameters:     *f_pro - Pointer to products file name.
+                **quote_sources - Array of quote source strings.
+                src_cnt - Number of quote sources.
+                *pdw - Pointer to a wrapper for product info array.
+                *qdw - Pointer to a wrapper for quote info array.
+                
+Return:         EXIT_SUCCESS (0) if all data was read and indexed. Otherwise
+                EXIT_FAILURE. Whatever was read is stored in the wrappers in
+                both cases, so they can be freed as usual.
+*/
+int load_data_files(char *f_pro, char **quote_sources, int src_cnt,
+                    struct product_data_wrapper *pdw,
+                    struct quote_data_wrapper *qdw);
+
+#endif
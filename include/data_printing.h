@@ -10,6 +10,9 @@ Description:  Header file for data_printing.c. Data struct definitions, macros
 #ifndef _DATA_PRINTING
 #define _DATA_PRINTING
 
+#include <main.h>
+#include <out_buf.h>
+
 #define SEP_LINE_LEN 80
 
 /*
@@ -29,11 +32,12 @@ Description:    Prints products name, all the specs and product code. Everything
                 product name is printed first, everything else that follows is
                 indented by '\t'.
                 
-Parameters:     pi - Struct holding all the data necessary for printing.
+Parameters:     *ob - Output buffer, where data is printed.
+                pi - Struct holding all the data necessary for printing.
                 
 Return:         -
 */
-void print_product_specs(struct product_info pi);
+void print_product_specs(struct out_buf *ob, struct product_info pi);
 
 
 /*
@@ -43,11 +47,12 @@ Description:    Prints quote info as one line with a "vertical a line ('|')"
                 the retailer has the product in stock, "In Stock" with amount of
                 stock is displayed. Otherwise "Order" is displayed.
                 
-Parameters:     qi - Struct holding all the data necessary for printing.
+Parameters:     *ob - Output buffer, where data is printed.
+                qi - Struct holding all the data necessary for printing.
                 
 Return:         -
 */
-void print_product_quote(struct quote_info qi);
+void print_product_quote(struct out_buf *ob, struct quote_info qi);
 
 
 /*
@@ -56,44 +61,20 @@ Description:    Prints the head of product quote table, with descriptive labels
                 '|'. These symbols align with the ones from print_product_quote
                 function.
                 
-Parameters:     -
+Parameters:     *ob - Output buffer, where data is printed.
                 
 Return:         -
 */
-void print_quote_table_head(void);
+void print_quote_table_head(struct out_buf *ob);
 
 
 /*
 Description:    Prints a separator line of dashes '-' with length SEP_LINE_LEN.
                 
-Parameters:     -
-                
-Return:         -
-*/
-void print_separator_line(void);
-
-
-/*
-Description:    Prints product info from struct pi into file pointed by *fp.
-                Data is separated by CSV_DELIMITER and in the following order:
-                Product Code, Name, RAM, Screen Size, OS.
-                
-Parameters:     pi - Struct holding all the data necessary for printing.
-                
-Return:         -
-*/
-void print_product_csv_line(FILE *fp, struct product_info pi);
-
-
-/*
-Description:    Prints quote info from struct qi into file pointed by *fp.
-                Data is separated by CSV_DELIMITER and in the following order:
-                Quote ID, Product Code, Retailer, Price, Stock.
-                
-Parameters:     qi - Struct holding all the data necessary for printing.
+Parameters:     *ob - Output buffer, where data is printed.
                 
 Return:         -
 */
-void print_quote_csv_line(FILE *fp, struct quote_info qi);
+void print_separator_line(struct out_buf *ob);
 
 #endif
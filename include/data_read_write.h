@@ -14,21 +14,6 @@ Description:  Header file for data_read_write.c. Data struct definitions, macros
 
 #define MIN_ALLOC_LINE_CNT 8
 
-// CSV and CSV reading macros
-// Product file fields. Index of first field is 1
-#define CSV_PRO_FIELD_CODE  1
-#define CSV_PRO_FIELD_NAME  2
-#define CSV_PRO_FIELD_RAM   3
-#define CSV_PRO_FIELD_SCRN  4
-#define CSV_PRO_FIELD_OS    5
-
-// Quote file fields. Index of first field is 1
-#define CSV_QTE_FIELD_ID    1
-#define CSV_QTE_FIELD_CODE  2
-#define CSV_QTE_FIELD_RTLR  3
-#define CSV_QTE_FIELD_PRICE 4
-#define CSV_QTE_FIELD_STOCK 5
-
 // Read error severity
 #define READ_ERR_NOT_FATAL  0
 #define READ_ERR_FATAL      1
@@ -37,11 +22,15 @@ Description:  Header file for data_read_write.c. Data struct definitions, macros
 #define CSV_WRITE_OK        1
 #define CSV_WRITE_FOPEN_ERR 0
 
+// Quote shards are written into temporary files before replacing them
+#define SAVE_TMP_SUFFIX ".tmp"
+
 // Read errors
 enum read_errors {READ_OK, READ_ERR_MSNG_DATA, READ_ERR_STR_MALLOC,
                   READ_ERR_RAM_NINT, READ_ERR_RAM_NEG, READ_ERR_SCRNS_NFLOAT,
                   READ_ERR_SCRNS_NEG, READ_ERR_PRICE_NINT, READ_ERR_PRICE_NEG,
-                  READ_ERR_STOCK_NINT, READ_ERR_STOCK_NEG};
+                  READ_ERR_STOCK_NINT, READ_ERR_STOCK_NEG, READ_ERR_DELTA_OP,
+                  READ_ERR_DICT_FULL, READ_ERR_CNT};
 
 /*
 Description:    A helper function for opening file with name f_name and in mode
@@ -60,12 +49,14 @@ FILE *open_file(char *f_name, char *mode);
 
 /*
 Description:    First calls a function to read a line from a csv file with name
-                f_name. Then calls another function to interpret the line into
-                buffer variables. The function itself creates a dynamic array to
-                which it saves the buffered values to. If needed, the dynamic
-                array is lengthened according to 2*n principle. If reading is
-                done, excess allocated memory is freed. The function contains
-                error printing and logging.
+                f_name (gzip or zstd compressed files are decompressed while
+                reading). Then the line is parsed with the routine generated
+                from the column table (record_schema.h) straight into a dynamic
+                array. If the first line is a header row, columns are mapped by
+                name once and unknown columns are skipped. If needed, the
+                dynamic array is lengthened according to 2*n principle. If
+                reading is done, excess allocated memory is freed. The function
+                contains error printing and logging.
                 
 Parameters:     *f_name - Pointer to string containing file name.
                 *pdw - Pointer to a wrapper for product info array.
@@ -79,9 +70,10 @@ int read_data_products(char *f_name, struct product_data_wrapper *pdw);
 /*
 Description:    A pointer to a struct *pi of buffer variables is passed to this
                 function together with *buf, that points to a data line read
-                from the products info data file. Using the get_field function,
-                data from *buf is interpreted into buffer variables. Necessary
-                checks are conducted.
+                from the products info data file. Fields are expected in the
+                order of the column table (no header row). Data from *buf is
+                interpreted into buffer variables. Necessary checks are
+                conducted. *buf is split in place.
                 
 Parameters:     *pi - Pointer to a struct of buffer variables.
                 *buf - Pointer to a string of read csv data.
@@ -94,12 +86,14 @@ int get_product_info(struct product_info *pi, char *buf);
 
 /*
 Description:    First calls a function to read a line from a csv file with name
-                f_name. Then calls another function to interpret the line into
-                buffer variables. The function itself creates a dynamic array to
-                which it saves the buffered values to. If needed, the dynamic
-                array is lengthened according to 2*n principle. If reading is
-                done, excess allocated memory is freed. The function contains
-                error printing and logging.
+                f_name (gzip or zstd compressed files are decompressed while
+                reading). Then the line is parsed with the routine generated
+                from the column table (record_schema.h) straight into a dynamic
+                array. If the first line is a header row, columns are mapped by
+                name once and unknown columns are skipped. If needed, the
+                dynamic array is lengthened according to 2*n principle. If
+                reading is done, excess allocated memory is freed. The function
+                contains error printing and logging.
                 
 Parameters:     *f_name - Pointer to string containing file name.
                 *qdw - Pointer to a wrapper for product info array.
@@ -113,9 +107,10 @@ int read_data_quotes(char *f_name, struct quote_data_wrapper *qdw);
 /*
 Description:    A pointer to a struct *qi of buffer variables is passed to this
                 function together with *buf, that points to a data line read
-                from the quotes info data file. Using the get_field function,
-                data from *buf is interpreted into buffer variables. Necessary
-                checks are conducted.
+                from the quotes info data file. Fields are expected in the
+                order of the column table (no header row). Data from *buf is
+                interpreted into buffer variables. Necessary checks are
+                conducted. *buf is split in place.
                 
 Parameters:     *qi - Pointer to a struct of buffer variables.
                 *buf - Pointer to a string of read csv data.
@@ -140,11 +135,26 @@ Parameters:     err - enum value of error message.
 Return:         READ_OK (0 - enum value) if all data was read successfully.
                 Otherwise a value corresponding to the first encountered error.
 */
-int print_read_error(enum read_errors err, char *f_name, int line);
+int print_read_error(enum read_errors err, char *f_name, size_t line);
+
+
+/*
+Description:    Checks if a file, that is about to be overwritten, is a
+                compressed data file. Compressed files are only read, so an
+                error is printed and logged for them.
+                
+Parameters:     *f_name - Pointer to string containing file name.
+                
+Return:         1 if the file is compressed, otherwise 0.
+*/
+int is_compressed_save_target(char *f_name);
 
 
 /*
-Description:    Writes all data from products data array into a CSV file.
+Description:    Writes all data from products data array into a CSV file. If
+                the file was read with a header row, it is written in the
+                layout of that header, columns unknown to the program keep
+                the values read for the same product code.
                 
 Parameters:     f_name - File name (path) of output file.
                 pdw - Wrapper containing a pointer to product data array and its
@@ -157,15 +167,31 @@ int save_product_file_changes(char *f_name, struct product_data_wrapper pdw);
 
 
 /*
-Description:    Writes all data from quotes data array into a CSV file.
+Description:    Writes all data from quotes data array into CSV files. Every
+                quote is written to the file (shard) it was read from. Shard
+                file names are stored in the wrapper. Files, that were read with
+                a header row, are written in the layout of that header, like
+                product files. Shards are first written into temporary
+                files, the shard files are replaced only if every write
+                succeeded.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array, its
+                      length and the shard file names.
+                
+Return:         CSV_WRITE_FOPEN_ERR - If an error occurs while opening a file.
+                CSV_WRITE_OK - Data was successfully written to the files.
+*/
+int save_quote_file_changes(struct quote_data_wrapper qdw);
+
+
+/*
+Description:    Frees the header layouts kept of the files read with a header
+                row.
                 
-Parameters:     f_name - File name (path) of output file.
-                qdw - Wrapper containing a pointer to quote data array and its
-                      length.
+Parameters:     -
                 
-Return:         CSV_WRITE_FOPEN_ERR - If an error occurs while opening the file.
-                CSV_WRITE_OK - Data was successfully written to the file.
+Return:         -
 */
-int save_quote_file_changes(char *f_name, struct quote_data_wrapper qdw);
+void free_file_layouts(void);
 
 #endif
@@ -0,0 +1,64 @@
+/*
+File:         data_stream.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for data_stream.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _DATA_STREAM_H
+#define _DATA_STREAM_H
+
+#include <stdio.h>
+
+#define STREAM_MAGIC_LEN 4
+#define STREAM_CHUNK_SIZE (256 * 1024)
+#define STREAM_PIPE_SIZE (1024 * 1024)
+
+// Stream status values
+#define STREAM_OK           0
+#define STREAM_ERR         -1
+
+enum stream_formats {STREAM_PLAIN, STREAM_GZIP, STREAM_ZSTD};
+
+/*
+Description:    Opens a data file for reading. The first bytes of the file are
+                checked for gzip or zstd magic bytes. A plain file is returned
+                as it is. For a compressed file a pipe is created and a
+                separate thread decompresses the file into it, while the caller
+                reads (and parses) decompressed data from the returned stream.
+                zstd is supported only when compiled with USE_ZSTD. Handles
+                log writing and error printing for associated actions.
+                
+Parameters:     *f_name - Pointer to string containing file name.
+                
+Return:         Pointer to a readable stream. NULL if unsuccessful.
+*/
+FILE *open_data_file(char *f_name);
+
+
+/*
+Description:    Closes a stream opened with open_data_file. If the stream is
+                fed by a decompression thread, waits for the thread to finish.
+                
+Parameters:     *fp - Stream returned by open_data_file.
+                
+Return:         STREAM_OK if the whole file was read (and decompressed)
+                successfully. STREAM_ERR if decompression failed, so data read
+                from the stream is incomplete.
+*/
+int close_data_file(FILE *fp);
+
+
+/*
+Description:    Checks the magic bytes of a file to find its format.
+                
+Parameters:     *f_name - Pointer to string containing file name.
+                
+Return:         enum stream_formats value. STREAM_PLAIN also if the file can
+                not be read.
+*/
+enum stream_formats get_file_format(char *f_name);
+
+#endif
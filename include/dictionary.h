@@ -0,0 +1,107 @@
+/*
+File:         dictionary.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for dictionary.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _DICTIONARY_H
+#define _DICTIONARY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DICT_NO_ID UINT32_MAX
+#define DICT_PAGE_BITS 10
+#define DICT_PAGE_LEN (1 << DICT_PAGE_BITS)   // Length of the first page
+#define DICT_PAGES_MAX (32 - DICT_PAGE_BITS)  // Page length doubles every time
+#define DICT_CHUNK_SIZE (64 * 1024)
+
+// Dictionary return values
+#define DICT_OK             0
+#define DICT_MALLOC_ERR     1
+#define DICT_FULL           2
+
+/*
+    Columns, that are stored as dictionary IDs. Product codes are shared by
+    products and quotes, so the join compares IDs.
+*/
+enum dictionaries {DICT_CODE, DICT_RETAILER, DICT_CNT};
+
+/*
+    Block of memory, where dictionary strings are stored. Strings never move,
+    so pointers to them stay valid until the dictionary is freed.
+*/
+struct dict_chunk
+{
+    struct dict_chunk *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+
+/*
+Description:    Finds the ID of a string or adds the string to a dictionary.
+                Safe to call from several threads, adding is serialized by a
+                mutex.
+                
+Parameters:     dict - Dictionary.
+                *str - String to find or add. Copied into the dictionary.
+                *id - Pointer to variable, where the ID is stored.
+                
+Return:         DICT_OK, DICT_MALLOC_ERR or DICT_FULL if all 32-bit IDs are
+                used.
+*/
+int dict_intern(enum dictionaries dict, const char *str, uint32_t *id);
+
+
+/*
+Description:    Finds the ID of a string without adding it.
+                
+Parameters:     dict - Dictionary.
+                *str - String.
+                
+Return:         ID of the string or DICT_NO_ID.
+*/
+uint32_t dict_find(enum dictionaries dict, const char *str);
+
+
+/*
+Description:    Returns the string of an ID. Does not lock, an ID returned by
+                dict_intern can be resolved from any thread.
+                
+Parameters:     dict - Dictionary.
+                id - ID returned by dict_intern.
+                
+Return:         Pointer to the string. Empty string for DICT_NO_ID.
+*/
+const char *dict_string(enum dictionaries dict, uint32_t id);
+
+
+/*
+Description:    Returns the number of strings in a dictionary and the bytes of
+                memory used for storing them.
+                
+Parameters:     dict - Dictionary.
+                *bytes - Pointer to variable, where memory usage is stored. Can
+                         be NULL.
+                
+Return:         Number of strings.
+*/
+uint32_t dict_size(enum dictionaries dict, size_t *bytes);
+
+
+/*
+Description:    Frees all dictionaries. IDs returned before are no longer
+                valid.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void free_dictionaries(void);
+
+#endif
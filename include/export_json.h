@@ -0,0 +1,67 @@
+/*
+File:         export_json.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for export_json.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _EXPORT_JSON_H
+#define _EXPORT_JSON_H
+
+#include <stdio.h>
+#include <main.h>
+#include <report.h>
+
+#define EXPORT_BUF_SIZE (64 * 1024)
+#define EXPORT_STDOUT "-"
+#define EXPORT_FMT_NAME_NDJSON "ndjson"
+#define EXPORT_FMT_NAME_JSON "json"
+#define EXPORT_INT_MAX_LEN 24
+#define EXPORT_FLOAT_MAX 1e15          // Larger values are written as null
+
+/*
+    NDJSON is one product object per line. JSON is an array of the same
+    objects, one per line.
+*/
+enum export_formats {EXPORT_NDJSON, EXPORT_JSON};
+
+/*
+    Buffered writer with a fixed size buffer, so memory use does not depend
+    on the amount of data. err is set if writing failed.
+*/
+struct json_writer
+{
+    FILE *fp;
+    size_t len;
+    int err;
+    char buf[EXPORT_BUF_SIZE];
+};
+
+
+/*
+Description:    Writes every product joined with its quotes as JSON objects:
+                {"code", "name", "ram", "screen_size", "os", "quotes": [{"id",
+                "retailer", "price", "stock"}]}. Prices are in cents. Strings
+                are escaped and numbers formatted without printf. Output is
+                streamed through a fixed size buffer. Handles log writing and
+                error printing.
+                
+Parameters:     *f_name - Name of the output file, EXPORT_STDOUT for standard
+                          output.
+                format - enum export_formats value.
+                pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *qg - Pointer to quotes grouped by product code ID.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if the file could not be
+                written.
+*/
+int export_catalog_json(char *f_name, int format,
+                        struct product_data_wrapper pdw,
+                        struct quote_data_wrapper qdw, struct quote_groups *qg);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+File:         fuzzy_search.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for fuzzy_search.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _FUZZY_SEARCH_H
+#define _FUZZY_SEARCH_H
+
+#include <stdint.h>
+#include <main.h>
+
+#define TRIGRAM_SYMBOLS 37              // Padding, a-z and 0-9
+#define TRIGRAM_CNT (TRIGRAM_SYMBOLS * TRIGRAM_SYMBOLS * TRIGRAM_SYMBOLS)
+#define TRIGRAMS_PER_NAME_MAX 256       // Longer names are indexed partly
+#define FUZZY_RESULTS_MAX 5
+#define FUZZY_MIN_SIMILARITY 0.4f
+
+/*
+    Inverted index from name trigrams to products. Names are lowercased and
+    everything except letters and digits is dropped, so "oPhone 7" and
+    "ophone7" have the same trigrams. Products with trigram t are
+    postings[first[t]] ... postings[first[t + 1] - 1], in ascending order.
+*/
+struct trigram_index
+{
+    size_t *first;
+    size_t *postings;
+    uint16_t *name_trigrams;    // Number of distinct trigrams of every name
+    uint16_t *name_symbols;     // Number of letters and digits of every name
+    size_t product_cnt;
+};
+
+
+/*
+    Product found by fuzzy search. similarity is the Dice coefficient of the
+    trigram sets of the query and the name, 1 for the same trigrams. Ties are
+    broken by length_diff, the difference in letters and digits.
+*/
+struct fuzzy_match
+{
+    size_t product;
+    float similarity;
+    int length_diff;
+};
+
+
+/*
+Description:    Builds a trigram index of product names.
+                
+Parameters:     pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                *ti - Pointer to trigram index, where the result is stored.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int build_trigram_index(struct product_data_wrapper pdw,
+                        struct trigram_index *ti);
+
+
+/*
+Description:    Finds the products with names most similar to the query. Only
+                products sharing a trigram with the query are looked at.
+                
+Parameters:     *ti - Pointer to trigram index.
+                *query - Search string.
+                *matches - Array, where matches are stored, most similar first.
+                max_matches - Length of the matches array.
+                
+Return:         Number of matches with similarity of at least
+                FUZZY_MIN_SIMILARITY. -1 on memory allocation error.
+*/
+int fuzzy_find_products(struct trigram_index *ti, const char *query,
+                        struct fuzzy_match *matches, int max_matches);
+
+
+/*
+Description:    Frees the memory of a trigram index.
+                
+Parameters:     *ti - Pointer to trigram index.
+                
+Return:         -
+*/
+void free_trigram_index(struct trigram_index *ti);
+
+#endif
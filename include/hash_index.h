@@ -0,0 +1,128 @@
+/*
+File:         hash_index.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for hash_index.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _HASH_INDEX_H
+#define _HASH_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HASH_MIN_CAPACITY 16
+#define HASH_NOT_FOUND -1
+
+// Hash index return values
+#define HASH_OK             0
+#define HASH_MALLOC_ERR     1
+
+/*
+    One slot of the hash table. key is NULL for an empty slot.
+*/
+struct hash_slot
+{
+    char *key;
+    int64_t value;
+    uint64_t hash;
+};
+
+
+/*
+    Hash table (open addressing, linear probing) that maps strings to integer
+    values, usually indexes into a data array. Keys are not copied, the caller
+    must keep them alive while they are in the table.
+*/
+struct hash_index
+{
+    struct hash_slot *slots;
+    size_t capacity;        // Always a power of 2
+    size_t count;
+};
+
+
+/*
+Description:    Calculates the 64-bit FNV-1a hash of a string. Tables of more
+                than 2^32 slots need all of its bits.
+                
+Parameters:     *str - Pointer to string.
+                
+Return:         Hash value.
+*/
+uint64_t hash_string(const char *str);
+
+
+/*
+Description:    Initializes an empty hash index with room for expected_cnt keys
+                without growing.
+                
+Parameters:     *hi - Pointer to hash index.
+                expected_cnt - Number of keys expected to be added.
+                
+Return:         HASH_OK or HASH_MALLOC_ERR.
+*/
+int hash_index_init(struct hash_index *hi, size_t expected_cnt);
+
+
+/*
+Description:    Adds a key with a value to the index. If the key already exists,
+                its value is replaced. The table is grown when it is over 3/4
+                full.
+                
+Parameters:     *hi - Pointer to hash index.
+                *key - Key string, not copied.
+                value - Value for the key.
+                
+Return:         HASH_OK or HASH_MALLOC_ERR.
+*/
+int hash_index_put(struct hash_index *hi, char *key, int64_t value);
+
+
+/*
+Description:    Finds the value for a key.
+                
+Parameters:     *hi - Pointer to hash index.
+                *key - Key string.
+                
+Return:         Value of the key or HASH_NOT_FOUND.
+*/
+int64_t hash_index_get(struct hash_index *hi, const char *key);
+
+
+/*
+Description:    Removes a key from the index. Following slots are shifted back,
+                so lookups never need tombstones.
+                
+Parameters:     *hi - Pointer to hash index.
+                *key - Key string.
+                
+Return:         Old value of the key or HASH_NOT_FOUND.
+*/
+int64_t hash_index_remove(struct hash_index *hi, const char *key);
+
+
+/*
+Description:    Copies an index. Keys are shared with the original.
+                
+Parameters:     *dest - Pointer to hash index, where the copy is made. Its old
+                        memory is not freed.
+                *src - Pointer to hash index being copied.
+                
+Return:         HASH_OK or HASH_MALLOC_ERR, then dest is empty.
+*/
+int hash_index_copy(struct hash_index *dest, struct hash_index *src);
+
+
+/*
+Description:    Frees the memory of the index. Keys are not freed.
+                
+Parameters:     *hi - Pointer to hash index.
+                
+Return:         -
+*/
+void hash_index_free(struct hash_index *hi);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+File:         latency.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for latency.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*
+    Histogram buckets are log-linear: values under LAT_SUB_CNT have their own
+    bucket, larger ones share a bucket with values, that have the same
+    LAT_SUB_BITS - 1 bits after the highest set bit. A recorded value is off
+    by less than 1 / LAT_HALF_CNT (about 3 %).
+*/
+#define LAT_SUB_BITS 6
+#define LAT_SUB_CNT (1 << LAT_SUB_BITS)
+#define LAT_HALF_CNT (LAT_SUB_CNT / 2)
+#define LAT_BUCKET_CNT ((64 - LAT_SUB_BITS + 2) * LAT_HALF_CNT)
+#define LAT_NS_PER_MS 1000000.0
+
+// Timed operations, menu options and batch actions
+enum latency_ops {LAT_LOAD, LAT_DISPLAY, LAT_EDIT_RAM, LAT_EDIT_RTLR,
+                  LAT_SEARCH, LAT_HIST_TREND, LAT_HIST_LOW, LAT_APPLY_DELTA,
+                  LAT_BULK_EDIT, LAT_BROWSE, LAT_RTLR_REPORT, LAT_QUERY,
+                  LAT_WATCH_ADD, LAT_WATCH_CHECK, LAT_EXPORT, LAT_BEST_PRICE,
+                  LAT_SAVE_PRO, LAT_SAVE_QTE, LAT_OP_CNT};
+
+/*
+    Durations of one operation in nanoseconds. Counters are updated with
+    relaxed atomics, so any thread can record without locking.
+*/
+struct latency_hist
+{
+    _Atomic uint64_t buckets[LAT_BUCKET_CNT];
+    _Atomic uint64_t cnt;
+    _Atomic uint64_t max;
+    _Atomic uint64_t sum;       // Total of all durations
+};
+
+
+/*
+    Start of a timed operation. Time spent waiting for user input during the
+    operation is not counted.
+*/
+struct latency_span
+{
+    uint64_t start;
+    uint64_t wait;
+};
+
+
+/*
+Description:    Returns the time of a monotonic clock.
+                
+Parameters:     -
+                
+Return:         Time in nanoseconds.
+*/
+uint64_t latency_now(void);
+
+
+/*
+Description:    Adds time the calling thread waited for user input. It is left
+                out of every operation running on the thread.
+                
+Parameters:     ns - Waited time in nanoseconds.
+                
+Return:         -
+*/
+void latency_add_wait(uint64_t ns);
+
+
+/*
+Description:    Starts timing an operation.
+                
+Parameters:     *span - Pointer to span, where the start is stored.
+                
+Return:         -
+*/
+void latency_begin(struct latency_span *span);
+
+
+/*
+Description:    Records the time since latency_begin, without waiting for user
+                input, into the histogram of an operation.
+                
+Parameters:     *span - Pointer to span started with latency_begin.
+                op - Operation. LAT_OP_CNT is ignored.
+                
+Return:         -
+*/
+void latency_end(struct latency_span *span, enum latency_ops op);
+
+
+/*
+Description:    Records a duration into the histogram of an operation.
+                
+Parameters:     op - Operation.
+                ns - Duration in nanoseconds.
+                
+Return:         -
+*/
+void latency_record(enum latency_ops op, uint64_t ns);
+
+
+/*
+Description:    Returns the value, that at least pct percent of the recorded
+                durations of an operation are not greater than. The value is
+                the highest value of its bucket, but not over the maximum.
+                
+Parameters:     op - Operation.
+                pct - Percentile, 0-100.
+                
+Return:         Duration in nanoseconds. 0 if nothing is recorded.
+*/
+uint64_t latency_percentile(enum latency_ops op, double pct);
+
+
+/*
+Description:    Registers a summary (count, p50, p90, p99, maximum and total of
+                every operation, that was run), that is printed to stderr and
+                written into the log when the program exits.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void latency_init(void);
+
+#endif
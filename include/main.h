@@ -10,6 +10,11 @@ Description:  Header file for main code file. Data struct definitions, macros
 #ifndef _MAIN_H
 #define _MAIN_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <hash_index.h>
+#include <alloc_acct.h>
+
 #define MAX_ERR_MSG_LEN 256
 
 #define MIN_ARGS_TO_PARSE 1
@@ -30,11 +35,14 @@ Description:  Header file for main code file. Data struct definitions, macros
 #define EDIT_MALLOC         2
 
 // Currency: cents to euros
-#define CNTS_TO_EUR(cnts) (cnts / 100.0f)
+#define CNTS_TO_EUR(cnts) (cnts / 100.0)
 
 // Menu options
 enum menu_options {MENU_OPT_EXIT, MENU_OPT_DISP_DATA, MENU_OPT_EDIT_RAM,
-                  MENU_OPT_EDIT_RTLR, MENU_OPT_SRCH_PRO, MENU_OPT_CNT};
+                  MENU_OPT_EDIT_RTLR, MENU_OPT_SRCH_PRO, MENU_OPT_HIST_TREND,
+                  MENU_OPT_HIST_LOW, MENU_OPT_APPLY_DELTA, MENU_OPT_BULK_EDIT,
+                  MENU_OPT_BROWSE, MENU_OPT_RTLR_REPORT, MENU_OPT_QUERY,
+                  MENU_OPT_WATCH_ADD, MENU_OPT_CNT};
 
 /*
     Struct that holds all the available information about one product, from the
@@ -43,6 +51,7 @@ enum menu_options {MENU_OPT_EXIT, MENU_OPT_DISP_DATA, MENU_OPT_EDIT_RAM,
 struct product_info
 {
     char *p_code;       // Product code
+    uint32_t code_id;   // Product code in the code dictionary
     char *p_name;       // Product name
     char *p_os;         // Operating system
     int ram;            // RAM in MB
@@ -53,38 +62,50 @@ struct product_info
 /*
     Wrapper for struct product_info. Has information about the structs size
     in bytes, how many entries (lines) exist and a pointer to the data array.
+    Products are found by product code through code_index.
 */
 struct product_data_wrapper
 {
     struct product_info *data;
-    int lines;
+    size_t lines;
     size_t data_struct_size;
+    struct hash_index code_index;
 };
 
 
 /*
     Struct that holds all the available information about one quote of a product,
-    from the quotes input file.
+    from the quotes input file. Product code and retailer repeat in many quotes,
+    they are stored once in dictionaries and quotes hold their IDs.
 */
 struct quote_info
 {
-    char *p_id;         // Quote id
-    char *p_code;       // Product code
-    char *p_retailer;   // Retailer
-    int price;          // Price in cents
+    char *p_id;             // Quote id
+    uint32_t code_id;       // Product code in the code dictionary
+    uint32_t retailer_id;   // Retailer in the retailer dictionary
+    int64_t price;          // Price in cents
     int stock;          // Stock status and count
+    int shard;          // Index of the quotes file the quote was read from
 };
 
 
 /*
     Wrapper for struct quote_info. Has information about the structs size
     in bytes, how many entries (lines) exist and a pointer to the data array.
+    Quotes can be read from several files (shards), their names are kept for
+    saving changes back to the file each quote came from. alloc_limit is the
+    allocated length of the data array, when it is longer than lines. Quotes
+    are found by ID through id_index.
 */
 struct quote_data_wrapper
 {
     struct quote_info *data;
-    int lines;
+    size_t lines;
     size_t data_struct_size;
+    char **shard_names;
+    int shard_cnt;
+    size_t alloc_limit;
+    struct hash_index id_index;
 };
 
 
@@ -94,18 +115,19 @@ Description:    Creates a dynamically allocated string, with the exact length
                 is successful, copies the origin string over to the new string.
                 
 Parameters:     *orgn_str - Pointer to the origin string.
+                cls - Allocation class, that the string is accounted to.
                 
 Return:         Pointer to the new dynamic string, if allocation was successful.
                 NULL if allocation failed.
 */
-char *dynamic_string(char *orgn_str);
+char *dynamic_string(const char *orgn_str, enum alloc_classes cls);
 
 
 /*
 Description:    Frees all dynamically allocated memory, that is used for storing
-                the names, codes, and OS names of all the products. The number
-                of data entries to free and the pointer to the data array are
-                stored in the wrapper *pwd.
+                the names, codes, and OS names of all the products and the
+                product code index. The number of data entries to free and the
+                pointer to the data array are stored in the wrapper *pwd.
                 
 Parameters:     *pdw - Wrapper for the product data array.
                 
@@ -116,9 +138,11 @@ void free_product_info(struct product_data_wrapper *pdw);
 
 /*
 Description:    Frees all dynamically allocated memory, that is used for storing
-                the IDs, codes, and retailer names of all the quotes. The number
-                of data entries to free and the pointer to the data array are
-                stored in the wrapper *qdw.
+                the IDs of all the quotes and the names of the files they were
+                read from. Codes and retailer names are kept in dictionaries,
+                which are freed with free_dictionaries. The number of data
+                entries to free and the pointer to the data array are stored in
+                the wrapper *qdw.
                 
 Parameters:     *qdw - Wrapper for the quotes data array.
                 
@@ -153,14 +177,13 @@ int get_int(void);
 
 
 /*
-Description:    For every product in product data array, searches through all of
-                quote data array for matching product codes. If codes match
-                calls a function that prints the quotes info. In case of first
-                match calls function to print a header for quotes table. Also
-                adds and prints an entry for all quotes. If no quotes are
-                available prints no table and an appropriate message.
-                Before quotes also prints the products info and separates
-                different products with a line (hopefully easier to follow).
+Description:    For every product in product data array, prints the products
+                info and a numbered table of quotes with a matching product
+                code ID. If no quotes are available prints no table and an
+                appropriate message. Different products are separated with a
+                line (hopefully easier to follow). Quotes are grouped by product
+                once and the output is formatted in parallel, see
+                print_catalog_report.
                 
 Parameters:     pdw - Wrapper containing a pointer to product data array and its
                       length.
@@ -175,7 +198,8 @@ void display_quotes_by_product(struct product_data_wrapper pdw,
 
 /*
 Description:    Prompts the user for a product code. Product code is used to
-                search for the product. If matching product is found, user is
+                search for the product through the product code index of the
+                wrapper. If matching product is found, user is
                 prompted to enter a new RAM amount (value must be [0; INT_MAX]).
                 Old RAM amount is overwritten. Function also logs/prints
                 appropriate messages/errors.
@@ -193,10 +217,10 @@ int edit_product_ram(struct product_data_wrapper pdw);
 
 /*
 Description:    Prompts the user for a quote ID. Quote ID is used to search for
-                the quote. If matching quote is found, user is prompted to enter
-                the new name for the retailer. The new name is also a dynamic
-                char array. The old dynamically allocated string for the
-                retailer is freed and then replaced by the new one. Function
+                the quote through the quote ID index of the wrapper. If
+                matching quote is found, user is prompted to enter the new name
+                for the retailer. The new name is added to the retailer
+                dictionary and the quotes retailer ID is replaced. Function
                 also logs/prints appropriate messages/errors.
                 
 Parameters:     qdw - Wrapper containing a pointer to quote data array and its
@@ -229,23 +253,71 @@ Return:         On success a pointer to a dynamically allocated string.
 char *get_dynamic_input_string(FILE *stream);
 
 
+/*
+Description:    Finds the cheapest quote with available stock for a product.
+                Equal prices keep the first quote.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                code_id - Dictionary ID of the product code.
+                
+Return:         Pointer to quote. NULL if no quote has stock.
+*/
+struct quote_info *find_cheapest_quote(struct quote_data_wrapper qdw,
+                                       uint32_t code_id);
+
+
+/*
+Description:    Prints price, retailer and stock of a quote.
+                
+Parameters:     *min_price - Pointer to quote.
+                
+Return:         -
+*/
+void print_cheapest_offer(struct quote_info *min_price);
+
+
+struct trigram_index;
+
+/*
+Description:    Prints the products with names most similar to search_str and
+                the cheapest offer for each of them.
+                
+Parameters:     pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *ti - Pointer to trigram index of product names. May be NULL,
+                      then nothing is found.
+                *search_str - Search string.
+                
+Return:         SRCH_RES_POS if similar products were found, else SRCH_RES_NEG.
+*/
+int search_similar_products(struct product_data_wrapper pdw,
+                            struct quote_data_wrapper qdw,
+                            struct trigram_index *ti, char *search_str);
+
+
 /*
 Description:    Checks if user entered string matches any product name. If
                 product exists, checks if there are any quotes for it. If
-                quote(s) exist, prints the cheapest option.
+                quote(s) exist, prints the cheapest option. If no name matches
+                exactly, the most similar names are shown instead.
                 
 Parameters:     pdw - Wrapper containing a pointer to product data array and its
                       length.
                 qdw - Wrapper containing a pointer to quote data array and its
                       length.
+                *ti - Pointer to trigram index of product names. May be NULL.
                 
 Return:         SRCH_RES_INPUT_ERR - If there was an error with input string
                 memory allocation.
-                SRCH_RES_NEG - If product searched for does not exist.
+                SRCH_RES_NEG - If no product with a similar name exists.
                 SRCH_RES_NO_STOCK - If there is no stock for product.
-                SRCH_RES_POS - If the product exists and is in stock.
+                SRCH_RES_POS - If the product exists and is in stock, or
+                similar products were found.
 */
 int search_best_price(struct product_data_wrapper pdw,
-                       struct quote_data_wrapper qdw);
+                      struct quote_data_wrapper qdw, struct trigram_index *ti);
 
 #endif
@@ -0,0 +1,76 @@
+/*
+File:         metrics.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for metrics.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdint.h>
+#include <data_read_write.h>
+
+#define METRICS_INTERVAL_S 10
+#define METRICS_TMP_SUFFIX ".tmp"
+#define METRICS_NS_PER_S 1000000000.0
+
+// Counters, that only grow
+enum metric_counters {MET_PRODUCT_ROWS, MET_QUOTE_ROWS, MET_QUERIES,
+                      MET_QUERY_ROWS, MET_EDITS, MET_SAVES, MET_SAVE_NS,
+                      MET_COUNTER_CNT};
+
+// Gauges, that are set to the current value
+enum metric_gauges {MET_G_PRODUCTS, MET_G_QUOTES, MET_G_VERSION,
+                    MET_GAUGE_CNT};
+
+
+/*
+Description:    Adds to a counter. Lock-free, any thread can call it.
+                
+Parameters:     counter - Counter.
+                n - Amount to add.
+                
+Return:         -
+*/
+void metrics_add(enum metric_counters counter, uint64_t n);
+
+
+/*
+Description:    Sets a gauge. Lock-free, any thread can call it.
+                
+Parameters:     gauge - Gauge.
+                value - New value.
+                
+Return:         -
+*/
+void metrics_set(enum metric_gauges gauge, uint64_t value);
+
+
+/*
+Description:    Counts a data line, that had a read error.
+                
+Parameters:     err - Read error code.
+                
+Return:         -
+*/
+void metrics_read_error(enum read_errors err);
+
+
+/*
+Description:    Starts writing metrics snapshots in Prometheus text format
+                into a file every METRICS_INTERVAL_S seconds on a separate
+                thread. A snapshot is written into a temporary file, that is
+                renamed over the metrics file, so a reader never sees a
+                partial one. The last snapshot is written at exit. Handles log
+                writing and error printing.
+                
+Parameters:     *f_name - Pointer to string containing metrics file name.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if the first snapshot can
+                not be written or the thread can not be started.
+*/
+int metrics_open(char *f_name);
+
+#endif
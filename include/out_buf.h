@@ -0,0 +1,99 @@
+/*
+File:         out_buf.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for out_buf.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _OUT_BUF_H
+#define _OUT_BUF_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define OUT_BUF_MIN_ALLOC 4096
+
+/*
+    Output target of the formatting functions. Either a growing memory buffer
+    or, when fp is set, a stream that is written directly. If memory could not
+    be allocated, err is set and further output is dropped.
+*/
+struct out_buf
+{
+    char *data;
+    size_t len;
+    size_t cap;
+    FILE *fp;
+    int err;
+};
+
+// Output buffer that writes straight to a stream
+#define OUT_BUF_FILE(stream) {NULL, 0, 0, stream, 0}
+
+/*
+Description:    Initializes an empty memory buffer.
+                
+Parameters:     *ob - Pointer to output buffer.
+                
+Return:         -
+*/
+void out_buf_init(struct out_buf *ob);
+
+
+/*
+Description:    Appends printf formatted text to the buffer.
+                
+Parameters:     *ob - Pointer to output buffer.
+                *fmt - Format string, followed by its arguments.
+                
+Return:         -
+*/
+void buf_printf(struct out_buf *ob, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+
+/*
+Description:    Appends a string to the buffer.
+                
+Parameters:     *ob - Pointer to output buffer.
+                *str - String.
+                
+Return:         -
+*/
+void buf_puts(struct out_buf *ob, const char *str);
+
+
+/*
+Description:    Appends a char to the buffer.
+                
+Parameters:     *ob - Pointer to output buffer.
+                c - Char.
+                
+Return:         -
+*/
+void buf_putc(struct out_buf *ob, char c);
+
+
+/*
+Description:    Writes the contents of a memory buffer to a stream and empties
+                the buffer. Memory is kept for reuse.
+                
+Parameters:     *ob - Pointer to output buffer.
+                *fp - Stream.
+                
+Return:         -
+*/
+void out_buf_flush(struct out_buf *ob, FILE *fp);
+
+
+/*
+Description:    Frees the memory of the buffer.
+                
+Parameters:     *ob - Pointer to output buffer.
+                
+Return:         -
+*/
+void out_buf_free(struct out_buf *ob);
+
+#endif
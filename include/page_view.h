@@ -0,0 +1,85 @@
+/*
+File:         page_view.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for page_view.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _PAGE_VIEW_H
+#define _PAGE_VIEW_H
+
+#include <main.h>
+#include <report.h>
+
+#define PAGE_SIZE_MAX 10000
+#define PAGE_STARTS_MIN_ALLOC 16
+
+// Page navigation options
+enum page_options {PAGE_OPT_MENU, PAGE_OPT_NEXT, PAGE_OPT_PREV, PAGE_OPT_CNT};
+
+/*
+    What products are shown. Products are in data file order, those outside
+    the product code range are skipped. NULL code bound means no limit.
+*/
+struct page_query
+{
+    int page_size;
+    int offset;                 // Matching products skipped before page 1
+    char *code_from;
+    char *code_to;
+};
+
+
+/*
+    State of browsing. starts[k] is the product index, where scanning for page
+    k starts, so moving between pages never scans from the beginning again.
+*/
+struct page_view
+{
+    struct product_data_wrapper pdw;
+    struct quote_data_wrapper qdw;
+    struct quote_groups *groups;
+    struct page_query query;
+    size_t *starts;
+    int start_cnt;
+    int alloc_limit;
+};
+
+
+/*
+Description:    Prints page number page of the products matching the query,
+                with their quotes. Only products of the page (and the ones
+                skipped because of the code range) are looked at.
+                
+Parameters:     *pv - Pointer to page view.
+                *ob - Output buffer, where data is printed.
+                page - Page number, starting from 0. Every earlier page must
+                       have been printed before.
+                *has_more - Pointer to variable, set to 1 if there are products
+                            after the page, 0 if not.
+                
+Return:         Number of products printed. -1 on memory allocation error.
+*/
+int print_page(struct page_view *pv, struct out_buf *ob, int page,
+               int *has_more);
+
+
+/*
+Description:    Prompts user for page size, offset and product code range and
+                lets the user move between pages of products and their quotes
+                until going back to the menu.
+                
+Parameters:     pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *qg - Pointer to quotes grouped by product code ID.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int browse_catalog_pages(struct product_data_wrapper pdw,
+                         struct quote_data_wrapper qdw,
+                         struct quote_groups *qg);
+
+#endif
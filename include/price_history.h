@@ -0,0 +1,184 @@
+/*
+File:         price_history.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for price_history.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _PRICE_HISTORY_H
+#define _PRICE_HISTORY_H
+
+#include <stdint.h>
+#include <main.h>
+#include <hash_index.h>
+
+#define HISTORY_MAGIC "PWHIST1"
+#define HISTORY_MAGIC_LEN 8
+#define HISTORY_MIN_ALLOC 64
+#define HISTORY_DELTA_MIN_ALLOC 16
+#define HISTORY_TMP_SUFFIX ".tmp"
+#define VARINT_MAX_LEN 10
+
+/*
+    Price and stock of one quote at one snapshot.
+*/
+struct history_sample
+{
+    int snapshot;
+    int64_t price;
+    int stock;
+};
+
+
+/*
+    History of one quote. Samples are stored as varints in *deltas: the number
+    of snapshots since the previous sample, then the zigzag encoded change in
+    price and stock. The first sample is relative to snapshot 0, price 0 and
+    stock 0. The last sample is also kept decoded for appending.
+*/
+struct history_entry
+{
+    char *q_id;
+    char *p_code;
+    int samples;
+    struct history_sample last;
+    int64_t next_in_product;        // Next entry with same code, -1 if none
+    unsigned char *deltas;
+    size_t delta_len;
+    size_t delta_cap;
+};
+
+
+/*
+    All known quote histories. Entries are found by quote ID and, through a
+    chain of entries with the same product code, by product code.
+*/
+struct price_history
+{
+    struct history_entry *entries;
+    size_t entry_cnt;
+    size_t alloc_limit;
+    int snapshot_cnt;
+    int64_t *snapshot_times;        // Unix time of every snapshot
+    struct hash_index by_id;
+    struct hash_index by_product;   // Product code -> first entry
+};
+
+
+/*
+    Position while decoding the samples of one history entry.
+*/
+struct history_cursor
+{
+    const unsigned char *pos;
+    const unsigned char *end;
+    struct history_sample sample;
+};
+
+
+/*
+Description:    Initializes an empty price history.
+                
+Parameters:     *ph - Pointer to price history.
+                
+Return:         -
+*/
+void history_init(struct price_history *ph);
+
+
+/*
+Description:    Reads price history from file f_name. A missing file is not an
+                error, history stays empty (first run). Handles log writing and
+                error printing.
+                
+Parameters:     *f_name - Pointer to string containing file name.
+                *ph - Pointer to initialized, empty price history.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if file is damaged or memory
+                could not be allocated.
+*/
+int load_price_history(char *f_name, struct price_history *ph);
+
+
+/*
+Description:    Writes price history into a temporary file and then renames it
+                to f_name, so an interrupted save never damages the history.
+                
+Parameters:     *f_name - Pointer to string containing file name.
+                *ph - Pointer to price history.
+                
+Return:         CSV_WRITE_OK or CSV_WRITE_FOPEN_ERR.
+*/
+int save_price_history(char *f_name, struct price_history *ph);
+
+
+/*
+Description:    Adds the current price and stock of every quote as a new
+                snapshot. Quotes not seen before get a new entry. If a quote ID
+                appears more than once, only the first one is recorded.
+                
+Parameters:     *ph - Pointer to price history.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int history_add_snapshot(struct price_history *ph, struct quote_data_wrapper qdw);
+
+
+/*
+Description:    Sets cursor to the start of an entries samples.
+                
+Parameters:     *cur - Pointer to cursor.
+                *he - Pointer to history entry.
+                
+Return:         -
+*/
+void history_cursor_init(struct history_cursor *cur, struct history_entry *he);
+
+
+/*
+Description:    Decodes the next sample into cur->sample.
+                
+Parameters:     *cur - Pointer to cursor.
+                
+Return:         1 if a sample was decoded, 0 if there are no more samples.
+*/
+int history_cursor_next(struct history_cursor *cur);
+
+
+/*
+Description:    Prompts user for a quote ID and prints every recorded price and
+                stock of the quote with the change from the previous snapshot.
+                
+Parameters:     *ph - Pointer to price history.
+                
+Return:         SRCH_RES_POS, SRCH_RES_NEG or SRCH_RES_INPUT_ERR.
+*/
+int show_quote_price_trend(struct price_history *ph);
+
+
+/*
+Description:    Prompts user for a product code and a number of snapshots N.
+                Prints the lowest price any quote of the product had in the
+                last N snapshots.
+                
+Parameters:     *ph - Pointer to price history.
+                
+Return:         SRCH_RES_POS, SRCH_RES_NEG or SRCH_RES_INPUT_ERR.
+*/
+int show_lowest_recent_price(struct price_history *ph);
+
+
+/*
+Description:    Frees all memory used by price history.
+                
+Parameters:     *ph - Pointer to price history.
+                
+Return:         -
+*/
+void free_price_history(struct price_history *ph);
+
+#endif
@@ -0,0 +1,110 @@
+/*
+File:         product_bulk_edit.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for product_bulk_edit.c. Data struct definitions,
+              macros etc.
+*/
+
+#ifndef _PRODUCT_BULK_EDIT_H
+#define _PRODUCT_BULK_EDIT_H
+
+#include <main.h>
+
+// Bulk edit file fields. Index of first field is 1
+#define CSV_EDIT_FIELD_CODE 1
+#define CSV_EDIT_FIELD_RAM  2
+#define CSV_EDIT_FIELD_SCRN 3
+#define CSV_EDIT_FIELD_NAME 4
+#define CSV_EDIT_FIELD_OS   5
+#define CSV_EDIT_FIELD_CNT  5
+
+/*
+    Counts of rows applied from a bulk edit file.
+*/
+struct bulk_edit_summary
+{
+    size_t rows;
+    size_t edited;      // Products with at least one changed field
+    size_t fields;      // Changed fields in total
+    size_t not_found;   // Rows with unknown product code
+    size_t invalid;     // Rows with invalid values, not applied
+};
+
+
+/*
+Description:    Builds the product code index of the wrapper, so products can
+                be found by code without going through the whole array. If a
+                code appears more than once, the first product is indexed.
+                
+Parameters:     *pdw - Pointer to a wrapper for product info array.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if memory allocation failed.
+*/
+int build_product_code_index(struct product_data_wrapper *pdw);
+
+
+/*
+Description:    Finds a product by its code using the product code index.
+                
+Parameters:     pdw - Wrapper containing product data array and its index.
+                *p_code - Product code.
+                
+Return:         Index of the product in the data array or HASH_NOT_FOUND.
+*/
+int64_t find_product_by_code(struct product_data_wrapper pdw, char *p_code);
+
+
+/*
+Description:    Applies every row of a bulk edit file in one pass. Every line
+                is: <code>; <RAM>; <screen size>; <name>; <OS>. Only the code
+                is required, empty or missing fields are left unchanged. If
+                the first line has product column names (header row), fields
+                are read by name in the order of the header instead, columns
+                the header does not name are left unchanged and unknown ones
+                are skipped. A header without the code column is an error
+                and nothing is applied. A row with an invalid RAM or screen
+                size value is not applied and an error with the line number is
+                printed. Successful edits are not logged one by one, a summary
+                is logged at the end.
+                
+Parameters:     *f_name - Pointer to string containing bulk edit file name.
+                *pdw - Pointer to a wrapper for product info array.
+                *summary - Pointer to struct, where row counts are stored.
+                
+Return:         EXIT_SUCCESS (0) if the file was read. EXIT_FAILURE if it
+                could not be read or memory allocation failed, rows before the
+                error stay applied.
+*/
+int apply_product_bulk_edit(char *f_name, struct product_data_wrapper *pdw,
+                            struct bulk_edit_summary *summary);
+
+
+/*
+Description:    Prompts the user for a bulk edit file name, applies it with
+                apply_product_bulk_edit and, if anything changed, saves the
+                products file once. Prints the summary.
+                
+Parameters:     *pdw - Pointer to a wrapper for product info array.
+                *f_pro - Products file name, where changes are saved.
+                
+Return:         EDIT_OK if products were changed, even if saving failed,
+                EDIT_NO_MATCH if nothing was changed, EDIT_MALLOC if reading
+                input failed.
+*/
+int apply_product_bulk_edit_prompt(struct product_data_wrapper *pdw,
+                                   char *f_pro);
+
+
+/*
+Description:    Logs and prints a summary of a bulk edit.
+                
+Parameters:     *f_name - Bulk edit file name.
+                summary - Counts of applied rows.
+                
+Return:         -
+*/
+void print_bulk_edit_summary(char *f_name, struct bulk_edit_summary summary);
+
+#endif
@@ -0,0 +1,183 @@
+/*
+File:         query.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for query_parse.c and query_exec.c. Data struct
+              definitions, macros etc.
+*/
+
+#ifndef _QUERY_H
+#define _QUERY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <main.h>
+#include <out_buf.h>
+
+#define QUERY_BATCH 1024            // Rows filtered at a time
+#define QUERY_ITEMS_MAX 16
+#define QUERY_PREDS_MAX 16
+#define QUERY_VALUE_LEN 128
+#define QUERY_ERR_LEN 256
+#define QUERY_ROWS_MIN_ALLOC 1024
+#define QUERY_GROUPS_MIN_ALLOC 64
+#define QUERY_CELL_LEN 512
+#define QUERY_NO_LIMIT -1
+
+// Query return values
+#define QUERY_OK            0
+#define QUERY_SYNTAX_ERR    1
+#define QUERY_MALLOC_ERR    2
+
+enum query_tables {QUERY_PRODUCTS, QUERY_QUOTES};
+
+// Fields of products and quotes, code is in both
+enum query_fields {QF_CODE, QF_NAME, QF_OS, QF_RAM, QF_SCREEN, QF_ID,
+                   QF_RETAILER, QF_PRICE, QF_STOCK, QF_CNT};
+
+// How field values are stored, QT_PRICE is cents shown as euros
+enum query_types {QT_STR, QT_DICT, QT_INT, QT_FLOAT, QT_PRICE};
+
+enum query_ops {QOP_EQ, QOP_NE, QOP_LT, QOP_LE, QOP_GT, QOP_GE, QOP_CONTAINS};
+
+enum query_aggs {QAGG_NONE, QAGG_COUNT, QAGG_SUM, QAGG_MIN, QAGG_MAX,
+                 QAGG_AVG};
+
+struct query_field_desc
+{
+    const char *name;
+    enum query_tables table;
+    enum query_types type;
+};
+
+extern const struct query_field_desc query_fields[QF_CNT];
+
+/*
+    Filter "field op value". Numbers are in the fields own unit (prices in
+    cents). For dictionary fields dict_id is the ID of the value, DICT_NO_ID
+    if no row has it.
+*/
+struct query_pred
+{
+    enum query_fields field;
+    enum query_ops op;
+    double num;
+    char str[QUERY_VALUE_LEN];
+    uint32_t dict_id;
+};
+
+/*
+    Selected column or sort key: a field, or an aggregate of a field.
+    COUNT(*) has no field (star is set).
+*/
+struct query_item
+{
+    enum query_aggs agg;
+    enum query_fields field;
+    int star;
+};
+
+/*
+    Parsed query. With join every quote is matched with the product of its
+    code (the first product, if several have the same code), so quotes are
+    always the scanned table and product filters are applied to products
+    before the scan.
+*/
+struct query
+{
+    enum query_tables from;
+    int join;
+    struct query_item items[QUERY_ITEMS_MAX];
+    int item_cnt;
+    struct query_pred preds[QUERY_PREDS_MAX];
+    int pred_cnt;
+    int has_aggs;
+    int group_by;                   // enum query_fields, -1 if none
+    int order_set;
+    int order_desc;
+    struct query_item order;
+    long limit;                     // QUERY_NO_LIMIT if none
+};
+
+
+/*
+Description:    Parses a query. Keywords and field names are case insensitive.
+                
+                SELECT <items> FROM <table> [JOIN <table>]
+                [WHERE <field> <op> <value> [AND ...]] [GROUP BY <field>]
+                [ORDER BY <item> [ASC | DESC]] [LIMIT <n>]
+                
+                Tables are products and quotes. Items are *, fields or
+                aggregates COUNT(*), COUNT, SUM, MIN, MAX and AVG of a field.
+                Operators are =, !=, <, <=, >, >= and ~ (contains, ignoring
+                case). Prices are given in euros. Values with spaces or
+                operator characters are quoted with ' or ".
+                
+Parameters:     *text - Pointer to query string.
+                *q - Pointer to query, where the result is stored.
+                *err - Pointer to string, where a syntax error is described.
+                err_len - Length of the error string.
+                
+Return:         QUERY_OK or QUERY_SYNTAX_ERR.
+*/
+int query_parse(const char *text, struct query *q, char *err, size_t err_len);
+
+
+/*
+Description:    Runs a parsed query over products and quotes and prints the
+                result table. Filters are applied to batches of QUERY_BATCH
+                rows, one filter at a time over the rows left by the ones
+                before. Aggregates are accumulated during the scan, groups are
+                found by dictionary ID (code, retailer) or through a hash index
+                (other text fields). Groups of number fields are formed by
+                sorting the matching rows.
+                
+Parameters:     *q - Pointer to parsed query.
+                pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *ob - Output buffer, where the result is printed.
+                *row_cnt - Pointer to variable, where the number of result rows
+                           is stored.
+                
+Return:         QUERY_OK or QUERY_MALLOC_ERR.
+*/
+int query_execute(struct query *q, struct product_data_wrapper pdw,
+                  struct quote_data_wrapper qdw, struct out_buf *ob,
+                  size_t *row_cnt);
+
+
+/*
+Description:    Parses and runs a query and prints the result to standard
+                output. Handles log writing and error printing.
+                
+Parameters:     pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *text - Pointer to query string.
+                
+Return:         QUERY_OK, QUERY_SYNTAX_ERR or QUERY_MALLOC_ERR.
+*/
+int run_query(struct product_data_wrapper pdw, struct quote_data_wrapper qdw,
+              const char *text);
+
+
+/*
+Description:    Asks the user for a query and runs it. A syntax error is shown
+                and the user is returned to the menu.
+                
+Parameters:     pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on input or memory allocation
+                error.
+*/
+int run_query_prompt(struct product_data_wrapper pdw,
+                     struct quote_data_wrapper qdw);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+File:         quote_delta.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for quote_delta.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _QUOTE_DELTA_H
+#define _QUOTE_DELTA_H
+
+#include <main.h>
+
+// Delta file operations, first field of every line
+#define DELTA_OP_INSERT 'I'
+#define DELTA_OP_UPDATE 'U'
+#define DELTA_OP_DELETE 'D'
+
+/*
+    Counts of changes applied from a delta file.
+*/
+struct delta_summary
+{
+    size_t inserted;
+    size_t updated;
+    size_t deleted;
+    size_t missing;     // Deletes of quotes that did not exist
+};
+
+
+/*
+Description:    Builds the quote ID index of the wrapper, so quotes can be
+                found by ID without going through the whole array. If an ID
+                appears more than once, the first quote with the ID is indexed.
+                
+Parameters:     *qdw - Pointer to a wrapper for quote info array.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if memory allocation failed.
+*/
+int build_quote_id_index(struct quote_data_wrapper *qdw);
+
+
+/*
+Description:    Finds a quote by its ID using the quote ID index.
+                
+Parameters:     qdw - Wrapper containing quote data array and its ID index.
+                *q_id - Quote ID.
+                
+Return:         Index of the quote in the data array or HASH_NOT_FOUND.
+*/
+int64_t find_quote_by_id(struct quote_data_wrapper qdw, char *q_id);
+
+
+/*
+Description:    Applies a delta file of quote changes to loaded quotes. Every
+                line starts with an operation followed by the quote fields in
+                the same order as in the quotes file:
+                    I; <id>; <code>; <retailer>; <price>; <stock>  - insert
+                    U; <id>; <code>; <retailer>; <price>; <stock>  - update
+                    D; <id>                                        - delete
+                Insert and update both replace an existing quote or add a new
+                one (upsert). Each change is found through the quote ID index,
+                so applying the changes costs only the size of the delta. From
+                the menu the quotes and their ID index are first copied for a
+                new catalog version by catalog_update_begin, so there the cost
+                also grows with the number of quotes. A deleted quote is
+                replaced by the last quote of the array. New quotes are
+                saved to the first quotes file. Reading stops at the first
+                fatal error, changes made until then are kept.
+                
+Parameters:     *f_name - Pointer to string containing delta file name.
+                *qdw - Pointer to a wrapper for quote info array.
+                *summary - Pointer to struct, where change counts are stored.
+                
+Return:         EXIT_SUCCESS (0) if the whole file was applied. Otherwise
+                EXIT_FAILURE.
+*/
+int apply_quote_delta(char *f_name, struct quote_data_wrapper *qdw,
+                      struct delta_summary *summary);
+
+
+/*
+Description:    Prompts the user for a delta file name and applies it with
+                apply_quote_delta. Prints and logs a summary.
+                
+Parameters:     *qdw - Pointer to a wrapper for quote info array.
+                
+Return:         EDIT_OK if any quote was changed, EDIT_NO_MATCH if nothing was
+                changed, EDIT_MALLOC if reading input failed.
+*/
+int apply_quote_delta_prompt(struct quote_data_wrapper *qdw);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+File:         quote_shards.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for quote_shards.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _QUOTE_SHARDS_H
+#define _QUOTE_SHARDS_H
+
+#include <main.h>
+
+#define SHARD_THREADS_MAX 16
+#define SHARD_NAMES_MIN_ALLOC 8
+#define SHARD_GLOB_CHARS "*?["
+#define SHARD_PATH_MAX_LEN 1024
+
+/*
+    One quotes file (shard) and the data that was read from it. status is the
+    return value of read_data_quotes for the file.
+*/
+struct shard_job
+{
+    char *f_name;
+    struct quote_data_wrapper qdw;
+    int status;
+};
+
+
+/*
+Description:    Turns quote sources given on the command line into a list of
+                quote file names. A source is either a file, a directory (every
+                regular, non hidden file in it is used, in alphabetical order)
+                or a glob pattern (when it contains any of SHARD_GLOB_CHARS).
+                Names are dynamically allocated, the list must be freed by the
+                caller, also on failure.
+                
+Parameters:     **sources - Array of quote source strings.
+                src_cnt - Number of quote sources.
+                ***f_names - Pointer, that will be pointed to the name list.
+                *f_cnt - Pointer to the number of names in the list.
+                
+Return:         EXIT_SUCCESS (0) if at least one file was found and all memory
+                was allocated. Otherwise EXIT_FAILURE.
+*/
+int expand_quote_sources(char **sources, int src_cnt, char ***f_names,
+                         int *f_cnt);
+
+
+/*
+Description:    Reads every quotes file from sources. Each file is read on its
+                own thread (at most SHARD_THREADS_MAX at a time) with
+                read_data_quotes, so error messages keep the line numbers of
+                the file they occurred in. Results are merged in the order of
+                the file list into one data array. Every quote remembers the
+                index of its file, the file names are moved into the wrapper.
+                
+Parameters:     **sources - Array of quote source strings (files, directories
+                            or glob patterns).
+                src_cnt - Number of quote sources.
+                *qdw - Pointer to a wrapper for quote info array.
+                
+Return:         EXIT_SUCCESS (0) if all data was read successfully. Otherwise
+                EXIT_FAILURE. Whatever was read is stored in the wrapper in both
+                cases, so it can be freed with free_quote_info.
+*/
+int read_data_quote_shards(char **sources, int src_cnt,
+                           struct quote_data_wrapper *qdw);
+
+#endif
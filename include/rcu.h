@@ -0,0 +1,106 @@
+/*
+File:         rcu.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for rcu.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _RCU_H
+#define _RCU_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define RCU_READERS_MAX 64
+#define RCU_RETIRE_MIN_ALLOC 32
+#define RCU_QUIESCENT 0         // Reader epoch, when not in a read section
+
+/*
+    Read side state of one thread. epoch is the global epoch at the start of
+    the threads current read section or RCU_QUIESCENT.
+*/
+struct rcu_reader
+{
+    _Atomic uint64_t epoch;
+    atomic_int in_use;
+    int depth;                  // Nesting of read sections, owner thread only
+};
+
+
+/*
+    Memory retired by a writer. It is freed with free_fn, when no reader, that
+    started at or before epoch, is still in its read section.
+*/
+struct rcu_retired
+{
+    void *ptr;
+    void (*free_fn)(void *);
+    uint64_t epoch;
+};
+
+
+/*
+Description:    Starts a read section for the calling thread. Memory retired
+                after the section started is not freed before the section ends.
+                Sections can be nested. The thread is registered as a reader on
+                first use and unregistered when it exits. Never blocks, unless
+                all RCU_READERS_MAX reader slots are in use.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void rcu_read_lock(void);
+
+
+/*
+Description:    Ends a read section started with rcu_read_lock. Pointers read
+                inside the section must not be used after it.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void rcu_read_unlock(void);
+
+
+/*
+Description:    Retires memory, that is no longer reachable for new readers.
+                Memory is freed by a later rcu_reclaim or rcu_synchronize, when
+                every reader that could still see it has finished. If the
+                retire list can not grow, waits for readers and frees memory
+                right away.
+                
+Parameters:     *ptr - Pointer to memory. NULL is ignored.
+                free_fn - Function that frees the memory.
+                
+Return:         -
+*/
+void rcu_retire(void *ptr, void (*free_fn)(void *));
+
+
+/*
+Description:    Frees retired memory, that no reader can see anymore. Does not
+                wait for readers.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void rcu_reclaim(void);
+
+
+/*
+Description:    Waits until every read section, that was running when the
+                function was called, has ended. Then frees all memory retired
+                before the call, and the list of retired memory if nothing is
+                left in it. Must not be called inside a read section.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void rcu_synchronize(void);
+
+#endif
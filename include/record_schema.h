@@ -0,0 +1,158 @@
+/*
+File:         record_schema.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for record_schema.c. Column tables of the data files,
+              data struct definitions, macros etc.
+*/
+
+#ifndef _RECORD_SCHEMA_H
+#define _RECORD_SCHEMA_H
+
+#include <stdio.h>
+#include <alloc_acct.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+
+#define SCHEMA_COLS_MAX 16
+#define CSV_FIELDS_MAX 64
+
+// Header row detection results
+#define HEADER_NONE         0
+#define HEADER_FOUND        1
+#define HEADER_MISSING_COL  2
+
+/*
+    Column tables. Every data file layout is described once here and the
+    parse and write routines are generated from it. Columns are in the order
+    they are written and in the order of a file without a header row.
+
+    X(col, name, kind, member, arg1, arg2)
+    col - enum value of the column.
+    name - column name in a header row.
+    kind - how the field is stored:
+        STR - dynamic string.
+        STR_DICT - dynamic string and its ID in dictionary arg1, stored in
+                   member arg2.
+        DICT - ID in dictionary arg1.
+        INT - integer, arg1 is the read error for a non integer value and arg2
+              for a negative value. Invalid values are set to 0.
+        INT64 - 64-bit integer, errors like for INT. Values out of its range
+                are not integers.
+        FLOAT - float, errors like for INT.
+    member - field of the record struct.
+*/
+#define PRODUCT_COLUMNS(X)                                                     \
+    X(PRO_COL_CODE, "code", STR_DICT, p_code, DICT_CODE, code_id)              \
+    X(PRO_COL_NAME, "name", STR, p_name, 0, 0)                                 \
+    X(PRO_COL_RAM, "ram", INT, ram, READ_ERR_RAM_NINT, READ_ERR_RAM_NEG)       \
+    X(PRO_COL_SCRN, "screen_size", FLOAT, screen_size, READ_ERR_SCRNS_NFLOAT,  \
+      READ_ERR_SCRNS_NEG)                                                      \
+    X(PRO_COL_OS, "os", STR, p_os, 0, 0)
+
+#define QUOTE_COLUMNS(X)                                                       \
+    X(QTE_COL_ID, "id", STR, p_id, 0, 0)                                       \
+    X(QTE_COL_CODE, "code", DICT, code_id, DICT_CODE, 0)                       \
+    X(QTE_COL_RTLR, "retailer", DICT, retailer_id, DICT_RETAILER, 0)           \
+    X(QTE_COL_PRICE, "price", INT64, price, READ_ERR_PRICE_NINT,               \
+      READ_ERR_PRICE_NEG)                                                      \
+    X(QTE_COL_STOCK, "stock", INT, stock, READ_ERR_STOCK_NINT,                 \
+      READ_ERR_STOCK_NEG)
+
+#define COLUMN_ENUM(col, name, kind, member, arg1, arg2) col,
+
+enum product_columns {PRODUCT_COLUMNS(COLUMN_ENUM) PRO_COL_CNT};
+enum quote_columns {QUOTE_COLUMNS(COLUMN_ENUM) QTE_COL_CNT};
+
+/*
+    Description of one record type. parse fills a record from the fields of a
+    data line. col_map has the field index of every column. print_field writes
+    one column of a record like the CSV line writers do.
+*/
+struct record_schema
+{
+    const char *name;
+    int col_cnt;
+    const char *const *col_names;
+    size_t record_size;
+    enum alloc_classes arr_class;   // Accounting class of the data array
+    enum alloc_classes str_class;   // Accounting class of string fields
+    int (*parse)(void *rec, char **fields, int field_cnt, const int *col_map);
+    void (*print_field)(FILE *fp, const void *rec, int col);
+};
+
+extern const struct record_schema product_schema;
+extern const struct record_schema quote_schema;
+
+
+/*
+Description:    Sets column map for a file without a header row. Columns are in
+                the order of the column table.
+                
+Parameters:     *schema - Record schema.
+                *col_map - Array of SCHEMA_COLS_MAX field indexes.
+                
+Return:         -
+*/
+void default_column_map(const struct record_schema *schema, int *col_map);
+
+
+/*
+Description:    Finds the column with a name. Case and trailing spaces of the
+                name are ignored like in a header row.
+                
+Parameters:     *schema - Record schema.
+                *name - Column name, usually a header field.
+                
+Return:         Index of the column or -1 if the schema has no such column.
+*/
+int find_column(const struct record_schema *schema, const char *name);
+
+
+/*
+Description:    Checks if the fields of the first line of a file are column
+                names. If they are, maps every column to the field with its
+                name (case insensitive). Columns can be in any order, fields
+                with unknown names are skipped. A line where most, but not all
+                columns are named, is a header with missing columns.
+                
+Parameters:     *schema - Record schema.
+                **fields - Fields of the first line.
+                field_cnt - Number of fields.
+                *col_map - Array of SCHEMA_COLS_MAX field indexes. Changed only
+                           if a header is found.
+                *missing - Pointer to variable, where the index of the first
+                           missing column is stored.
+                
+Return:         HEADER_NONE, HEADER_FOUND or HEADER_MISSING_COL.
+*/
+int map_header_columns(const struct record_schema *schema, char **fields,
+                       int field_cnt, int *col_map, int *missing);
+
+
+/*
+Description:    Prints product info from struct pi into file pointed by *fp.
+                Data is separated by CSV_DELIMITER and in the order of the
+                product column table.
+                
+Parameters:     pi - Struct holding all the data necessary for printing.
+                
+Return:         -
+*/
+void print_product_csv_line(FILE *fp, struct product_info pi);
+
+
+/*
+Description:    Prints quote info from struct qi into file pointed by *fp.
+                Data is separated by CSV_DELIMITER and in the order of the
+                quote column table.
+                
+Parameters:     qi - Struct holding all the data necessary for printing.
+                
+Return:         -
+*/
+void print_quote_csv_line(FILE *fp, struct quote_info qi);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+File:         report.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for report.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _REPORT_H
+#define _REPORT_H
+
+#include <stdio.h>
+#include <main.h>
+#include <out_buf.h>
+
+#define REPORT_THREADS_MAX 16
+#define REPORT_CHUNK_PRODUCTS 1024      // Products formatted as one job
+#define REPORT_CHUNKS_PER_THREAD 4      // Jobs per thread before writing
+
+/*
+    Quotes grouped by product code ID. Quotes of code ID c are
+    quotes[first[c]] ... quotes[first[c + 1] - 1], as indexes into the quote
+    data array in their original order.
+*/
+struct quote_groups
+{
+    size_t *first;
+    size_t *quotes;
+    uint32_t group_cnt;
+};
+
+
+/*
+Description:    Groups quotes by their product code ID with a counting sort, so
+                quotes of a product are found without going through all quotes.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *qg - Pointer to quote groups, where the result is stored.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int build_quote_groups(struct quote_data_wrapper qdw, struct quote_groups *qg);
+
+
+/*
+Description:    Returns the quotes of a product code ID.
+                
+Parameters:     *qg - Pointer to quote groups.
+                code_id - Product code ID.
+                *cnt - Pointer to variable, where the number of quotes is
+                       stored.
+                
+Return:         Pointer to quote indexes. NULL if there are none.
+*/
+size_t *get_quote_group(struct quote_groups *qg, uint32_t code_id,
+                        size_t *cnt);
+
+
+/*
+Description:    Frees the memory of quote groups.
+                
+Parameters:     *qg - Pointer to quote groups.
+                
+Return:         -
+*/
+void free_quote_groups(struct quote_groups *qg);
+
+
+/*
+Description:    Prints the report of one product: its specs and a numbered
+                table of its quotes or a message, that it has none. A separator
+                line follows every product except the last one.
+                
+Parameters:     *ob - Output buffer, where data is printed.
+                pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                *qg - Pointer to quotes grouped by product code ID.
+                i - Index of the product.
+                
+Return:         -
+*/
+void print_product_report(struct out_buf *ob, struct product_data_wrapper pdw,
+                          struct quote_data_wrapper qdw,
+                          struct quote_groups *qg, size_t i);
+
+
+/*
+Description:    Prints the report of every product into a stream. Chunks of
+                REPORT_CHUNK_PRODUCTS products are formatted in parallel into
+                their own buffers, that are written in order, so output is the
+                same as printing products one by one. Handles log writing and
+                error printing.
+                
+Parameters:     *fp - Stream.
+                pdw - Wrapper containing a pointer to product data array and its
+                      length.
+                qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int print_catalog_report(FILE *fp, struct product_data_wrapper pdw,
+                         struct quote_data_wrapper qdw);
+
+#endif
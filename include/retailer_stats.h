@@ -0,0 +1,81 @@
+/*
+File:         retailer_stats.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for retailer_stats.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _RETAILER_STATS_H
+#define _RETAILER_STATS_H
+
+#include <stdint.h>
+#include <main.h>
+#include <out_buf.h>
+
+#define STATS_THREADS_MAX 16
+#define STATS_MIN_QUOTES_PER_THREAD 65536
+
+/*
+    Aggregates of the quotes of one retailer.
+*/
+struct retailer_stats
+{
+    uint32_t retailer_id;
+    int64_t quotes;
+    int64_t stock;              // Sum of stock of all quotes
+    int64_t in_stock;           // Quotes with stock > 0
+    int64_t price_sum;
+    int64_t min_price;
+    int64_t max_price;
+};
+
+
+/*
+Description:    Aggregates quotes by retailer in one pass over the quote array.
+                Retailers are dictionary IDs, so aggregates are kept in an array
+                indexed by retailer ID instead of a hash table. Large quote
+                arrays are split between threads, that aggregate into their own
+                arrays, which are merged afterwards.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                **stats - Pointer to array pointer, where the dynamically
+                          allocated aggregates of retailers with quotes are
+                          stored, sorted by retailer name.
+                *cnt - Pointer to variable, where the number of retailers is
+                       stored.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int aggregate_retailers(struct quote_data_wrapper qdw,
+                        struct retailer_stats **stats, uint32_t *cnt);
+
+
+/*
+Description:    Prints a table with quote count, total stock, in stock ratio and
+                minimum, average and maximum price of every retailer.
+                
+Parameters:     *ob - Output buffer, where data is printed.
+                *stats - Array of retailer aggregates.
+                cnt - Length of the array.
+                
+Return:         -
+*/
+void print_retailer_report(struct out_buf *ob, struct retailer_stats *stats,
+                           uint32_t cnt);
+
+
+/*
+Description:    Aggregates quotes by retailer and prints the report. Handles
+                log writing and error printing.
+                
+Parameters:     qdw - Wrapper containing a pointer to quote data array and its
+                      length.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int show_retailer_report(struct quote_data_wrapper qdw);
+
+#endif
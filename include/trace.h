@@ -0,0 +1,95 @@
+/*
+File:         trace.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for trace.c. Data struct definitions, macros etc.
+*/
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define TRACE_MIN_ALLOC 256
+#define TRACE_NO_CNT -1
+#define TRACE_NS_PER_US 1000.0
+
+// Lines parsed per span while reading a data file
+#define TRACE_PARSE_BATCH 65536
+
+// Span categories
+#define TRACE_CAT_IO "io"
+#define TRACE_CAT_LOAD "load"
+#define TRACE_CAT_DISPLAY "display"
+#define TRACE_CAT_SAVE "save"
+
+/*
+    One finished span. Names and categories are string literals, so they are
+    not copied.
+*/
+struct trace_event
+{
+    const char *cat;
+    const char *name;
+    uint64_t start;             // Nanoseconds of latency_now
+    uint64_t dur;
+    int64_t cnt;                // Lines, bytes etc., TRACE_NO_CNT if none
+};
+
+
+/*
+    Spans of one thread. Only the owning thread appends to its buffer, so
+    recording takes no lock. Buffers are linked when a thread records its
+    first span and are written after all threads have been joined.
+*/
+struct trace_buf
+{
+    struct trace_event *events;
+    size_t cnt;
+    size_t alloc_limit;
+    size_t dropped;             // Spans lost to failed allocation
+    pid_t tid;
+    struct trace_buf *next;
+};
+
+
+/*
+Description:    Opens the trace file and starts tracing. The spans of all
+                threads are written into the file as Chrome trace event JSON
+                when the program exits, it can be opened in Perfetto or
+                chrome://tracing. Handles log writing and error printing.
+                
+Parameters:     *f_name - Pointer to string containing trace file name.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE if the file can not be opened.
+*/
+int trace_open(char *f_name);
+
+
+/*
+Description:    Starts a span.
+                
+Parameters:     -
+                
+Return:         Start time to pass to trace_end. 0 if tracing is off.
+*/
+uint64_t trace_begin(void);
+
+
+/*
+Description:    Ends a span started with trace_begin and stores it in the
+                buffer of the calling thread. Does nothing if tracing is off.
+                
+Parameters:     start - Return value of trace_begin.
+                *cat - Category, string literal.
+                *name - Span name, string literal.
+                cnt - Number of items handled in the span or TRACE_NO_CNT.
+                
+Return:         -
+*/
+void trace_end(uint64_t start, const char *cat, const char *name, int64_t cnt);
+
+#endif
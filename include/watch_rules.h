@@ -0,0 +1,180 @@
+/*
+File:         watch_rules.h
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Header file for watch_rules.c. Data struct definitions, macros
+              etc.
+*/
+
+#ifndef _WATCH_RULES_H
+#define _WATCH_RULES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <main.h>
+#include <hash_index.h>
+
+#define WATCH_MIN_ALLOC 64
+#define WATCH_CHANGED_MIN_ALLOC 64
+#define WATCH_STDOUT "-"
+#define WATCH_ALERTS_MIN_ALLOC 4
+#define WATCH_DEFAULT_MIN_STOCK 1
+
+// Rule kinds, first field of every rules file line
+#define WATCH_BY_CODE 'C'
+#define WATCH_BY_NAME 'N'
+
+// Rules file fields. Index of first field is 1
+#define CSV_WATCH_FIELD_KIND    1
+#define CSV_WATCH_FIELD_TARGET  2
+#define CSV_WATCH_FIELD_PRICE   3
+#define CSV_WATCH_FIELD_RTLR    4
+#define CSV_WATCH_FIELD_STOCK   5
+#define CSV_WATCH_FIELD_CNT     5
+
+/*
+    Last alert of a rule for one product. Removed, when the product has no
+    matching offer anymore.
+*/
+struct watch_alert
+{
+    uint32_t code_id;
+    uint32_t retailer_id;
+    int64_t price;
+};
+
+
+/*
+    Rule "tell me when the product is offered for at most max_price with at
+    least min_stock in stock". The product is given by code or by name. A name
+    can match several products, so the last alert is kept for every product
+    and the same offer of a product is not reported again.
+*/
+struct watch_rule
+{
+    char *target;               // Product code or name
+    int by_name;
+    int64_t max_price;          // Price in cents
+    char *retailer;             // NULL for any retailer
+    int min_stock;
+    size_t line;                // Line of the rule in the rules file
+    int64_t next;               // Next rule with the same target, -1 if none
+    struct watch_alert *alerts; // Products with a matching offer
+    size_t alert_cnt;
+    size_t alert_limit;
+};
+
+
+/*
+    All watch rules. Rules are found through a chain of rules with the same
+    target, by product code or by product name, so a changed product is
+    checked against its own rules only. Code IDs of products with changed
+    quotes are collected until they are checked.
+*/
+struct watch_rules
+{
+    struct watch_rule *rules;
+    size_t rule_cnt;
+    size_t alloc_limit;
+    size_t line_cnt;                // Lines in the rules file
+    struct hash_index by_code;      // Product code -> last rule
+    struct hash_index by_name;      // Product name -> last rule
+    uint8_t *marked;                // Every code ID, 1 if in changed
+    size_t marked_len;
+    uint32_t *changed;
+    size_t changed_cnt;
+    size_t changed_limit;
+    char *f_rules;
+    char *f_alerts;
+    FILE *alerts;
+};
+
+
+/*
+Description:    Reads watch rules from a file and opens the alerts output.
+                Every line of the rules file is
+                    C; <code>; <max price>; <retailer>; <min stock>
+                    N; <name>; <max price>; <retailer>; <min stock>
+                Prices are in cents. Retailer can be empty for any retailer,
+                minimum stock defaults to WATCH_DEFAULT_MIN_STOCK. A missing
+                rules file is an empty one. Products of all rules are marked
+                changed, so the first watch_check_changes checks every rule.
+                Handles log writing and error printing.
+                
+Parameters:     *f_rules - Pointer to string containing rules file name.
+                *f_alerts - Pointer to string containing alerts file name.
+                            Alerts are appended to it. WATCH_STDOUT or an empty
+                            string for standard output.
+                pdw - Wrapper containing a pointer to product data array and its
+                      code index.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on read or memory allocation
+                error.
+*/
+int watch_load(char *f_rules, char *f_alerts, struct product_data_wrapper pdw);
+
+
+/*
+Description:    Marks the quotes of a product changed. Called by every writer,
+                that adds, changes or removes quotes (or renames a product).
+                Writers are serialized by the catalog. Does nothing if no rules
+                are loaded.
+                
+Parameters:     code_id - Product code ID.
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int watch_mark_code(uint32_t code_id);
+
+
+/*
+Description:    Checks the rules of every product marked changed against the
+                current catalog version. For every rule the cheapest quote
+                with at most the rules price, enough stock and the rules
+                retailer is found. If it differs from the last alert of the
+                rule for the product, an alert line is written:
+                    <rule>; <code>; <name>; <quote id>; <retailer>; <price>;
+                    <stock>
+                where rule is the line number of the rule in the rules file.
+                Handles log writing and error printing.
+                
+Parameters:     -
+                
+Return:         EXIT_SUCCESS (0) or EXIT_FAILURE on memory allocation error.
+*/
+int watch_check_changes(void);
+
+
+/*
+Description:    Asks the user for a watch rule in the rules file format,
+                appends it to the rules file and checks it right away.
+                
+Parameters:     -
+                
+Return:         EDIT_OK if a rule was added, EDIT_NO_MATCH if the rule was not
+                valid or not saved, EDIT_MALLOC on memory allocation error.
+*/
+int watch_add_rule_prompt(void);
+
+
+/*
+Description:    Returns whether watch rules are in use.
+                
+Parameters:     -
+                
+Return:         1 if watch_load was successful, else 0.
+*/
+int watch_enabled(void);
+
+
+/*
+Description:    Frees all watch rules and closes the alerts output.
+                
+Parameters:     -
+                
+Return:         -
+*/
+void watch_free(void);
+
+#endif
@@ -0,0 +1,309 @@
+/*
+File:         alloc_acct.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Optional accounting of the programs memory allocations by
+              subsystem. Compiled in with ALLOC_ACCOUNTING (make all ACCT=1),
+              otherwise the header maps everything to the standard functions.
+              Array growth with overflow checks is always compiled.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <alloc_acct.h>
+
+#ifdef ALLOC_ACCOUNTING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <log_handler.h>
+
+/*
+    Put in front of every accounted allocation. Its size keeps the memory
+    after it aligned like malloc's.
+*/
+struct acct_header
+{
+    size_t size;            // Requested bytes
+    uint32_t cls;
+    uint32_t unused;        // Bytes set unused with acct_set_unused
+};
+
+_Static_assert(sizeof(struct acct_header) % _Alignof(max_align_t) == 0,
+               "Accounting header breaks alignment");
+
+/*
+    Counters of one class. Wasted bytes are malloc's rounding up of the
+    requested size and capacity set unused.
+*/
+struct acct_class
+{
+    atomic_size_t allocs;
+    atomic_size_t frees;
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_size_t wasted;
+    atomic_size_t peak_wasted;
+};
+
+static struct acct_class classes[ALLOC_CLASS_CNT];
+static struct acct_class total;
+
+static const char *const class_names[ALLOC_CLASS_CNT] =
+{
+    "line buffers",
+    "product strings",
+    "quote strings",
+    "product arrays",
+    "quote arrays",
+    "dictionaries",
+    "indexes",
+    "price history",
+    "other"
+};
+
+#define ACCT_HEADER(ptr) ((struct acct_header *)(ptr) - 1)
+#define ACCT_UNUSED_MAX UINT32_MAX
+
+static void raise_peak(atomic_size_t *peak, size_t value)
+{
+    size_t old = atomic_load_explicit(peak, memory_order_relaxed);
+    while (old < value &&
+           !atomic_compare_exchange_weak_explicit(peak, &old, value,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+    {
+    }
+}
+
+
+/*
+    Adds (or with a negative sign removes) bytes to a counter pair.
+*/
+static void add_bytes(atomic_size_t *value, atomic_size_t *peak, size_t bytes,
+                      int sign)
+{
+    if (sign > 0)
+    {
+        size_t now = atomic_fetch_add_explicit(value, bytes,
+                                               memory_order_relaxed) + bytes;
+        raise_peak(peak, now);
+    }
+    else
+    {
+        atomic_fetch_sub_explicit(value, bytes, memory_order_relaxed);
+    }
+}
+
+
+/*
+    Bytes of an allocation, that hold no data.
+*/
+static size_t wasted_bytes(struct acct_header *h)
+{
+    return malloc_usable_size(h) - sizeof(struct acct_header) - h->size +
+           h->unused;
+}
+
+
+static void account(struct acct_header *h, int sign)
+{
+    struct acct_class *c = classes + h->cls;
+    size_t wasted = wasted_bytes(h);
+    add_bytes(&c->live, &c->peak, h->size, sign);
+    add_bytes(&c->wasted, &c->peak_wasted, wasted, sign);
+    add_bytes(&total.live, &total.peak, h->size, sign);
+    add_bytes(&total.wasted, &total.peak_wasted, wasted, sign);
+}
+
+
+static void *finish_alloc(enum alloc_classes cls, struct acct_header *h,
+                          size_t size)
+{
+    if (h == NULL)
+    {
+        return NULL;
+    }
+    h->size = size;
+    h->cls = (uint32_t)cls;
+    h->unused = 0;
+    atomic_fetch_add_explicit(&(classes + cls)->allocs, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&total.allocs, 1, memory_order_relaxed);
+    account(h, 1);
+    return h + 1;
+}
+
+
+void *acct_malloc(enum alloc_classes cls, size_t size)
+{
+    return finish_alloc(cls, malloc(sizeof(struct acct_header) + size), size);
+}
+
+
+void *acct_calloc(enum alloc_classes cls, size_t cnt, size_t size)
+{
+    if (size != 0 && cnt > (SIZE_MAX - sizeof(struct acct_header)) / size)
+    {
+        return NULL;
+    }
+    return finish_alloc(cls, calloc(1, sizeof(struct acct_header) + cnt * size),
+                        cnt * size);
+}
+
+
+/*
+    Resizing counts as freeing the old memory and allocating the new one.
+*/
+void *acct_realloc(enum alloc_classes cls, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return acct_malloc(cls, size);
+    }
+    struct acct_header *h = ACCT_HEADER(ptr);
+    uint32_t old_cls = h->cls;
+    account(h, -1);
+    
+    struct acct_header *moved = realloc(h, sizeof(struct acct_header) + size);
+    if (moved == NULL)
+    {
+        // Old memory stays valid and counted
+        account(h, 1);
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&(classes + old_cls)->frees, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&total.frees, 1, memory_order_relaxed);
+    return finish_alloc(cls, moved, size);
+}
+
+
+void acct_free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    struct acct_header *h = ACCT_HEADER(ptr);
+    atomic_fetch_add_explicit(&(classes + h->cls)->frees, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&total.frees, 1, memory_order_relaxed);
+    account(h, -1);
+    free(h);
+}
+
+
+void acct_set_unused(void *ptr, size_t unused)
+{
+    struct acct_header *h = ACCT_HEADER(ptr);
+    account(h, -1);
+    h->unused = (uint32_t)(unused > ACCT_UNUSED_MAX ? ACCT_UNUSED_MAX : unused);
+    account(h, 1);
+}
+
+
+static void format_row(char *str, size_t len, const char *name,
+                       struct acct_class *c)
+{
+    snprintf(str, len, "%-16s%9zu%9zu%11zu%11zu%11zu%11zu", name,
+             atomic_load(&c->allocs), atomic_load(&c->frees),
+             atomic_load(&c->live), atomic_load(&c->peak),
+             atomic_load(&c->wasted), atomic_load(&c->peak_wasted));
+}
+
+
+static void format_head(char *str, size_t len)
+{
+    snprintf(str, len, "%-16s%9s%9s%11s%11s%11s%11s", "Memory (bytes)",
+             "Allocs", "Frees", "Live", "Peak", "Wasted", "Peak wst");
+}
+
+
+void acct_log_report(const char *stage)
+{
+    char msg[MAX_LOG_MSG_STR_LEN];
+    snprintf(msg, MAX_LOG_MSG_STR_LEN, "Allocation report %s:", stage);
+    write_log(INFO, msg);
+    format_head(msg, MAX_LOG_MSG_STR_LEN);
+    write_log(INFO, msg);
+    for (int i = 0; i < ALLOC_CLASS_CNT; i++)
+    {
+        format_row(msg, MAX_LOG_MSG_STR_LEN, *(class_names + i), classes + i);
+        write_log(INFO, msg);
+    }
+    format_row(msg, MAX_LOG_MSG_STR_LEN, "total", &total);
+    write_log(INFO, msg);
+}
+
+
+void acct_log_per_record(size_t product_cnt, size_t quote_cnt)
+{
+    char msg[MAX_LOG_MSG_STR_LEN];
+    if (product_cnt > 0)
+    {
+        size_t bytes = atomic_load(&(classes + ALLOC_PRODUCT_STR)->live) +
+                       atomic_load(&(classes + ALLOC_PRODUCT_ARR)->live);
+        snprintf(msg, MAX_LOG_MSG_STR_LEN, "Memory per product: %zu bytes "
+                 "(%zu products).", bytes / product_cnt, product_cnt);
+        write_log(INFO, msg);
+    }
+    if (quote_cnt > 0)
+    {
+        size_t bytes = atomic_load(&(classes + ALLOC_QUOTE_STR)->live) +
+                       atomic_load(&(classes + ALLOC_QUOTE_ARR)->live);
+        snprintf(msg, MAX_LOG_MSG_STR_LEN, "Memory per quote: %zu bytes "
+                 "(%zu quotes).", bytes / quote_cnt, quote_cnt);
+        write_log(INFO, msg);
+    }
+}
+
+
+static void exit_report(void)
+{
+    char row[MAX_LOG_MSG_STR_LEN];
+    format_head(row, MAX_LOG_MSG_STR_LEN);
+    fprintf(stderr, "%s\n", row);
+    for (int i = 0; i < ALLOC_CLASS_CNT; i++)
+    {
+        format_row(row, MAX_LOG_MSG_STR_LEN, *(class_names + i), classes + i);
+        fprintf(stderr, "%s\n", row);
+    }
+    format_row(row, MAX_LOG_MSG_STR_LEN, "total", &total);
+    fprintf(stderr, "%s\n", row);
+    acct_log_report("at exit");
+}
+
+
+void acct_init(void)
+{
+    atexit(exit_report);
+}
+
+#endif
+
+
+size_t acct_grow_limit(size_t limit, size_t min_limit, size_t elem_size)
+{
+    size_t new_limit = limit == 0 ? min_limit : limit * 2;
+    if (new_limit < limit || elem_size == 0 || new_limit > SIZE_MAX / elem_size)
+    {
+        return 0;
+    }
+    return new_limit;
+}
+
+
+size_t acct_live_bytes(void)
+{
+    #ifdef ALLOC_ACCOUNTING
+    return atomic_load_explicit(&total.live, memory_order_relaxed);
+    #else
+    // Chunks in use in all arenas and memory mapped chunks
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+    #endif
+}
@@ -10,6 +10,7 @@ Description:  Code for parsing command line arguments.
 #include <stdlib.h>
 #include <string.h>
 #include <log_handler.h>
+#include <export_json.h>
 #include <arg_parse.h>
 
 void parse_arguments(struct argument_description *opts, struct argument *args,
@@ -61,10 +62,39 @@ int change_argument_value(struct argument *args, enum argument_cases event,
             break;
             
         case ARG_FILE_QTE:
-            strcpy(args->f_qte, *(arg_vec + cnt + 1));
-            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as quotes file.",
-                     *(arg_vec + cnt + 1));
-            write_log(INFO, buf);
+            // Replaces default sources, consumes words until next argument
+            args->f_qte_cnt = 0;
+            arg_mems = 1;
+            while (cnt + arg_mems < arg_vec_len &&
+                   strncmp(*(arg_vec + cnt + arg_mems), ARG_PREFIX,
+                           strlen(ARG_PREFIX)) != 0)
+            {
+                if (args->f_qte_cnt >= QTE_SOURCES_MAX)
+                {
+                    snprintf(buf, MSG_MAX_LEN, "Too many quote sources. At "
+                             "most %d are supported.", QTE_SOURCES_MAX);
+                    write_log(ERROR, buf);
+                    exit_with_error(buf);
+                }
+                if (strlen(*(arg_vec + cnt + arg_mems)) >= FILE_NAME_MAX_LEN)
+                {
+                    snprintf(buf, MSG_MAX_LEN, "Quote source name too long. "
+                             "Must be under %d chars long.", FILE_NAME_MAX_LEN);
+                    write_log(ERROR, buf);
+                    exit_with_error(buf);
+                }
+                strcpy(args->f_qte[args->f_qte_cnt], *(arg_vec + cnt + arg_mems));
+                args->f_qte_cnt++;
+                snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as quotes source.",
+                         *(arg_vec + cnt + arg_mems));
+                write_log(INFO, buf);
+                arg_mems++;
+            }
+            if (args->f_qte_cnt == 0)
+            {
+                exit_with_error("Not enough arguments provided. Check if every "
+                                "file name argument specifies a name.");
+            }
             break;
             
         case LOG_FILE:
@@ -88,6 +118,138 @@ int change_argument_value(struct argument *args, enum argument_cases event,
             write_log(INFO, buf);
             break;
             
+        case ARG_FILE_HIST:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Price history file name too long.");
+            }
+            strcpy(args->f_hist, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as price history file.",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_FILE_DELTA:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Quote changes file name too long.");
+            }
+            strcpy(args->f_delta, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as quote changes file.",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_FILE_BULK:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Product bulk edit file name too long.");
+            }
+            strcpy(args->f_bulk, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as product bulk edit file.",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_EXPORT_JSON:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Export file name too long.");
+            }
+            strcpy(args->f_export, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Exporting data as JSON to \"%s\".",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_QUERY:
+            if (strlen(*(arg_vec + cnt + 1)) >= QUERY_TEXT_MAX_LEN)
+            {
+                exit_with_error("Query too long.");
+            }
+            strcpy(args->query, *(arg_vec + cnt + 1));
+            write_log(INFO, "Running query given on the command line.");
+            break;
+            
+        case ARG_FILE_WATCH:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Watch rules file name too long.");
+            }
+            strcpy(args->f_watch, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as watch rules file.",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_FILE_ALERTS:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Alerts file name too long.");
+            }
+            strcpy(args->f_alerts, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Writing alerts to \"%s\".",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_FILE_TRACE:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Trace file name too long.");
+            }
+            strcpy(args->f_trace, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Writing trace to \"%s\".",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_FILE_METRICS:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Metrics file name too long.");
+            }
+            strcpy(args->f_metrics, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Using \"%s\" as metrics file.",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_BEST_PRICE:
+            if (strlen(*(arg_vec + cnt + 1)) >= FILE_NAME_MAX_LEN)
+            {
+                exit_with_error("Best price report file name too long.");
+            }
+            strcpy(args->f_best, *(arg_vec + cnt + 1));
+            snprintf(buf, MSG_MAX_LEN, "Writing best price report to \"%s\".",
+                     *(arg_vec + cnt + 1));
+            write_log(INFO, buf);
+            break;
+            
+        case ARG_EXPORT_FMT:
+            if (strcmp(*(arg_vec + cnt + 1), EXPORT_FMT_NAME_NDJSON) == 0)
+            {
+                args->export_fmt = EXPORT_NDJSON;
+            }
+            else if (strcmp(*(arg_vec + cnt + 1), EXPORT_FMT_NAME_JSON) == 0)
+            {
+                args->export_fmt = EXPORT_JSON;
+            }
+            else
+            {
+                snprintf(buf, MSG_MAX_LEN, "\"%s\" is not a supported export "
+                         "format (%s or %s).", *(arg_vec + cnt + 1),
+                         EXPORT_FMT_NAME_NDJSON, EXPORT_FMT_NAME_JSON);
+                write_log(ERROR, buf);
+                exit_with_error(buf);
+            }
+            break;
+            
+        case ARG_HIST_ADD:
+            args->hist_add = 1;
+            write_log(INFO, "Quotes will be added to price history.");
+            break;
+            
         default:
             exit_with_error("Error with argument handling setup, check argument"
                             " case values. This is not a user error!");
@@ -0,0 +1,376 @@
+/*
+File:         async_read.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Reading regular files ahead of the parser with io_uring. The ring
+              is set up with plain system calls, no library is needed. If the
+              kernel has no io_uring (or it is blocked), files are read with
+              stdio as before.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <async_read.h>
+
+/*
+    Mapped submission and completion queues of one io_uring instance.
+*/
+struct uring
+{
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    _Atomic unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+#define RING_FIELD(ring, off) ((void *)((char *)(ring) + (off)))
+
+static void uring_free(struct uring *ur)
+{
+    if (ur->sqes != NULL)
+    {
+        munmap(ur->sqes, ur->sqes_size);
+    }
+    if (ur->cq_ring != NULL && ur->cq_ring != ur->sq_ring)
+    {
+        munmap(ur->cq_ring, ur->cq_ring_size);
+    }
+    if (ur->sq_ring != NULL)
+    {
+        munmap(ur->sq_ring, ur->sq_ring_size);
+    }
+    close(ur->fd);
+    acct_free(ur);
+}
+
+
+static struct uring *uring_init(unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct uring *ur = acct_calloc(ALLOC_LINE_BUF, 1, sizeof(struct uring));
+    if (ur == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+    ur->fd = fd;
+    
+    // IORING_OP_READ came with the same kernel version as this feature
+    if (!(p.features & IORING_FEAT_RW_CUR_POS))
+    {
+        uring_free(ur);
+        return NULL;
+    }
+    
+    ur->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ur->cq_ring_size = p.cq_off.cqes +
+                       p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ur->cq_ring_size > ur->sq_ring_size)
+        {
+            ur->sq_ring_size = ur->cq_ring_size;
+        }
+        ur->cq_ring_size = ur->sq_ring_size;
+    }
+    ur->sq_ring = mmap(NULL, ur->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ur->sq_ring == MAP_FAILED)
+    {
+        ur->sq_ring = NULL;
+        uring_free(ur);
+        return NULL;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ur->cq_ring = ur->sq_ring;
+    }
+    else
+    {
+        ur->cq_ring = mmap(NULL, ur->cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ur->cq_ring == MAP_FAILED)
+        {
+            ur->cq_ring = NULL;
+            uring_free(ur);
+            return NULL;
+        }
+    }
+    ur->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ur->sqes = mmap(NULL, ur->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ur->sqes == MAP_FAILED)
+    {
+        ur->sqes = NULL;
+        uring_free(ur);
+        return NULL;
+    }
+    
+    ur->sq_tail = RING_FIELD(ur->sq_ring, p.sq_off.tail);
+    ur->sq_mask = RING_FIELD(ur->sq_ring, p.sq_off.ring_mask);
+    ur->sq_array = RING_FIELD(ur->sq_ring, p.sq_off.array);
+    ur->cq_head = RING_FIELD(ur->cq_ring, p.cq_off.head);
+    ur->cq_tail = RING_FIELD(ur->cq_ring, p.cq_off.tail);
+    ur->cq_mask = RING_FIELD(ur->cq_ring, p.cq_off.ring_mask);
+    ur->cqes = RING_FIELD(ur->cq_ring, p.cq_off.cqes);
+    return ur;
+}
+
+
+/*
+    Calls io_uring_enter, repeating it if a signal interrupts the call.
+*/
+static int uring_enter(struct uring *ur, unsigned to_submit,
+                       unsigned min_complete, unsigned flags)
+{
+    long res;
+    do
+    {
+        res = syscall(__NR_io_uring_enter, ur->fd, to_submit, min_complete,
+                      flags, NULL, 0);
+    } while (res < 0 && errno == EINTR);
+    return res < 0 ? -1 : 0;
+}
+
+
+static char *block_data(struct async_reader *ar, int i)
+{
+    return ar->data + (size_t)i * ASYNC_BLOCK_SIZE;
+}
+
+
+/*
+    Starts reading every free block, in file order after the blocks already
+    being read.
+*/
+static int submit_free_blocks(struct async_reader *ar)
+{
+    struct uring *ur = ar->ring;
+    unsigned tail = atomic_load_explicit(ur->sq_tail, memory_order_relaxed);
+    unsigned submitted = 0;
+    for (int k = 0; k < ASYNC_BLOCKS && !ar->eof; k++)
+    {
+        int i = (ar->head + k) % ASYNC_BLOCKS;
+        if (ar->states[i] != BLOCK_FREE)
+        {
+            continue;
+        }
+        unsigned idx = (tail + submitted) & *ur->sq_mask;
+        struct io_uring_sqe *sqe = ur->sqes + idx;
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = ar->fd;
+        sqe->addr = (unsigned long)block_data(ar, i);
+        sqe->len = ASYNC_BLOCK_SIZE;
+        sqe->off = (unsigned long long)ar->next_off;
+        sqe->user_data = (unsigned long long)i;
+        *(ur->sq_array + idx) = idx;
+        ar->offsets[i] = ar->next_off;
+        ar->states[i] = BLOCK_READING;
+        ar->next_off += ASYNC_BLOCK_SIZE;
+        submitted++;
+    }
+    if (submitted == 0)
+    {
+        return 0;
+    }
+    atomic_store_explicit(ur->sq_tail, tail + submitted, memory_order_release);
+    return uring_enter(ur, submitted, 0, 0);
+}
+
+
+/*
+    Marks the blocks of all completed reads done.
+*/
+static void reap_completions(struct async_reader *ar)
+{
+    struct uring *ur = ar->ring;
+    unsigned head = atomic_load_explicit(ur->cq_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(ur->cq_tail, memory_order_acquire);
+    while (head != tail)
+    {
+        struct io_uring_cqe *cqe = ur->cqes + (head & *ur->cq_mask);
+        int i = (int)cqe->user_data;
+        ar->results[i] = cqe->res;
+        ar->states[i] = BLOCK_DONE;
+        head++;
+    }
+    atomic_store_explicit(ur->cq_head, head, memory_order_release);
+}
+
+
+static int wait_block(struct async_reader *ar, int i)
+{
+    reap_completions(ar);
+    while (ar->states[i] == BLOCK_READING)
+    {
+        if (uring_enter(ar->ring, 0, 1, IORING_ENTER_GETEVENTS) != 0)
+        {
+            return -1;
+        }
+        reap_completions(ar);
+    }
+    return 0;
+}
+
+
+/*
+    Waits for every running read and frees all blocks except keep.
+*/
+static int drain_blocks(struct async_reader *ar, int keep)
+{
+    int return_val = 0;
+    for (int i = 0; i < ASYNC_BLOCKS; i++)
+    {
+        if (ar->states[i] == BLOCK_READING && wait_block(ar, i) != 0)
+        {
+            return_val = -1;
+        }
+        if (i != keep)
+        {
+            ar->states[i] = BLOCK_FREE;
+        }
+    }
+    return return_val;
+}
+
+
+int async_reader_open(struct async_reader *ar, FILE *p_file)
+{
+    struct stat st;
+    ar->ring = NULL;
+    int fd = fileno(p_file);
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        ftell(p_file) != 0)
+    {
+        return ASYNC_UNSUPPORTED;
+    }
+    
+    ar->fd = dup(fd);
+    if (ar->fd < 0)
+    {
+        return ASYNC_UNSUPPORTED;
+    }
+    ar->data = acct_malloc(ALLOC_LINE_BUF,
+                           (size_t)ASYNC_BLOCKS * ASYNC_BLOCK_SIZE);
+    ar->ring = ar->data == NULL ? NULL : uring_init(ASYNC_BLOCKS);
+    if (ar->ring == NULL)
+    {
+        acct_free(ar->data);
+        ar->data = NULL;
+        close(ar->fd);
+        return ASYNC_UNSUPPORTED;
+    }
+    ar->eof = 0;
+    ar->head = 0;
+    ar->parsed = -1;
+    ar->next_off = 0;
+    for (int i = 0; i < ASYNC_BLOCKS; i++)
+    {
+        ar->states[i] = BLOCK_FREE;
+    }
+    
+    if (submit_free_blocks(ar) != 0)
+    {
+        async_reader_close(ar);
+        return ASYNC_UNSUPPORTED;
+    }
+    return ASYNC_OK;
+}
+
+
+long async_reader_next(struct async_reader *ar, char **data)
+{
+    // Block parsed before is read again, after the others
+    if (ar->parsed >= 0)
+    {
+        ar->states[ar->parsed] = BLOCK_FREE;
+        ar->parsed = -1;
+    }
+    int head = ar->head;
+    if (submit_free_blocks(ar) != 0 || ar->states[head] == BLOCK_FREE ||
+        wait_block(ar, head) != 0)
+    {
+        if (ar->states[head] == BLOCK_FREE && ar->eof)
+        {
+            return 0;
+        }
+        write_log(ERROR, "Unable to read file through io_uring.");
+        drain_blocks(ar, -1);
+        ar->eof = 1;
+        return ASYNC_READ_ERR;
+    }
+    
+    int res = ar->results[head];
+    if (res < 0)
+    {
+        char msg[MAX_LOG_MSG_STR_LEN];
+        snprintf(msg, MAX_LOG_MSG_STR_LEN, "Reading file failed: %s.",
+                 strerror(-res));
+        write_log(ERROR, msg);
+        drain_blocks(ar, -1);
+        ar->eof = 1;
+        return ASYNC_READ_ERR;
+    }
+    
+    // End of file or a short read, reads after it have wrong offsets
+    if (res < ASYNC_BLOCK_SIZE)
+    {
+        drain_blocks(ar, head);
+        ar->next_off = ar->offsets[head] + res;
+        if (res == 0)
+        {
+            ar->states[head] = BLOCK_FREE;
+            ar->eof = 1;
+            return 0;
+        }
+    }
+    ar->states[head] = BLOCK_PARSED;
+    ar->parsed = head;
+    ar->head = (head + 1) % ASYNC_BLOCKS;
+    *data = block_data(ar, head);
+    return res;
+}
+
+
+void async_reader_close(struct async_reader *ar)
+{
+    if (ar->ring == NULL)
+    {
+        return;
+    }
+    // Kernel writes into the blocks until the reads are finished
+    drain_blocks(ar, -1);
+    uring_free(ar->ring);
+    ar->ring = NULL;
+    acct_free(ar->data);
+    ar->data = NULL;
+    close(ar->fd);
+}
@@ -0,0 +1,240 @@
+/*
+File:         best_price.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Cheapest offer of every product, found in one parallel pass over
+              the quotes instead of a search of all quotes per product.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <csv_helper.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+#include <best_price.h>
+
+/*
+    Range of quotes searched by one thread into its own array.
+*/
+struct best_job
+{
+    struct quote_data_wrapper qdw;
+    size_t first;
+    size_t last;
+    int64_t *partial;
+    uint32_t code_cnt;
+};
+
+
+static void *best_worker(void *arg)
+{
+    struct best_job *job = arg;
+    for (size_t i = job->first; i < job->last; i++)
+    {
+        struct quote_info *qi = job->qdw.data + i;
+        if (qi->stock <= 0 || qi->code_id >= job->code_cnt)
+        {
+            continue;
+        }
+        int64_t *best = job->partial + qi->code_id;
+        if (*best == BEST_NO_QUOTE ||
+            qi->price < (job->qdw.data + *best)->price)
+        {
+            *best = (int64_t)i;
+        }
+    }
+    return NULL;
+}
+
+
+/*
+    Ranges are merged in quote order, so equal prices keep the first quote.
+*/
+static void merge_best(int64_t *dest, int64_t *src, uint32_t cnt,
+                       struct quote_data_wrapper qdw)
+{
+    for (uint32_t c = 0; c < cnt; c++)
+    {
+        if (*(src + c) != BEST_NO_QUOTE &&
+            (*(dest + c) == BEST_NO_QUOTE ||
+             (qdw.data + *(src + c))->price < (qdw.data + *(dest + c))->price))
+        {
+            *(dest + c) = *(src + c);
+        }
+    }
+}
+
+
+/*
+    Every thread has an array of all codes, so a thread is only used for at
+    least as many quotes as there are codes. Memory of the arrays then stays
+    below the memory of the quote indexes.
+*/
+static int get_best_thread_cnt(size_t quote_cnt, uint32_t code_cnt)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_cnt = cpu_cnt < 1 ? 1 : (cpu_cnt < BEST_THREADS_MAX ?
+                                        (int)cpu_cnt : BEST_THREADS_MAX);
+    size_t min_quotes = code_cnt > BEST_MIN_QUOTES_PER_THREAD ?
+                        code_cnt : BEST_MIN_QUOTES_PER_THREAD;
+    size_t useful = quote_cnt / min_quotes;
+    if (useful < (size_t)thread_cnt)
+    {
+        thread_cnt = useful < 1 ? 1 : (int)useful;
+    }
+    return thread_cnt;
+}
+
+
+int find_best_prices(struct quote_data_wrapper qdw, int64_t **best,
+                     uint32_t *cnt)
+{
+    uint32_t code_cnt = dict_size(DICT_CODE, NULL);
+    int thread_cnt = get_best_thread_cnt(qdw.lines, code_cnt);
+    size_t partial_cnt = (size_t)thread_cnt * ((size_t)code_cnt + 1);
+    int64_t *partials = acct_malloc(ALLOC_OTHER, sizeof(int64_t) *
+                                    partial_cnt);
+    if (partials == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    struct best_job jobs[BEST_THREADS_MAX];
+    pthread_t threads[BEST_THREADS_MAX];
+    size_t per_thread = qdw.lines / (size_t)thread_cnt;
+    for (int t = 0; t < thread_cnt; t++)
+    {
+        (jobs + t)->qdw = qdw;
+        (jobs + t)->first = (size_t)t * per_thread;
+        (jobs + t)->last = t == thread_cnt - 1 ? qdw.lines
+                                               : (size_t)(t + 1) * per_thread;
+        (jobs + t)->partial = partials + (size_t)t * code_cnt;
+        (jobs + t)->code_cnt = code_cnt;
+        for (uint32_t c = 0; c < code_cnt; c++)
+        {
+            *((jobs + t)->partial + c) = BEST_NO_QUOTE;
+        }
+    }
+    
+    // Job 0 runs on the calling thread, also covers failing to start threads
+    int started = 1;
+    for (; started < thread_cnt; started++)
+    {
+        if (pthread_create(threads + started, NULL, best_worker,
+                           jobs + started) != 0)
+        {
+            break;
+        }
+    }
+    best_worker(jobs);
+    for (int t = 1; t < thread_cnt; t++)
+    {
+        if (t < started)
+        {
+            pthread_join(*(threads + t), NULL);
+        }
+        else
+        {
+            best_worker(jobs + t);
+        }
+        merge_best(partials, (jobs + t)->partial, code_cnt, qdw);
+    }
+    
+    *best = partials;
+    *cnt = code_cnt;
+    return EXIT_SUCCESS;
+}
+
+
+static void print_best_line(FILE *fp, struct product_info *pi,
+                            struct quote_info *qi)
+{
+    print_csv_field(fp, pi->p_code);
+    fputc(CSV_DELIMITER, fp);
+    print_csv_field(fp, pi->p_name);
+    fputc(CSV_DELIMITER, fp);
+    if (qi == NULL)
+    {
+        fprintf(fp, "%c%c%c\n", CSV_DELIMITER, CSV_DELIMITER, CSV_DELIMITER);
+        return;
+    }
+    print_csv_field(fp, qi->p_id);
+    fputc(CSV_DELIMITER, fp);
+    print_csv_field(fp, dict_string(DICT_RETAILER, qi->retailer_id));
+    fprintf(fp, "%c%lld%c%d\n", CSV_DELIMITER, (long long)qi->price,
+            CSV_DELIMITER, qi->stock);
+}
+
+
+int write_best_price_report(char *f_name, struct product_data_wrapper pdw,
+                            struct quote_data_wrapper qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    int64_t *best;
+    uint32_t code_cnt;
+    if (find_best_prices(qdw, &best, &code_cnt) == EXIT_FAILURE)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for the best "
+                 "price report of %zu quotes.", qdw.lines);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    int to_stdout = strcmp(f_name, BEST_STDOUT) == 0;
+    FILE *fp = to_stdout ? stdout : open_file(f_name, "w");
+    if (fp == NULL)
+    {
+        acct_free(best);
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "code%cname%cquote_id%cretailer%cprice%cstock\n",
+            CSV_DELIMITER, CSV_DELIMITER, CSV_DELIMITER, CSV_DELIMITER,
+            CSV_DELIMITER);
+    
+    // Products without an offer are listed after the ones with an offer
+    size_t no_offer = 0;
+    for (int offers = 1; offers >= 0; offers--)
+    {
+        for (size_t i = 0; i < pdw.lines; i++)
+        {
+            struct product_info *pi = pdw.data + i;
+            int64_t q = pi->code_id < code_cnt ? *(best + pi->code_id)
+                                               : BEST_NO_QUOTE;
+            if ((q != BEST_NO_QUOTE) != offers)
+            {
+                continue;
+            }
+            print_best_line(fp, pi, offers ? qdw.data + q : NULL);
+            no_offer += !offers;
+        }
+    }
+    acct_free(best);
+    
+    int err = fflush(fp) != 0 || ferror(fp);
+    if (!to_stdout && fclose(fp) != 0)
+    {
+        err = 1;
+    }
+    if (err)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Writing best price report \"%s\" "
+                 "failed.", f_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    snprintf(msg, MAX_ERR_MSG_LEN, "Wrote best prices of %zu product(s), %zu "
+             "without quotes with stock, to \"%s\".", pdw.lines - no_offer,
+             no_offer, f_name);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,403 @@
+/*
+File:         catalog.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Versioned product and quote data. Readers get a consistent
+              snapshot without locks, writers publish a changed copy and the
+              previous version is freed through RCU.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <hash_index.h>
+#include <rcu.h>
+#include <main.h>
+#include <report.h>
+#include <fuzzy_search.h>
+#include <metrics.h>
+#include <catalog.h>
+
+static _Atomic(struct catalog_version *) current = NULL;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static int update_parts = 0;
+static int update_active = 0;
+
+// Memory retired during an update, handed to RCU when the update is published
+static void **pending = NULL;
+static int pending_cnt = 0;
+static int pending_limit = 0;
+
+int catalog_init(struct product_data_wrapper pdw, struct quote_data_wrapper qdw)
+{
+    struct catalog_version *cv = acct_malloc(ALLOC_OTHER,
+                                             sizeof(struct catalog_version));
+    if (cv == NULL)
+    {
+        write_log(ERROR, "Unable to allocate memory for catalog version.");
+        fprintf(stderr, "Unable to allocate memory for catalog version.\n");
+        return EXIT_FAILURE;
+    }
+    cv->products = pdw;
+    cv->quotes = qdw;
+    cv->version = 1;
+    atomic_init(&cv->groups, NULL);
+    atomic_init(&cv->names, NULL);
+    atomic_store(&current, cv);
+    metrics_set(MET_G_PRODUCTS, pdw.lines);
+    metrics_set(MET_G_QUOTES, qdw.lines);
+    metrics_set(MET_G_VERSION, cv->version);
+    return EXIT_SUCCESS;
+}
+
+
+struct catalog_version *catalog_read_begin(void)
+{
+    rcu_read_lock();
+    return atomic_load(&current);
+}
+
+
+void catalog_read_end(void)
+{
+    rcu_read_unlock();
+}
+
+
+static void free_groups(struct quote_groups *qg)
+{
+    free_quote_groups(qg);
+    acct_free(qg);
+}
+
+
+static void free_names(struct trigram_index *ti)
+{
+    free_trigram_index(ti);
+    acct_free(ti);
+}
+
+
+/*
+    Frees memory retired by a writer. Strings, arrays and indexes are allocated
+    through allocation accounting, so they are not freed with plain free.
+*/
+static void free_retired(void *ptr)
+{
+    acct_free(ptr);
+}
+
+
+/*
+    Frees a version struct. Its groups and name index are freed here too,
+    because a reader may add them after the version was replaced.
+*/
+static void free_version(void *ptr)
+{
+    struct catalog_version *cv = ptr;
+    struct quote_groups *qg = atomic_load(&cv->groups);
+    struct trigram_index *ti = atomic_load(&cv->names);
+    if (qg != NULL)
+    {
+        free_groups(qg);
+    }
+    if (ti != NULL)
+    {
+        free_names(ti);
+    }
+    acct_free(cv);
+}
+
+
+struct quote_groups *catalog_quote_groups(struct catalog_version *cv)
+{
+    struct quote_groups *qg = atomic_load(&cv->groups);
+    if (qg != NULL)
+    {
+        return qg;
+    }
+    qg = acct_malloc(ALLOC_INDEX, sizeof(struct quote_groups));
+    if (qg == NULL || build_quote_groups(cv->quotes, qg) == EXIT_FAILURE)
+    {
+        acct_free(qg);
+        return NULL;
+    }
+    
+    // Another reader may have built them at the same time, first one is kept
+    struct quote_groups *expected = NULL;
+    if (!atomic_compare_exchange_strong(&cv->groups, &expected, qg))
+    {
+        free_groups(qg);
+        return expected;
+    }
+    return qg;
+}
+
+
+struct trigram_index *catalog_name_index(struct catalog_version *cv)
+{
+    struct trigram_index *ti = atomic_load(&cv->names);
+    if (ti != NULL)
+    {
+        return ti;
+    }
+    ti = acct_malloc(ALLOC_INDEX, sizeof(struct trigram_index));
+    if (ti == NULL || build_trigram_index(cv->products, ti) == EXIT_FAILURE)
+    {
+        acct_free(ti);
+        return NULL;
+    }
+    
+    struct trigram_index *expected = NULL;
+    if (!atomic_compare_exchange_strong(&cv->names, &expected, ti))
+    {
+        free_names(ti);
+        return expected;
+    }
+    return ti;
+}
+
+
+/*
+    Copies the first cnt entries of a data array. At least one entry is
+    allocated, so an empty array is not mistaken for an allocation error.
+*/
+static void *copy_data(void *src, size_t cnt, size_t entry_size,
+                       enum alloc_classes cls)
+{
+    size_t size = entry_size * (cnt > 0 ? cnt : 1);
+    void *dest = acct_malloc(cls, size);
+    if (dest != NULL && cnt > 0)
+    {
+        memcpy(dest, src, entry_size * cnt);
+    }
+    return dest;
+}
+
+
+struct catalog_version *catalog_update_begin(int parts)
+{
+    pthread_mutex_lock(&writer_lock);
+    struct catalog_version *old = atomic_load(&current);
+    
+    struct catalog_version *cv = acct_malloc(ALLOC_OTHER,
+                                             sizeof(struct catalog_version));
+    if (cv == NULL)
+    {
+        pthread_mutex_unlock(&writer_lock);
+        write_log(ERROR, "Unable to allocate memory for catalog version.");
+        fprintf(stderr, "Unable to allocate memory for catalog version.\n");
+        return NULL;
+    }
+    *cv = *old;
+    cv->version++;
+    atomic_init(&cv->groups, NULL);
+    atomic_init(&cv->names, NULL);
+    
+    int err = 0;
+    if (parts & CATALOG_PRODUCTS)
+    {
+        cv->products.code_index.slots = NULL;
+        cv->products.data = copy_data(old->products.data, old->products.lines,
+                                      old->products.data_struct_size,
+                                      ALLOC_PRODUCT_ARR);
+        err |= cv->products.data == NULL ||
+               hash_index_copy(&cv->products.code_index,
+                               &old->products.code_index) != HASH_OK;
+    }
+    if (parts & CATALOG_QUOTES)
+    {
+        cv->quotes.id_index.slots = NULL;
+        cv->quotes.data = copy_data(old->quotes.data, old->quotes.lines,
+                                    old->quotes.data_struct_size,
+                                    ALLOC_QUOTE_ARR);
+        cv->quotes.alloc_limit = old->quotes.lines;
+        err |= cv->quotes.data == NULL ||
+               hash_index_copy(&cv->quotes.id_index,
+                               &old->quotes.id_index) != HASH_OK;
+    }
+    
+    if (err)
+    {
+        if (parts & CATALOG_PRODUCTS)
+        {
+            acct_free(cv->products.data);
+            hash_index_free(&cv->products.code_index);
+        }
+        if (parts & CATALOG_QUOTES)
+        {
+            acct_free(cv->quotes.data);
+            hash_index_free(&cv->quotes.id_index);
+        }
+        acct_free(cv);
+        pthread_mutex_unlock(&writer_lock);
+        write_log(ERROR, "Unable to allocate memory for catalog version.");
+        fprintf(stderr, "Unable to allocate memory for catalog version.\n");
+        return NULL;
+    }
+    
+    // Unchanged parts keep their derived data, the old version gives it up
+    if (!(parts & CATALOG_QUOTES))
+    {
+        atomic_store(&cv->groups, atomic_exchange(&old->groups, NULL));
+    }
+    if (!(parts & CATALOG_PRODUCTS))
+    {
+        atomic_store(&cv->names, atomic_exchange(&old->names, NULL));
+    }
+    update_parts = parts;
+    update_active = 1;
+    return cv;
+}
+
+
+void catalog_retire(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    if (!update_active)
+    {
+        rcu_retire(ptr, free_retired);
+        return;
+    }
+    
+    if (pending_cnt >= pending_limit)
+    {
+        int new_limit = pending_limit == 0 ? CATALOG_RETIRE_MIN_ALLOC :
+                        pending_limit * 2;
+        void **p_temp = acct_realloc(ALLOC_OTHER, pending, sizeof(void *) *
+                                     (size_t)new_limit);
+        if (p_temp == NULL)
+        {
+            // Still reachable through the published version, can not be freed
+            write_log(ERROR, "Unable to allocate memory for retiring replaced "
+                      "data. It will not be freed.");
+            return;
+        }
+        pending = p_temp;
+        pending_limit = new_limit;
+    }
+    *(pending + pending_cnt) = ptr;
+    pending_cnt++;
+}
+
+
+void catalog_update_commit(struct catalog_version *cv)
+{
+    struct catalog_version *old = atomic_exchange(&current, cv);
+    update_active = 0;
+    metrics_set(MET_G_PRODUCTS, cv->products.lines);
+    metrics_set(MET_G_QUOTES, cv->quotes.lines);
+    metrics_set(MET_G_VERSION, cv->version);
+    
+    // Replaced data is unreachable for new readers only from now on
+    for (int i = 0; i < pending_cnt; i++)
+    {
+        rcu_retire(*(pending + i), free_retired);
+    }
+    pending_cnt = 0;
+    
+    // Only arrays and indexes, that were copied, belong to the old version
+    if (update_parts & CATALOG_PRODUCTS)
+    {
+        rcu_retire(old->products.data, free_retired);
+        rcu_retire(old->products.code_index.slots, free_retired);
+    }
+    if (update_parts & CATALOG_QUOTES)
+    {
+        rcu_retire(old->quotes.data, free_retired);
+        rcu_retire(old->quotes.id_index.slots, free_retired);
+    }
+    rcu_retire(old, free_version);
+    pthread_mutex_unlock(&writer_lock);
+    
+    rcu_reclaim();
+}
+
+
+/*
+    Gives derived data taken over by an aborted update back to the current
+    version. A reader may have built new data for it in the meantime, then
+    the given back data is freed.
+*/
+static void give_back_groups(struct catalog_version *dest,
+                             struct catalog_version *src)
+{
+    struct quote_groups *qg = atomic_exchange(&src->groups, NULL);
+    struct quote_groups *expected = NULL;
+    if (qg != NULL && !atomic_compare_exchange_strong(&dest->groups,
+                                                      &expected, qg))
+    {
+        free_groups(qg);
+    }
+}
+
+
+static void give_back_names(struct catalog_version *dest,
+                            struct catalog_version *src)
+{
+    struct trigram_index *ti = atomic_exchange(&src->names, NULL);
+    struct trigram_index *expected = NULL;
+    if (ti != NULL && !atomic_compare_exchange_strong(&dest->names,
+                                                      &expected, ti))
+    {
+        free_names(ti);
+    }
+}
+
+
+void catalog_update_abort(struct catalog_version *cv)
+{
+    struct catalog_version *old = atomic_load(&current);
+    update_active = 0;
+    
+    // Retired memory is still used by the current version
+    pending_cnt = 0;
+    
+    if (update_parts & CATALOG_PRODUCTS)
+    {
+        acct_free(cv->products.data);
+        hash_index_free(&cv->products.code_index);
+    }
+    else
+    {
+        give_back_names(old, cv);
+    }
+    if (update_parts & CATALOG_QUOTES)
+    {
+        acct_free(cv->quotes.data);
+        hash_index_free(&cv->quotes.id_index);
+    }
+    else
+    {
+        give_back_groups(old, cv);
+    }
+    free_version(cv);
+    pthread_mutex_unlock(&writer_lock);
+}
+
+
+void catalog_free(void)
+{
+    pthread_mutex_lock(&writer_lock);
+    struct catalog_version *cv = atomic_exchange(&current, NULL);
+    pthread_mutex_unlock(&writer_lock);
+    
+    rcu_synchronize();
+    acct_free(pending);
+    pending = NULL;
+    pending_limit = 0;
+    if (cv != NULL)
+    {
+        free_product_info(&cv->products);
+        free_quote_info(&cv->quotes);
+        free_version(cv);
+    }
+}
@@ -3,38 +3,162 @@ File:         csv_helper.c
 Author:       Anton Jaska
 Created:      2024.12.00
 Modified:     2024.04.20
-Description:  Code for reading a simplified CSV file (no column descriptions and
-              no quotations). Dynamic buffers are used for reading, to not limit
-              data line length.
+Description:  Code for reading CSV files. Fields can be quoted as in RFC 4180,
+              so they can contain delimiters, newlines and escaped quotes ("").
+              Files are read in blocks and structural characters are found
+              with the vectorized scanner of csv_scan.c. Regular files are
+              read ahead through io_uring when the kernel supports it. Dynamic
+              buffers are used for reading, to not limit data line length.
 */
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <alloc_acct.h>
 #include <log_handler.h>
+#include <csv_scan.h>
+#include <async_read.h>
+#include <trace.h>
 #include <csv_helper.h>
 
-static char *p_line_buffer = NULL;
+/*
+    Data read from a file, but not yet returned as lines.
+*/
+struct read_block
+{
+    FILE *p_file;
+    char *data;                     // Buffer for fread
+    char *cur;                      // Block being read, data or async block
+    size_t pos;
+    size_t len;
+    int eof;
+    int err;                        // Set with eof, if reading failed
+    struct async_reader reader;     // reader.ring is NULL when not in use
+};
+
+// Every thread has its own buffers, so files can be read in parallel
+static _Thread_local char *p_line_buffer = NULL;
+static _Thread_local size_t buffer_len = 0;
+static _Thread_local struct read_block block;
+
+static int read_line_malloc_err(char **str)
+{
+    char *err = "Failed to allocate memory for dynamic string "
+                "while reading data file.";
+    free_buffer_manually();
+    write_log(ERROR, err);
+    fprintf(stderr, "%s\n", err);
+    *str = NULL;
+    return CSV_MALLOC_ERR;
+}
+
+
+static int read_line_read_err(char **str)
+{
+    char *err = "Failed to read data file, it is not read further.";
+    free_buffer_manually();
+    write_log(ERROR, err);
+    fprintf(stderr, "%s\n", err);
+    *str = NULL;
+    return CSV_READ_ERR;
+}
+
+
+/*
+    Reads the next block of the file. Sets block.eof, if nothing could be read
+    and block.err too, if it was because of a read error.
+*/
+static void fill_block(void)
+{
+    uint64_t span = trace_begin();
+    block.pos = 0;
+    if (block.reader.ring != NULL)
+    {
+        long len = async_reader_next(&block.reader, &block.cur);
+        block.len = len > 0 ? (size_t)len : 0;
+        block.err = len < 0;
+    }
+    else
+    {
+        block.cur = block.data;
+        block.len = fread(block.data, 1, CSV_BLOCK_SIZE, block.p_file);
+        block.err = block.len == 0 && ferror(block.p_file);
+    }
+    if (block.len == 0)
+    {
+        block.eof = 1;
+    }
+    trace_end(span, TRACE_CAT_IO, "read block", (int64_t)block.len);
+}
+
 
 int read_line(FILE *p_file, char **str)
-{    
-    int chars_read = 0;
-    static int buffer_len = 0;
-    char *temp = NULL;
-    char *current = NULL;
+{
+    // Have same data read before simulating realloc fail
+    #ifdef FUNC_READ_LINE_TEST
+    static _Thread_local int lines_read = 0;
+    lines_read++;
+    #endif
+    
+    if (block.p_file != p_file)
+    {
+        async_reader_close(&block.reader);
+        async_reader_open(&block.reader, p_file);
+        block.p_file = p_file;
+        block.pos = 0;
+        block.len = 0;
+        block.eof = 0;
+        block.err = 0;
+    }
+    // Buffer for fread is only needed without the async reader
+    if (block.reader.ring == NULL && block.data == NULL)
+    {
+        block.data = acct_malloc(ALLOC_LINE_BUF, CSV_BLOCK_SIZE);
+        if (block.data == NULL)
+        {
+            return read_line_malloc_err(str);
+        }
+    }
+    
+    size_t line_len = 0;
+    int rec_state = REC_FIELD_START;
     while (1)
     {
-        // Have same data read before simulating realloc fail
+        if (block.pos == block.len)
+        {
+            if (block.eof)
+            {
+                if (block.err)
+                {
+                    return read_line_read_err(str);
+                }
+                break;
+            }
+            fill_block();
+            continue;
+        }
+        
+        char *start = block.cur + block.pos;
+        size_t avail = block.len - block.pos;
+        size_t end = scan_record_end(start, avail, CSV_DELIMITER,
+                                     &rec_state);
+        
+        // Allocate more memory, if line buffer is too small
+        int grow = line_len + end + 1 > buffer_len;
         #ifdef FUNC_READ_LINE_TEST
-        static int lines_read = 0;
-        lines_read++;
+        grow = grow || lines_read > 10;
         #endif
-        
-        // Allocate more memory, if line buffer is full
-        if (buffer_len <= chars_read)
+        if (grow)
         {
-            buffer_len += DYN_BUF_STEP;
-            temp = realloc(p_line_buffer, (size_t)buffer_len);
+            size_t new_len = buffer_len < DYN_BUF_STEP ? DYN_BUF_STEP
+                                                       : buffer_len;
+            while (new_len < line_len + end + 1)
+            {
+                new_len *= 2;
+            }
+            char *temp = acct_realloc(ALLOC_LINE_BUF, p_line_buffer, new_len);
             
             // Have same data read before simulating realloc fail
             #ifdef FUNC_READ_LINE_TEST
@@ -51,109 +175,161 @@ int read_line(FILE *p_file, char **str)
             
             if (temp == NULL)
             {
-                char *err = "Failed to allocate memory for dynamic string "
-                            "while reading data file.";
-                free_buffer_manually();
-                write_log(ERROR, err);
-                fprintf(stderr, "%s\n", err);
-                *str = NULL;
-                return CSV_MALLOC_ERR;
+                return read_line_malloc_err(str);
             }
             p_line_buffer = temp;
+            buffer_len = new_len;
+            acct_set_unused(p_line_buffer, new_len - (line_len + end + 1));
         }
+        memcpy(p_line_buffer + line_len, start, end);
+        line_len += end;
+        block.pos += end;
         
-        current = (p_line_buffer + chars_read);
-        *current = (char)fgetc(p_file);
-        
-        if (!chars_read)
+        if (end < avail) // Record ending newline found
         {
-            if (feof(p_file)) // EOF, no chars read
-            {
-                // Buffer reset after finishing every file
-                free_buffer_manually();
-                buffer_len = 0;
-                *str = NULL;
-                return EOF;
-            }
-            if (*current == '\n') // Empty line skip
+            block.pos++;
+            if (line_len == 0) // Empty line skip
             {
                 continue;
             }
-        }
-        chars_read++;
-        
-        if (*current == '\n')
-        {
-            *current = '\0';  // Get rid of newline and end string
             break;
         }
-        if (feof(p_file)) // File ended without newline
-        {
-            if (buffer_len > chars_read)
-            {
-                *(current + 1) = '\0';
-                break;
-            }
-            else
-            {
-                buffer_len += DYN_BUF_STEP;
-                temp = realloc(p_line_buffer, (size_t)buffer_len);
-                
-                if (temp == NULL)
-                {
-                    char *err = "Failed to allocate memory for dynamic string "
-                                "while reading data file.";
-                    free_buffer_manually();
-                    write_log(ERROR, err);
-                    fprintf(stderr, "%s\n", err);
-                    *str = NULL;
-                    return CSV_MALLOC_ERR;
-                }
-                
-                // Cant use current because of realloc
-                *(p_line_buffer + chars_read) = '\0';
-                p_line_buffer = temp;
-                break;
-            }
-        }
     }
     
+    if (line_len == 0) // EOF, no chars read
+    {
+        // Buffer reset after finishing every file
+        free_buffer_manually();
+        *str = NULL;
+        return EOF;
+    }
+    *(p_line_buffer + line_len) = '\0';
     *str = p_line_buffer;
     
-    return chars_read;
+    return line_len > INT_MAX ? INT_MAX : (int)line_len;
 }
 
 
-char *get_field(char *src, int field_num)
+/*
+    Terminates the field starting at *p_pos and moves *p_pos to the start of
+    the next field, NULL if there is none. *end is the '\0' ending the line.
+    A quoted field is unquoted in place. Returns the start of the field.
+*/
+static char *next_field(char **p_pos, char *end)
 {
-    int i = 0;
-    int field_cnt = 1;
+    char *src = *p_pos;
+    while (*src == ' ') // Removes leading spaces from a field
+    {
+        src++;
+    }
+    
+    if (*src != CSV_QUOTE)
+    {
+        char *delim = src + scan_for2(src, (size_t)(end - src), CSV_DELIMITER,
+                                      CSV_DELIMITER);
+        *p_pos = delim == end ? NULL : delim + 1;
+        *delim = '\0';
+        return src;
+    }
     
-    while (field_cnt < field_num)
-    {   
-        if (*(src + i) == CSV_DELIMITER)
+    // Quoted field, "" inside quotes is one quote
+    char *write = src;
+    char *read = src + 1;
+    while (read < end)
+    {
+        size_t len = scan_for2(read, (size_t)(end - read), CSV_QUOTE,
+                               CSV_QUOTE);
+        memmove(write, read, len);
+        write += len;
+        read += len;
+        if (read == end) // Closing quote missing
+        {
+            break;
+        }
+        if (*(read + 1) == CSV_QUOTE)
         {
-            field_cnt++;
+            *write = CSV_QUOTE;
+            write++;
+            read += 2;
+            continue;
         }
-        else if (*(src + i) == '\0')
+        
+        // Closing quote, anything before the next delimiter is ignored
+        read++;
+        read += scan_for2(read, (size_t)(end - read), CSV_DELIMITER,
+                          CSV_DELIMITER);
+        break;
+    }
+    *p_pos = read >= end ? NULL : read + 1;
+    *write = '\0';
+    return src;
+}
+
+
+char *get_field(char *src, int field_num)
+{
+    char *end = src + strlen(src);
+    char *pos = src;
+    char *field = NULL;
+    for (int i = 0; i < field_num; i++)
+    {
+        if (pos == NULL)
         {
             return NULL;
         }
-        i++;
+        field = next_field(&pos, end);
+    }
+    return field;
+}
+
+
+int split_fields(char *src, char **fields, int max_fields)
+{
+    char *end = src + strlen(src);
+    int field_cnt = 0;
+    char *pos = src;
+    while (pos != NULL && field_cnt < max_fields)
+    {
+        *(fields + field_cnt) = next_field(&pos, end);
+        field_cnt++;
+    }
+    return field_cnt;
+}
+
+
+void print_csv_field(FILE *fp, const char *str)
+{
+    // Leading spaces are removed when reading, so they need quotes too
+    if (*str != ' ' && strpbrk(str, CSV_QUOTED_CHARS) == NULL)
+    {
+        fputs(str, fp);
+        return;
     }
-    while (*(src + i) == ' ') // Removes leading spaces from a field
+    fputc(CSV_QUOTE, fp);
+    for (; *str != '\0'; str++)
     {
-        i++;
+        if (*str == CSV_QUOTE)
+        {
+            fputc(CSV_QUOTE, fp);
+        }
+        fputc(*str, fp);
     }
-    int j;
-    for (j = i; *(src + j) != CSV_DELIMITER && *(src + j) != '\0'; j++);
-    *(src + j) = '\0';
-    return src + i;
+    fputc(CSV_QUOTE, fp);
 }
 
 
 void free_buffer_manually(void)
 {
-    free(p_line_buffer);
+    acct_free(p_line_buffer);
     p_line_buffer = NULL;
+    buffer_len = 0;
+    async_reader_close(&block.reader);
+    acct_free(block.data);
+    block.data = NULL;
+    block.cur = NULL;
+    block.p_file = NULL;
+    block.pos = 0;
+    block.len = 0;
+    block.eof = 0;
+    block.err = 0;
 }
@@ -0,0 +1,241 @@
+/*
+File:         csv_scan.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Vectorized search for structural characters of CSV data. Uses
+              AVX2 or SSE2 when the CPU supports them, otherwise goes byte by
+              byte.
+*/
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <csv_scan.h>
+
+#if !defined(CSV_SCAN_SCALAR) && (defined(__x86_64__) || defined(__i386__))
+#define CSV_SCAN_X86
+#include <immintrin.h>
+#endif
+
+#define QUOTE_CHAR '"'
+
+typedef size_t (*scan_fn)(const char *buf, size_t len, char a, char b);
+
+static size_t scan_scalar(const char *buf, size_t len, char a, char b)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (*(buf + i) == a || *(buf + i) == b)
+        {
+            return i;
+        }
+    }
+    return len;
+}
+
+
+#ifdef CSV_SCAN_X86
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char *buf, size_t len, char a, char b)
+{
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                   _mm_cmpeq_epi8(chunk, vb));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + scan_scalar(buf + i, len - i, a, b);
+}
+
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *buf, size_t len, char a, char b)
+{
+    __m256i va = _mm256_set1_epi8(a);
+    __m256i vb = _mm256_set1_epi8(b);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(buf + i));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va),
+                                      _mm256_cmpeq_epi8(chunk, vb));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    // Tail is done here, calling legacy SSE code with dirty upper halves of
+    // the AVX registers would stall on every call
+    if (i + 16 <= len)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(a)),
+                                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8(b)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+        i += 16;
+    }
+    return i + scan_scalar(buf + i, len - i, a, b);
+}
+#endif
+
+
+static enum scan_isa pick_isa(void)
+{
+    #ifdef CSV_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SCAN_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SCAN_ISA_SSE2;
+    }
+    #endif
+    return SCAN_ISA_SCALAR;
+}
+
+
+static size_t scan_dispatch(const char *buf, size_t len, char a, char b);
+
+// Resolved on the first scan. Every thread picks the same, so a race is fine
+static _Atomic(scan_fn) scan_impl = scan_dispatch;
+
+static size_t scan_dispatch(const char *buf, size_t len, char a, char b)
+{
+    scan_fn fn = scan_scalar;
+    #ifdef CSV_SCAN_X86
+    switch (pick_isa())
+    {
+        case SCAN_ISA_AVX2:
+            fn = scan_avx2;
+            break;
+            
+        case SCAN_ISA_SSE2:
+            fn = scan_sse2;
+            break;
+            
+        default:
+            break;
+    }
+    #endif
+    atomic_store_explicit(&scan_impl, fn, memory_order_relaxed);
+    return fn(buf, len, a, b);
+}
+
+
+size_t scan_for2(const char *buf, size_t len, char a, char b)
+{
+    scan_fn fn = atomic_load_explicit(&scan_impl, memory_order_relaxed);
+    return fn(buf, len, a, b);
+}
+
+
+// Checks if the quote at buf + pos starts a field. Only spaces can be between
+// the delimiter and the opening quote, as next_field skips them.
+static int opens_field(const char *buf, size_t pos, char delim, int state)
+{
+    while (pos > 0 && *(buf + pos - 1) == ' ')
+    {
+        pos--;
+    }
+    if (pos == 0)
+    {
+        return state == REC_FIELD_START;
+    }
+    return *(buf + pos - 1) == delim;
+}
+
+
+size_t scan_record_end(const char *buf, size_t len, char delim, int *state)
+{
+    size_t i = 0;
+    
+    // Previous block ended with a quote that closed the field or was the
+    // first half of an escaped quote
+    if (*state == REC_QUOTE_END && len > 0)
+    {
+        if (*buf == QUOTE_CHAR)
+        {
+            *state = REC_QUOTED;
+            i++;
+        }
+        else
+        {
+            *state = REC_IN_FIELD;
+        }
+    }
+    while (1)
+    {
+        i += scan_for2(buf + i, len - i, '\n', QUOTE_CHAR);
+        if (i >= len)
+        {
+            break;
+        }
+        if (*(buf + i) == QUOTE_CHAR)
+        {
+            if (*state == REC_QUOTED)
+            {
+                // Escaped quote "" keeps the field open
+                if (i + 1 == len)
+                {
+                    *state = REC_QUOTE_END;
+                    return len;
+                }
+                if (*(buf + i + 1) == QUOTE_CHAR)
+                {
+                    i++;
+                }
+                else
+                {
+                    *state = REC_IN_FIELD;
+                }
+            }
+            else if (opens_field(buf, i, delim, *state))
+            {
+                *state = REC_QUOTED;
+            }
+            // Other quotes are part of an unquoted field
+        }
+        else if (*state != REC_QUOTED)
+        {
+            return i;
+        }
+        i++;
+    }
+    
+    // Record continues in the next block, remember if a field starts there
+    if (*state != REC_QUOTED && *state != REC_QUOTE_END)
+    {
+        size_t end = len;
+        while (end > 0 && *(buf + end - 1) == ' ')
+        {
+            end--;
+        }
+        if (end > 0)
+        {
+            *state = *(buf + end - 1) == delim ? REC_FIELD_START
+                                               : REC_IN_FIELD;
+        }
+    }
+    return len;
+}
+
+
+enum scan_isa get_scan_isa(void)
+{
+    return pick_isa();
+}
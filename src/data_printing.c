@@ -7,8 +7,9 @@ Description:  Most of the functions, that print formatted data.
 */
 
 #include <stdio.h>
-#include <csv_helper.h>
 #include <main.h>
+#include <dictionary.h>
+#include <out_buf.h>
 #include <data_printing.h>
 
 void print_menu(void)
@@ -18,73 +19,62 @@ void print_menu(void)
     printf("%d - Edit product RAM\n", MENU_OPT_EDIT_RAM);
     printf("%d - Edit quote retailer\n", MENU_OPT_EDIT_RTLR);
     printf("%d - Search for product\n", MENU_OPT_SRCH_PRO);
+    printf("%d - Price history of quote\n", MENU_OPT_HIST_TREND);
+    printf("%d - Lowest recent price of product\n", MENU_OPT_HIST_LOW);
+    printf("%d - Apply quote changes file\n", MENU_OPT_APPLY_DELTA);
+    printf("%d - Bulk edit products from file\n", MENU_OPT_BULK_EDIT);
+    printf("%d - Browse data by pages\n", MENU_OPT_BROWSE);
+    printf("%d - Retailer report\n", MENU_OPT_RTLR_REPORT);
+    printf("%d - Run query\n", MENU_OPT_QUERY);
+    printf("%d - Add watch rule\n", MENU_OPT_WATCH_ADD);
     printf("%d - EXIT\n", MENU_OPT_EXIT);
     putchar('\n');
 }
 
 
-void print_product_specs(struct product_info pi)
+void print_product_specs(struct out_buf *ob, struct product_info pi)
 {
-    printf("\nProduct: %s\n", pi.p_name);
-    printf("\t%-13s %d MB\n", "RAM:", pi.ram);
-    printf("\t%-13s %.1f \"\n", "Screen size:", pi.screen_size);
-    printf("\t%-13s %s\n", "OS:", pi.p_os);
-    printf("\t%-13s %s\n", "Product code:", pi.p_code);
+    buf_printf(ob, "\nProduct: %s\n", pi.p_name);
+    buf_printf(ob, "\t%-13s %d MB\n", "RAM:", pi.ram);
+    buf_printf(ob, "\t%-13s %.1f \"\n", "Screen size:",
+               pi.screen_size);
+    buf_printf(ob, "\t%-13s %s\n", "OS:", pi.p_os);
+    buf_printf(ob, "\t%-13s %s\n", "Product code:", pi.p_code);
 }
 
 
-void print_product_quote(struct quote_info qi)
+void print_product_quote(struct out_buf *ob, struct quote_info qi)
 {
-    printf("| %-16s ", qi.p_retailer);
-    printf("| %8.2f EUR ", CNTS_TO_EUR((float)qi.price));
+    buf_printf(ob, "| %-16s ", dict_string(DICT_RETAILER, qi.retailer_id));
+    buf_printf(ob, "| %8.2f EUR ", CNTS_TO_EUR((double)qi.price));
     if (qi.stock > 0)
     {
-        printf("| %3d %-8s ", qi.stock, "In Stock");
+        buf_printf(ob, "| %3d %-8s ", qi.stock, "In Stock");
     }
     else
     {
-        printf("| %3s %-8s ", "", "Order");
+        buf_printf(ob, "| %3s %-8s ", "", "Order");
     }
-    printf("| %s", qi.p_id);
-    putchar('\n');
+    buf_printf(ob, "| %s", qi.p_id);
+    buf_putc(ob, '\n');
 }
 
 
-void print_quote_table_head(void)
+void print_quote_table_head(struct out_buf *ob)
 {
-    printf("| %16s ", "Retailer");
-    printf("| %12s ", "Price");
-    printf("| %12s ", "Stock status");
-    printf("| %s", "Quote ID");
-    putchar('\n');
+    buf_printf(ob, "| %16s ", "Retailer");
+    buf_printf(ob, "| %12s ", "Price");
+    buf_printf(ob, "| %12s ", "Stock status");
+    buf_printf(ob, "| %s", "Quote ID");
+    buf_putc(ob, '\n');
 }
 
 
-void print_separator_line(void)
+void print_separator_line(struct out_buf *ob)
 {
     for (int i = 0; i < SEP_LINE_LEN; i++)
     {
-        putchar('-');
+        buf_putc(ob, '-');
     }
-    putchar('\n');
-}
-
-
-void print_product_csv_line(FILE *fp, struct product_info pi)
-{
-    fprintf(fp, "%s%c", pi.p_code, CSV_DELIMITER);
-    fprintf(fp, "%s%c", pi.p_name, CSV_DELIMITER);
-    fprintf(fp, "%d%c", pi.ram, CSV_DELIMITER);
-    fprintf(fp, "%.1f%c", pi.screen_size, CSV_DELIMITER);
-    fprintf(fp, "%s\n", pi.p_os);
-}
-
-
-void print_quote_csv_line(FILE *fp, struct quote_info qi)
-{
-    fprintf(fp, "%s%c", qi.p_id, CSV_DELIMITER);
-    fprintf(fp, "%s%c", qi.p_code, CSV_DELIMITER);
-    fprintf(fp, "%s%c", qi.p_retailer, CSV_DELIMITER);
-    fprintf(fp, "%d%c", qi.price, CSV_DELIMITER);
-    fprintf(fp, "%d\n", qi.stock);
+    buf_putc(ob, '\n');
 }
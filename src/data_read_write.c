@@ -10,17 +10,28 @@ Description:  Functions that handle errors and the logic of reading from and
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <alloc_acct.h>
 #include <log_handler.h>
 #include <csv_helper.h>
 #include <main.h>
-#include <data_printing.h>
+#include <data_stream.h>
 #include <data_read_write.h>
+#include <record_schema.h>
+#include <hash_index.h>
+#include <trace.h>
+#include <latency.h>
+#include <metrics.h>
 
 FILE *open_file(char *f_name, char *mode)
 {
     char msg[MAX_ERR_MSG_LEN];
     FILE *fp;
+    uint64_t span = trace_begin();
     fp = fopen(f_name, mode);
+    trace_end(span, TRACE_CAT_IO, "open file", TRACE_NO_CNT);
     if (fp == NULL)
     {
         snprintf(msg, MAX_ERR_MSG_LEN, "Unable to open file \"%s\" in mode "
@@ -36,226 +47,284 @@ FILE *open_file(char *f_name, char *mode)
 }
 
 
-int read_data_products(char *f_name, struct product_data_wrapper *pdw)
+/*
+    Layout of a data file, that was loaded with a header row. Keeps the header
+    fields, the column of every field and the values of unknown columns of
+    every row by the rows key (first column of the column table), so the file
+    is saved in the same layout.
+*/
+struct file_layout
 {
-    char msg[MAX_ERR_MSG_LEN];
-    char *line_buffer;
-    FILE *p_file = open_file(f_name, "r");
-    if (p_file == NULL)
+    char *f_name;
+    int field_cnt;
+    int cols[CSV_FIELDS_MAX];       // Column of every field, -1 if unknown
+    char *names[CSV_FIELDS_MAX];    // Header fields
+    int extra_cnt;                  // Unknown fields in every row
+    struct hash_index extra_index;  // Key -> row in extras
+    char **extras;                  // Key and unknown fields, '\0' separated
+    size_t extra_rows;
+    size_t extra_limit;
+    struct file_layout *next;
+};
+
+// Quote files are read in parallel, layouts are only added while loading
+static struct file_layout *layouts = NULL;
+static pthread_mutex_t layouts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void free_layout(struct file_layout *fl)
+{
+    acct_free(fl->f_name);
+    for (int j = 0; j < fl->field_cnt; j++)
     {
-        pdw->lines = 0;
-        return EXIT_FAILURE;
+        acct_free(*(fl->names + j));
     }
-    
-    // Dynamic allocation variables
-    struct product_info *p_arr = NULL;
-    struct product_info *p_temp = NULL;
-    struct product_info pro_buf;
-    int count = 0;
-    int return_val;
-    int alloc_limit = MIN_ALLOC_LINE_CNT;
-    
-    enum read_errors err_code;
-    while (1)
+    for (size_t i = 0; i < fl->extra_rows; i++)
     {
-        return_val = read_line(p_file, &line_buffer);
-        if (return_val == EOF)
-        {
-            break;
-        }
-        else if (return_val == CSV_MALLOC_ERR)
-        {
-            pdw->data = p_arr;
-            pdw->lines = count;
-            fclose(p_file);
-            return EXIT_FAILURE;
-        }
-        
-        // Allocate memory if necessary
-        if (count >= alloc_limit || count == 0)
-        {
-            alloc_limit *= 2;
-            p_temp = realloc(p_arr, pdw->data_struct_size * (size_t)(alloc_limit));
-                        
-            // Have same data read before simulating realloc fail
-            #ifdef FUNC_READ_DATA_PRODUCTS_TEST
-            if (count > MIN_ALLOC_LINE_CNT * 2)
-            {
-                printf("Simulating realloc fail. (Products reading)\n");
-                if (p_temp != NULL)
-                {
-                    p_arr = p_temp;
-                    p_temp = NULL;
-                }
-            }
-            #endif
-            
-            if (p_temp == NULL)
-            {
-                snprintf(msg, MAX_ERR_MSG_LEN, "Unable to expand data array from"
-                         " length %d to %d", count, alloc_limit);
-                write_log(ERROR, msg);
-                fprintf(stderr, "%s\n", msg);
-                pdw->data = p_arr;
-                pdw->lines = count;
-                fclose(p_file);
-                free_buffer_manually();
-                return EXIT_FAILURE;
-            }
-            p_arr = p_temp;
-        }
-        
-        err_code = get_product_info(&pro_buf, line_buffer);
-        
-        // Copy buffer to data array
-        *(p_arr + count) = pro_buf;
-        count++;
-        
-        if (err_code != READ_OK)
-        {
-            if (print_read_error(err_code, f_name, count) == READ_ERR_FATAL)
-            {
-                pdw->data = p_arr;
-                pdw->lines = count;
-                fclose(p_file);
-                free_buffer_manually();
-                return EXIT_FAILURE;
-            }
-        }
+        acct_free(*(fl->extras + i));
     }
-    fclose(p_file);
-    snprintf(msg, MAX_ERR_MSG_LEN, "Closed file \"%s\".", f_name);
-    write_log(INFO, msg);
-    
-    // Free excess allocated memory
-    p_temp = realloc(p_arr, pdw->data_struct_size * (size_t)(count));
-    if (p_temp == NULL)
+    acct_free(fl->extras);
+    hash_index_free(&fl->extra_index);
+    acct_free(fl);
+}
+
+
+/*
+    Creates the layout of a file from its header row and the column map made
+    from it. Returns NULL on memory allocation error.
+*/
+static struct file_layout *new_layout(char *f_name, char **fields,
+                                      int field_cnt,
+                                      const struct record_schema *schema,
+                                      const int *col_map)
+{
+    struct file_layout *fl = acct_calloc(ALLOC_OTHER, 1,
+                                         sizeof(struct file_layout));
+    if (fl == NULL)
     {
-        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to free excess memory");
-        write_log(ERROR, msg);
-        fprintf(stderr, "%s\n", msg);
-        pdw->data = p_arr;
-        pdw->lines = count;
-        return EXIT_FAILURE;
+        return NULL;
     }
-    
-    // Save to wrapper
-    pdw->data = p_temp;
-    pdw->lines = count;
-    snprintf(msg, MAX_ERR_MSG_LEN, "Product data read successfully.");
-    write_log(INFO, msg);
-    return EXIT_SUCCESS;
+    fl->f_name = dynamic_string(f_name, ALLOC_OTHER);
+    int ok = fl->f_name != NULL;
+    for (int j = 0; j < field_cnt; j++)
+    {
+        *(fl->cols + j) = -1;
+    }
+    for (int i = 0; i < schema->col_cnt; i++)
+    {
+        *(fl->cols + *(col_map + i)) = i;
+    }
+    for (int j = 0; ok && j < field_cnt; j++)
+    {
+        *(fl->names + j) = dynamic_string(*(fields + j), ALLOC_OTHER);
+        ok = *(fl->names + j) != NULL;
+        fl->field_cnt = j + 1;
+        fl->extra_cnt += *(fl->cols + j) < 0;
+    }
+    if (!ok)
+    {
+        free_layout(fl);
+        return NULL;
+    }
+    return fl;
 }
 
 
-int get_product_info(struct product_info *pi, char *buf)
+/*
+    Keeps the unknown fields of a row. The first row with the same key is
+    kept. Returns EXIT_FAILURE on memory allocation error.
+*/
+static int add_layout_row(struct file_layout *fl, char **fields, int field_cnt,
+                          const int *col_map)
 {
-    char field[STR_MAX];
-    char *p_field;
-    int error_status = READ_OK; // For non fatal errors
-    
-    // Initialize in case an error might occur
-    pi->p_code = NULL;
-    pi->p_name = NULL;
-    pi->p_os = NULL;
-    
-    // Getting product code
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_PRO_FIELD_CODE);
-    if (p_field == NULL)
+    if (fl->extra_cnt == 0 || *col_map >= field_cnt ||
+        hash_index_get(&fl->extra_index, *(fields + *col_map)) !=
+        HASH_NOT_FOUND)
     {
-        return READ_ERR_MSNG_DATA;
+        return EXIT_SUCCESS;
     }
-    pi->p_code = dynamic_string(p_field);
-    if (pi->p_code == NULL)
+    
+    char *key = *(fields + *col_map);
+    size_t len = strlen(key) + 1;
+    for (int j = 0; j < fl->field_cnt; j++)
     {
-        return READ_ERR_STR_MALLOC;
+        if (*(fl->cols + j) < 0 && j < field_cnt)
+        {
+            len += strlen(*(fields + j));
+        }
+        len += *(fl->cols + j) < 0;
     }
     
-    // Getting product name
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_PRO_FIELD_NAME);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
+    if (fl->extra_rows >= fl->extra_limit)
+    {
+        size_t new_limit = acct_grow_limit(fl->extra_limit, MIN_ALLOC_LINE_CNT,
+                                           sizeof(char *));
+        char **temp = new_limit == 0 ? NULL :
+                      acct_realloc(ALLOC_OTHER, fl->extras,
+                                   sizeof(char *) * new_limit);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        fl->extras = temp;
+        fl->extra_limit = new_limit;
     }
-    pi->p_name = dynamic_string(p_field);
-    if (pi->p_name == NULL)
+    char *row = acct_malloc(ALLOC_OTHER, len);
+    if (row == NULL)
     {
-        return READ_ERR_STR_MALLOC;
+        return EXIT_FAILURE;
     }
     
-    // Getting product OS
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_PRO_FIELD_OS);
-    if (p_field == NULL)
+    // Missing fields of a short row are kept as empty
+    char *dest = stpcpy(row, key) + 1;
+    for (int j = 0; j < fl->field_cnt; j++)
     {
-        return READ_ERR_MSNG_DATA;
+        if (*(fl->cols + j) < 0)
+        {
+            dest = stpcpy(dest, j < field_cnt ? *(fields + j) : "") + 1;
+        }
     }
-    pi->p_os = dynamic_string(p_field);
-    if (pi->p_os == NULL)
+    if (hash_index_put(&fl->extra_index, row, (int64_t)fl->extra_rows) !=
+        HASH_OK)
     {
-        return READ_ERR_STR_MALLOC;
+        acct_free(row);
+        return EXIT_FAILURE;
     }
-    
-    // Getting product RAM
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_PRO_FIELD_RAM);
-    if (p_field == NULL)
+    *(fl->extras + fl->extra_rows++) = row;
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Adds a layout, a layout of a file read before is replaced.
+*/
+static void register_layout(struct file_layout *fl)
+{
+    pthread_mutex_lock(&layouts_lock);
+    struct file_layout **p_fl = &layouts;
+    while (*p_fl != NULL && strcmp((*p_fl)->f_name, fl->f_name) != 0)
     {
-        return READ_ERR_MSNG_DATA;
+        p_fl = &(*p_fl)->next;
     }
-    if (sscanf(p_field, "%d", &pi->ram) != 1)
+    if (*p_fl != NULL)
     {
-       pi->ram = 0;
-       error_status = READ_ERR_RAM_NINT;
+        struct file_layout *old = *p_fl;
+        *p_fl = old->next;
+        free_layout(old);
     }
-    if (pi->ram < 0)
+    fl->next = layouts;
+    layouts = fl;
+    pthread_mutex_unlock(&layouts_lock);
+}
+
+
+static struct file_layout *find_layout(const char *f_name)
+{
+    pthread_mutex_lock(&layouts_lock);
+    struct file_layout *fl = layouts;
+    while (fl != NULL && strcmp(fl->f_name, f_name) != 0)
     {
-        pi->ram = 0;
-        error_status = READ_ERR_RAM_NEG;
+        fl = fl->next;
     }
-    
-    // Getting product screen size
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_PRO_FIELD_SCRN);
-    if (p_field == NULL)
+    pthread_mutex_unlock(&layouts_lock);
+    return fl;
+}
+
+
+static void print_layout_header(FILE *fp, struct file_layout *fl)
+{
+    for (int j = 0; j < fl->field_cnt; j++)
     {
-        return READ_ERR_MSNG_DATA;
+        if (j != 0)
+        {
+            fputc(CSV_DELIMITER, fp);
+        }
+        print_csv_field(fp, *(fl->names + j));
     }
-    if (sscanf(p_field, "%f", &pi->screen_size) != 1)
+    fputc('\n', fp);
+}
+
+
+/*
+    Writes a record in the layout of its file. Unknown columns get the values
+    read for the same key, empty for a record added after loading.
+*/
+static void print_layout_row(FILE *fp, struct file_layout *fl,
+                             const struct record_schema *schema,
+                             const void *rec, const char *key)
+{
+    int64_t row = fl->extra_cnt == 0 ? HASH_NOT_FOUND :
+                  hash_index_get(&fl->extra_index, key);
+    const char *extra = row == HASH_NOT_FOUND ? NULL :
+                        *(fl->extras + row) + strlen(key) + 1;
+    for (int j = 0; j < fl->field_cnt; j++)
     {
-        pi->screen_size = 0.0f;
-        error_status = READ_ERR_SCRNS_NFLOAT;
+        if (j != 0)
+        {
+            fputc(CSV_DELIMITER, fp);
+        }
+        if (*(fl->cols + j) >= 0)
+        {
+            schema->print_field(fp, rec, *(fl->cols + j));
+        }
+        else if (extra != NULL)
+        {
+            print_csv_field(fp, extra);
+            extra += strlen(extra) + 1;
+        }
     }
-    if (pi->screen_size < 0.0f)
+    fputc('\n', fp);
+}
+
+
+void free_file_layouts(void)
+{
+    pthread_mutex_lock(&layouts_lock);
+    while (layouts != NULL)
     {
-        pi->screen_size = 0.0f;
-        error_status = READ_ERR_SCRNS_NEG;
+        struct file_layout *next = layouts->next;
+        free_layout(layouts);
+        layouts = next;
     }
-    
-    return error_status;
+    pthread_mutex_unlock(&layouts_lock);
 }
 
 
-int read_data_quotes(char *f_name, struct quote_data_wrapper *qdw)
+/*
+    Reads all records of one file into a dynamic array, that is lengthened
+    according to 2*n principle. If the first line is a header row, columns are
+    mapped by name, otherwise they are in the order of the column table. On
+    failure *data and *lines still describe the records read so far, so the
+    caller can free them.
+*/
+static int read_records(char *f_name, const struct record_schema *schema,
+                        void **data, size_t *lines)
 {
     char msg[MAX_ERR_MSG_LEN];
     char *line_buffer;
-    FILE *p_file = open_file(f_name, "r");
+    *lines = 0;
+    uint64_t span = trace_begin();
+    uint64_t batch_span = span;
+    FILE *p_file = open_data_file(f_name);
     if (p_file == NULL)
     {
-        qdw->lines = 0;
         return EXIT_FAILURE;
     }
     
     // Dynamic allocation variables
-    struct quote_info *p_arr = NULL;
-    struct quote_info *p_temp = NULL;
-    struct quote_info qte_buf;
-    int count = 0;
+    char *p_arr = NULL;
+    char *p_temp = NULL;
+    size_t count = 0;
     int return_val;
-    int alloc_limit = MIN_ALLOC_LINE_CNT;
+    size_t alloc_limit = 0;
+    
+    // Fields of the current line and the field index of every column
+    char *fields[CSV_FIELDS_MAX];
+    int col_map[SCHEMA_COLS_MAX];
+    int field_cnt;
+    int missing;
+    size_t line = 0;
+    struct file_layout *layout = NULL;
+    default_column_map(schema, col_map);
     
     enum read_errors err_code;
     while (1)
@@ -265,23 +334,81 @@ int read_data_quotes(char *f_name, struct quote_data_wrapper *qdw)
         {
             break;
         }
-        else if (return_val == CSV_MALLOC_ERR)
+        else if (return_val == CSV_MALLOC_ERR || return_val == CSV_READ_ERR)
         {
-            qdw->data = p_arr;
-            qdw->lines = count;
-            fclose(p_file);
+            *data = p_arr;
+            *lines = count;
+            close_data_file(p_file);
             return EXIT_FAILURE;
         }
+        line++;
+        if (line % TRACE_PARSE_BATCH == 0)
+        {
+            trace_end(batch_span, TRACE_CAT_LOAD, "parse lines",
+                      TRACE_PARSE_BATCH);
+            batch_span = trace_begin();
+        }
+        field_cnt = split_fields(line_buffer, fields, CSV_FIELDS_MAX);
+        
+        // Header row is checked once per file
+        if (line == 1)
+        {
+            return_val = map_header_columns(schema, fields, field_cnt, col_map,
+                                            &missing);
+            if (return_val == HEADER_FOUND)
+            {
+                layout = new_layout(f_name, fields, field_cnt, schema,
+                                    col_map);
+                if (layout == NULL)
+                {
+                    print_read_error(READ_ERR_STR_MALLOC, f_name, line);
+                    close_data_file(p_file);
+                    free_buffer_manually();
+                    return EXIT_FAILURE;
+                }
+                register_layout(layout);
+                snprintf(msg, MAX_ERR_MSG_LEN, "Mapped columns of file \"%s\" "
+                         "by its header row.", f_name);
+                write_log(INFO, msg);
+                continue;
+            }
+            if (return_val == HEADER_MISSING_COL)
+            {
+                snprintf(msg, MAX_ERR_MSG_LEN, "Header row of file \"%s\" has "
+                         "no column \"%s\".", f_name,
+                         *(schema->col_names + missing));
+                write_log(ERROR, msg);
+                fprintf(stderr, "%s\n", msg);
+                close_data_file(p_file);
+                free_buffer_manually();
+                return EXIT_FAILURE;
+            }
+        }
         
         // Allocate memory if necessary
-        if (count >= alloc_limit || count == 0)
+        if (count >= alloc_limit)
         {
-            alloc_limit *= 2;
-            p_temp = realloc(p_arr, qdw->data_struct_size * (size_t)(alloc_limit));
+            size_t new_limit = acct_grow_limit(alloc_limit,
+                                               MIN_ALLOC_LINE_CNT * 2,
+                                               schema->record_size);
+            p_temp = new_limit == 0 ? NULL :
+                     acct_realloc(schema->arr_class, p_arr,
+                                  schema->record_size * new_limit);
             
             // Have same data read before simulating realloc fail
+            #ifdef FUNC_READ_DATA_PRODUCTS_TEST
+            if (schema == &product_schema && count > MIN_ALLOC_LINE_CNT * 2)
+            {
+                printf("Simulating realloc fail. (Products reading)\n");
+                if (p_temp != NULL)
+                {
+                    p_arr = p_temp;
+                    p_temp = NULL;
+                }
+            }
+            #endif
             #ifdef FUNC_READ_DATA_QUOTES_TEST
-            if (count > MIN_ALLOC_LINE_CNT * 2)
+            if (schema == &quote_schema && count > MIN_ALLOC_LINE_CNT * 2)
             {
                 printf("Simulating realloc fail. (Quotes reading)\n");
                 if (p_temp != NULL)
@@ -295,237 +422,221 @@ int read_data_quotes(char *f_name, struct quote_data_wrapper *qdw)
             if (p_temp == NULL)
             {
                 snprintf(msg, MAX_ERR_MSG_LEN, "Unable to expand data array from"
-                         " length %d to %d", count, count + 1);
+                         " length %zu", count);
                 write_log(ERROR, msg);
                 fprintf(stderr, "%s\n", msg);
-                qdw->data = p_arr;
-                qdw->lines = count;
-                fclose(p_file);
+                *data = p_arr;
+                *lines = count;
+                close_data_file(p_file);
                 free_buffer_manually();
                 return EXIT_FAILURE;
             }
             p_arr = p_temp;
+            alloc_limit = new_limit;
+            acct_set_unused(p_arr, schema->record_size *
+                                   (alloc_limit - count));
         }
         
-        err_code = get_quote_info(&qte_buf, line_buffer);
-        
-        // Copy buffer to data array
-        *(p_arr + count) = qte_buf;
+        // Record is parsed straight into the data array
+        err_code = schema->parse(p_arr + schema->record_size * count,
+                                 fields, field_cnt, col_map);
         count++;
+        if ((err_code == READ_OK || err_code > READ_ERR_STR_MALLOC) &&
+            layout != NULL &&
+            add_layout_row(layout, fields, field_cnt, col_map) == EXIT_FAILURE)
+        {
+            err_code = READ_ERR_STR_MALLOC;
+        }
         
         if (err_code != READ_OK)
         {
-            if (print_read_error(err_code, f_name, count) == READ_ERR_FATAL)
+            if (print_read_error(err_code, f_name, line) == READ_ERR_FATAL)
             {
-                qdw->data = p_arr;
-                qdw->lines = count;
-                fclose(p_file);
+                *data = p_arr;
+                *lines = count;
+                close_data_file(p_file);
                 free_buffer_manually();
                 return EXIT_FAILURE;
             }
         }
     }
-    fclose(p_file);
+    trace_end(batch_span, TRACE_CAT_LOAD, "parse lines",
+              (int64_t)(line % TRACE_PARSE_BATCH));
+    if (close_data_file(p_file) != STREAM_OK)
+    {
+        *data = p_arr;
+        *lines = count;
+        return EXIT_FAILURE;
+    }
     snprintf(msg, MAX_ERR_MSG_LEN, "Closed file \"%s\".", f_name);
     write_log(INFO, msg);
     
     // Free excess allocated memory
-    // Fatal ?
-    p_temp = realloc(p_arr, qdw->data_struct_size * (size_t)(count));
+    p_temp = acct_realloc(schema->arr_class, p_arr, schema->record_size *
+                          count);
     if (p_temp == NULL)
     {
         snprintf(msg, MAX_ERR_MSG_LEN, "Unable to free excess memory");
         write_log(ERROR, msg);
         fprintf(stderr, "%s\n", msg);
-        qdw->data = p_arr;
-        qdw->lines = count;
+        *data = p_arr;
+        *lines = count;
         return EXIT_FAILURE;
     }
     
-    // Save to wrapper
-    qdw->data = p_temp;
-    qdw->lines = count;
-    snprintf(msg, MAX_ERR_MSG_LEN, "Quote data read successfully.");
+    // Save to caller
+    *data = p_temp;
+    *lines = count;
+    trace_end(span, TRACE_CAT_LOAD, "read file", (int64_t)count);
+    snprintf(msg, MAX_ERR_MSG_LEN, "%s data read successfully.", schema->name);
     write_log(INFO, msg);
     return EXIT_SUCCESS;
 }
 
 
+int read_data_products(char *f_name, struct product_data_wrapper *pdw)
+{
+    void *data = NULL;
+    int return_val = read_records(f_name, &product_schema, &data, &pdw->lines);
+    pdw->data = data;
+    metrics_add(MET_PRODUCT_ROWS, pdw->lines);
+    return return_val;
+}
+
+
+int get_product_info(struct product_info *pi, char *buf)
+{
+    char *fields[CSV_FIELDS_MAX];
+    int col_map[SCHEMA_COLS_MAX];
+    default_column_map(&product_schema, col_map);
+    int field_cnt = split_fields(buf, fields, CSV_FIELDS_MAX);
+    return product_schema.parse(pi, fields, field_cnt, col_map);
+}
+
+
+int read_data_quotes(char *f_name, struct quote_data_wrapper *qdw)
+{
+    void *data = NULL;
+    int return_val = read_records(f_name, &quote_schema, &data, &qdw->lines);
+    qdw->data = data;
+    metrics_add(MET_QUOTE_ROWS, qdw->lines);
+    return return_val;
+}
+
+
 int get_quote_info(struct quote_info *qi, char *buf)
 {
-    char field[STR_MAX];
-    char *p_field;
-    int error_status = READ_OK; // For non fatal errors
-    
-    // Initialize in case an error might occur
-    qi->p_id = NULL;
-    qi->p_code = NULL;
-    qi->p_retailer = NULL;
-    
-    // Getting quote id
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_QTE_FIELD_ID);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
-    }
-    qi->p_id = dynamic_string(p_field);
-    if (qi->p_id == NULL)
-    {
-        return READ_ERR_STR_MALLOC;
-    }
-    
-    // Getting product code (FK)
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_QTE_FIELD_CODE);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
-    }
-    qi->p_code = dynamic_string(p_field);
-    if (qi->p_code == NULL)
-    {
-        return READ_ERR_STR_MALLOC;
-    }
-    
-    // Getting quote retailer
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_QTE_FIELD_RTLR);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
-    }
-    qi->p_retailer = dynamic_string(p_field);
-    if (qi->p_retailer == NULL)
-    {
-        return READ_ERR_STR_MALLOC;
-    }
-    
-    // Getting quote price
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_QTE_FIELD_PRICE);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
-    }
-    if (sscanf(p_field, "%d", &qi->price) != 1)
-    {
-       qi->price = 0;
-       error_status = READ_ERR_PRICE_NINT;
-    }
-    else if (qi->price < 0)
-    {
-        error_status = READ_ERR_PRICE_NEG;
-    }
-    
-    // Getting quoted items stock
-    strcpy(field, buf);
-    p_field = get_field(field, CSV_QTE_FIELD_STOCK);
-    if (p_field == NULL)
-    {
-        return READ_ERR_MSNG_DATA;
-    }
-    if (sscanf(p_field, "%d", &qi->stock) != 1)
-    {
-       qi->stock = 0;
-       error_status = READ_ERR_STOCK_NINT;
-    }
-    else if (qi->stock < 0)
-    {
-        error_status = READ_ERR_STOCK_NEG;
-    }
-    
-    return error_status;
+    char *fields[CSV_FIELDS_MAX];
+    int col_map[SCHEMA_COLS_MAX];
+    default_column_map(&quote_schema, col_map);
+    int field_cnt = split_fields(buf, fields, CSV_FIELDS_MAX);
+    return quote_schema.parse(qi, fields, field_cnt, col_map);
 }
 
 
-int print_read_error(enum read_errors err, char *f_name, int line)
+int print_read_error(enum read_errors err, char *f_name, size_t line)
 {
     char err_msg[MAX_ERR_MSG_LEN];
+    metrics_read_error(err);
     switch (err)
     {
         case READ_ERR_MSNG_DATA:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Line: %d from file \"%s\" is "
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Line: %zu from file \"%s\" is "
                      "missing data fields.", line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_FATAL;
-        
+            
         case READ_ERR_STR_MALLOC:
             snprintf(err_msg, MAX_ERR_MSG_LEN, "Could not allocate memory for "
-                     "string type date field at line: %d from file \"%s\".",
+                     "string type date field at line: %zu from file \"%s\".",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_FATAL;
-        
+            
         case READ_ERR_RAM_NINT:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product RAM value at line: %d "
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product RAM value at line: %zu "
                      "in file \"%s\" is not an integer. It will be set to 0",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_RAM_NEG:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product RAM value at line: %d "
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product RAM value at line: %zu "
                      "in file \"%s\" is negative. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_SCRNS_NFLOAT:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product screen size at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product screen size at line: %zu"
                      " in file \"%s\" is not a float. It will be set to 0",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_SCRNS_NEG:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product screen size at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Product screen size at line: %zu"
                      " in file \"%s\" is negative. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_PRICE_NINT:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote price value at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote price value at line: %zu"
                      " in file \"%s\" is not an integer. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_PRICE_NEG:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote price value at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote price value at line: %zu"
                      " in file \"%s\" is negative. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_STOCK_NINT:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote stock value at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote stock value at line: %zu"
                      " in file \"%s\" is not an integer. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
-        
+            
         case READ_ERR_STOCK_NEG:
-            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote stock value at line: %d"
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Quote stock value at line: %zu"
                      " in file \"%s\" is negative. It will be set to 0.",
                      line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
             return READ_ERR_NOT_FATAL;
             
+        case READ_ERR_DELTA_OP:
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Unknown change operation at "
+                     "line: %zu in file \"%s\". Supported operations are I, U "
+                     "and D.", line, f_name);
+            write_log(ERROR, err_msg);
+            fprintf(stderr, "%s\n", err_msg);
+            return READ_ERR_FATAL;
+            
+        case READ_ERR_DICT_FULL:
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Too many distinct codes or "
+                     "retailers at line: %zu in file \"%s\".", line, f_name);
+            write_log(ERROR, err_msg);
+            fprintf(stderr, "%s\n", err_msg);
+            return READ_ERR_FATAL;
+            
         default:
             snprintf(err_msg, MAX_ERR_MSG_LEN, "Unknown error with value %d "
-                     " called by read error at line: %d in file \"%s\".",
+                     " called by read error at line: %zu in file \"%s\".",
                      err, line, f_name);
             write_log(ERROR, err_msg);
             fprintf(stderr, "%s\n", err_msg);
@@ -534,20 +645,59 @@ int print_read_error(enum read_errors err, char *f_name, int line)
 }
 
 
+int is_compressed_save_target(char *f_name)
+{
+    if (get_file_format(f_name) == STREAM_PLAIN)
+    {
+        return 0;
+    }
+    
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "File \"%s\" is compressed and read only. "
+             "Changes will not be written to it.", f_name);
+    write_log(ERROR, msg);
+    fprintf(stderr, "%s\n", msg);
+    return 1;
+}
+
+
 int save_product_file_changes(char *f_name, struct product_data_wrapper pdw)
 {
+    if (is_compressed_save_target(f_name))
+    {
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    
+    uint64_t start = latency_now();
+    uint64_t span = trace_begin();
+    struct file_layout *fl = find_layout(f_name);
     FILE *p_file = open_file(f_name, "w");
     if (p_file == NULL)
     {
         return CSV_WRITE_FOPEN_ERR;
     }
     
-    for (int i = 0; i < pdw.lines; i++)
+    // File read with a header row is written back in its own layout
+    if (fl != NULL)
     {
+        print_layout_header(p_file, fl);
+    }
+    
+    for (size_t i = 0; i < pdw.lines; i++)
+    {
+        if (fl != NULL)
+        {
+            print_layout_row(p_file, fl, &product_schema, pdw.data + i,
+                             (pdw.data + i)->p_code);
+            continue;
+        }
         print_product_csv_line(p_file, *(pdw.data + i));
     }
     
     fclose(p_file);
+    trace_end(span, TRACE_CAT_SAVE, "save products", (int64_t)pdw.lines);
+    metrics_add(MET_SAVES, 1);
+    metrics_add(MET_SAVE_NS, latency_now() - start);
     char msg[STR_MAX];
     snprintf(msg, STR_MAX, "Closed file \"%s\".", f_name);
     write_log(INFO, msg);
@@ -556,23 +706,193 @@ int save_product_file_changes(char *f_name, struct product_data_wrapper pdw)
 }
 
 
-int save_quote_file_changes(char *f_name, struct quote_data_wrapper qdw)
+/*
+    Orders quote indexes by shard with a counting sort, so every shard is
+    written from its own range of order. starts has 2 * shard_cnt + 1
+    entries, the last shard_cnt are write positions.
+*/
+static void bucket_quotes_by_shard(struct quote_data_wrapper qdw,
+                                   size_t *order, size_t *starts)
 {
-    FILE *p_file = open_file(f_name, "w");
+    for (size_t i = 0; i < qdw.lines; i++)
+    {
+        (*(starts + (qdw.data + i)->shard + 1))++;
+    }
+    for (int s = 0; s < qdw.shard_cnt; s++)
+    {
+        *(starts + s + 1) += *(starts + s);
+    }
+    size_t *next = starts + qdw.shard_cnt + 1;
+    memcpy(next, starts, sizeof(size_t) * (size_t)qdw.shard_cnt);
+    for (size_t i = 0; i < qdw.lines; i++)
+    {
+        *(order + (*(next + (qdw.data + i)->shard))++) = i;
+    }
+}
+
+
+/*
+    Writes the quotes of one shard into a temporary file, that gets the
+    permissions of the shard file. A shard file, that can not be written, is
+    not replaced.
+*/
+static int write_quote_shard(struct quote_data_wrapper qdw, int s,
+                             size_t *order, size_t cnt, char *tmp_name)
+{
+    char msg[STR_MAX];
+    char *f_name = *(qdw.shard_names + s);
+    struct stat st;
+    int exists = stat(f_name, &st) == 0;
+    if (exists && access(f_name, W_OK) != 0)
+    {
+        snprintf(msg, STR_MAX, "Unable to open file \"%s\" in mode \"w\".",
+                 f_name);
+        fprintf(stderr, "%s\n", msg);
+        write_log(ERROR, msg);
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    
+    uint64_t start = latency_now();
+    uint64_t span = trace_begin();
+    struct file_layout *fl = find_layout(f_name);
+    FILE *p_file = open_file(tmp_name, "w");
     if (p_file == NULL)
     {
         return CSV_WRITE_FOPEN_ERR;
     }
     
-    for (int i = 0; i < qdw.lines; i++)
+    if (fl != NULL)
     {
-        print_quote_csv_line(p_file, *(qdw.data + i));
+        print_layout_header(p_file, fl);
+    }
+    for (size_t i = 0; i < cnt; i++)
+    {
+        struct quote_info *qi = qdw.data + *(order + i);
+        if (fl != NULL)
+        {
+            print_layout_row(p_file, fl, &quote_schema, qi, qi->p_id);
+            continue;
+        }
+        print_quote_csv_line(p_file, *qi);
     }
     
-    fclose(p_file);
+    int ok = !ferror(p_file);
+    ok = fclose(p_file) == 0 && ok;
+    ok = ok && (!exists || chmod(tmp_name, st.st_mode & 07777) == 0);
+    trace_end(span, TRACE_CAT_SAVE, "save quotes", (int64_t)cnt);
+    metrics_add(MET_SAVES, 1);
+    metrics_add(MET_SAVE_NS, latency_now() - start);
+    if (!ok)
+    {
+        snprintf(msg, STR_MAX, "Unable to write file \"%s\".", tmp_name);
+        fprintf(stderr, "%s\n", msg);
+        write_log(ERROR, msg);
+        remove(tmp_name);
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    return CSV_WRITE_OK;
+}
+
+
+static void free_tmp_names(char **tmp_names, int cnt)
+{
+    for (int s = 0; tmp_names != NULL && s < cnt; s++)
+    {
+        acct_free(*(tmp_names + s));
+    }
+    acct_free(tmp_names);
+}
+
+
+int save_quote_file_changes(struct quote_data_wrapper qdw)
+{
     char msg[STR_MAX];
-    snprintf(msg, STR_MAX, "Closed file \"%s\".", f_name);
-    write_log(INFO, msg);
+    int return_val = CSV_WRITE_OK;
+    size_t shard_cnt = (size_t)qdw.shard_cnt;
+    size_t *starts = acct_calloc(ALLOC_OTHER, 2 * shard_cnt + 1,
+                                 sizeof(size_t));
+    size_t *order = acct_malloc(ALLOC_OTHER, sizeof(size_t) *
+                                (qdw.lines ? qdw.lines : 1));
+    char **tmp_names = acct_calloc(ALLOC_OTHER, shard_cnt ? shard_cnt : 1,
+                                   sizeof(char *));
+    int ok = starts != NULL && order != NULL && tmp_names != NULL;
+    for (size_t s = 0; ok && s < shard_cnt; s++)
+    {
+        char *f_name = *(qdw.shard_names + s);
+        *(tmp_names + s) = acct_malloc(ALLOC_OTHER, strlen(f_name) +
+                                       sizeof(SAVE_TMP_SUFFIX));
+        ok = *(tmp_names + s) != NULL;
+        if (ok)
+        {
+            strcpy(*(tmp_names + s), f_name);
+            strcat(*(tmp_names + s), SAVE_TMP_SUFFIX);
+        }
+    }
+    if (!ok)
+    {
+        snprintf(msg, STR_MAX, "Unable to allocate memory for saving %zu "
+                 "quotes.", qdw.lines);
+        fprintf(stderr, "%s\n", msg);
+        write_log(ERROR, msg);
+        acct_free(starts);
+        acct_free(order);
+        free_tmp_names(tmp_names, qdw.shard_cnt);
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    bucket_quotes_by_shard(qdw, order, starts);
     
-    return CSV_WRITE_OK;
+    // Shard files are replaced only after every shard was written
+    int failed = 0;
+    int written = qdw.shard_cnt;
+    for (int s = 0; s < qdw.shard_cnt; s++)
+    {
+        if (is_compressed_save_target(*(qdw.shard_names + s)))
+        {
+            return_val = CSV_WRITE_FOPEN_ERR;
+            acct_free(*(tmp_names + s));
+            *(tmp_names + s) = NULL;
+            continue;
+        }
+        if (write_quote_shard(qdw, s, order + *(starts + s),
+                              *(starts + s + 1) - *(starts + s),
+                              *(tmp_names + s)) == CSV_WRITE_FOPEN_ERR)
+        {
+            failed = 1;
+            written = s;
+            break;
+        }
+    }
+    
+    for (int s = 0; s < written; s++)
+    {
+        char *tmp_name = *(tmp_names + s);
+        if (tmp_name == NULL)
+        {
+            continue;
+        }
+        if (failed)
+        {
+            remove(tmp_name);
+        }
+        else if (rename(tmp_name, *(qdw.shard_names + s)) != 0)
+        {
+            snprintf(msg, STR_MAX, "Unable to replace file \"%s\".",
+                     *(qdw.shard_names + s));
+            fprintf(stderr, "%s\n", msg);
+            write_log(ERROR, msg);
+            remove(tmp_name);
+            return_val = CSV_WRITE_FOPEN_ERR;
+        }
+        else
+        {
+            snprintf(msg, STR_MAX, "Closed file \"%s\".",
+                     *(qdw.shard_names + s));
+            write_log(INFO, msg);
+        }
+    }
+    
+    acct_free(starts);
+    acct_free(order);
+    free_tmp_names(tmp_names, qdw.shard_cnt);
+    return failed ? CSV_WRITE_FOPEN_ERR : return_val;
 }
@@ -0,0 +1,360 @@
+/*
+File:         data_stream.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Opening data files for reading. Compressed files (gzip, zstd) are
+              decompressed on a separate thread into a pipe, so decompressing
+              and parsing happen at the same time.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <data_read_write.h>
+#include <data_stream.h>
+
+static const unsigned char gzip_magic[] = {0x1f, 0x8b};
+static const unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+/*
+    A running decompression. Streams are kept in a list, so close_data_file
+    can find the thread feeding the stream it closes.
+*/
+struct stream_job
+{
+    FILE *p_src;            // Compressed file
+    FILE *p_out;            // Read end of the pipe, given to the caller
+    int fd_write;           // Write end of the pipe
+    char *f_name;
+    enum stream_formats format;
+    int status;
+    pthread_t thread;
+    struct stream_job *next;
+};
+
+static struct stream_job *p_jobs = NULL;
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void stream_error(char *msg_start, char *f_name)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "%s \"%s\".", msg_start, f_name);
+    write_log(ERROR, msg);
+    fprintf(stderr, "%s\n", msg);
+}
+
+
+static enum stream_formats detect_format(unsigned char *magic, size_t len)
+{
+    if (len >= sizeof(gzip_magic) &&
+        memcmp(magic, gzip_magic, sizeof(gzip_magic)) == 0)
+    {
+        return STREAM_GZIP;
+    }
+    if (len >= sizeof(zstd_magic) &&
+        memcmp(magic, zstd_magic, sizeof(zstd_magic)) == 0)
+    {
+        return STREAM_ZSTD;
+    }
+    return STREAM_PLAIN;
+}
+
+
+enum stream_formats get_file_format(char *f_name)
+{
+    unsigned char magic[STREAM_MAGIC_LEN];
+    FILE *fp = fopen(f_name, "rb");
+    if (fp == NULL)
+    {
+        return STREAM_PLAIN;
+    }
+    size_t len = fread(magic, 1, STREAM_MAGIC_LEN, fp);
+    fclose(fp);
+    return detect_format(magic, len);
+}
+
+
+/*
+    Writes all of buf into the pipe. Returns STREAM_ERR if the reader has
+    closed its end (stopped reading early) or writing failed.
+*/
+static int write_all(int fd, unsigned char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return STREAM_ERR;
+        }
+        buf += written;
+        len -= (size_t)written;
+    }
+    return STREAM_OK;
+}
+
+
+static int inflate_gzip(struct stream_job *job, unsigned char *in,
+                        unsigned char *out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 15 window bits + 32 for automatic gzip/zlib header detection
+    if (inflateInit2(&zs, 15 + 32) != Z_OK)
+    {
+        return STREAM_ERR;
+    }
+    
+    int ret = Z_OK;
+    size_t in_len;
+    while ((in_len = fread(in, 1, STREAM_CHUNK_SIZE, job->p_src)) > 0)
+    {
+        zs.next_in = in;
+        zs.avail_in = (uInt)in_len;
+        while (zs.avail_in > 0)
+        {
+            zs.next_out = out;
+            zs.avail_out = STREAM_CHUNK_SIZE;
+            ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+            {
+                inflateEnd(&zs);
+                return STREAM_ERR;
+            }
+            if (write_all(job->fd_write, out,
+                          STREAM_CHUNK_SIZE - zs.avail_out) != STREAM_OK)
+            {
+                inflateEnd(&zs);
+                return STREAM_ERR;
+            }
+            // Concatenated gzip members (e.g. appended feeds)
+            if (ret == Z_STREAM_END && zs.avail_in > 0)
+            {
+                inflateReset(&zs);
+            }
+        }
+    }
+    inflateEnd(&zs);
+    
+    if (ferror(job->p_src) || ret != Z_STREAM_END)
+    {
+        return STREAM_ERR; // Read error or truncated file
+    }
+    return STREAM_OK;
+}
+
+
+#ifdef USE_ZSTD
+static int inflate_zstd(struct stream_job *job, unsigned char *in,
+                        unsigned char *out)
+{
+    ZSTD_DStream *zds = ZSTD_createDStream();
+    if (zds == NULL)
+    {
+        return STREAM_ERR;
+    }
+    ZSTD_initDStream(zds);
+    
+    size_t ret = 0;
+    size_t in_len;
+    while ((in_len = fread(in, 1, STREAM_CHUNK_SIZE, job->p_src)) > 0)
+    {
+        ZSTD_inBuffer zin = {in, in_len, 0};
+        while (zin.pos < zin.size)
+        {
+            ZSTD_outBuffer zout = {out, STREAM_CHUNK_SIZE, 0};
+            ret = ZSTD_decompressStream(zds, &zout, &zin);
+            if (ZSTD_isError(ret) ||
+                write_all(job->fd_write, out, zout.pos) != STREAM_OK)
+            {
+                ZSTD_freeDStream(zds);
+                return STREAM_ERR;
+            }
+        }
+    }
+    ZSTD_freeDStream(zds);
+    
+    // ret is 0 only when a frame was fully decoded
+    if (ferror(job->p_src) || ret != 0)
+    {
+        return STREAM_ERR;
+    }
+    return STREAM_OK;
+}
+#endif
+
+
+static void *decompress_worker(void *arg)
+{
+    struct stream_job *job = arg;
+    
+    // Reader closing the pipe early must not kill the program
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    
+    unsigned char *in = acct_malloc(ALLOC_OTHER, STREAM_CHUNK_SIZE);
+    unsigned char *out = acct_malloc(ALLOC_OTHER, STREAM_CHUNK_SIZE);
+    if (in == NULL || out == NULL)
+    {
+        job->status = STREAM_ERR;
+    }
+    else if (job->format == STREAM_GZIP)
+    {
+        job->status = inflate_gzip(job, in, out);
+    }
+    #ifdef USE_ZSTD
+    else if (job->format == STREAM_ZSTD)
+    {
+        job->status = inflate_zstd(job, in, out);
+    }
+    #endif
+    else
+    {
+        job->status = STREAM_ERR;
+    }
+    acct_free(in);
+    acct_free(out);
+    
+    // Reader sees EOF
+    close(job->fd_write);
+    fclose(job->p_src);
+    return NULL;
+}
+
+
+FILE *open_data_file(char *f_name)
+{
+    FILE *p_file = open_file(f_name, "r");
+    if (p_file == NULL)
+    {
+        return NULL;
+    }
+    
+    unsigned char magic[STREAM_MAGIC_LEN];
+    size_t len = fread(magic, 1, STREAM_MAGIC_LEN, p_file);
+    enum stream_formats format = detect_format(magic, len);
+    rewind(p_file);
+    
+    if (format == STREAM_PLAIN)
+    {
+        // Kernel reads further ahead, when the file is read with fread
+        posix_fadvise(fileno(p_file), 0, 0, POSIX_FADV_SEQUENTIAL);
+        return p_file;
+    }
+    
+    #ifndef USE_ZSTD
+    if (format == STREAM_ZSTD)
+    {
+        stream_error("zstd support is not compiled in, unable to read",
+                     f_name);
+        fclose(p_file);
+        return NULL;
+    }
+    #endif
+    
+    struct stream_job *job = acct_calloc(ALLOC_OTHER, 1,
+                                         sizeof(struct stream_job));
+    int fds[2];
+    if (job == NULL || pipe(fds) != 0)
+    {
+        stream_error("Unable to set up decompression for", f_name);
+        acct_free(job);
+        fclose(p_file);
+        return NULL;
+    }
+    // Bigger pipe, less switching between decompressing and parsing
+    fcntl(fds[1], F_SETPIPE_SZ, STREAM_PIPE_SIZE);
+    
+    job->p_src = p_file;
+    job->fd_write = fds[1];
+    job->format = format;
+    job->f_name = f_name;
+    job->p_out = fdopen(fds[0], "r");
+    if (job->p_out == NULL)
+    {
+        stream_error("Unable to set up decompression for", f_name);
+        close(fds[0]);
+        close(fds[1]);
+        fclose(p_file);
+        acct_free(job);
+        return NULL;
+    }
+    
+    if (pthread_create(&job->thread, NULL, decompress_worker, job) != 0)
+    {
+        stream_error("Unable to start decompression thread for", f_name);
+        fclose(job->p_out);
+        close(fds[1]);
+        fclose(p_file);
+        acct_free(job);
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&jobs_lock);
+    job->next = p_jobs;
+    p_jobs = job;
+    pthread_mutex_unlock(&jobs_lock);
+    
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "Decompressing \"%s\" (%s) while reading.",
+             f_name, format == STREAM_GZIP ? "gzip" : "zstd");
+    write_log(INFO, msg);
+    return job->p_out;
+}
+
+
+int close_data_file(FILE *fp)
+{
+    struct stream_job *job = NULL;
+    
+    pthread_mutex_lock(&jobs_lock);
+    struct stream_job **pp = &p_jobs;
+    while (*pp != NULL)
+    {
+        if ((*pp)->p_out == fp)
+        {
+            job = *pp;
+            *pp = job->next;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+    pthread_mutex_unlock(&jobs_lock);
+    
+    // Closing first lets the thread stop, if reading ended early
+    fclose(fp);
+    if (job == NULL)
+    {
+        return STREAM_OK;
+    }
+    
+    pthread_join(job->thread, NULL);
+    int status = job->status;
+    if (status != STREAM_OK)
+    {
+        stream_error("Decompression failed or was stopped early for", job->f_name);
+    }
+    acct_free(job);
+    return status;
+}
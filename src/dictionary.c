@@ -0,0 +1,231 @@
+/*
+File:         dictionary.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Dictionaries for columns with few distinct values (product codes,
+              retailers). Every distinct string is stored once and columns
+              hold 32-bit IDs.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <alloc_acct.h>
+#include <hash_index.h>
+#include <dictionary.h>
+
+/*
+    One dictionary. ID to string lookups go through pages, that never move, so
+    they need no lock. Page n holds DICT_PAGE_LEN << n IDs, so the fixed page
+    table covers all 32-bit IDs. String to ID lookups and adding use the hash
+    index under the lock.
+*/
+struct string_dict
+{
+    _Atomic(const char **) pages[DICT_PAGES_MAX];
+    uint32_t count;
+    struct hash_index index;
+    struct dict_chunk *chunks;
+    size_t bytes;
+    pthread_mutex_t lock;
+};
+
+static struct string_dict dicts[DICT_CNT] =
+{
+    [DICT_CODE] = {.lock = PTHREAD_MUTEX_INITIALIZER},
+    [DICT_RETAILER] = {.lock = PTHREAD_MUTEX_INITIALIZER}
+};
+
+// Changes when dictionaries are freed, so per-thread caches are not reused
+static atomic_uint generation = 1;
+
+/*
+    Last string interned by the thread for every dictionary. Rows of one
+    retailer or product usually come together, so most rows skip the lock.
+*/
+struct dict_cache
+{
+    unsigned int generation;
+    const char *str;
+    uint32_t id;
+};
+
+static _Thread_local struct dict_cache cache[DICT_CNT];
+
+
+/*
+    Finds the page of an ID and the IDs slot in it. IDs before page n fill
+    DICT_PAGE_LEN * (2^n - 1) slots, so the page is given by the highest bit
+    of id + DICT_PAGE_LEN.
+*/
+static uint32_t locate_id(uint32_t id, uint64_t *slot)
+{
+    uint64_t pos = (uint64_t)id + DICT_PAGE_LEN;
+    int high_bit = 63 - __builtin_clzll(pos);
+    *slot = pos - ((uint64_t)1 << high_bit);
+    return (uint32_t)(high_bit - DICT_PAGE_BITS);
+}
+
+
+/*
+    Copies a string into the dictionaries memory chunks. Lock must be held.
+*/
+static const char *store_string(struct string_dict *d, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    struct dict_chunk *chunk = d->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < len)
+    {
+        size_t size = len > DICT_CHUNK_SIZE ? len : DICT_CHUNK_SIZE;
+        chunk = acct_malloc(ALLOC_DICT, sizeof(struct dict_chunk) + size);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = d->chunks;
+        chunk->used = 0;
+        chunk->size = size;
+        d->chunks = chunk;
+        d->bytes += sizeof(struct dict_chunk) + size;
+    }
+    char *dest = chunk->data + chunk->used;
+    memcpy(dest, str, len);
+    chunk->used += len;
+    return dest;
+}
+
+
+/*
+    Adds a stored string as the next ID. Lock must be held.
+*/
+static int add_id(struct string_dict *d, const char *stored, uint32_t *id)
+{
+    uint64_t slot;
+    uint32_t page_nr = locate_id(d->count, &slot);
+    if (page_nr >= DICT_PAGES_MAX)
+    {
+        return DICT_FULL;
+    }
+    const char **page = atomic_load_explicit(d->pages + page_nr,
+                                             memory_order_relaxed);
+    if (page == NULL)
+    {
+        size_t page_len = (size_t)DICT_PAGE_LEN << page_nr;
+        page = acct_calloc(ALLOC_DICT, page_len, sizeof(char *));
+        if (page == NULL)
+        {
+            return DICT_MALLOC_ERR;
+        }
+        d->bytes += page_len * sizeof(char *);
+        atomic_store_explicit(d->pages + page_nr, page, memory_order_release);
+    }
+    
+    if (hash_index_put(&d->index, (char *)stored, d->count) != HASH_OK)
+    {
+        return DICT_MALLOC_ERR;
+    }
+    *(page + slot) = stored;
+    *id = d->count;
+    d->count++;
+    return DICT_OK;
+}
+
+
+int dict_intern(enum dictionaries dict, const char *str, uint32_t *id)
+{
+    struct string_dict *d = dicts + dict;
+    struct dict_cache *c = cache + dict;
+    unsigned int gen = atomic_load_explicit(&generation, memory_order_relaxed);
+    if (c->generation == gen && strcmp(c->str, str) == 0)
+    {
+        *id = c->id;
+        return DICT_OK;
+    }
+    
+    pthread_mutex_lock(&d->lock);
+    int return_val = DICT_OK;
+    int64_t found = hash_index_get(&d->index, str);
+    if (found != HASH_NOT_FOUND)
+    {
+        *id = (uint32_t)found;
+    }
+    else
+    {
+        const char *stored = store_string(d, str);
+        return_val = stored == NULL ? DICT_MALLOC_ERR : add_id(d, stored, id);
+    }
+    if (return_val == DICT_OK)
+    {
+        c->generation = gen;
+        c->str = dict_string(dict, *id);
+        c->id = *id;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return return_val;
+}
+
+
+uint32_t dict_find(enum dictionaries dict, const char *str)
+{
+    struct string_dict *d = dicts + dict;
+    pthread_mutex_lock(&d->lock);
+    int64_t found = hash_index_get(&d->index, str);
+    pthread_mutex_unlock(&d->lock);
+    return found == HASH_NOT_FOUND ? DICT_NO_ID : (uint32_t)found;
+}
+
+
+const char *dict_string(enum dictionaries dict, uint32_t id)
+{
+    if (id == DICT_NO_ID)
+    {
+        return "";
+    }
+    uint64_t slot;
+    uint32_t page_nr = locate_id(id, &slot);
+    const char **page = atomic_load_explicit(dicts[dict].pages + page_nr,
+                                             memory_order_acquire);
+    return *(page + slot);
+}
+
+
+uint32_t dict_size(enum dictionaries dict, size_t *bytes)
+{
+    struct string_dict *d = dicts + dict;
+    pthread_mutex_lock(&d->lock);
+    uint32_t count = d->count;
+    if (bytes != NULL)
+    {
+        *bytes = d->bytes + d->index.capacity * sizeof(struct hash_slot);
+    }
+    pthread_mutex_unlock(&d->lock);
+    return count;
+}
+
+
+void free_dictionaries(void)
+{
+    atomic_fetch_add(&generation, 1);
+    for (int i = 0; i < DICT_CNT; i++)
+    {
+        struct string_dict *d = dicts + i;
+        pthread_mutex_lock(&d->lock);
+        for (int j = 0; j < DICT_PAGES_MAX; j++)
+        {
+            acct_free((void *)atomic_load(d->pages + j));
+            atomic_store(d->pages + j, NULL);
+        }
+        while (d->chunks != NULL)
+        {
+            struct dict_chunk *next = d->chunks->next;
+            acct_free(d->chunks);
+            d->chunks = next;
+        }
+        hash_index_free(&d->index);
+        d->count = 0;
+        d->bytes = 0;
+        pthread_mutex_unlock(&d->lock);
+    }
+}
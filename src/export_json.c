@@ -0,0 +1,277 @@
+/*
+File:         export_json.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Export of products joined with their quotes as NDJSON or JSON.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+#include <report.h>
+#include <export_json.h>
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static void jw_flush(struct json_writer *jw)
+{
+    if (jw->len > 0 && fwrite(jw->buf, 1, jw->len, jw->fp) != jw->len)
+    {
+        jw->err = 1;
+    }
+    jw->len = 0;
+}
+
+
+static void jw_write(struct json_writer *jw, const char *str, size_t len)
+{
+    if (jw->len + len > EXPORT_BUF_SIZE)
+    {
+        jw_flush(jw);
+        if (len > EXPORT_BUF_SIZE)
+        {
+            if (fwrite(str, 1, len, jw->fp) != len)
+            {
+                jw->err = 1;
+            }
+            return;
+        }
+    }
+    memcpy(jw->buf + jw->len, str, len);
+    jw->len += len;
+}
+
+
+static void jw_putc(struct json_writer *jw, char c)
+{
+    if (jw->len == EXPORT_BUF_SIZE)
+    {
+        jw_flush(jw);
+    }
+    *(jw->buf + jw->len) = c;
+    jw->len++;
+}
+
+
+#define JW_LITERAL(jw, str) jw_write(jw, str, sizeof(str) - 1)
+
+/*
+    Writes a string in quotes. Runs of chars, that need no escaping, are
+    copied at once.
+*/
+static void jw_string(struct json_writer *jw, const char *str)
+{
+    jw_putc(jw, '"');
+    const char *run = str;
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        jw_write(jw, run, (size_t)(str - run));
+        run = str + 1;
+        jw_putc(jw, '\\');
+        switch (c)
+        {
+            case '"':
+            case '\\':
+                jw_putc(jw, (char)c);
+                break;
+                
+            case '\n':
+                jw_putc(jw, 'n');
+                break;
+                
+            case '\r':
+                jw_putc(jw, 'r');
+                break;
+                
+            case '\t':
+                jw_putc(jw, 't');
+                break;
+                
+            default:
+                JW_LITERAL(jw, "u00");
+                jw_putc(jw, hex_digits[c >> 4]);
+                jw_putc(jw, hex_digits[c & 0xF]);
+                break;
+        }
+    }
+    jw_write(jw, run, (size_t)(str - run));
+    jw_putc(jw, '"');
+}
+
+
+static void jw_int(struct json_writer *jw, long long value)
+{
+    char digits[EXPORT_INT_MAX_LEN];
+    int pos = EXPORT_INT_MAX_LEN;
+    // Negative values are turned positive as unsigned, so LLONG_MIN works too
+    unsigned long long u = value < 0 ? 0ULL - (unsigned long long)value
+                                     : (unsigned long long)value;
+    do
+    {
+        pos--;
+        digits[pos] = (char)('0' + u % 10);
+        u /= 10;
+    }
+    while (u > 0);
+    if (value < 0)
+    {
+        pos--;
+        digits[pos] = '-';
+    }
+    jw_write(jw, digits + pos, (size_t)(EXPORT_INT_MAX_LEN - pos));
+}
+
+
+/*
+    Writes a number with one decimal, like screen size is saved in CSV.
+*/
+static void jw_tenths(struct json_writer *jw, float value)
+{
+    if (!isfinite(value) || value > EXPORT_FLOAT_MAX ||
+        value < -EXPORT_FLOAT_MAX)
+    {
+        JW_LITERAL(jw, "null");
+        return;
+    }
+    double scaled = (double)value * 10.0;
+    long long tenths = (long long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    if (tenths < 0)
+    {
+        jw_putc(jw, '-');
+        tenths = -tenths;
+    }
+    jw_int(jw, tenths / 10);
+    jw_putc(jw, '.');
+    jw_putc(jw, (char)('0' + tenths % 10));
+}
+
+
+static void write_product_json(struct json_writer *jw,
+                               struct product_info *pi,
+                               struct quote_data_wrapper qdw,
+                               struct quote_groups *qg)
+{
+    JW_LITERAL(jw, "{\"code\":");
+    jw_string(jw, pi->p_code);
+    JW_LITERAL(jw, ",\"name\":");
+    jw_string(jw, pi->p_name);
+    JW_LITERAL(jw, ",\"ram\":");
+    jw_int(jw, pi->ram);
+    JW_LITERAL(jw, ",\"screen_size\":");
+    jw_tenths(jw, pi->screen_size);
+    JW_LITERAL(jw, ",\"os\":");
+    jw_string(jw, pi->p_os);
+    JW_LITERAL(jw, ",\"quotes\":[");
+    
+    size_t cnt;
+    size_t *group = get_quote_group(qg, pi->code_id, &cnt);
+    for (size_t i = 0; i < cnt; i++)
+    {
+        struct quote_info *qi = qdw.data + *(group + i);
+        if (i > 0)
+        {
+            jw_putc(jw, ',');
+        }
+        JW_LITERAL(jw, "{\"id\":");
+        jw_string(jw, qi->p_id);
+        JW_LITERAL(jw, ",\"retailer\":");
+        jw_string(jw, dict_string(DICT_RETAILER, qi->retailer_id));
+        JW_LITERAL(jw, ",\"price\":");
+        jw_int(jw, qi->price);
+        JW_LITERAL(jw, ",\"stock\":");
+        jw_int(jw, qi->stock);
+        jw_putc(jw, '}');
+    }
+    JW_LITERAL(jw, "]}");
+}
+
+
+int export_catalog_json(char *f_name, int format,
+                        struct product_data_wrapper pdw,
+                        struct quote_data_wrapper qdw, struct quote_groups *qg)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    int to_stdout = strcmp(f_name, EXPORT_STDOUT) == 0;
+    FILE *fp = to_stdout ? stdout : open_file(f_name, "w");
+    if (fp == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    // Writer is big, so it is not kept on the stack
+    struct json_writer *jw = acct_malloc(ALLOC_OTHER,
+                                         sizeof(struct json_writer));
+    if (jw == NULL)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for "
+                 "exporting to \"%s\".", f_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        if (!to_stdout)
+        {
+            fclose(fp);
+        }
+        return EXIT_FAILURE;
+    }
+    jw->fp = fp;
+    jw->len = 0;
+    jw->err = 0;
+    
+    if (format == EXPORT_JSON)
+    {
+        jw_putc(jw, '[');
+    }
+    for (size_t i = 0; i < pdw.lines && !jw->err; i++)
+    {
+        if (format == EXPORT_JSON && i > 0)
+        {
+            jw_putc(jw, ',');
+        }
+        if (format == EXPORT_JSON)
+        {
+            jw_putc(jw, '\n');
+        }
+        write_product_json(jw, pdw.data + i, qdw, qg);
+        if (format == EXPORT_NDJSON)
+        {
+            jw_putc(jw, '\n');
+        }
+    }
+    if (format == EXPORT_JSON)
+    {
+        JW_LITERAL(jw, "\n]\n");
+    }
+    jw_flush(jw);
+    
+    int err = jw->err || fflush(fp) != 0 || ferror(fp);
+    acct_free(jw);
+    if (!to_stdout && fclose(fp) != 0)
+    {
+        err = 1;
+    }
+    if (err)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Writing export file \"%s\" failed.",
+                 f_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    snprintf(msg, MAX_ERR_MSG_LEN, "Exported %zu product(s) as %s to \"%s\".",
+             pdw.lines, format == EXPORT_JSON ? EXPORT_FMT_NAME_JSON :
+             EXPORT_FMT_NAME_NDJSON, f_name);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
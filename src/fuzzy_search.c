@@ -0,0 +1,281 @@
+/*
+File:         fuzzy_search.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Trigram index of product names for finding products, when the
+              name is not typed exactly right.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <alloc_acct.h>
+#include <main.h>
+#include <fuzzy_search.h>
+
+#define TRIGRAM_PAD 0
+
+/*
+    Maps a char to a trigram symbol. Returns -1 for chars that are dropped.
+*/
+static int trigram_symbol(char c)
+{
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 1;
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A' + 1;
+    }
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0' + 27;
+    }
+    return -1;
+}
+
+
+/*
+    Stores the distinct trigram keys of a string into keys, sorted. The string
+    is padded with two symbols at the start and one at the end. The number of
+    letters and digits read is stored into symbols. Returns the number of keys.
+*/
+static int get_trigrams(const char *str, int *keys, int *symbols)
+{
+    int prev2 = TRIGRAM_PAD;
+    int prev1 = TRIGRAM_PAD;
+    int cnt = 0;
+    for (; cnt < TRIGRAMS_PER_NAME_MAX; str++)
+    {
+        int sym = *str == '\0' ? TRIGRAM_PAD : trigram_symbol(*str);
+        if (sym < 0)
+        {
+            continue;
+        }
+        // Empty string has no trigrams, not even padding
+        if (*str == '\0' && prev1 == TRIGRAM_PAD)
+        {
+            break;
+        }
+        *(keys + cnt) = (prev2 * TRIGRAM_SYMBOLS + prev1) * TRIGRAM_SYMBOLS +
+                        sym;
+        cnt++;
+        if (*str == '\0')
+        {
+            break;
+        }
+        prev2 = prev1;
+        prev1 = sym;
+    }
+    *symbols = cnt > 0 ? cnt - 1 : 0;
+    
+    // Names are short, insertion sort beats qsort here
+    for (int i = 1; i < cnt; i++)
+    {
+        int key = *(keys + i);
+        int j = i;
+        while (j > 0 && *(keys + j - 1) > key)
+        {
+            *(keys + j) = *(keys + j - 1);
+            j--;
+        }
+        *(keys + j) = key;
+    }
+    int unique = 0;
+    for (int i = 0; i < cnt; i++)
+    {
+        if (unique == 0 || *(keys + i) != *(keys + unique - 1))
+        {
+            *(keys + unique) = *(keys + i);
+            unique++;
+        }
+    }
+    return unique;
+}
+
+
+int build_trigram_index(struct product_data_wrapper pdw,
+                        struct trigram_index *ti)
+{
+    int keys[TRIGRAMS_PER_NAME_MAX];
+    int symbols;
+    ti->product_cnt = pdw.lines;
+    ti->postings = NULL;
+    ti->first = acct_calloc(ALLOC_INDEX, TRIGRAM_CNT + 1, sizeof(size_t));
+    ti->name_trigrams = acct_malloc(ALLOC_INDEX, sizeof(uint16_t) *
+                                    (pdw.lines + 1));
+    ti->name_symbols = acct_malloc(ALLOC_INDEX, sizeof(uint16_t) *
+                                   (pdw.lines + 1));
+    if (ti->first == NULL || ti->name_trigrams == NULL ||
+        ti->name_symbols == NULL)
+    {
+        free_trigram_index(ti);
+        return EXIT_FAILURE;
+    }
+    
+    // Count postings of every trigram, then turn counts into list ends
+    size_t total = 0;
+    for (size_t i = 0; i < pdw.lines; i++)
+    {
+        int cnt = get_trigrams((pdw.data + i)->p_name, keys, &symbols);
+        *(ti->name_trigrams + i) = (uint16_t)cnt;
+        *(ti->name_symbols + i) = (uint16_t)symbols;
+        for (int k = 0; k < cnt; k++)
+        {
+            (*(ti->first + *(keys + k) + 1))++;
+        }
+        total += (size_t)cnt;
+    }
+    for (int t = 0; t < TRIGRAM_CNT; t++)
+    {
+        *(ti->first + t + 1) += *(ti->first + t);
+    }
+    
+    ti->postings = acct_malloc(ALLOC_INDEX, sizeof(size_t) * (total + 1));
+    if (ti->postings == NULL)
+    {
+        free_trigram_index(ti);
+        return EXIT_FAILURE;
+    }
+    
+    // Filling moves every start to the next lists start, shifted back after
+    for (size_t i = 0; i < pdw.lines; i++)
+    {
+        int cnt = get_trigrams((pdw.data + i)->p_name, keys, &symbols);
+        for (int k = 0; k < cnt; k++)
+        {
+            *(ti->postings + *(ti->first + *(keys + k))) = i;
+            (*(ti->first + *(keys + k)))++;
+        }
+    }
+    for (int t = TRIGRAM_CNT; t > 0; t--)
+    {
+        *(ti->first + t) = *(ti->first + t - 1);
+    }
+    *ti->first = 0;
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Returns nonzero, if match a ranks before match b. Equal similarity prefers
+    the name closer to the query in length, then the earlier product.
+*/
+static int ranks_before(struct fuzzy_match *a, struct fuzzy_match *b)
+{
+    if (a->similarity != b->similarity)
+    {
+        return a->similarity > b->similarity;
+    }
+    if (a->length_diff != b->length_diff)
+    {
+        return a->length_diff < b->length_diff;
+    }
+    return a->product < b->product;
+}
+
+
+/*
+    Adds a match into the sorted matches array, if it is good enough.
+*/
+static void add_match(struct fuzzy_match *matches, int *cnt, int max_matches,
+                      struct fuzzy_match m)
+{
+    int pos = *cnt;
+    while (pos > 0 && ranks_before(&m, matches + pos - 1))
+    {
+        pos--;
+    }
+    if (pos >= max_matches)
+    {
+        return;
+    }
+    int last = *cnt < max_matches ? *cnt : max_matches - 1;
+    for (int i = last; i > pos; i--)
+    {
+        *(matches + i) = *(matches + i - 1);
+    }
+    *(matches + pos) = m;
+    if (*cnt < max_matches)
+    {
+        (*cnt)++;
+    }
+}
+
+
+int fuzzy_find_products(struct trigram_index *ti, const char *query,
+                        struct fuzzy_match *matches, int max_matches)
+{
+    int keys[TRIGRAMS_PER_NAME_MAX];
+    int symbols;
+    int key_cnt = get_trigrams(query, keys, &symbols);
+    if (key_cnt == 0 || ti->product_cnt == 0)
+    {
+        return 0;
+    }
+    
+    // Shared trigram count of every product, touched lists the nonzero ones
+    uint16_t *shared = acct_calloc(ALLOC_OTHER, ti->product_cnt,
+                                   sizeof(uint16_t));
+    size_t *touched = acct_malloc(ALLOC_OTHER, sizeof(size_t) *
+                                  ti->product_cnt);
+    if (shared == NULL || touched == NULL)
+    {
+        acct_free(shared);
+        acct_free(touched);
+        return -1;
+    }
+    size_t touched_cnt = 0;
+    for (int k = 0; k < key_cnt; k++)
+    {
+        size_t end = *(ti->first + *(keys + k) + 1);
+        for (size_t p = *(ti->first + *(keys + k)); p < end; p++)
+        {
+            size_t product = *(ti->postings + p);
+            if (*(shared + product) == 0)
+            {
+                *(touched + touched_cnt) = product;
+                touched_cnt++;
+            }
+            (*(shared + product))++;
+        }
+    }
+    
+    int cnt = 0;
+    for (size_t i = 0; i < touched_cnt; i++)
+    {
+        size_t product = *(touched + i);
+        int length_diff = *(ti->name_symbols + product) - symbols;
+        struct fuzzy_match m =
+        {
+            .product = product,
+            .similarity = 2.0f * *(shared + product) /
+                          (float)(key_cnt + *(ti->name_trigrams + product)),
+            .length_diff = length_diff < 0 ? -length_diff : length_diff
+        };
+        if (m.similarity >= FUZZY_MIN_SIMILARITY)
+        {
+            add_match(matches, &cnt, max_matches, m);
+        }
+    }
+    acct_free(shared);
+    acct_free(touched);
+    return cnt;
+}
+
+
+void free_trigram_index(struct trigram_index *ti)
+{
+    acct_free(ti->first);
+    acct_free(ti->postings);
+    acct_free(ti->name_trigrams);
+    acct_free(ti->name_symbols);
+    ti->first = NULL;
+    ti->postings = NULL;
+    ti->name_trigrams = NULL;
+    ti->name_symbols = NULL;
+    ti->product_cnt = 0;
+}
@@ -0,0 +1,214 @@
+/*
+File:         hash_index.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  A string to integer hash table, used for finding data entries by
+              their ID or code without going through the whole data array.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <alloc_acct.h>
+#include <hash_index.h>
+
+#define FNV_OFFSET_BASIS 14695981039346656037u
+#define FNV_PRIME 1099511628211u
+
+uint64_t hash_string(const char *str)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    while (*str != '\0')
+    {
+        hash ^= (unsigned char)*str;
+        hash *= FNV_PRIME;
+        str++;
+    }
+    return hash;
+}
+
+
+static int hash_index_alloc(struct hash_index *hi, size_t capacity)
+{
+    hi->slots = acct_calloc(ALLOC_INDEX, capacity, sizeof(struct hash_slot));
+    if (hi->slots == NULL)
+    {
+        return HASH_MALLOC_ERR;
+    }
+    hi->capacity = capacity;
+    hi->count = 0;
+    return HASH_OK;
+}
+
+
+int hash_index_init(struct hash_index *hi, size_t expected_cnt)
+{
+    size_t capacity = HASH_MIN_CAPACITY;
+    while (capacity / 4 * 3 < expected_cnt)
+    {
+        capacity = acct_grow_limit(capacity, HASH_MIN_CAPACITY,
+                                   sizeof(struct hash_slot));
+        if (capacity == 0)
+        {
+            return HASH_MALLOC_ERR;
+        }
+    }
+    return hash_index_alloc(hi, capacity);
+}
+
+
+static void insert_slot(struct hash_index *hi, struct hash_slot slot)
+{
+    size_t mask = hi->capacity - 1;
+    size_t i = slot.hash & mask;
+    while ((hi->slots + i)->key != NULL)
+    {
+        i = (i + 1) & mask;
+    }
+    *(hi->slots + i) = slot;
+    hi->count++;
+}
+
+
+static int grow(struct hash_index *hi)
+{
+    struct hash_index bigger;
+    size_t capacity = acct_grow_limit(hi->capacity, HASH_MIN_CAPACITY,
+                                      sizeof(struct hash_slot));
+    if (capacity == 0 || hash_index_alloc(&bigger, capacity) != HASH_OK)
+    {
+        return HASH_MALLOC_ERR;
+    }
+    for (size_t i = 0; i < hi->capacity; i++)
+    {
+        if ((hi->slots + i)->key != NULL)
+        {
+            insert_slot(&bigger, *(hi->slots + i));
+        }
+    }
+    acct_free(hi->slots);
+    *hi = bigger;
+    return HASH_OK;
+}
+
+
+static struct hash_slot *find_slot(struct hash_index *hi, const char *key,
+                                   uint64_t hash)
+{
+    if (hi->slots == NULL)
+    {
+        return NULL;
+    }
+    size_t mask = hi->capacity - 1;
+    size_t i = hash & mask;
+    while ((hi->slots + i)->key != NULL)
+    {
+        if ((hi->slots + i)->hash == hash &&
+            strcmp((hi->slots + i)->key, key) == 0)
+        {
+            return hi->slots + i;
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+
+int hash_index_put(struct hash_index *hi, char *key, int64_t value)
+{
+    if (hi->slots == NULL && hash_index_init(hi, 0) != HASH_OK)
+    {
+        return HASH_MALLOC_ERR;
+    }
+    
+    uint64_t hash = hash_string(key);
+    struct hash_slot *slot = find_slot(hi, key, hash);
+    if (slot != NULL)
+    {
+        slot->value = value;
+        slot->key = key;
+        return HASH_OK;
+    }
+    
+    if ((hi->count + 1) > hi->capacity / 4 * 3 && grow(hi) != HASH_OK)
+    {
+        return HASH_MALLOC_ERR;
+    }
+    struct hash_slot new_slot = {.key = key, .value = value, .hash = hash};
+    insert_slot(hi, new_slot);
+    return HASH_OK;
+}
+
+
+int64_t hash_index_get(struct hash_index *hi, const char *key)
+{
+    struct hash_slot *slot = find_slot(hi, key, hash_string(key));
+    if (slot == NULL)
+    {
+        return HASH_NOT_FOUND;
+    }
+    return slot->value;
+}
+
+
+int64_t hash_index_remove(struct hash_index *hi, const char *key)
+{
+    struct hash_slot *slot = find_slot(hi, key, hash_string(key));
+    if (slot == NULL)
+    {
+        return HASH_NOT_FOUND;
+    }
+    int64_t value = slot->value;
+    
+    // Backward shift: move later entries of the probe chain into the gap
+    size_t mask = hi->capacity - 1;
+    size_t gap = (size_t)(slot - hi->slots);
+    size_t i = (gap + 1) & mask;
+    while ((hi->slots + i)->key != NULL)
+    {
+        size_t home = (hi->slots + i)->hash & mask;
+        // Entry can move, if its home is not between the gap and itself
+        if (((i - home) & mask) >= ((i - gap) & mask))
+        {
+            *(hi->slots + gap) = *(hi->slots + i);
+            gap = i;
+        }
+        i = (i + 1) & mask;
+    }
+    (hi->slots + gap)->key = NULL;
+    hi->count--;
+    return value;
+}
+
+
+int hash_index_copy(struct hash_index *dest, struct hash_index *src)
+{
+    if (src->slots == NULL)
+    {
+        dest->slots = NULL;
+        dest->capacity = 0;
+        dest->count = 0;
+        return HASH_OK;
+    }
+    dest->slots = acct_malloc(ALLOC_INDEX, sizeof(struct hash_slot) *
+                              src->capacity);
+    if (dest->slots == NULL)
+    {
+        dest->capacity = 0;
+        dest->count = 0;
+        return HASH_MALLOC_ERR;
+    }
+    memcpy(dest->slots, src->slots, sizeof(struct hash_slot) * src->capacity);
+    dest->capacity = src->capacity;
+    dest->count = src->count;
+    return HASH_OK;
+}
+
+
+void hash_index_free(struct hash_index *hi)
+{
+    acct_free(hi->slots);
+    hi->slots = NULL;
+    hi->capacity = 0;
+    hi->count = 0;
+}
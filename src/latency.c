@@ -0,0 +1,204 @@
+/*
+File:         latency.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Latency histograms of menu options and batch actions. Recording
+              takes two clock reads and a few relaxed atomic additions, so it
+              is always on.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <log_handler.h>
+#include <latency.h>
+
+static struct latency_hist hists[LAT_OP_CNT];
+
+// User input waited for by the thread, left out of its operations
+static _Thread_local uint64_t input_wait = 0;
+
+static const char *const op_names[LAT_OP_CNT] =
+{
+    "load data",
+    "print all data",
+    "edit RAM",
+    "edit retailer",
+    "search product",
+    "price history",
+    "lowest price",
+    "apply delta",
+    "bulk edit",
+    "browse pages",
+    "retailer report",
+    "query",
+    "add watch rule",
+    "check watches",
+    "export JSON",
+    "best prices",
+    "save products",
+    "save quotes"
+};
+
+uint64_t latency_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+void latency_add_wait(uint64_t ns)
+{
+    input_wait += ns;
+}
+
+
+void latency_begin(struct latency_span *span)
+{
+    span->wait = input_wait;
+    span->start = latency_now();
+}
+
+
+void latency_end(struct latency_span *span, enum latency_ops op)
+{
+    uint64_t end = latency_now();
+    if (op >= LAT_OP_CNT)
+    {
+        return;
+    }
+    uint64_t ns = end - span->start;
+    uint64_t waited = input_wait - span->wait;
+    latency_record(op, waited < ns ? ns - waited : 0);
+}
+
+
+static int bucket_index(uint64_t ns)
+{
+    if (ns < LAT_SUB_CNT)
+    {
+        return (int)ns;
+    }
+    int shift = 63 - __builtin_clzll(ns) - LAT_SUB_BITS + 1;
+    return (shift + 1) * LAT_HALF_CNT + (int)(ns >> shift) - LAT_HALF_CNT;
+}
+
+
+/*
+    Highest value, that is recorded into a bucket.
+*/
+static uint64_t bucket_max(int idx)
+{
+    if (idx < LAT_SUB_CNT)
+    {
+        return (uint64_t)idx;
+    }
+    int shift = idx / LAT_HALF_CNT - 1;
+    uint64_t sub = (uint64_t)(idx % LAT_HALF_CNT + LAT_HALF_CNT);
+    return ((sub + 1) << shift) - 1;
+}
+
+
+void latency_record(enum latency_ops op, uint64_t ns)
+{
+    struct latency_hist *h = hists + op;
+    atomic_fetch_add_explicit(h->buckets + bucket_index(ns), 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->cnt, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, ns, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (ns > max &&
+           !atomic_compare_exchange_weak_explicit(&h->max, &max, ns,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+    {
+    }
+}
+
+
+uint64_t latency_percentile(enum latency_ops op, double pct)
+{
+    struct latency_hist *h = hists + op;
+    uint64_t cnt = atomic_load_explicit(&h->cnt, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    if (cnt == 0)
+    {
+        return 0;
+    }
+    
+    // Rank of the value, rounded up, at least the first value
+    double rank = pct / 100.0 * (double)cnt;
+    uint64_t target = (uint64_t)rank;
+    target += (double)target < rank || target == 0;
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKET_CNT; i++)
+    {
+        seen += atomic_load_explicit(h->buckets + i, memory_order_relaxed);
+        if (seen >= target)
+        {
+            uint64_t val = bucket_max(i);
+            return val < max ? val : max;
+        }
+    }
+    return max;
+}
+
+
+static void format_row(char *str, size_t len, enum latency_ops op)
+{
+    snprintf(str, len, "%-16s%9llu%11.3f%11.3f%11.3f%11.3f%12.3f",
+             *(op_names + op),
+             (unsigned long long)atomic_load(&(hists + op)->cnt),
+             (double)latency_percentile(op, 50) / LAT_NS_PER_MS,
+             (double)latency_percentile(op, 90) / LAT_NS_PER_MS,
+             (double)latency_percentile(op, 99) / LAT_NS_PER_MS,
+             (double)atomic_load(&(hists + op)->max) / LAT_NS_PER_MS,
+             (double)atomic_load(&(hists + op)->sum) / LAT_NS_PER_MS);
+}
+
+
+static void format_head(char *str, size_t len)
+{
+    snprintf(str, len, "%-16s%9s%11s%11s%11s%11s%12s", "Latency (ms)",
+             "Count", "p50", "p90", "p99", "Max", "Total");
+}
+
+
+static void exit_report(void)
+{
+    char row[MAX_LOG_MSG_STR_LEN];
+    int ran = 0;
+    for (int i = 0; i < LAT_OP_CNT; i++)
+    {
+        ran = ran || atomic_load(&(hists + i)->cnt) != 0;
+    }
+    if (!ran)
+    {
+        return;
+    }
+    format_head(row, MAX_LOG_MSG_STR_LEN);
+    fprintf(stderr, "%s\n", row);
+    write_log(INFO, "Latency report at exit:");
+    write_log(INFO, row);
+    for (int i = 0; i < LAT_OP_CNT; i++)
+    {
+        if (atomic_load(&(hists + i)->cnt) == 0)
+        {
+            continue;
+        }
+        format_row(row, MAX_LOG_MSG_STR_LEN, (enum latency_ops)i);
+        fprintf(stderr, "%s\n", row);
+        write_log(INFO, row);
+    }
+}
+
+
+void latency_init(void)
+{
+    atexit(exit_report);
+}
@@ -9,11 +9,15 @@ Description:  Functions to help with logging.
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
 #include <log_handler.h>
 
 static enum log_levels global_log_level = INFO;
 static char global_log_file_name[MAX_LOG_FILE_NAME_LEN] = "log.txt";
 
+// Data files can be read by several threads, keeps log lines whole
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
 void get_log_time(char *str)
 {
     time_t current_time;
@@ -32,10 +36,12 @@ void write_log(enum log_levels msg_lvl, char *msg)
         return;
     }
     
+    pthread_mutex_lock(&log_lock);
     FILE *p_log_file;
     p_log_file = fopen(global_log_file_name, "a");
     if (p_log_file == NULL)
     {
+        pthread_mutex_unlock(&log_lock);
         fprintf(stderr, "%s\n", WARNING_BAR_STR);
         fprintf(stderr, "\t\t!!! WARNING !!!\n");
         fprintf(stderr, "Unable to open logfile \"%s\". Current actions are not"
@@ -50,6 +56,7 @@ void write_log(enum log_levels msg_lvl, char *msg)
     fprintf(p_log_file, "%s %s: %s\n", s_time, print_log_level(msg_lvl), msg);
     
     fclose(p_log_file);
+    pthread_mutex_unlock(&log_lock);
 }
 
 
@@ -78,7 +85,6 @@ void set_logging_file_name(char *f_name)
         
         if (*(f_name + i) == '\0')
         {
-            printf("%s\n", global_log_file_name);
             return;
         }
         i++;
@@ -13,13 +13,53 @@ Description:  Main code file for homework assignment II - Price Watch. General
 #include <stdbool.h>
 #include <limits.h>
 #include <string.h>
+#include <alloc_acct.h>
 #include <log_handler.h>
 #include <arg_parse.h>
 #include <data_read_write.h>
 #include <csv_helper.h>
 #include <data_printing.h>
+#include <quote_shards.h>
+#include <data_load.h>
+#include <price_history.h>
+#include <quote_delta.h>
+#include <product_bulk_edit.h>
+#include <catalog.h>
+#include <dictionary.h>
+#include <report.h>
+#include <page_view.h>
+#include <export_json.h>
+#include <retailer_stats.h>
+#include <fuzzy_search.h>
+#include <query.h>
+#include <watch_rules.h>
+#include <latency.h>
+#include <trace.h>
+#include <metrics.h>
+#include <best_price.h>
 #include <main.h>
 
+// Benchmarks link the other functions of this file with their own main
+#ifndef PRICE_WATCH_NO_MAIN
+
+// Timed operation of every menu option
+static const enum latency_ops menu_ops[MENU_OPT_CNT] =
+{
+    [MENU_OPT_EXIT] = LAT_OP_CNT,
+    [MENU_OPT_DISP_DATA] = LAT_DISPLAY,
+    [MENU_OPT_EDIT_RAM] = LAT_EDIT_RAM,
+    [MENU_OPT_EDIT_RTLR] = LAT_EDIT_RTLR,
+    [MENU_OPT_SRCH_PRO] = LAT_SEARCH,
+    [MENU_OPT_HIST_TREND] = LAT_HIST_TREND,
+    [MENU_OPT_HIST_LOW] = LAT_HIST_LOW,
+    [MENU_OPT_APPLY_DELTA] = LAT_APPLY_DELTA,
+    [MENU_OPT_BULK_EDIT] = LAT_BULK_EDIT,
+    [MENU_OPT_BROWSE] = LAT_BROWSE,
+    [MENU_OPT_RTLR_REPORT] = LAT_RTLR_REPORT,
+    [MENU_OPT_QUERY] = LAT_QUERY,
+    [MENU_OPT_WATCH_ADD] = LAT_WATCH_ADD
+};
+
 int main(int argc, char **argv)
 {
     // Default logging level: INFO & file name: "log.txt" in log lib
@@ -34,14 +74,27 @@ int main(int argc, char **argv)
         {ARG_FILE_PRO, "--file_products", 2},
         {ARG_FILE_QTE, "--file_quotes", 2},
         {LOG_FILE, "--file_log", 2},
-        {LOG_LEVEL, "--log_level", 2}
+        {LOG_LEVEL, "--log_level", 2},
+        {ARG_FILE_HIST, "--history_file", 2},
+        {ARG_HIST_ADD, "--history_add", 1},
+        {ARG_FILE_DELTA, "--delta_quotes", 2},
+        {ARG_FILE_BULK, "--bulk_edit_products", 2},
+        {ARG_EXPORT_JSON, "--export_json", 2},
+        {ARG_EXPORT_FMT, "--export_format", 2},
+        {ARG_QUERY, "--query", 2},
+        {ARG_FILE_WATCH, "--watch_rules", 2},
+        {ARG_FILE_ALERTS, "--alerts_file", 2},
+        {ARG_FILE_TRACE, "--trace_file", 2},
+        {ARG_FILE_METRICS, "--metrics_file", 2},
+        {ARG_BEST_PRICE, "--best_price_report", 2}
     };
     
     // Default argument values
     struct argument arguments =
     {
         .f_pro = "data/products.csv",
-        .f_qte = "data/quotes.csv",
+        .f_qte = {"data/quotes.csv"},
+        .f_qte_cnt = 1
     };
     
     // Parse arguments if needed
@@ -54,94 +107,500 @@ int main(int argc, char **argv)
     {
         write_log(INFO, "Using default arguments.");
     }
+    acct_init();
+    latency_init();
+    if ((*arguments.f_trace != '\0' && trace_open(arguments.f_trace) ==
+         EXIT_FAILURE) ||
+        (*arguments.f_metrics != '\0' && metrics_open(arguments.f_metrics) ==
+         EXIT_FAILURE))
+    {
+        write_log(INFO, "Closing program after encountering an error.");
+        return EXIT_FAILURE;
+    }
+    
+    int return_val;
+    struct latency_span span;
     
-    // Setup products wrapper and read products data
+    // Setup wrappers and read products and quotes data at the same time
     struct product_data_wrapper products_wrapper =
     {
         .data = NULL,
         .lines = 0,
         .data_struct_size = sizeof(struct product_info)
     };
+    struct quote_data_wrapper quotes_wrapper =
+    {
+        .data = NULL,
+        .lines = 0,
+        .data_struct_size = sizeof(struct quote_info),
+        .shard_names = NULL,
+        .shard_cnt = 0
+    };
     
-    if (read_data_products(arguments.f_pro, &products_wrapper) == EXIT_FAILURE)
+    char *quote_sources[QTE_SOURCES_MAX];
+    for (int i = 0; i < arguments.f_qte_cnt; i++)
+    {
+        quote_sources[i] = arguments.f_qte[i];
+    }
+    
+    latency_begin(&span);
+    return_val = load_data_files(arguments.f_pro, quote_sources,
+                                 arguments.f_qte_cnt, &products_wrapper,
+                                 &quotes_wrapper);
+    latency_end(&span, LAT_LOAD);
+    if (return_val == EXIT_FAILURE)
     {
         free_product_info(&products_wrapper);
+        free_quote_info(&quotes_wrapper);
+        free_dictionaries();
+        free_file_layouts();
         write_log(INFO, "Closing program after encountering an error.");
         return EXIT_FAILURE;
     }
     
-    // Setup quotes wrapper and read quotes data
-    struct quote_data_wrapper quotes_wrapper =
+    // Memory use of loaded data, logged only with allocation accounting
+    acct_log_report("after loading data");
+    acct_log_per_record(products_wrapper.lines, quotes_wrapper.lines);
+    
+    // Quote changes are applied before anything else uses the quotes
+    bool quotes_modified = false;
+    if (*arguments.f_delta != '\0')
     {
-        .data = NULL,
-        .lines = 0,
-        .data_struct_size = sizeof(struct quote_info)
-    };
+        struct delta_summary summary;
+        latency_begin(&span);
+        return_val = apply_quote_delta(arguments.f_delta, &quotes_wrapper,
+                                       &summary);
+        latency_end(&span, LAT_APPLY_DELTA);
+        if (return_val == EXIT_FAILURE)
+        {
+            free_product_info(&products_wrapper);
+            free_quote_info(&quotes_wrapper);
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        quotes_modified = summary.inserted + summary.updated +
+                          summary.deleted > 0;
+    }
+    
+    // Bulk product edits are saved with one write of the products file
+    if (*arguments.f_bulk != '\0')
+    {
+        struct bulk_edit_summary summary;
+        latency_begin(&span);
+        return_val = apply_product_bulk_edit(arguments.f_bulk, &products_wrapper,
+                                             &summary);
+        latency_end(&span, LAT_BULK_EDIT);
+        print_bulk_edit_summary(arguments.f_bulk, summary);
+        if (return_val == EXIT_FAILURE)
+        {
+            free_product_info(&products_wrapper);
+            free_quote_info(&quotes_wrapper);
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        if (summary.edited > 0 &&
+            !save_product_file_changes(arguments.f_pro, products_wrapper))
+        {
+            fprintf(stderr, "Changes made will not be saved.\n");
+        }
+    }
+    
+    // Price history is used only with a history file
+    struct price_history history;
+    history_init(&history);
+    if (*arguments.f_hist != '\0')
+    {
+        if (load_price_history(arguments.f_hist, &history) == EXIT_FAILURE ||
+            (arguments.hist_add &&
+             history_add_snapshot(&history, quotes_wrapper) == EXIT_FAILURE))
+        {
+            free_product_info(&products_wrapper);
+            free_quote_info(&quotes_wrapper);
+            free_price_history(&history);
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        if (arguments.hist_add &&
+            !save_price_history(arguments.f_hist, &history))
+        {
+            fprintf(stderr, "Price history snapshot will not be saved.\n");
+        }
+    }
     
-    if (read_data_quotes(arguments.f_qte, &quotes_wrapper) == EXIT_FAILURE)
+    // From here on data is read and changed only through catalog versions
+    if (catalog_init(products_wrapper, quotes_wrapper) == EXIT_FAILURE)
     {
         free_product_info(&products_wrapper);
         free_quote_info(&quotes_wrapper);
+        free_price_history(&history);
+        free_dictionaries();
+        free_file_layouts();
         write_log(INFO, "Closing program after encountering an error.");
         return EXIT_FAILURE;
     }
     
     // Menu
     bool products_modified = false;
-    bool quotes_modified = false;
+    struct catalog_version *cv;
+    struct quote_groups *groups;
     char msg[STR_MAX];
-    int menu_action;
-    int return_val;
-    do
+    int menu_action = MENU_OPT_DISP_DATA;
+    
+    // Watch rules are checked against the loaded quotes first
+    if (*arguments.f_watch != '\0')
+    {
+        cv = catalog_read_begin();
+        return_val = watch_load(arguments.f_watch, arguments.f_alerts,
+                                cv->products);
+        catalog_read_end();
+        if (return_val == EXIT_FAILURE || watch_check_changes() == EXIT_FAILURE)
+        {
+            catalog_free();
+            free_price_history(&history);
+            watch_free();
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // Export mode writes the data instead of showing the menu
+    if (*arguments.f_export != '\0')
+    {
+        latency_begin(&span);
+        cv = catalog_read_begin();
+        groups = catalog_quote_groups(cv);
+        return_val = groups == NULL ? EXIT_FAILURE :
+                     export_catalog_json(arguments.f_export,
+                                         arguments.export_fmt, cv->products,
+                                         cv->quotes, groups);
+        catalog_read_end();
+        latency_end(&span, LAT_EXPORT);
+        if (return_val == EXIT_FAILURE)
+        {
+            catalog_free();
+            free_price_history(&history);
+            watch_free();
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        menu_action = MENU_OPT_EXIT;
+    }
+    
+    // Best price report mode writes the report instead of showing the menu
+    if (*arguments.f_best != '\0')
+    {
+        latency_begin(&span);
+        cv = catalog_read_begin();
+        return_val = write_best_price_report(arguments.f_best, cv->products,
+                                             cv->quotes);
+        catalog_read_end();
+        latency_end(&span, LAT_BEST_PRICE);
+        if (return_val == EXIT_FAILURE)
+        {
+            catalog_free();
+            free_price_history(&history);
+            watch_free();
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        menu_action = MENU_OPT_EXIT;
+    }
+    
+    // Query mode prints the query result instead of showing the menu
+    if (*arguments.query != '\0')
+    {
+        latency_begin(&span);
+        cv = catalog_read_begin();
+        return_val = run_query(cv->products, cv->quotes, arguments.query);
+        catalog_read_end();
+        latency_end(&span, LAT_QUERY);
+        if (return_val != QUERY_OK)
+        {
+            catalog_free();
+            free_price_history(&history);
+            watch_free();
+            free_dictionaries();
+            free_file_layouts();
+            write_log(INFO, "Closing program after encountering an error.");
+            return EXIT_FAILURE;
+        }
+        menu_action = MENU_OPT_EXIT;
+    }
+    
+    while (menu_action != MENU_OPT_EXIT)
     {
         print_menu();
         menu_action = get_int_in_range(MENU_OPT_EXIT, MENU_OPT_CNT - 1);
         putchar('\n');
+        latency_begin(&span);
         switch (menu_action)
         {
             case MENU_OPT_EXIT:
                 break;
             
             case MENU_OPT_DISP_DATA:
-                display_quotes_by_product(products_wrapper, quotes_wrapper);
+                cv = catalog_read_begin();
+                display_quotes_by_product(cv->products, cv->quotes);
+                catalog_read_end();
+                break;
+            
+            case MENU_OPT_RTLR_REPORT:
+                cv = catalog_read_begin();
+                show_retailer_report(cv->quotes);
+                catalog_read_end();
+                break;
+            
+            case MENU_OPT_QUERY:
+                cv = catalog_read_begin();
+                return_val = run_query_prompt(cv->products, cv->quotes);
+                catalog_read_end();
+                if (return_val == EXIT_FAILURE)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
                 break;
             
             case MENU_OPT_EDIT_RAM:
-                return_val = edit_product_ram(products_wrapper);
+                cv = catalog_update_begin(CATALOG_PRODUCTS);
+                if (cv == NULL)
+                {
+                    return_val = EDIT_MALLOC;
+                }
+                else
+                {
+                    return_val = edit_product_ram(cv->products);
+                    if (return_val == EDIT_OK)
+                    {
+                        catalog_update_commit(cv);
+                    }
+                    else
+                    {
+                        catalog_update_abort(cv);
+                    }
+                }
                 if (return_val == EDIT_OK)
                 {
                     products_modified = true;
                 }
                 else if (return_val == EDIT_MALLOC)
                 {
-                    free_product_info(&products_wrapper);
-                    free_quote_info(&quotes_wrapper);
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
                     write_log(INFO, "Closing program after encountering an error.");
                     return EXIT_FAILURE;
                 }
                 break;
             
             case MENU_OPT_EDIT_RTLR:
-                return_val = edit_quote_retailer(quotes_wrapper);
+                cv = catalog_update_begin(CATALOG_QUOTES);
+                if (cv == NULL)
+                {
+                    return_val = EDIT_MALLOC;
+                }
+                else
+                {
+                    return_val = edit_quote_retailer(cv->quotes);
+                    if (return_val == EDIT_OK)
+                    {
+                        catalog_update_commit(cv);
+                    }
+                    else
+                    {
+                        catalog_update_abort(cv);
+                    }
+                    if (watch_check_changes() == EXIT_FAILURE)
+                    {
+                        return_val = EDIT_MALLOC;
+                    }
+                }
                 if (return_val == EDIT_OK)
                 {
                     quotes_modified = true;
                 }
                 else if (return_val == EDIT_MALLOC)
                 {
-                    free_product_info(&products_wrapper);
-                    free_quote_info(&quotes_wrapper);
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
                     write_log(INFO, "Closing program after encountering an error.");
                     return EXIT_FAILURE;
                 }
                 break;
             
             case MENU_OPT_SRCH_PRO:
-                return_val = search_best_price(products_wrapper, quotes_wrapper);
+                cv = catalog_read_begin();
+                return_val = search_best_price(cv->products, cv->quotes,
+                                               catalog_name_index(cv));
+                catalog_read_end();
+                if (return_val == SRCH_RES_INPUT_ERR)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
+                break;
+            
+            case MENU_OPT_HIST_TREND:
+            case MENU_OPT_HIST_LOW:
+                if (*arguments.f_hist == '\0')
+                {
+                    printf("Price history is not in use. Start the program "
+                           "with \"--history_file <file>\".\n");
+                    break;
+                }
+                if (menu_action == MENU_OPT_HIST_TREND)
+                {
+                    return_val = show_quote_price_trend(&history);
+                }
+                else
+                {
+                    return_val = show_lowest_recent_price(&history);
+                }
                 if (return_val == SRCH_RES_INPUT_ERR)
                 {
-                    free_product_info(&products_wrapper);
-                    free_quote_info(&quotes_wrapper);
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
+                break;
+            
+            case MENU_OPT_APPLY_DELTA:
+                cv = catalog_update_begin(CATALOG_QUOTES);
+                if (cv == NULL)
+                {
+                    return_val = EDIT_MALLOC;
+                }
+                else
+                {
+                    return_val = apply_quote_delta_prompt(&cv->quotes);
+                    if (return_val == EDIT_OK)
+                    {
+                        catalog_update_commit(cv);
+                    }
+                    else
+                    {
+                        catalog_update_abort(cv);
+                    }
+                    if (watch_check_changes() == EXIT_FAILURE)
+                    {
+                        return_val = EDIT_MALLOC;
+                    }
+                }
+                if (return_val == EDIT_OK)
+                {
+                    quotes_modified = true;
+                }
+                else if (return_val == EDIT_MALLOC)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
+                break;
+            
+            case MENU_OPT_BULK_EDIT:
+                cv = catalog_update_begin(CATALOG_PRODUCTS);
+                if (cv == NULL)
+                {
+                    return_val = EDIT_MALLOC;
+                }
+                else
+                {
+                    return_val = apply_product_bulk_edit_prompt(&cv->products,
+                                                                arguments.f_pro);
+                    if (return_val == EDIT_OK)
+                    {
+                        catalog_update_commit(cv);
+                    }
+                    else
+                    {
+                        catalog_update_abort(cv);
+                    }
+                    if (watch_check_changes() == EXIT_FAILURE)
+                    {
+                        return_val = EDIT_MALLOC;
+                    }
+                }
+                if (return_val == EDIT_MALLOC)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
+                break;
+            
+            case MENU_OPT_WATCH_ADD:
+                if (!watch_enabled())
+                {
+                    printf("Watch rules are not in use. Start the program "
+                           "with \"--watch_rules <file>\".\n");
+                    break;
+                }
+                if (watch_add_rule_prompt() == EDIT_MALLOC)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
+                    write_log(INFO, "Closing program after encountering an error.");
+                    return EXIT_FAILURE;
+                }
+                break;
+            
+            case MENU_OPT_BROWSE:
+                cv = catalog_read_begin();
+                groups = catalog_quote_groups(cv);
+                return_val = groups == NULL ? EXIT_FAILURE :
+                             browse_catalog_pages(cv->products, cv->quotes,
+                                                  groups);
+                catalog_read_end();
+                if (return_val == EXIT_FAILURE)
+                {
+                    catalog_free();
+                    free_price_history(&history);
+                    watch_free();
+                    free_dictionaries();
+                    free_file_layouts();
                     write_log(INFO, "Closing program after encountering an error.");
                     return EXIT_FAILURE;
                 }
@@ -154,37 +613,47 @@ int main(int argc, char **argv)
                 fprintf(stderr, "%s\n", msg);
                 break;
         }
+        latency_end(&span, *(menu_ops + menu_action));
     }
-    while (menu_action != MENU_OPT_EXIT);
     
     // Write changes to file if needed
+    cv = catalog_read_begin();
     if (products_modified)
     {
-        if (!save_product_file_changes(arguments.f_pro, products_wrapper))
+        latency_begin(&span);
+        if (!save_product_file_changes(arguments.f_pro, cv->products))
         {
             fprintf(stderr, "Changes made will not be saved.\n");
         }
+        latency_end(&span, LAT_SAVE_PRO);
     }
     if (quotes_modified)
     {
-        if(!save_quote_file_changes(arguments.f_qte, quotes_wrapper))
+        latency_begin(&span);
+        if(!save_quote_file_changes(cv->quotes))
         {
             fprintf(stderr, "Changes made will not be saved.\n");
         }
+        latency_end(&span, LAT_SAVE_QTE);
     }
+    catalog_read_end();
     
     // Free dynamically allocated memory
-    free_product_info(&products_wrapper);
-    free_quote_info(&quotes_wrapper);
+    catalog_free();
+    free_price_history(&history);
+    watch_free();
+    free_dictionaries();
+    free_file_layouts();
     
     write_log(INFO, "Closing program successfully.");
     return EXIT_SUCCESS;
 }
+#endif
 
 
-char *dynamic_string(char *orgn_str)
+char *dynamic_string(const char *orgn_str, enum alloc_classes cls)
 {
-    char *dest_str = malloc(sizeof(char) * (strlen(orgn_str) + 1));
+    char *dest_str = acct_malloc(cls, sizeof(char) * (strlen(orgn_str) + 1));
     if (dest_str == NULL)
     {
         return NULL;
@@ -196,33 +665,39 @@ char *dynamic_string(char *orgn_str)
 
 void free_product_info(struct product_data_wrapper *pdw)
 {
-    for (int i = 0; i < pdw->lines; i++)
+    for (size_t i = 0; i < pdw->lines; i++)
     {   
-        free((pdw->data + i)->p_code);
-        free((pdw->data + i)->p_name);
-        free((pdw->data + i)->p_os);
+        acct_free((pdw->data + i)->p_code);
+        acct_free((pdw->data + i)->p_name);
+        acct_free((pdw->data + i)->p_os);
         (pdw->data + i)->p_code = NULL;
         (pdw->data + i)->p_name = NULL;
         (pdw->data + i)->p_os = NULL;
     }
-    free(pdw->data);
+    acct_free(pdw->data);
     pdw->data = NULL;
+    hash_index_free(&pdw->code_index);
 }
 
 
 void free_quote_info(struct quote_data_wrapper *qdw)
 {
-    for (int i = 0; i < qdw->lines; i++)
+    for (size_t i = 0; i < qdw->lines; i++)
     {   
-        free((qdw->data + i)->p_id);
-        free((qdw->data + i)->p_code);
-        free((qdw->data + i)->p_retailer);
+        acct_free((qdw->data + i)->p_id);
         (qdw->data + i)->p_id = NULL;
-        (qdw->data + i)->p_code = NULL;
-        (qdw->data + i)->p_retailer = NULL;
     }
-    free(qdw->data);
+    acct_free(qdw->data);
     qdw->data = NULL;
+    
+    for (int i = 0; i < qdw->shard_cnt; i++)
+    {
+        acct_free(*(qdw->shard_names + i));
+    }
+    acct_free(qdw->shard_names);
+    qdw->shard_names = NULL;
+    qdw->shard_cnt = 0;
+    hash_index_free(&qdw->id_index);
 }
 
 
@@ -248,7 +723,9 @@ int get_int(void)
     while (1)
     {
         printf("> ");
+        uint64_t wait_start = latency_now();
         fgets(buf, USER_INT_PROMPT_LEN, stdin);
+        latency_add_wait(latency_now() - wait_start);
         *(buf + strlen(buf) - 1) = '\0';
         if (sscanf(buf, "%d", &val) == 1)
         {
@@ -267,45 +744,12 @@ int get_int(void)
 void display_quotes_by_product(struct product_data_wrapper pdw,
                                struct quote_data_wrapper qdw)
 {
-    for (int i = 0; i < pdw.lines; i++)
+    uint64_t span = trace_begin();
+    if (print_catalog_report(stdout, pdw, qdw) == EXIT_SUCCESS)
     {
-        int nr = 0;
-        print_product_specs(*(pdw.data + i));
-        
-        for (int j = 0; j < qdw.lines; j++)
-        {
-            if (strcmp((*(pdw.data + i)).p_code, (*(qdw.data + j)).p_code) == 0)
-            {
-                if (nr == 0)
-                {
-                    printf("\nQuotes:\n");
-                    /*
-                        This column is not part of quote data printing.
-                        Therefore, to have the printing align when using both
-                        functions elsewhere, it is also not included in table
-                        head printing.
-                    */
-                    printf("\t%3s ", "Nr.");
-                    print_quote_table_head();
-                }
-                nr++;
-                printf("\t%3d ", nr);
-                print_product_quote(*(qdw.data + j));
-            }
-        }
-        
-        if (nr <= 0)
-        {
-            printf("\nNo quotes for %s available.\n\n", (pdw.data + i)->p_name);
-        }
-        putchar('\n');
-        
-        if (i != (pdw.lines - 1))
-        {
-            print_separator_line();
-        }
+        write_log(INFO, "Displayed all product and quote info to user.");
     }
-    write_log(INFO, "Displayed all product and quote info to user.");
+    trace_end(span, TRACE_CAT_DISPLAY, "display data", (int64_t)pdw.lines);
 }
 
 
@@ -321,30 +765,26 @@ int edit_product_ram(struct product_data_wrapper pdw)
     
     char msg[STR_MAX];
     
-    for (int i = 0; i < pdw.lines; i++)
+    int64_t i = find_product_by_code(pdw, search_str);
+    if (i == HASH_NOT_FOUND)
     {
-        if (strcmp(search_str, (pdw.data + i)->p_code) == 0)
-        {
-            printf("\nEnter new RAM amount.\n");
-            int new_ram = get_int_in_range(0, INT_MAX);
-            snprintf(msg, STR_MAX, "Updating products %s RAM: %d -> %d",
-                     (pdw.data + i)->p_name, (pdw.data + i)->ram, new_ram);
-            (pdw.data + i)->ram = new_ram;
-            write_log(INFO, msg);
-            printf("%s\n", msg);
-            break;
-        }
-        if (i == (pdw.lines - 1))
-        {
-            snprintf(msg, STR_MAX, "Search for product with product code: %s, "
-                     "returned no results.", search_str);
-            write_log(INFO, msg);
-            printf("%s Search is case sensitive!\n\n", msg);
-            free(search_str);
-            return EDIT_NO_MATCH;
-        }
+        snprintf(msg, STR_MAX, "Search for product with product code: %s, "
+                 "returned no results.", search_str);
+        write_log(INFO, msg);
+        printf("%s Search is case sensitive!\n\n", msg);
+        acct_free(search_str);
+        return EDIT_NO_MATCH;
     }
-    free(search_str);
+    
+    printf("\nEnter new RAM amount.\n");
+    int new_ram = get_int_in_range(0, INT_MAX);
+    snprintf(msg, STR_MAX, "Updating products %s RAM: %d -> %d",
+             (pdw.data + i)->p_name, (pdw.data + i)->ram, new_ram);
+    (pdw.data + i)->ram = new_ram;
+    metrics_add(MET_EDITS, 1);
+    write_log(INFO, msg);
+    printf("%s\n", msg);
+    acct_free(search_str);
     return EDIT_OK;
 }
 
@@ -361,38 +801,49 @@ int edit_quote_retailer(struct quote_data_wrapper qdw)
     
     char msg[STR_MAX];
     
-    for (int i = 0; i < qdw.lines; i++)
+    int64_t i = find_quote_by_id(qdw, search_str);
+    if (i == HASH_NOT_FOUND)
     {
-        if (strcmp(search_str, (qdw.data + i)->p_id) == 0)
-        {
-            printf("\nEnter new retailer name.\n> ");
-            char *new_retailer = get_dynamic_input_string(stdin);
-            if (new_retailer == NULL)
-            {
-                free(search_str);
-                return EDIT_MALLOC;
-            }
-            
-            snprintf(msg, STR_MAX, "Updating quote's %s retailer: %s -> %s",
-                     (qdw.data + i)->p_id, (qdw.data + i)->p_retailer,
-                     new_retailer);
-            free((qdw.data + i)->p_retailer);
-            (qdw.data + i)->p_retailer = new_retailer;
-            write_log(INFO, msg);
-            printf("%s\n\n", msg);
-            break;
-        }
-        if (i == (qdw.lines - 1))
-        {
-            snprintf(msg, STR_MAX, "Search for quote with id: %s, "
-                     "returned no results.", search_str);
-            write_log(INFO, msg);
-            printf("%s Search is case sensitive!\n\n", msg);
-            free(search_str);
-            return EDIT_NO_MATCH;
-        }
+        snprintf(msg, STR_MAX, "Search for quote with id: %s, "
+                 "returned no results.", search_str);
+        write_log(INFO, msg);
+        printf("%s Search is case sensitive!\n\n", msg);
+        acct_free(search_str);
+        return EDIT_NO_MATCH;
+    }
+    
+    printf("\nEnter new retailer name.\n> ");
+    char *new_retailer = get_dynamic_input_string(stdin);
+    if (new_retailer == NULL)
+    {
+        acct_free(search_str);
+        return EDIT_MALLOC;
+    }
+    
+    uint32_t new_id;
+    if (dict_intern(DICT_RETAILER, new_retailer, &new_id) != DICT_OK)
+    {
+        acct_free(new_retailer);
+        acct_free(search_str);
+        return EDIT_MALLOC;
+    }
+    
+    snprintf(msg, STR_MAX, "Updating quote's %s retailer: %s -> %s",
+             (qdw.data + i)->p_id,
+             dict_string(DICT_RETAILER, (qdw.data + i)->retailer_id),
+             new_retailer);
+    // Dictionary strings are never freed, so old versions stay readable
+    (qdw.data + i)->retailer_id = new_id;
+    metrics_add(MET_EDITS, 1);
+    write_log(INFO, msg);
+    printf("%s\n\n", msg);
+    
+    acct_free(new_retailer);
+    acct_free(search_str);
+    if (watch_mark_code((qdw.data + i)->code_id) == EXIT_FAILURE)
+    {
+        return EDIT_MALLOC;
     }
-    free(search_str);
     return EDIT_OK;
 }
 
@@ -403,6 +854,7 @@ char *get_dynamic_input_string(FILE *stream)
     char *temp = NULL;
     int chars_read = 0;
     int cur_str_len = 0;
+    uint64_t wait_start = latency_now();
     
     // INPUT STREAM MUST BE FLUSHED BEFOREHAND !!!
     while (1)
@@ -411,11 +863,11 @@ char *get_dynamic_input_string(FILE *stream)
         if (cur_str_len <= chars_read)
         {
             cur_str_len += DYN_INPUT_STR_LEN_MIN;
-            temp = realloc(str, (size_t)cur_str_len);
+            temp = acct_realloc(ALLOC_OTHER, str, (size_t)cur_str_len);
             
             // Simulates realloc fail
             #ifdef FUNC_GET_DYNAMIC_INPUT_STRING_TEST
-            free(temp);
+            acct_free(temp);
             temp = NULL;
             #endif
             
@@ -423,7 +875,7 @@ char *get_dynamic_input_string(FILE *stream)
             {
                 char *err = "Failed to allocate memory for dynamic string "
                             "while reading input.";
-                free(str);
+                acct_free(str);
                 write_log(ERROR, err);
                 fprintf(stderr, "%s\n", err);
                 return NULL;
@@ -434,7 +886,7 @@ char *get_dynamic_input_string(FILE *stream)
         *(str + chars_read) = (char)fgetc(stream);
         if (feof(stream))
         {
-            free(str);
+            acct_free(str);
             char *err = "Unexpected EOF occured while reading input into "
                         "dynamic string.";
             write_log(ERROR, err);
@@ -448,24 +900,91 @@ char *get_dynamic_input_string(FILE *stream)
         }
         chars_read++;
     }
+    latency_add_wait(latency_now() - wait_start);
     
     // Free unused allocated memory
-    temp = dynamic_string(str);
+    temp = dynamic_string(str, ALLOC_OTHER);
     if (temp == NULL)
     {
         char *err = "Failed to reallocate input string to shorten it.";
         write_log(ERROR, err);
         fprintf(stderr, "%s\n", err);
     }
-    free(str);
+    acct_free(str);
     str = temp;
     
     return str;
 }
 
 
+struct quote_info *find_cheapest_quote(struct quote_data_wrapper qdw,
+                                       uint32_t code_id)
+{
+    struct quote_info *min_price = NULL;
+    for (size_t j = 0; j < qdw.lines; j++)
+    {
+        if (code_id == (qdw.data + j)->code_id && (qdw.data + j)->stock &&
+            (min_price == NULL || min_price->price > (qdw.data + j)->price))
+        {
+            min_price = (qdw.data + j);
+        }
+    }
+    return min_price;
+}
+
+
+void print_cheapest_offer(struct quote_info *min_price)
+{
+    printf("\t%12s: %.2f\n", "Price", CNTS_TO_EUR((double)min_price->price));
+    printf("\t%12s: %s\n", "Retailer",
+           dict_string(DICT_RETAILER, min_price->retailer_id));
+    printf("\t%12s: %d\n", "Stock", min_price->stock);
+}
+
+
+int search_similar_products(struct product_data_wrapper pdw,
+                            struct quote_data_wrapper qdw,
+                            struct trigram_index *ti, char *search_str)
+{
+    struct fuzzy_match matches[FUZZY_RESULTS_MAX];
+    int match_cnt = 0;
+    if (ti != NULL)
+    {
+        match_cnt = fuzzy_find_products(ti, search_str, matches,
+                                        FUZZY_RESULTS_MAX);
+    }
+    if (match_cnt <= 0)
+    {
+        return SRCH_RES_NEG;
+    }
+    
+    char msg[STR_MAX];
+    snprintf(msg, STR_MAX, "Search for product with name \"%s\", returned "
+             "%d similar products.", search_str, match_cnt);
+    write_log(INFO, msg);
+    printf("\nNo exact match for \"%s\", closest matches:\n", search_str);
+    for (int i = 0; i < match_cnt; i++)
+    {
+        struct product_info *pi = pdw.data + matches[i].product;
+        printf("\n%s (%d%% similar)\n", pi->p_name,
+               (int)(matches[i].similarity * 100.0f + 0.5f));
+        struct quote_info *min_price = find_cheapest_quote(qdw, pi->code_id);
+        if (min_price == NULL)
+        {
+            printf("\tNo quotes with available stock.\n");
+        }
+        else
+        {
+            print_cheapest_offer(min_price);
+        }
+    }
+    putchar('\n');
+    return SRCH_RES_POS;
+}
+
+
 int search_best_price(struct product_data_wrapper pdw,
-                       struct quote_data_wrapper qdw)
+                      struct quote_data_wrapper qdw, struct trigram_index *ti)
 {
     printf("Enter product name to search for.\n> ");
     
@@ -479,7 +998,7 @@ int search_best_price(struct product_data_wrapper pdw,
     
     // Find if product exists
     struct product_info *search_res = NULL;
-    for (int i = 0; i < pdw.lines; i++)
+    for (size_t i = 0; i < pdw.lines; i++)
     {
         if (strcmp(search_str, (pdw.data + i)->p_name) == 0)
         {
@@ -489,29 +1008,22 @@ int search_best_price(struct product_data_wrapper pdw,
     }
     if (!search_res)
     {
-        snprintf(msg, STR_MAX, "Search for product with name \"%s\", "
-                 "returned no results.", search_str);
-        write_log(INFO, msg);
-        printf("%s Search is case sensitive!\n\n", msg);
-        free(search_str);
-        return SRCH_RES_NEG;
-    }
-    
-    // Find product with matching product code
-    struct quote_info *min_price = NULL;
-    int j = 0;
-    while (j < qdw.lines)
-    {
-        if (strcmp(search_res->p_code, (qdw.data + j)->p_code) == 0)
+        // Fall back to names with similar spelling
+        int return_val = search_similar_products(pdw, qdw, ti, search_str);
+        if (return_val == SRCH_RES_NEG)
         {
-            if ((qdw.data + j)->stock)
-            {
-                min_price = (qdw.data + j);
-                break;
-            }
+            snprintf(msg, STR_MAX, "Search for product with name \"%s\", "
+                     "returned no results.", search_str);
+            write_log(INFO, msg);
+            printf("%s\n\n", msg);
         }
-        j++;
+        acct_free(search_str);
+        return return_val;
     }
+    
+    // Find cheapest quote with stock for the product
+    struct quote_info *min_price = find_cheapest_quote(qdw,
+                                                       search_res->code_id);
     if (!min_price)
     {
         // No quote with stock found msg
@@ -519,32 +1031,16 @@ int search_best_price(struct product_data_wrapper pdw,
                  "stock exist.", search_str);
         write_log(INFO, msg);
         printf("%s\n\n", msg);
-        free(search_str);
+        acct_free(search_str);
         return SRCH_RES_NO_STOCK;
     }
-    j++;
-    
-    // Find if there are cheaper options
-    while (j < qdw.lines)
-    {
-        if (strcmp(search_res->p_code, (qdw.data + j)->p_code) == 0)
-        {
-            if (min_price->price > (qdw.data + j)->price && (qdw.data + j)->stock)
-            {
-                min_price = (qdw.data + j);
-            }
-        }
-        j++;
-    }
     
     // Print retailer with best price
     printf("\nCheapest offer for %s:\n", search_str);
-    printf("\t%12s: %.2f\n", "Price", CNTS_TO_EUR((float)min_price->price));
-    printf("\t%12s: %s\n", "Retailer", min_price->p_retailer);
-    printf("\t%12s: %d\n", "Stock", min_price->stock);
+    print_cheapest_offer(min_price);
     putchar('\n');
     
-    free(search_str);
+    acct_free(search_str);
     
     return SRCH_RES_POS;
 }
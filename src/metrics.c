@@ -0,0 +1,273 @@
+/*
+File:         metrics.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Counters and gauges of loading, queries, edits, saves and memory.
+              They are updated with relaxed atomics and written periodically
+              into a Prometheus text format file for external scraping.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <data_read_write.h>
+#include <metrics.h>
+
+static _Atomic uint64_t counters[MET_COUNTER_CNT];
+static _Atomic uint64_t gauges[MET_GAUGE_CNT];
+static _Atomic uint64_t read_errors[READ_ERR_CNT];
+
+// Label values of read error codes, READ_OK is not an error
+static const char *const read_error_names[READ_ERR_CNT] =
+{
+    [READ_OK] = NULL,
+    [READ_ERR_MSNG_DATA] = "missing_data",
+    [READ_ERR_STR_MALLOC] = "string_malloc",
+    [READ_ERR_RAM_NINT] = "ram_not_int",
+    [READ_ERR_RAM_NEG] = "ram_negative",
+    [READ_ERR_SCRNS_NFLOAT] = "screen_not_float",
+    [READ_ERR_SCRNS_NEG] = "screen_negative",
+    [READ_ERR_PRICE_NINT] = "price_not_int",
+    [READ_ERR_PRICE_NEG] = "price_negative",
+    [READ_ERR_STOCK_NINT] = "stock_not_int",
+    [READ_ERR_STOCK_NEG] = "stock_negative",
+    [READ_ERR_DELTA_OP] = "delta_op",
+    [READ_ERR_DICT_FULL] = "dictionary_full"
+};
+
+// Snapshot writer thread, stopped at exit
+static char *f_metrics = NULL;
+static char *f_tmp = NULL;
+static pthread_t writer;
+static pthread_mutex_t stop_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stop_cond;
+static int stop = 0;
+static int failing = 0;
+
+void metrics_add(enum metric_counters counter, uint64_t n)
+{
+    atomic_fetch_add_explicit(counters + counter, n, memory_order_relaxed);
+}
+
+
+void metrics_set(enum metric_gauges gauge, uint64_t value)
+{
+    atomic_store_explicit(gauges + gauge, value, memory_order_relaxed);
+}
+
+
+void metrics_read_error(enum read_errors err)
+{
+    if (err > READ_OK && err < READ_ERR_CNT)
+    {
+        atomic_fetch_add_explicit(read_errors + err, 1, memory_order_relaxed);
+    }
+}
+
+
+static uint64_t get_counter(enum metric_counters counter)
+{
+    return atomic_load_explicit(counters + counter, memory_order_relaxed);
+}
+
+
+static uint64_t get_gauge(enum metric_gauges gauge)
+{
+    return atomic_load_explicit(gauges + gauge, memory_order_relaxed);
+}
+
+
+static void print_head(FILE *fp, const char *name, const char *type,
+                       const char *help)
+{
+    fprintf(fp, "# HELP price_watch_%s %s\n# TYPE price_watch_%s %s\n", name,
+            help, name, type);
+}
+
+
+static void print_metrics(FILE *fp)
+{
+    print_head(fp, "rows_loaded_total", "counter", "Data rows read from "
+               "products and quotes files.");
+    fprintf(fp, "price_watch_rows_loaded_total{file=\"products\"} %llu\n"
+            "price_watch_rows_loaded_total{file=\"quotes\"} %llu\n",
+            (unsigned long long)get_counter(MET_PRODUCT_ROWS),
+            (unsigned long long)get_counter(MET_QUOTE_ROWS));
+    
+    print_head(fp, "parse_errors_total", "counter", "Data lines with a read "
+               "error by error code.");
+    for (int i = READ_OK + 1; i < READ_ERR_CNT; i++)
+    {
+        fprintf(fp, "price_watch_parse_errors_total{code=\"%s\"} %llu\n",
+                *(read_error_names + i),
+                (unsigned long long)atomic_load_explicit(read_errors + i,
+                                                         memory_order_relaxed));
+    }
+    
+    print_head(fp, "queries_total", "counter", "Queries run.");
+    fprintf(fp, "price_watch_queries_total %llu\n",
+            (unsigned long long)get_counter(MET_QUERIES));
+    print_head(fp, "query_rows_total", "counter", "Rows returned by queries.");
+    fprintf(fp, "price_watch_query_rows_total %llu\n",
+            (unsigned long long)get_counter(MET_QUERY_ROWS));
+    print_head(fp, "edits_total", "counter", "Products and quotes changed by "
+               "edits, deltas and bulk edits.");
+    fprintf(fp, "price_watch_edits_total %llu\n",
+            (unsigned long long)get_counter(MET_EDITS));
+    
+    print_head(fp, "save_duration_seconds", "summary", "Time spent saving "
+               "data files.");
+    fprintf(fp, "price_watch_save_duration_seconds_sum %.6f\n"
+            "price_watch_save_duration_seconds_count %llu\n",
+            (double)get_counter(MET_SAVE_NS) / METRICS_NS_PER_S,
+            (unsigned long long)get_counter(MET_SAVES));
+    
+    print_head(fp, "products", "gauge", "Products in the catalog.");
+    fprintf(fp, "price_watch_products %llu\n",
+            (unsigned long long)get_gauge(MET_G_PRODUCTS));
+    print_head(fp, "quotes", "gauge", "Quotes in the catalog.");
+    fprintf(fp, "price_watch_quotes %llu\n",
+            (unsigned long long)get_gauge(MET_G_QUOTES));
+    print_head(fp, "catalog_version", "gauge", "Current catalog version.");
+    fprintf(fp, "price_watch_catalog_version %llu\n",
+            (unsigned long long)get_gauge(MET_G_VERSION));
+    print_head(fp, "memory_bytes", "gauge", "Heap memory in use.");
+    fprintf(fp, "price_watch_memory_bytes %zu\n", acct_live_bytes());
+}
+
+
+/*
+    Writes a snapshot into the temporary file and renames it over the metrics
+    file. Errors are logged when writing starts failing, not on every write.
+*/
+static int write_snapshot(void)
+{
+    FILE *fp = fopen(f_tmp, "w");
+    int ok = fp != NULL;
+    if (ok)
+    {
+        print_metrics(fp);
+        ok = fclose(fp) == 0 && rename(f_tmp, f_metrics) == 0;
+        if (!ok)
+        {
+            unlink(f_tmp);
+        }
+    }
+    
+    if (!ok && !failing)
+    {
+        char msg[MAX_ERR_MSG_LEN];
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to write metrics file "
+                 "\"%.200s\".", f_metrics);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+    }
+    failing = !ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+static void *snapshot_worker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&stop_lock);
+    while (!stop)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += METRICS_INTERVAL_S;
+        while (!stop && pthread_cond_timedwait(&stop_cond, &stop_lock,
+                                               &deadline) != ETIMEDOUT)
+        {
+        }
+        if (!stop)
+        {
+            pthread_mutex_unlock(&stop_lock);
+            write_snapshot();
+            pthread_mutex_lock(&stop_lock);
+        }
+    }
+    pthread_mutex_unlock(&stop_lock);
+    return NULL;
+}
+
+
+/*
+    Stops the writer thread and writes the last snapshot. Runs at exit.
+*/
+static void metrics_close(void)
+{
+    pthread_mutex_lock(&stop_lock);
+    stop = 1;
+    pthread_cond_signal(&stop_cond);
+    pthread_mutex_unlock(&stop_lock);
+    pthread_join(writer, NULL);
+    pthread_cond_destroy(&stop_cond);
+    
+    write_snapshot();
+    acct_free(f_metrics);
+    acct_free(f_tmp);
+    f_metrics = NULL;
+    f_tmp = NULL;
+}
+
+
+int metrics_open(char *f_name)
+{
+    char *err = "Unable to allocate memory for metrics.";
+    size_t len = strlen(f_name);
+    f_metrics = acct_malloc(ALLOC_OTHER, len + 1);
+    f_tmp = acct_malloc(ALLOC_OTHER, len + sizeof(METRICS_TMP_SUFFIX));
+    if (f_metrics == NULL || f_tmp == NULL)
+    {
+        acct_free(f_metrics);
+        acct_free(f_tmp);
+        write_log(ERROR, err);
+        fprintf(stderr, "%s\n", err);
+        return EXIT_FAILURE;
+    }
+    strcpy(f_metrics, f_name);
+    strcpy(f_tmp, f_name);
+    strcat(f_tmp, METRICS_TMP_SUFFIX);
+    
+    // Deadlines of the writer do not jump with the wall clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&stop_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    
+    if (write_snapshot() == EXIT_FAILURE ||
+        pthread_create(&writer, NULL, snapshot_worker, NULL) != 0)
+    {
+        if (!failing)
+        {
+            err = "Unable to start metrics writer thread.";
+            write_log(ERROR, err);
+            fprintf(stderr, "%s\n", err);
+        }
+        pthread_cond_destroy(&stop_cond);
+        acct_free(f_metrics);
+        acct_free(f_tmp);
+        f_metrics = NULL;
+        f_tmp = NULL;
+        return EXIT_FAILURE;
+    }
+    atexit(metrics_close);
+    
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "Writing metrics to \"%.200s\" every %d "
+             "s.", f_name, METRICS_INTERVAL_S);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*
+File:         out_buf.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Output buffers, so formatted text can be produced on several
+              threads and written in order afterwards.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <alloc_acct.h>
+#include <out_buf.h>
+
+void out_buf_init(struct out_buf *ob)
+{
+    ob->data = NULL;
+    ob->len = 0;
+    ob->cap = 0;
+    ob->fp = NULL;
+    ob->err = 0;
+}
+
+
+/*
+    Makes room for extra bytes and the ending '\0'. Returns 0 on failure.
+*/
+static int reserve(struct out_buf *ob, size_t extra)
+{
+    if (ob->err)
+    {
+        return 0;
+    }
+    if (ob->len + extra + 1 <= ob->cap)
+    {
+        return 1;
+    }
+    size_t new_cap = ob->cap < OUT_BUF_MIN_ALLOC ? OUT_BUF_MIN_ALLOC : ob->cap;
+    while (new_cap < ob->len + extra + 1)
+    {
+        new_cap *= 2;
+    }
+    char *temp = acct_realloc(ALLOC_OTHER, ob->data, new_cap);
+    if (temp == NULL)
+    {
+        ob->err = 1;
+        return 0;
+    }
+    ob->data = temp;
+    ob->cap = new_cap;
+    return 1;
+}
+
+
+void buf_printf(struct out_buf *ob, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    if (ob->fp != NULL)
+    {
+        vfprintf(ob->fp, fmt, args);
+        va_end(args);
+        return;
+    }
+    
+    // Most lines fit in the space left, otherwise grow and format again
+    size_t space = ob->cap > ob->len ? ob->cap - ob->len : 0;
+    va_list retry;
+    va_copy(retry, args);
+    int len = vsnprintf(space ? ob->data + ob->len : NULL, space, fmt, args);
+    va_end(args);
+    if (len < 0)
+    {
+        va_end(retry);
+        return;
+    }
+    if ((size_t)len >= space)
+    {
+        if (!reserve(ob, (size_t)len))
+        {
+            va_end(retry);
+            return;
+        }
+        vsnprintf(ob->data + ob->len, (size_t)len + 1, fmt, retry);
+    }
+    va_end(retry);
+    ob->len += (size_t)len;
+}
+
+
+void buf_puts(struct out_buf *ob, const char *str)
+{
+    if (ob->fp != NULL)
+    {
+        fputs(str, ob->fp);
+        return;
+    }
+    size_t len = strlen(str);
+    if (reserve(ob, len))
+    {
+        memcpy(ob->data + ob->len, str, len);
+        ob->len += len;
+    }
+}
+
+
+void buf_putc(struct out_buf *ob, char c)
+{
+    if (ob->fp != NULL)
+    {
+        putc(c, ob->fp);
+        return;
+    }
+    if (reserve(ob, 1))
+    {
+        *(ob->data + ob->len) = c;
+        ob->len++;
+    }
+}
+
+
+void out_buf_flush(struct out_buf *ob, FILE *fp)
+{
+    if (ob->len > 0)
+    {
+        fwrite(ob->data, 1, ob->len, fp);
+    }
+    ob->len = 0;
+}
+
+
+void out_buf_free(struct out_buf *ob)
+{
+    acct_free(ob->data);
+    out_buf_init(ob);
+}
@@ -0,0 +1,249 @@
+/*
+File:         page_view.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Showing products with their quotes one page at a time. A page
+              is found and formatted without going through the whole catalog.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <out_buf.h>
+#include <report.h>
+#include <page_view.h>
+
+static int in_code_range(struct page_query *q, struct product_info *pi)
+{
+    if (q->code_from != NULL && strcmp(pi->p_code, q->code_from) < 0)
+    {
+        return 0;
+    }
+    if (q->code_to != NULL && strcmp(pi->p_code, q->code_to) > 0)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+
+/*
+    Returns the index of the first matching product at or after pos, or the
+    number of products if there is none.
+*/
+static size_t next_match(struct page_view *pv, size_t pos)
+{
+    while (pos < pv->pdw.lines &&
+           !in_code_range(&pv->query, pv->pdw.data + pos))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+
+static int add_page_start(struct page_view *pv, size_t pos)
+{
+    if (pv->start_cnt >= pv->alloc_limit)
+    {
+        int new_limit = pv->alloc_limit ? pv->alloc_limit * 2
+                                        : PAGE_STARTS_MIN_ALLOC;
+        size_t *temp = acct_realloc(ALLOC_OTHER, pv->starts, sizeof(size_t) *
+                                    (size_t)new_limit);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        pv->starts = temp;
+        pv->alloc_limit = new_limit;
+    }
+    *(pv->starts + pv->start_cnt) = pos;
+    pv->start_cnt++;
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Finds where page 0 starts by skipping offset matching products.
+*/
+static size_t find_first_start(struct page_view *pv)
+{
+    struct page_query *q = &pv->query;
+    if (q->code_from == NULL && q->code_to == NULL)
+    {
+        return (size_t)q->offset < pv->pdw.lines ? (size_t)q->offset
+                                                 : pv->pdw.lines;
+    }
+    size_t pos = next_match(pv, 0);
+    for (int skipped = 0; skipped < q->offset && pos < pv->pdw.lines; skipped++)
+    {
+        pos = next_match(pv, pos + 1);
+    }
+    return pos;
+}
+
+
+int print_page(struct page_view *pv, struct out_buf *ob, int page,
+               int *has_more)
+{
+    if (pv->start_cnt == 0 &&
+        add_page_start(pv, find_first_start(pv)) == EXIT_FAILURE)
+    {
+        return -1;
+    }
+    if (page >= pv->start_cnt)
+    {
+        *has_more = 0;
+        return 0;
+    }
+    
+    size_t pos = next_match(pv, *(pv->starts + page));
+    int cnt = 0;
+    while (cnt < pv->query.page_size && pos < pv->pdw.lines)
+    {
+        print_product_report(ob, pv->pdw, pv->qdw, pv->groups, pos);
+        cnt++;
+        pos = next_match(pv, pos + 1);
+    }
+    
+    // Start of the next page is known now, also if it is visited again
+    *has_more = pos < pv->pdw.lines;
+    if (page + 1 == pv->start_cnt && *has_more &&
+        add_page_start(pv, pos) == EXIT_FAILURE)
+    {
+        return -1;
+    }
+    return cnt;
+}
+
+
+static double elapsed_ms(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) * 1000.0 +
+           (double)(end.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+
+/*
+    Asks for an optional product code. Empty input means no limit. Returns
+    EXIT_FAILURE on memory allocation error.
+*/
+static int get_code_bound(char *prompt, char **bound)
+{
+    printf("%s (empty for no limit)\n> ", prompt);
+    *bound = get_dynamic_input_string(stdin);
+    if (*bound == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    if (**bound == '\0')
+    {
+        acct_free(*bound);
+        *bound = NULL;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static void free_page_view(struct page_view *pv)
+{
+    acct_free(pv->query.code_from);
+    acct_free(pv->query.code_to);
+    acct_free(pv->starts);
+}
+
+
+int browse_catalog_pages(struct product_data_wrapper pdw,
+                         struct quote_data_wrapper qdw,
+                         struct quote_groups *qg)
+{
+    struct page_view pv = {.pdw = pdw, .qdw = qdw, .groups = qg};
+    char msg[MAX_ERR_MSG_LEN];
+    
+    printf("Enter page size (products per page).\n");
+    pv.query.page_size = get_int_in_range(1, PAGE_SIZE_MAX);
+    printf("Enter number of products to skip before the first page.\n");
+    pv.query.offset = get_int_in_range(0, INT_MAX);
+    if (get_code_bound("Enter first product code", &pv.query.code_from) ==
+        EXIT_FAILURE ||
+        get_code_bound("Enter last product code", &pv.query.code_to) ==
+        EXIT_FAILURE)
+    {
+        free_page_view(&pv);
+        return EXIT_FAILURE;
+    }
+    
+    struct out_buf ob = OUT_BUF_FILE(stdout);
+    int page = 0;
+    int action = PAGE_OPT_NEXT;
+    while (action != PAGE_OPT_MENU)
+    {
+        struct timespec start;
+        int has_more;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int cnt = print_page(&pv, &ob, page, &has_more);
+        if (cnt < 0)
+        {
+            snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for "
+                     "showing page %d.", page + 1);
+            write_log(ERROR, msg);
+            fprintf(stderr, "%s\n", msg);
+            free_page_view(&pv);
+            return EXIT_FAILURE;
+        }
+        snprintf(msg, MAX_ERR_MSG_LEN, "Displayed page %d with %d product(s) "
+                 "in %.3f ms.", page + 1, cnt, elapsed_ms(&start));
+        write_log(INFO, msg);
+        
+        long long first = (long long)pv.query.offset +
+                          (long long)page * pv.query.page_size;
+        if (cnt == 0)
+        {
+            printf("No products on page %d.\n", page + 1);
+        }
+        else
+        {
+            printf("Page %d, products %lld-%lld%s\n", page + 1, first + 1,
+                   first + cnt, has_more ? "" : " (last page)");
+        }
+        
+        while (1)
+        {
+            printf("\n%d - Next page\n", PAGE_OPT_NEXT);
+            printf("%d - Previous page\n", PAGE_OPT_PREV);
+            printf("%d - Back to menu\n\n", PAGE_OPT_MENU);
+            action = get_int_in_range(PAGE_OPT_MENU, PAGE_OPT_CNT - 1);
+            putchar('\n');
+            if (action == PAGE_OPT_NEXT && !has_more)
+            {
+                printf("This is the last page.\n");
+            }
+            else if (action == PAGE_OPT_PREV && page == 0)
+            {
+                printf("This is the first page.\n");
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (action == PAGE_OPT_NEXT)
+        {
+            page++;
+        }
+        else if (action == PAGE_OPT_PREV)
+        {
+            page--;
+        }
+    }
+    free_page_view(&pv);
+    return EXIT_SUCCESS;
+}
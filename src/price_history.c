@@ -0,0 +1,620 @@
+/*
+File:         price_history.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Price and stock history of quotes over successive quote files
+              (snapshots). Changes between snapshots are stored as varints, so
+              history of a quote, that rarely changes, takes a few bytes per
+              snapshot.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <data_read_write.h>
+#include <dictionary.h>
+#include <price_history.h>
+
+static size_t encode_varint(unsigned char *buf, uint64_t val)
+{
+    size_t len = 0;
+    while (val >= 0x80)
+    {
+        *(buf + len++) = (unsigned char)(val | 0x80);
+        val >>= 7;
+    }
+    *(buf + len++) = (unsigned char)val;
+    return len;
+}
+
+
+static int decode_varint(const unsigned char **pos, const unsigned char *end,
+                         uint64_t *val)
+{
+    uint64_t result = 0;
+    int shift = 0;
+    while (*pos < end && shift < 64)
+    {
+        unsigned char byte = **pos;
+        (*pos)++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            *val = result;
+            return 1;
+        }
+        shift += 7;
+    }
+    return 0; // Data ended in the middle of a varint
+}
+
+
+static uint64_t zigzag_encode(int64_t val)
+{
+    return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+
+static int64_t zigzag_decode(uint64_t val)
+{
+    return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+
+void history_init(struct price_history *ph)
+{
+    memset(ph, 0, sizeof(struct price_history));
+}
+
+
+static int append_sample(struct history_entry *he, int snapshot, int64_t price,
+                         int stock)
+{
+    if (he->delta_len + 3 * VARINT_MAX_LEN > he->delta_cap)
+    {
+        size_t new_cap = he->delta_cap ? he->delta_cap * 2 :
+                                         HISTORY_DELTA_MIN_ALLOC;
+        unsigned char *temp = acct_realloc(ALLOC_HISTORY, he->deltas, new_cap);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        he->deltas = temp;
+        he->delta_cap = new_cap;
+    }
+    
+    unsigned char *pos = he->deltas + he->delta_len;
+    pos += encode_varint(pos, (uint64_t)(snapshot - he->last.snapshot));
+    pos += encode_varint(pos, zigzag_encode(price - he->last.price));
+    pos += encode_varint(pos, zigzag_encode((int64_t)stock - he->last.stock));
+    he->delta_len = (size_t)(pos - he->deltas);
+    
+    he->last.snapshot = snapshot;
+    he->last.price = price;
+    he->last.stock = stock;
+    he->samples++;
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Adds an empty entry for a quote and indexes it. Takes ownership of the
+    strings. Returns the index of the new entry or HASH_NOT_FOUND on error.
+*/
+static int64_t add_entry(struct price_history *ph, char *q_id, char *p_code)
+{
+    if (ph->entry_cnt >= ph->alloc_limit)
+    {
+        size_t new_limit = acct_grow_limit(ph->alloc_limit, HISTORY_MIN_ALLOC,
+                                           sizeof(struct history_entry));
+        struct history_entry *temp = new_limit == 0 ? NULL :
+                                     acct_realloc(ALLOC_HISTORY, ph->entries,
+                                                  sizeof(struct history_entry) *
+                                                  new_limit);
+        if (temp == NULL)
+        {
+            return HASH_NOT_FOUND;
+        }
+        ph->entries = temp;
+        ph->alloc_limit = new_limit;
+    }
+    
+    int64_t idx = (int64_t)ph->entry_cnt;
+    struct history_entry *he = ph->entries + idx;
+    memset(he, 0, sizeof(struct history_entry));
+    he->q_id = q_id;
+    he->p_code = p_code;
+    he->next_in_product = hash_index_get(&ph->by_product, p_code);
+    
+    if (hash_index_put(&ph->by_id, q_id, idx) != HASH_OK)
+    {
+        return HASH_NOT_FOUND;
+    }
+    if (hash_index_put(&ph->by_product, p_code, idx) != HASH_OK)
+    {
+        // The caller frees q_id, so the index must not keep it
+        hash_index_remove(&ph->by_id, q_id);
+        return HASH_NOT_FOUND;
+    }
+    ph->entry_cnt++;
+    return idx;
+}
+
+
+static int add_snapshot_time(struct price_history *ph, int64_t time_val)
+{
+    int64_t *temp = acct_realloc(ALLOC_HISTORY, ph->snapshot_times,
+                                 sizeof(int64_t) *
+                                 (size_t)(ph->snapshot_cnt + 1));
+    if (temp == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    ph->snapshot_times = temp;
+    *(ph->snapshot_times + ph->snapshot_cnt) = time_val;
+    ph->snapshot_cnt++;
+    return EXIT_SUCCESS;
+}
+
+
+int history_add_snapshot(struct price_history *ph, struct quote_data_wrapper qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    int snapshot = ph->snapshot_cnt;
+    if (add_snapshot_time(ph, (int64_t)time(NULL)) == EXIT_FAILURE)
+    {
+        write_log(ERROR, "Unable to allocate memory for a history snapshot.");
+        fprintf(stderr, "Unable to allocate memory for a history snapshot.\n");
+        return EXIT_FAILURE;
+    }
+    
+    size_t new_entries = 0;
+    for (size_t i = 0; i < qdw.lines; i++)
+    {
+        struct quote_info *qi = qdw.data + i;
+        int64_t idx = hash_index_get(&ph->by_id, qi->p_id);
+        if (idx == HASH_NOT_FOUND)
+        {
+            char *q_id = dynamic_string(qi->p_id, ALLOC_HISTORY);
+            char *p_code = dynamic_string(dict_string(DICT_CODE, qi->code_id),
+                                          ALLOC_HISTORY);
+            idx = HASH_NOT_FOUND;
+            if (q_id != NULL && p_code != NULL)
+            {
+                idx = add_entry(ph, q_id, p_code);
+            }
+            if (idx == HASH_NOT_FOUND)
+            {
+                acct_free(q_id);
+                acct_free(p_code);
+                write_log(ERROR, "Unable to allocate memory for history entry.");
+                fprintf(stderr, "Unable to allocate memory for history entry.\n");
+                return EXIT_FAILURE;
+            }
+            new_entries++;
+        }
+        else if ((ph->entries + idx)->samples > 0 &&
+                 (ph->entries + idx)->last.snapshot == snapshot)
+        {
+            continue; // Same ID twice in one snapshot
+        }
+        
+        if (append_sample(ph->entries + idx, snapshot, qi->price,
+                          qi->stock) == EXIT_FAILURE)
+        {
+            write_log(ERROR, "Unable to allocate memory for history sample.");
+            fprintf(stderr, "Unable to allocate memory for history sample.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    
+    snprintf(msg, MAX_ERR_MSG_LEN, "Added price history snapshot %d with %zu "
+             "quote(s), %zu new.", snapshot + 1, qdw.lines, new_entries);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
+
+
+void history_cursor_init(struct history_cursor *cur, struct history_entry *he)
+{
+    cur->pos = he->deltas;
+    cur->end = he->deltas + he->delta_len;
+    cur->sample.snapshot = 0;
+    cur->sample.price = 0;
+    cur->sample.stock = 0;
+}
+
+
+int history_cursor_next(struct history_cursor *cur)
+{
+    uint64_t gap, d_price, d_stock;
+    if (cur->pos >= cur->end ||
+        !decode_varint(&cur->pos, cur->end, &gap) ||
+        !decode_varint(&cur->pos, cur->end, &d_price) ||
+        !decode_varint(&cur->pos, cur->end, &d_stock))
+    {
+        return 0;
+    }
+    cur->sample.snapshot += (int)gap;
+    cur->sample.price += zigzag_decode(d_price);
+    cur->sample.stock += (int)zigzag_decode(d_stock);
+    return 1;
+}
+
+
+static int write_varint(FILE *fp, uint64_t val)
+{
+    unsigned char buf[VARINT_MAX_LEN];
+    size_t len = encode_varint(buf, val);
+    return fwrite(buf, 1, len, fp) == len;
+}
+
+
+static int write_bytes(FILE *fp, const void *data, size_t len)
+{
+    return write_varint(fp, len) && fwrite(data, 1, len, fp) == len;
+}
+
+
+int save_price_history(char *f_name, struct price_history *ph)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    char *tmp_name = acct_malloc(ALLOC_OTHER, strlen(f_name) +
+                                 sizeof(HISTORY_TMP_SUFFIX));
+    if (tmp_name == NULL)
+    {
+        write_log(ERROR, "Unable to allocate memory for price history file "
+                  "name.");
+        fprintf(stderr, "Unable to allocate memory for price history file "
+                "name.\n");
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    strcpy(tmp_name, f_name);
+    strcat(tmp_name, HISTORY_TMP_SUFFIX);
+    
+    FILE *p_file = open_file(tmp_name, "wb");
+    if (p_file == NULL)
+    {
+        acct_free(tmp_name);
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    
+    int ok = fwrite(HISTORY_MAGIC, 1, HISTORY_MAGIC_LEN, p_file) ==
+             HISTORY_MAGIC_LEN;
+    ok = ok && write_varint(p_file, (uint64_t)ph->snapshot_cnt);
+    int64_t prev_time = 0;
+    for (int i = 0; ok && i < ph->snapshot_cnt; i++)
+    {
+        ok = write_varint(p_file, zigzag_encode(*(ph->snapshot_times + i) -
+                                                prev_time));
+        prev_time = *(ph->snapshot_times + i);
+    }
+    ok = ok && write_varint(p_file, (uint64_t)ph->entry_cnt);
+    for (size_t i = 0; ok && i < ph->entry_cnt; i++)
+    {
+        struct history_entry *he = ph->entries + i;
+        ok = write_bytes(p_file, he->q_id, strlen(he->q_id)) &&
+             write_bytes(p_file, he->p_code, strlen(he->p_code)) &&
+             write_varint(p_file, (uint64_t)he->samples) &&
+             write_bytes(p_file, he->deltas, he->delta_len);
+    }
+    
+    if (fclose(p_file) != 0 || !ok || rename(tmp_name, f_name) != 0)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to write price history file "
+                 "\"%s\".", f_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        remove(tmp_name);
+        acct_free(tmp_name);
+        return CSV_WRITE_FOPEN_ERR;
+    }
+    acct_free(tmp_name);
+    
+    snprintf(msg, MAX_ERR_MSG_LEN, "Saved price history with %d snapshot(s) "
+             "and %zu quote(s) to \"%s\".", ph->snapshot_cnt, ph->entry_cnt,
+             f_name);
+    write_log(INFO, msg);
+    return CSV_WRITE_OK;
+}
+
+
+static char *read_string(const unsigned char **pos, const unsigned char *end)
+{
+    uint64_t len;
+    if (!decode_varint(pos, end, &len) || len > (uint64_t)(end - *pos))
+    {
+        return NULL;
+    }
+    char *str = acct_malloc(ALLOC_HISTORY, (size_t)len + 1);
+    if (str == NULL)
+    {
+        return NULL;
+    }
+    memcpy(str, *pos, (size_t)len);
+    *(str + len) = '\0';
+    *pos += len;
+    return str;
+}
+
+
+static int parse_history(const unsigned char *pos, const unsigned char *end,
+                         struct price_history *ph)
+{
+    uint64_t cnt, val;
+    if (end - pos < HISTORY_MAGIC_LEN ||
+        memcmp(pos, HISTORY_MAGIC, HISTORY_MAGIC_LEN) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    pos += HISTORY_MAGIC_LEN;
+    
+    if (!decode_varint(&pos, end, &cnt) || cnt > INT_MAX)
+    {
+        return EXIT_FAILURE;
+    }
+    int64_t prev_time = 0;
+    for (uint64_t i = 0; i < cnt; i++)
+    {
+        if (!decode_varint(&pos, end, &val) ||
+            add_snapshot_time(ph, prev_time + zigzag_decode(val)) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        prev_time = *(ph->snapshot_times + ph->snapshot_cnt - 1);
+    }
+    
+    if (!decode_varint(&pos, end, &cnt))
+    {
+        return EXIT_FAILURE;
+    }
+    for (uint64_t i = 0; i < cnt; i++)
+    {
+        char *q_id = read_string(&pos, end);
+        char *p_code = read_string(&pos, end);
+        int64_t idx = HASH_NOT_FOUND;
+        if (q_id != NULL && p_code != NULL)
+        {
+            idx = add_entry(ph, q_id, p_code);
+        }
+        if (idx == HASH_NOT_FOUND)
+        {
+            acct_free(q_id);
+            acct_free(p_code);
+            return EXIT_FAILURE;
+        }
+        
+        struct history_entry *he = ph->entries + idx;
+        uint64_t samples, len;
+        if (!decode_varint(&pos, end, &samples) || samples > INT_MAX ||
+            !decode_varint(&pos, end, &len) || len > (uint64_t)(end - pos))
+        {
+            return EXIT_FAILURE;
+        }
+        he->deltas = acct_malloc(ALLOC_HISTORY, len ? (size_t)len : 1);
+        if (he->deltas == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        memcpy(he->deltas, pos, (size_t)len);
+        he->delta_len = (size_t)len;
+        he->delta_cap = (size_t)len;
+        pos += len;
+        
+        // Decoding restores the last sample and checks the data
+        struct history_cursor cur;
+        history_cursor_init(&cur, he);
+        while (history_cursor_next(&cur))
+        {
+            he->samples++;
+        }
+        if (he->samples != (int)samples || cur.pos != cur.end ||
+            cur.sample.snapshot >= ph->snapshot_cnt)
+        {
+            return EXIT_FAILURE;
+        }
+        he->last = cur.sample;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int load_price_history(char *f_name, struct price_history *ph)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    FILE *p_file = fopen(f_name, "rb");
+    if (p_file == NULL)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "No price history file \"%s\", starting "
+                 "a new history.", f_name);
+        write_log(INFO, msg);
+        return EXIT_SUCCESS;
+    }
+    
+    unsigned char *data = NULL;
+    long size = -1;
+    if (fseek(p_file, 0, SEEK_END) == 0)
+    {
+        size = ftell(p_file);
+        rewind(p_file);
+    }
+    if (size >= 0)
+    {
+        data = acct_malloc(ALLOC_HISTORY, (size_t)size + 1);
+    }
+    int return_val = EXIT_FAILURE;
+    if (data != NULL && fread(data, 1, (size_t)size, p_file) == (size_t)size)
+    {
+        return_val = parse_history(data, data + size, ph);
+    }
+    acct_free(data);
+    fclose(p_file);
+    
+    if (return_val == EXIT_FAILURE)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Price history file \"%s\" is damaged or "
+                 "could not be read.", f_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    snprintf(msg, MAX_ERR_MSG_LEN, "Read price history with %d snapshot(s) and "
+             "%zu quote(s).", ph->snapshot_cnt, ph->entry_cnt);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
+
+
+static void format_snapshot_time(struct price_history *ph, int snapshot,
+                                 char *str)
+{
+    time_t snap_time = (time_t)*(ph->snapshot_times + snapshot);
+    strftime(str, MAX_TIME_STR_LEN, "%Y.%m.%d %T", localtime(&snap_time));
+}
+
+
+int show_quote_price_trend(struct price_history *ph)
+{
+    printf("Enter quote ID to show its price history.\n> ");
+    char *search_str = get_dynamic_input_string(stdin);
+    if (search_str == NULL)
+    {
+        return SRCH_RES_INPUT_ERR;
+    }
+    
+    char msg[STR_MAX];
+    int64_t idx = hash_index_get(&ph->by_id, search_str);
+    if (idx == HASH_NOT_FOUND)
+    {
+        snprintf(msg, STR_MAX, "Price history for quote with id: %s, returned "
+                 "no results.", search_str);
+        write_log(INFO, msg);
+        printf("%s Search is case sensitive!\n\n", msg);
+        acct_free(search_str);
+        return SRCH_RES_NEG;
+    }
+    
+    struct history_entry *he = ph->entries + idx;
+    char s_time[MAX_TIME_STR_LEN];
+    printf("\nPrice history of quote %s (product %s), %d of %d snapshot(s):\n",
+           he->q_id, he->p_code, he->samples, ph->snapshot_cnt);
+    printf("\t%8s | %-19s | %12s | %13s | %s\n", "Snapshot", "Date", "Price",
+           "Change", "Stock");
+           
+    struct history_cursor cur;
+    history_cursor_init(&cur, he);
+    int64_t prev_price = 0;
+    int first = 1;
+    while (history_cursor_next(&cur))
+    {
+        format_snapshot_time(ph, cur.sample.snapshot, s_time);
+        printf("\t%8d | %-19s | %8.2f EUR | ", cur.sample.snapshot + 1, s_time,
+               CNTS_TO_EUR((double)cur.sample.price));
+        if (first)
+        {
+            printf("%13s", "");
+        }
+        else
+        {
+            printf("%+9.2f EUR", CNTS_TO_EUR((double)(cur.sample.price -
+                                                      prev_price)));
+        }
+        printf(" | %d\n", cur.sample.stock);
+        prev_price = cur.sample.price;
+        first = 0;
+    }
+    putchar('\n');
+    
+    snprintf(msg, STR_MAX, "Displayed price history of quote %s.", search_str);
+    write_log(INFO, msg);
+    acct_free(search_str);
+    return SRCH_RES_POS;
+}
+
+
+int show_lowest_recent_price(struct price_history *ph)
+{
+    printf("Enter product code to find its lowest recent price.\n> ");
+    char *search_str = get_dynamic_input_string(stdin);
+    if (search_str == NULL)
+    {
+        return SRCH_RES_INPUT_ERR;
+    }
+    printf("\nEnter number of latest snapshots to search.\n");
+    int snapshots = get_int_in_range(1, INT_MAX);
+    
+    char msg[STR_MAX];
+    int first_snapshot = ph->snapshot_cnt - snapshots;
+    struct history_entry *best = NULL;
+    struct history_sample best_sample = {0};
+    
+    // Only entries of this product are visited
+    int64_t idx = hash_index_get(&ph->by_product, search_str);
+    while (idx != HASH_NOT_FOUND)
+    {
+        struct history_entry *he = ph->entries + idx;
+        if (he->last.snapshot >= first_snapshot)
+        {
+            struct history_cursor cur;
+            history_cursor_init(&cur, he);
+            while (history_cursor_next(&cur))
+            {
+                if (cur.sample.snapshot >= first_snapshot &&
+                    (best == NULL || cur.sample.price < best_sample.price))
+                {
+                    best = he;
+                    best_sample = cur.sample;
+                }
+            }
+        }
+        idx = he->next_in_product;
+    }
+    
+    if (best == NULL)
+    {
+        snprintf(msg, STR_MAX, "No price history for product code %s in the "
+                 "last %d snapshot(s).", search_str, snapshots);
+        write_log(INFO, msg);
+        printf("%s Search is case sensitive!\n\n", msg);
+        acct_free(search_str);
+        return SRCH_RES_NEG;
+    }
+    
+    char s_time[MAX_TIME_STR_LEN];
+    format_snapshot_time(ph, best_sample.snapshot, s_time);
+    printf("\nLowest price for %s in the last %d snapshot(s):\n", search_str,
+           snapshots);
+    printf("\t%12s: %.2f\n", "Price", CNTS_TO_EUR((double)best_sample.price));
+    printf("\t%12s: %s\n", "Quote ID", best->q_id);
+    printf("\t%12s: %d (%s)\n", "Snapshot", best_sample.snapshot + 1, s_time);
+    printf("\t%12s: %d\n", "Stock", best_sample.stock);
+    putchar('\n');
+    
+    snprintf(msg, STR_MAX, "Displayed lowest price of product %s in the last "
+             "%d snapshot(s).", search_str, snapshots);
+    write_log(INFO, msg);
+    acct_free(search_str);
+    return SRCH_RES_POS;
+}
+
+
+void free_price_history(struct price_history *ph)
+{
+    for (size_t i = 0; i < ph->entry_cnt; i++)
+    {
+        acct_free((ph->entries + i)->q_id);
+        acct_free((ph->entries + i)->p_code);
+        acct_free((ph->entries + i)->deltas);
+    }
+    acct_free(ph->entries);
+    acct_free(ph->snapshot_times);
+    hash_index_free(&ph->by_id);
+    hash_index_free(&ph->by_product);
+    history_init(ph);
+}
@@ -0,0 +1,348 @@
+/*
+File:         product_bulk_edit.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Editing many products at once from a file of product codes and
+              new field values.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <csv_helper.h>
+#include <hash_index.h>
+#include <main.h>
+#include <data_stream.h>
+#include <data_read_write.h>
+#include <record_schema.h>
+#include <catalog.h>
+#include <watch_rules.h>
+#include <metrics.h>
+#include <product_bulk_edit.h>
+
+int build_product_code_index(struct product_data_wrapper *pdw)
+{
+    hash_index_free(&pdw->code_index);
+    if (hash_index_init(&pdw->code_index, pdw->lines) != HASH_OK)
+    {
+        write_log(ERROR, "Unable to allocate memory for product code index.");
+        fprintf(stderr, "Unable to allocate memory for product code index.\n");
+        return EXIT_FAILURE;
+    }
+    
+    for (size_t i = 0; i < pdw->lines; i++)
+    {
+        char *p_code = (pdw->data + i)->p_code;
+        if (p_code == NULL ||
+            hash_index_get(&pdw->code_index, p_code) != HASH_NOT_FOUND)
+        {
+            continue; // First product with the same code stays indexed
+        }
+        if (hash_index_put(&pdw->code_index, p_code, (int64_t)i) != HASH_OK)
+        {
+            write_log(ERROR, "Unable to allocate memory for product code index.");
+            fprintf(stderr, "Unable to allocate memory for product code index.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int64_t find_product_by_code(struct product_data_wrapper pdw, char *p_code)
+{
+    return hash_index_get(&pdw.code_index, p_code);
+}
+
+
+static void print_bulk_edit_error(char *f_name, size_t line, char *field_name,
+                                  char *value)
+{
+    char err_msg[MAX_ERR_MSG_LEN];
+    snprintf(err_msg, MAX_ERR_MSG_LEN, "Product %s \"%s\" at line: %zu in file "
+             "\"%s\" is not valid. Row will not be applied.", field_name, value,
+             line, f_name);
+    write_log(ERROR, err_msg);
+    fprintf(stderr, "%s\n", err_msg);
+}
+
+
+// Product column of every bulk edit field, in bulk edit field order
+static const int edit_columns[CSV_EDIT_FIELD_CNT] =
+{
+    PRO_COL_CODE, PRO_COL_RAM, PRO_COL_SCRN, PRO_COL_NAME, PRO_COL_OS
+};
+
+/*
+    Maps bulk edit fields to the fields of a header row by column name, -1 for
+    a column the header does not have. Unknown columns are skipped. Returns 0
+    if the line is not a header and field_map is unchanged, 1 if it is a header
+    and -1 if it is a header without the code column.
+*/
+static int map_edit_header(char **fields, int field_cnt, int *field_map)
+{
+    int header_map[CSV_EDIT_FIELD_CNT];
+    int is_header = 0;
+    for (int i = 0; i < CSV_EDIT_FIELD_CNT; i++)
+    {
+        *(header_map + i) = -1;
+    }
+    for (int j = 0; j < field_cnt; j++)
+    {
+        int col = find_column(&product_schema, *(fields + j));
+        for (int i = 0; col >= 0 && i < CSV_EDIT_FIELD_CNT; i++)
+        {
+            if (*(edit_columns + i) == col && *(header_map + i) < 0)
+            {
+                *(header_map + i) = j;
+            }
+        }
+        is_header = is_header || col >= 0;
+    }
+    if (!is_header)
+    {
+        return 0;
+    }
+    memcpy(field_map, header_map, sizeof(header_map));
+    return *(field_map + CSV_EDIT_FIELD_CODE - 1) < 0 ? -1 : 1;
+}
+
+
+/*
+    Gets an optional field of a split bulk edit row through the field map. NULL
+    if the field is empty or missing.
+*/
+static char *get_edit_field(char **fields, int field_cnt, const int *field_map,
+                            int field_num)
+{
+    int idx = *(field_map + field_num - 1);
+    if (idx < 0 || idx >= field_cnt || **(fields + idx) == '\0')
+    {
+        return NULL;
+    }
+    return *(fields + idx);
+}
+
+
+/*
+    Replaces a product string field, if the new value differs. The old string
+    is retired, readers of an older catalog version may still use it. Returns
+    1 if the field was changed, 0 if not and -1 on memory allocation error.
+*/
+static int replace_string(char **p_str, char *new_str)
+{
+    if (new_str == NULL || strcmp(*p_str, new_str) == 0)
+    {
+        return 0;
+    }
+    char *temp = dynamic_string(new_str, ALLOC_PRODUCT_STR);
+    if (temp == NULL)
+    {
+        return -1;
+    }
+    catalog_retire(*p_str);
+    *p_str = temp;
+    return 1;
+}
+
+
+/*
+    Applies one row. Values are checked before anything is changed, so an
+    invalid row leaves the product as it was.
+*/
+static int apply_edit_row(char *f_name, size_t line, char **fields,
+                          int field_cnt, const int *field_map,
+                          struct product_data_wrapper *pdw,
+                          struct bulk_edit_summary *summary)
+{
+    char *p_field = get_edit_field(fields, field_cnt, field_map,
+                                   CSV_EDIT_FIELD_CODE);
+    int64_t idx = p_field == NULL ? HASH_NOT_FOUND
+                                  : find_product_by_code(*pdw, p_field);
+    if (idx == HASH_NOT_FOUND)
+    {
+        summary->not_found++;
+        return EXIT_SUCCESS;
+    }
+    struct product_info *pi = pdw->data + idx;
+    
+    int ram = pi->ram;
+    p_field = get_edit_field(fields, field_cnt, field_map, CSV_EDIT_FIELD_RAM);
+    if (p_field != NULL && (sscanf(p_field, "%d", &ram) != 1 || ram < 0))
+    {
+        print_bulk_edit_error(f_name, line, "RAM", p_field);
+        summary->invalid++;
+        return EXIT_SUCCESS;
+    }
+    
+    float screen_size = pi->screen_size;
+    p_field = get_edit_field(fields, field_cnt, field_map,
+                             CSV_EDIT_FIELD_SCRN);
+    if (p_field != NULL &&
+        (sscanf(p_field, "%f", &screen_size) != 1 || screen_size < 0.0f))
+    {
+        print_bulk_edit_error(f_name, line, "screen size", p_field);
+        summary->invalid++;
+        return EXIT_SUCCESS;
+    }
+    
+    size_t changed = (size_t)((ram != pi->ram) +
+                              (screen_size != pi->screen_size));
+    pi->ram = ram;
+    pi->screen_size = screen_size;
+    
+    int return_val = replace_string(&pi->p_name,
+                                    get_edit_field(fields, field_cnt,
+                                                   field_map,
+                                                   CSV_EDIT_FIELD_NAME));
+    // Watch rules by the new name may match the quotes of the product now
+    if (return_val < 0 ||
+        (return_val > 0 && watch_mark_code(pi->code_id) == EXIT_FAILURE))
+    {
+        return EXIT_FAILURE;
+    }
+    changed += (size_t)return_val;
+    
+    return_val = replace_string(&pi->p_os,
+                                get_edit_field(fields, field_cnt, field_map,
+                                               CSV_EDIT_FIELD_OS));
+    if (return_val < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    changed += (size_t)return_val;
+    
+    if (changed)
+    {
+        summary->edited++;
+        metrics_add(MET_EDITS, 1);
+        summary->fields += changed;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int apply_product_bulk_edit(char *f_name, struct product_data_wrapper *pdw,
+                            struct bulk_edit_summary *summary)
+{
+    char *line_buffer;
+    memset(summary, 0, sizeof(struct bulk_edit_summary));
+    
+    FILE *p_file = open_data_file(f_name);
+    if (p_file == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    // Without a header row fields are in bulk edit field order
+    char *fields[CSV_FIELDS_MAX];
+    int field_map[CSV_EDIT_FIELD_CNT];
+    for (int i = 0; i < CSV_EDIT_FIELD_CNT; i++)
+    {
+        *(field_map + i) = i;
+    }
+    size_t line = 0;
+    int return_val;
+    while (1)
+    {
+        return_val = read_line(p_file, &line_buffer);
+        if (return_val == EOF)
+        {
+            break;
+        }
+        else if (return_val == CSV_MALLOC_ERR || return_val == CSV_READ_ERR)
+        {
+            close_data_file(p_file);
+            return EXIT_FAILURE;
+        }
+        line++;
+        
+        // Every row is split once, fields are used from the split
+        int field_cnt = split_fields(line_buffer, fields, CSV_FIELDS_MAX);
+        int header = line == 1 ? map_edit_header(fields, field_cnt, field_map)
+                               : 0;
+        if (header < 0)
+        {
+            char err_msg[MAX_ERR_MSG_LEN];
+            snprintf(err_msg, MAX_ERR_MSG_LEN, "Header row of bulk edit file "
+                     "\"%s\" has no code column. File will not be applied.",
+                     f_name);
+            write_log(ERROR, err_msg);
+            fprintf(stderr, "%s\n", err_msg);
+            close_data_file(p_file);
+            free_buffer_manually();
+            return EXIT_FAILURE;
+        }
+        if (header > 0)
+        {
+            write_log(INFO, "Read bulk edit columns from header row.");
+            continue;
+        }
+        summary->rows++;
+        
+        if (apply_edit_row(f_name, line, fields, field_cnt, field_map, pdw,
+                           summary) == EXIT_FAILURE)
+        {
+            print_read_error(READ_ERR_STR_MALLOC, f_name, line);
+            close_data_file(p_file);
+            free_buffer_manually();
+            return EXIT_FAILURE;
+        }
+    }
+    if (close_data_file(p_file) != STREAM_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+void print_bulk_edit_summary(char *f_name, struct bulk_edit_summary summary)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "Bulk edit from \"%s\": %zu row(s), %zu "
+             "product(s) changed (%zu field(s)), %zu unknown product code(s), "
+             "%zu invalid row(s).", f_name, summary.rows, summary.edited,
+             summary.fields, summary.not_found, summary.invalid);
+    write_log(INFO, msg);
+    printf("%s\n", msg);
+}
+
+
+int apply_product_bulk_edit_prompt(struct product_data_wrapper *pdw,
+                                   char *f_pro)
+{
+    printf("Enter name of product bulk edit file.\n> ");
+    
+    char *f_name = get_dynamic_input_string(stdin);
+    if (f_name == NULL)
+    {
+        return EDIT_MALLOC;
+    }
+    
+    struct bulk_edit_summary summary;
+    if (apply_product_bulk_edit(f_name, pdw, &summary) == EXIT_FAILURE)
+    {
+        printf("Bulk edit file was not fully applied.\n");
+    }
+    putchar('\n');
+    print_bulk_edit_summary(f_name, summary);
+    acct_free(f_name);
+    
+    if (summary.edited == 0)
+    {
+        putchar('\n');
+        return EDIT_NO_MATCH;
+    }
+    
+    // All rows are saved with one write of the products file
+    if (!save_product_file_changes(f_pro, *pdw))
+    {
+        fprintf(stderr, "Changes made will not be saved.\n");
+    }
+    putchar('\n');
+    return EDIT_OK;
+}
@@ -0,0 +1,1254 @@
+/*
+File:         query_exec.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Running parsed queries over the product and quote arrays. Rows
+              are processed in batches: every filter is a tight loop over the
+              row numbers left by the filters before it (a selection vector),
+              so there is no per-row interpreting of the query. Product filters
+              are applied to products once, before quotes are scanned and
+              joined with them.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <dictionary.h>
+#include <hash_index.h>
+#include <out_buf.h>
+#include <query.h>
+#include <metrics.h>
+
+/*
+    Value of a field or an aggregate of one result row.
+*/
+struct query_value
+{
+    int is_str;
+    double num;
+    const char *str;
+};
+
+/*
+    How groups are found: by dictionary ID (or a single group without GROUP
+    BY), through a hash index of text keys, or by sorting the rows by a
+    numeric key.
+*/
+enum group_modes {GROUP_DENSE, GROUP_HASH, GROUP_SORT};
+
+/*
+    Sort key of a result row, extracted once before sorting.
+*/
+struct sort_entry
+{
+    size_t entry;
+    double num;
+    const char *str;
+};
+
+/*
+    State of one query run. Result rows are either rows of the scanned table
+    (with their joined product) or groups of them.
+*/
+struct query_ctx
+{
+    struct query *q;
+    struct product_data_wrapper pdw;
+    struct quote_data_wrapper qdw;
+    int scan_quotes;                // Quotes are the scanned table
+    int64_t *join_map;              // Product of every code ID or -1
+    uint32_t code_cnt;
+    
+    // Cheap filters (numbers, dictionary IDs) run before string filters
+    struct query_pred *scan_preds[QUERY_PREDS_MAX];
+    int scan_pred_cnt;
+    int scan_cheap_cnt;
+    struct query_pred *product_preds[QUERY_PREDS_MAX];
+    int product_pred_cnt;
+    int product_cheap_cnt;
+    
+    int64_t *rows;
+    int64_t *products;              // Joined product of every row or -1
+    size_t row_cnt;
+    size_t row_cap;
+    
+    int grouped;
+    enum group_modes group_mode;
+    struct hash_index group_index;  // Text key to group, GROUP_HASH only
+    size_t group_cnt;
+    size_t group_cap;
+    int64_t *counts;
+    double *acc;                    // item_cnt values per group
+    int64_t *group_rows;            // First row of every group
+    int64_t *group_products;
+    
+    size_t entry_cnt;               // Result rows or groups
+    size_t *order;                  // Printing order of entries
+};
+
+static double elapsed_ms(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) * 1000.0 +
+           (double)(end.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+
+static int is_cheap(struct query_pred *pred)
+{
+    enum query_types type = query_fields[pred->field].type;
+    if (type == QT_STR)
+    {
+        return 0;
+    }
+    return type != QT_DICT || pred->op == QOP_EQ || pred->op == QOP_NE;
+}
+
+
+/*
+    Adds a filter to a list, cheap filters before the others.
+*/
+static void add_pred(struct query_pred **list, int *cnt, int *cheap_cnt,
+                     struct query_pred *pred)
+{
+    if (!is_cheap(pred))
+    {
+        *(list + (*cnt)++) = pred;
+        return;
+    }
+    memmove(list + *cheap_cnt + 1, list + *cheap_cnt,
+            (size_t)(*cnt - *cheap_cnt) * sizeof(struct query_pred *));
+    *(list + (*cheap_cnt)++) = pred;
+    (*cnt)++;
+}
+
+
+/*
+    Splits filters between products and the scanned table and finds the
+    dictionary IDs of compared values.
+*/
+static void plan_filters(struct query_ctx *c)
+{
+    struct query *q = c->q;
+    for (int i = 0; i < q->pred_cnt; i++)
+    {
+        struct query_pred *pred = q->preds + i;
+        if (query_fields[pred->field].type == QT_DICT)
+        {
+            pred->dict_id = dict_find(pred->field == QF_CODE ? DICT_CODE
+                                                             : DICT_RETAILER,
+                                      pred->str);
+        }
+        // Code is compared on quotes, they have it as a dictionary ID too
+        if (q->join && query_fields[pred->field].table == QUERY_PRODUCTS &&
+            pred->field != QF_CODE)
+        {
+            add_pred(c->product_preds, &c->product_pred_cnt,
+                     &c->product_cheap_cnt, pred);
+        }
+        else if (c->scan_quotes)
+        {
+            add_pred(c->scan_preds, &c->scan_pred_cnt, &c->scan_cheap_cnt,
+                     pred);
+        }
+        else
+        {
+            add_pred(c->product_preds, &c->product_pred_cnt,
+                     &c->product_cheap_cnt, pred);
+        }
+    }
+}
+
+
+// Keeps the rows of sel, for which cond (using row number r) is true
+#define FILTER_LOOP(cond)                                                     \
+    for (int k = 0; k < n; k++)                                               \
+    {                                                                         \
+        int64_t r = *(sel + k);                                               \
+        *(sel + kept) = r;                                                    \
+        kept += (cond) ? 1 : 0;                                               \
+    }
+
+#define FILTER_CMP(value, x)                                                  \
+    switch (pred->op)                                                         \
+    {                                                                         \
+        case QOP_EQ: FILTER_LOOP((value) == (x)); break;                      \
+        case QOP_NE: FILTER_LOOP((value) != (x)); break;                      \
+        case QOP_LT: FILTER_LOOP((value) < (x)); break;                       \
+        case QOP_LE: FILTER_LOOP((value) <= (x)); break;                      \
+        case QOP_GT: FILTER_LOOP((value) > (x)); break;                       \
+        case QOP_GE: FILTER_LOOP((value) >= (x)); break;                      \
+        default: break;                                                       \
+    }
+
+#define FILTER_STR(text)                                                      \
+    if (pred->op == QOP_CONTAINS)                                             \
+    {                                                                         \
+        FILTER_LOOP(strcasestr(text, pred->str) != NULL);                     \
+    }                                                                         \
+    else                                                                      \
+    {                                                                         \
+        FILTER_CMP(strcmp(text, pred->str), 0);                               \
+    }
+
+#define FILTER_DICT(dict, id)                                                 \
+    if (pred->op == QOP_EQ || pred->op == QOP_NE)                             \
+    {                                                                         \
+        FILTER_CMP(id, pred->dict_id);                                        \
+    }                                                                         \
+    else                                                                      \
+    {                                                                         \
+        FILTER_STR(dict_string(dict, id));                                    \
+    }
+
+/*
+    Filters a batch of quote rows. Returns the number of rows left.
+*/
+static int filter_quotes(struct query_pred *pred, struct quote_info *data,
+                         int64_t *sel, int n)
+{
+    int kept = 0;
+    switch (pred->field)
+    {
+        case QF_CODE:
+            FILTER_DICT(DICT_CODE, (data + r)->code_id);
+            break;
+        case QF_ID:
+            FILTER_STR((data + r)->p_id);
+            break;
+        case QF_RETAILER:
+            FILTER_DICT(DICT_RETAILER, (data + r)->retailer_id);
+            break;
+        case QF_PRICE:
+            FILTER_CMP((double)(data + r)->price, pred->num);
+            break;
+        case QF_STOCK:
+            FILTER_CMP((double)(data + r)->stock, pred->num);
+            break;
+        default:
+            kept = n;
+            break;
+    }
+    return kept;
+}
+
+
+/*
+    Filters a batch of product rows. Returns the number of rows left.
+*/
+static int filter_products(struct query_pred *pred, struct product_info *data,
+                           int64_t *sel, int n)
+{
+    int kept = 0;
+    switch (pred->field)
+    {
+        case QF_CODE:
+            FILTER_DICT(DICT_CODE, (data + r)->code_id);
+            break;
+        case QF_NAME:
+            FILTER_STR((data + r)->p_name);
+            break;
+        case QF_OS:
+            FILTER_STR((data + r)->p_os);
+            break;
+        case QF_RAM:
+            FILTER_CMP((double)(data + r)->ram, pred->num);
+            break;
+        case QF_SCREEN:
+            FILTER_CMP((double)(data + r)->screen_size, pred->num);
+            break;
+        default:
+            kept = n;
+            break;
+    }
+    return kept;
+}
+
+
+static int filter_product_batch(struct query_ctx *c, int64_t *sel, int n)
+{
+    for (int i = 0; i < c->product_pred_cnt && n > 0; i++)
+    {
+        n = filter_products(*(c->product_preds + i), c->pdw.data, sel, n);
+    }
+    return n;
+}
+
+
+/*
+    Maps every product code ID to the first product with the code, that
+    passes the product filters. Filters are so applied to every product once
+    instead of to every quote.
+*/
+static int build_join_map(struct query_ctx *c)
+{
+    c->code_cnt = dict_size(DICT_CODE, NULL);
+    c->join_map = acct_malloc(ALLOC_OTHER, ((size_t)c->code_cnt + 1) *
+                              sizeof(int64_t));
+    int64_t *first = acct_malloc(ALLOC_OTHER, ((size_t)c->code_cnt + 1) *
+                                 sizeof(int64_t));
+    if (c->join_map == NULL || first == NULL)
+    {
+        acct_free(first);
+        return QUERY_MALLOC_ERR;
+    }
+    for (uint32_t i = 0; i < c->code_cnt; i++)
+    {
+        *(c->join_map + i) = -1;
+        *(first + i) = -1;
+    }
+    for (int64_t i = (int64_t)c->pdw.lines - 1; i >= 0; i--)
+    {
+        uint32_t id = (c->pdw.data + i)->code_id;
+        if (id < c->code_cnt)
+        {
+            *(first + id) = i;
+        }
+    }
+    
+    int64_t sel[QUERY_BATCH];
+    int64_t total = (int64_t)c->pdw.lines;
+    for (int64_t start = 0; start < total; start += QUERY_BATCH)
+    {
+        int n = 0;
+        int64_t end = total - start < QUERY_BATCH ? total
+                                                  : start + QUERY_BATCH;
+        for (int64_t r = start; r < end; r++)
+        {
+            uint32_t id = (c->pdw.data + r)->code_id;
+            *(sel + n) = r;
+            n += id < c->code_cnt && *(first + id) == r;
+        }
+        n = filter_product_batch(c, sel, n);
+        for (int k = 0; k < n; k++)
+        {
+            *(c->join_map + (c->pdw.data + *(sel + k))->code_id) = *(sel + k);
+        }
+    }
+    acct_free(first);
+    return QUERY_OK;
+}
+
+
+/*
+    Joins a batch of quotes with their products. Quotes without a product
+    are dropped.
+*/
+static int probe_join(struct query_ctx *c, int64_t *sel, int64_t *prod, int n)
+{
+    int kept = 0;
+    for (int k = 0; k < n; k++)
+    {
+        int64_t r = *(sel + k);
+        uint32_t id = (c->qdw.data + r)->code_id;
+        int64_t p = id < c->code_cnt ? *(c->join_map + id) : -1;
+        *(sel + kept) = r;
+        *(prod + kept) = p;
+        kept += p >= 0;
+    }
+    return kept;
+}
+
+
+static int add_rows(struct query_ctx *c, int64_t *sel, int64_t *prod, int n)
+{
+    if (c->row_cnt + (size_t)n > c->row_cap)
+    {
+        size_t new_cap = acct_grow_limit(c->row_cap, QUERY_ROWS_MIN_ALLOC,
+                                         sizeof(int64_t));
+        if (new_cap == 0)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+        int64_t *rows = acct_realloc(ALLOC_OTHER, c->rows,
+                                     new_cap * sizeof(int64_t));
+        if (rows == NULL)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+        c->rows = rows;
+        int64_t *products = acct_realloc(ALLOC_OTHER, c->products,
+                                         new_cap * sizeof(int64_t));
+        if (products == NULL)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+        c->products = products;
+        c->row_cap = new_cap;
+    }
+    memcpy(c->rows + c->row_cnt, sel, (size_t)n * sizeof(int64_t));
+    memcpy(c->products + c->row_cnt, prod, (size_t)n * sizeof(int64_t));
+    c->row_cnt += (size_t)n;
+    return QUERY_OK;
+}
+
+
+/*
+    Values of a numeric field for a batch of rows.
+*/
+static void gather_values(struct query_ctx *c, enum query_fields field,
+                          const int64_t *rows, const int64_t *prod, int n,
+                          double *vals)
+{
+    switch (field)
+    {
+        case QF_RAM:
+            for (int k = 0; k < n; k++)
+            {
+                *(vals + k) = (double)(c->pdw.data + *(prod + k))->ram;
+            }
+            break;
+        case QF_SCREEN:
+            for (int k = 0; k < n; k++)
+            {
+                *(vals + k) = (double)(c->pdw.data + *(prod + k))->screen_size;
+            }
+            break;
+        case QF_PRICE:
+            for (int k = 0; k < n; k++)
+            {
+                *(vals + k) = (double)(c->qdw.data + *(rows + k))->price;
+            }
+            break;
+        case QF_STOCK:
+            for (int k = 0; k < n; k++)
+            {
+                *(vals + k) = (double)(c->qdw.data + *(rows + k))->stock;
+            }
+            break;
+        default:
+            memset(vals, 0, (size_t)n * sizeof(double));
+            break;
+    }
+}
+
+
+/*
+    Adds a batch of rows to their groups.
+*/
+static void accumulate(struct query_ctx *c, const int64_t *rows,
+                       const int64_t *prod, const size_t *groups, int n)
+{
+    struct query *q = c->q;
+    size_t stride = (size_t)q->item_cnt;
+    double vals[QUERY_BATCH];
+    for (int i = 0; i < q->item_cnt; i++)
+    {
+        struct query_item *item = q->items + i;
+        if (item->agg == QAGG_NONE || item->agg == QAGG_COUNT)
+        {
+            continue;
+        }
+        gather_values(c, item->field, rows, prod, n, vals);
+        double *acc = c->acc + i;
+        for (int k = 0; k < n; k++)
+        {
+            double *a = acc + *(groups + k) * stride;
+            double v = *(vals + k);
+            if (item->agg == QAGG_MIN)
+            {
+                *a = v < *a ? v : *a;
+            }
+            else if (item->agg == QAGG_MAX)
+            {
+                *a = v > *a ? v : *a;
+            }
+            else
+            {
+                *a += v;
+            }
+        }
+    }
+    for (int k = 0; k < n; k++)
+    {
+        size_t g = *(groups + k);
+        if (*(c->counts + g) == 0)
+        {
+            *(c->group_rows + g) = *(rows + k);
+            *(c->group_products + g) = *(prod + k);
+        }
+        (*(c->counts + g))++;
+    }
+}
+
+
+/*
+    Makes room for cnt groups. New groups are empty.
+*/
+static int grow_groups(struct query_ctx *c, size_t cnt)
+{
+    size_t stride = (size_t)c->q->item_cnt;
+    size_t old = c->group_cap;
+    if (cnt <= old)
+    {
+        return QUERY_OK;
+    }
+    int64_t *counts = acct_realloc(ALLOC_OTHER, c->counts,
+                                   cnt * sizeof(int64_t));
+    if (counts == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    c->counts = counts;
+    double *acc = acct_realloc(ALLOC_OTHER, c->acc,
+                               cnt * stride * sizeof(double) + 1);
+    if (acc == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    c->acc = acc;
+    int64_t *group_rows = acct_realloc(ALLOC_OTHER, c->group_rows,
+                                       cnt * sizeof(int64_t));
+    if (group_rows == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    c->group_rows = group_rows;
+    int64_t *group_products = acct_realloc(ALLOC_OTHER, c->group_products,
+                                           cnt * sizeof(int64_t));
+    if (group_products == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    c->group_products = group_products;
+    c->group_cap = cnt;
+    
+    memset(c->counts + old, 0, (cnt - old) * sizeof(int64_t));
+    for (int i = 0; i < c->q->item_cnt; i++)
+    {
+        enum query_aggs agg = (c->q->items + i)->agg;
+        double init = agg == QAGG_MIN ? INFINITY :
+                      agg == QAGG_MAX ? -INFINITY : 0.0;
+        for (size_t g = old; g < cnt; g++)
+        {
+            *(c->acc + g * stride + (size_t)i) = init;
+        }
+    }
+    return QUERY_OK;
+}
+
+
+static enum group_modes group_mode(struct query *q)
+{
+    if (q->group_by < 0 || query_fields[q->group_by].type == QT_DICT)
+    {
+        return GROUP_DENSE;
+    }
+    return query_fields[q->group_by].type == QT_STR ? GROUP_HASH : GROUP_SORT;
+}
+
+
+static struct query_value field_value(struct query_ctx *c,
+                                      enum query_fields field, int64_t row,
+                                      int64_t product);
+
+static void dense_keys(struct query_ctx *c, const int64_t *rows,
+                       const int64_t *prod, int n, size_t *groups)
+{
+    for (int k = 0; k < n; k++)
+    {
+        if (c->q->group_by == QF_RETAILER)
+        {
+            *(groups + k) = (c->qdw.data + *(rows + k))->retailer_id;
+        }
+        else if (c->q->group_by == QF_CODE)
+        {
+            *(groups + k) = c->scan_quotes
+                            ? (c->qdw.data + *(rows + k))->code_id
+                            : (c->pdw.data + *(prod + k))->code_id;
+        }
+        else
+        {
+            *(groups + k) = 0;
+        }
+    }
+}
+
+
+/*
+    Finds the groups of text keys, new keys get the next group.
+*/
+static int hash_keys(struct query_ctx *c, const int64_t *rows,
+                     const int64_t *prod, int n, size_t *groups)
+{
+    enum query_fields field = (enum query_fields)c->q->group_by;
+    for (int k = 0; k < n; k++)
+    {
+        char *key = (char *)field_value(c, field, *(rows + k),
+                                        *(prod + k)).str;
+        int64_t g = hash_index_get(&c->group_index, key);
+        if (g == HASH_NOT_FOUND)
+        {
+            g = (int64_t)c->group_cnt;
+            if ((c->group_cnt == c->group_cap &&
+                 grow_groups(c, c->group_cap * 2) != QUERY_OK) ||
+                hash_index_put(&c->group_index, key, g) != HASH_OK)
+            {
+                return QUERY_MALLOC_ERR;
+            }
+            c->group_cnt++;
+        }
+        *(groups + k) = (size_t)g;
+    }
+    return QUERY_OK;
+}
+
+
+/*
+    Scans the table in batches. Rows passing the filters are either kept as
+    result rows or added to their groups.
+*/
+static int scan_table(struct query_ctx *c)
+{
+    struct query *q = c->q;
+    int accumulating = c->grouped && c->group_mode != GROUP_SORT;
+    int64_t sel[QUERY_BATCH];
+    int64_t prod[QUERY_BATCH];
+    size_t groups[QUERY_BATCH];
+    int64_t total = (int64_t)(c->scan_quotes ? c->qdw.lines : c->pdw.lines);
+    // Without sorting or grouping the scan stops at the limit
+    int early_stop = !c->grouped && !q->order_set && q->limit >= 0;
+    
+    for (int64_t start = 0; start < total; start += QUERY_BATCH)
+    {
+        int n = total - start < QUERY_BATCH ? (int)(total - start)
+                                            : QUERY_BATCH;
+        for (int k = 0; k < n; k++)
+        {
+            *(sel + k) = start + k;
+        }
+        if (c->scan_quotes)
+        {
+            int i = 0;
+            for (; i < c->scan_cheap_cnt && n > 0; i++)
+            {
+                n = filter_quotes(*(c->scan_preds + i), c->qdw.data, sel, n);
+            }
+            if (q->join)
+            {
+                n = probe_join(c, sel, prod, n);
+            }
+            for (; i < c->scan_pred_cnt && n > 0; i++)
+            {
+                n = filter_quotes(*(c->scan_preds + i), c->qdw.data, sel, n);
+            }
+            if (!q->join)
+            {
+                for (int k = 0; k < n; k++)
+                {
+                    *(prod + k) = -1;
+                }
+            }
+        }
+        else
+        {
+            n = filter_product_batch(c, sel, n);
+            memcpy(prod, sel, (size_t)n * sizeof(int64_t));
+        }
+        if (n == 0)
+        {
+            continue;
+        }
+        
+        if (accumulating)
+        {
+            if (c->group_mode == GROUP_DENSE)
+            {
+                dense_keys(c, sel, prod, n, groups);
+            }
+            else if (hash_keys(c, sel, prod, n, groups) != QUERY_OK)
+            {
+                return QUERY_MALLOC_ERR;
+            }
+            accumulate(c, sel, prod, groups, n);
+            continue;
+        }
+        if (early_stop && c->row_cnt + (size_t)n > (size_t)q->limit)
+        {
+            n = (int)((size_t)q->limit - c->row_cnt);
+        }
+        if (add_rows(c, sel, prod, n) != QUERY_OK)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+        if (early_stop && c->row_cnt >= (size_t)q->limit)
+        {
+            break;
+        }
+    }
+    return QUERY_OK;
+}
+
+
+static struct query_value field_value(struct query_ctx *c,
+                                      enum query_fields field, int64_t row,
+                                      int64_t product)
+{
+    struct query_value v = {0, 0.0, NULL};
+    struct quote_info *qi = c->scan_quotes ? c->qdw.data + row : NULL;
+    struct product_info *pi = product >= 0 ? c->pdw.data + product : NULL;
+    switch (field)
+    {
+        case QF_CODE:
+            v.str = qi != NULL ? dict_string(DICT_CODE, qi->code_id)
+                               : pi->p_code;
+            break;
+        case QF_NAME:
+            v.str = pi->p_name;
+            break;
+        case QF_OS:
+            v.str = pi->p_os;
+            break;
+        case QF_RAM:
+            v.num = (double)pi->ram;
+            break;
+        case QF_SCREEN:
+            v.num = (double)pi->screen_size;
+            break;
+        case QF_ID:
+            v.str = qi->p_id;
+            break;
+        case QF_RETAILER:
+            v.str = dict_string(DICT_RETAILER, qi->retailer_id);
+            break;
+        case QF_PRICE:
+            v.num = (double)qi->price;
+            break;
+        case QF_STOCK:
+            v.num = (double)qi->stock;
+            break;
+        default:
+            break;
+    }
+    v.is_str = v.str != NULL;
+    return v;
+}
+
+
+/*
+    Value of an item for a result entry (a row or a group).
+*/
+static struct query_value entry_value(struct query_ctx *c, size_t e,
+                                      struct query_item *item, int item_idx)
+{
+    if (!c->grouped)
+    {
+        return field_value(c, item->field, *(c->rows + e),
+                           *(c->products + e));
+    }
+    if (item->agg == QAGG_NONE)
+    {
+        return field_value(c, item->field, *(c->group_rows + e),
+                           *(c->group_products + e));
+    }
+    struct query_value v = {0, 0.0, NULL};
+    int64_t cnt = *(c->counts + e);
+    if (item->agg == QAGG_COUNT)
+    {
+        v.num = (double)cnt;
+        return v;
+    }
+    v.num = *(c->acc + e * (size_t)c->q->item_cnt + (size_t)item_idx);
+    if (item->agg == QAGG_AVG && cnt > 0)
+    {
+        v.num /= (double)cnt;
+    }
+    return v;
+}
+
+
+static int compare_entries(struct sort_entry *a, struct sort_entry *b,
+                           int is_str, int desc)
+{
+    int res;
+    if (is_str)
+    {
+        res = strcmp(a->str, b->str);
+    }
+    else
+    {
+        res = (a->num > b->num) - (a->num < b->num);
+    }
+    return desc ? -res : res;
+}
+
+
+/*
+    Stable merge sort, equal entries keep the order they were found in.
+*/
+static void merge_sort(struct sort_entry *arr, struct sort_entry *tmp,
+                       size_t cnt, int is_str, int desc)
+{
+    for (size_t width = 1; width < cnt; width *= 2)
+    {
+        for (size_t lo = 0; lo < cnt; lo += 2 * width)
+        {
+            size_t mid = lo + width < cnt ? lo + width : cnt;
+            size_t hi = lo + 2 * width < cnt ? lo + 2 * width : cnt;
+            size_t i = lo;
+            size_t j = mid;
+            size_t k = lo;
+            while (i < mid && j < hi)
+            {
+                if (compare_entries(arr + j, arr + i, is_str, desc) < 0)
+                {
+                    *(tmp + k++) = *(arr + j++);
+                }
+                else
+                {
+                    *(tmp + k++) = *(arr + i++);
+                }
+            }
+            while (i < mid)
+            {
+                *(tmp + k++) = *(arr + i++);
+            }
+            while (j < hi)
+            {
+                *(tmp + k++) = *(arr + j++);
+            }
+        }
+        memcpy(arr, tmp, cnt * sizeof(struct sort_entry));
+    }
+}
+
+
+/*
+    Sorts entries by an item into c->order.
+*/
+static int sort_entries(struct query_ctx *c, struct query_item *item,
+                        int item_idx, int desc)
+{
+    size_t cnt = c->entry_cnt;
+    struct sort_entry *arr = acct_malloc(ALLOC_OTHER, (cnt + 1) *
+                                         sizeof(struct sort_entry));
+    struct sort_entry *tmp = acct_malloc(ALLOC_OTHER, (cnt + 1) *
+                                         sizeof(struct sort_entry));
+    if (arr == NULL || tmp == NULL)
+    {
+        acct_free(arr);
+        acct_free(tmp);
+        return QUERY_MALLOC_ERR;
+    }
+    int is_str = 0;
+    for (size_t i = 0; i < cnt; i++)
+    {
+        size_t e = *(c->order + i);
+        struct query_value v = entry_value(c, e, item, item_idx);
+        (arr + i)->entry = e;
+        (arr + i)->num = v.num;
+        (arr + i)->str = v.str;
+        is_str = v.is_str;
+    }
+    merge_sort(arr, tmp, cnt, is_str, desc);
+    for (size_t i = 0; i < cnt; i++)
+    {
+        *(c->order + i) = (arr + i)->entry;
+    }
+    acct_free(arr);
+    acct_free(tmp);
+    return QUERY_OK;
+}
+
+
+static int init_order(struct query_ctx *c, size_t cnt)
+{
+    c->entry_cnt = cnt;
+    c->order = acct_malloc(ALLOC_OTHER, (cnt + 1) * sizeof(size_t));
+    if (c->order == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    for (size_t i = 0; i < cnt; i++)
+    {
+        *(c->order + i) = i;
+    }
+    return QUERY_OK;
+}
+
+
+/*
+    Forms groups of other fields by sorting the matching rows by the field
+    and accumulating runs of equal values.
+*/
+static int sorted_groups(struct query_ctx *c)
+{
+    struct query_item key = {QAGG_NONE, (enum query_fields)c->q->group_by, 0};
+    c->grouped = 0;
+    if (init_order(c, c->row_cnt) != QUERY_OK ||
+        sort_entries(c, &key, -1, 0) != QUERY_OK)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    
+    // Groups are numbered in key order
+    size_t group_cnt = 0;
+    struct query_value prev = {0, 0.0, NULL};
+    size_t *group_of = acct_malloc(ALLOC_OTHER, (c->row_cnt + 1) *
+                                   sizeof(size_t));
+    if (group_of == NULL)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    for (size_t i = 0; i < c->row_cnt; i++)
+    {
+        size_t e = *(c->order + i);
+        struct query_value v = entry_value(c, e, &key, -1);
+        if (i == 0 || (v.is_str ? strcmp(v.str, prev.str) != 0
+                                : v.num != prev.num))
+        {
+            group_cnt++;
+        }
+        *(group_of + i) = group_cnt - 1;
+        prev = v;
+    }
+    if (grow_groups(c, group_cnt) != QUERY_OK)
+    {
+        acct_free(group_of);
+        return QUERY_MALLOC_ERR;
+    }
+    c->group_cnt = group_cnt;
+    
+    int64_t rows[QUERY_BATCH];
+    int64_t prod[QUERY_BATCH];
+    for (size_t start = 0; start < c->row_cnt; start += QUERY_BATCH)
+    {
+        int n = c->row_cnt - start < QUERY_BATCH ? (int)(c->row_cnt - start)
+                                                 : QUERY_BATCH;
+        for (int k = 0; k < n; k++)
+        {
+            size_t e = *(c->order + start + (size_t)k);
+            *(rows + k) = *(c->rows + e);
+            *(prod + k) = *(c->products + e);
+        }
+        accumulate(c, rows, prod, group_of + start, n);
+    }
+    acct_free(group_of);
+    acct_free(c->order);
+    c->order = NULL;
+    c->grouped = 1;
+    return init_order(c, group_cnt);
+}
+
+
+/*
+    Lists the groups, that have rows. Without GROUP BY there is always one
+    group, also for no rows.
+*/
+static int list_groups(struct query_ctx *c)
+{
+    if (init_order(c, c->group_cnt) != QUERY_OK)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    if (c->q->group_by < 0 || c->group_mode != GROUP_DENSE)
+    {
+        return QUERY_OK;
+    }
+    size_t cnt = 0;
+    for (size_t g = 0; g < c->group_cnt; g++)
+    {
+        if (*(c->counts + g) > 0)
+        {
+            *(c->order + cnt++) = g;
+        }
+    }
+    c->entry_cnt = cnt;
+    return QUERY_OK;
+}
+
+
+static void item_header(struct query_item *item, char *str, size_t len)
+{
+    static const char *const agg_names[] = {"", "count", "sum", "min", "max",
+                                            "avg"};
+    if (item->agg == QAGG_NONE)
+    {
+        snprintf(str, len, "%s", query_fields[item->field].name);
+    }
+    else
+    {
+        snprintf(str, len, "%s(%s)", agg_names[item->agg],
+                 item->star ? "*" : query_fields[item->field].name);
+    }
+}
+
+
+/*
+    Formats a value. Prices are shown in euros, averages with decimals.
+*/
+static void format_cell(struct query_ctx *c, size_t e, struct query_item *item,
+                        int item_idx, char *cell)
+{
+    struct query_value v = entry_value(c, e, item, item_idx);
+    enum query_types type = query_fields[item->field].type;
+    if (v.is_str)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%s", v.str);
+    }
+    else if (item->agg == QAGG_COUNT)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%.0f", v.num);
+    }
+    else if (item->agg != QAGG_NONE && *(c->counts + e) == 0)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "-");
+    }
+    else if (type == QT_PRICE)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%.2f", v.num / 100.0);
+    }
+    else if (item->agg == QAGG_AVG)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%.2f", v.num);
+    }
+    else if (type == QT_FLOAT)
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%.1f", v.num);
+    }
+    else
+    {
+        snprintf(cell, QUERY_CELL_LEN, "%.0f", v.num);
+    }
+}
+
+
+static int is_text_column(struct query_item *item)
+{
+    enum query_types type = query_fields[item->field].type;
+    return item->agg == QAGG_NONE && (type == QT_STR || type == QT_DICT);
+}
+
+
+/*
+    Prints the result table. Column widths are found in a first pass over
+    the printed rows.
+*/
+static void print_result(struct query_ctx *c, struct out_buf *ob, size_t cnt)
+{
+    struct query *q = c->q;
+    int widths[QUERY_ITEMS_MAX];
+    char cell[QUERY_CELL_LEN];
+    for (int i = 0; i < q->item_cnt; i++)
+    {
+        item_header(q->items + i, cell, QUERY_CELL_LEN);
+        *(widths + i) = (int)strlen(cell);
+    }
+    for (size_t r = 0; r < cnt; r++)
+    {
+        for (int i = 0; i < q->item_cnt; i++)
+        {
+            format_cell(c, *(c->order + r), q->items + i, i, cell);
+            int len = (int)strlen(cell);
+            *(widths + i) = len > *(widths + i) ? len : *(widths + i);
+        }
+    }
+    
+    for (int i = 0; i < q->item_cnt; i++)
+    {
+        item_header(q->items + i, cell, QUERY_CELL_LEN);
+        buf_printf(ob, is_text_column(q->items + i) ? "%s%-*s" : "%s%*s",
+                   i ? " | " : "", *(widths + i), cell);
+    }
+    buf_putc(ob, '\n');
+    for (size_t r = 0; r < cnt; r++)
+    {
+        for (int i = 0; i < q->item_cnt; i++)
+        {
+            format_cell(c, *(c->order + r), q->items + i, i, cell);
+            buf_printf(ob, is_text_column(q->items + i) ? "%s%-*s" : "%s%*s",
+                       i ? " | " : "", *(widths + i), cell);
+        }
+        buf_putc(ob, '\n');
+    }
+}
+
+
+static void free_ctx(struct query_ctx *c)
+{
+    acct_free(c->join_map);
+    acct_free(c->rows);
+    acct_free(c->products);
+    acct_free(c->counts);
+    acct_free(c->acc);
+    acct_free(c->group_rows);
+    acct_free(c->group_products);
+    acct_free(c->order);
+    hash_index_free(&c->group_index);
+}
+
+
+/*
+    Runs the query up to the ordered result entries.
+*/
+static int execute_ctx(struct query_ctx *c)
+{
+    struct query *q = c->q;
+    plan_filters(c);
+    if (q->join && build_join_map(c) != QUERY_OK)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    if (c->grouped && c->group_mode == GROUP_DENSE)
+    {
+        size_t cnt = 1;
+        if (q->group_by >= 0)
+        {
+            cnt = dict_size(q->group_by == QF_CODE ? DICT_CODE : DICT_RETAILER,
+                            NULL);
+        }
+        if (grow_groups(c, cnt + 1) != QUERY_OK)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+        c->group_cnt = cnt;
+    }
+    else if (c->grouped && c->group_mode == GROUP_HASH &&
+             (hash_index_init(&c->group_index, QUERY_GROUPS_MIN_ALLOC) !=
+              HASH_OK ||
+              grow_groups(c, QUERY_GROUPS_MIN_ALLOC) != QUERY_OK))
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    if (scan_table(c) != QUERY_OK)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    
+    if (c->grouped)
+    {
+        int res = c->group_mode == GROUP_SORT ? sorted_groups(c)
+                                              : list_groups(c);
+        if (res != QUERY_OK)
+        {
+            return QUERY_MALLOC_ERR;
+        }
+    }
+    else if (init_order(c, c->row_cnt) != QUERY_OK)
+    {
+        return QUERY_MALLOC_ERR;
+    }
+    
+    // Groups are listed by their key unless ordered otherwise
+    if (q->order_set)
+    {
+        int item_idx = -1;
+        for (int i = 0; i < q->item_cnt && c->grouped; i++)
+        {
+            if ((q->items + i)->agg == q->order.agg &&
+                (q->items + i)->star == q->order.star &&
+                (q->order.star || (q->items + i)->field == q->order.field))
+            {
+                item_idx = i;
+                break;
+            }
+        }
+        return sort_entries(c, &q->order, item_idx, q->order_desc);
+    }
+    if (c->grouped && q->group_by >= 0 && c->group_mode != GROUP_SORT)
+    {
+        struct query_item key = {QAGG_NONE, (enum query_fields)q->group_by, 0};
+        return sort_entries(c, &key, -1, 0);
+    }
+    return QUERY_OK;
+}
+
+
+int query_execute(struct query *q, struct product_data_wrapper pdw,
+                  struct quote_data_wrapper qdw, struct out_buf *ob,
+                  size_t *row_cnt)
+{
+    struct query_ctx c;
+    memset(&c, 0, sizeof(struct query_ctx));
+    c.q = q;
+    c.pdw = pdw;
+    c.qdw = qdw;
+    c.scan_quotes = q->from == QUERY_QUOTES;
+    c.grouped = q->has_aggs || q->group_by >= 0;
+    c.group_mode = group_mode(q);
+    
+    if (execute_ctx(&c) != QUERY_OK)
+    {
+        free_ctx(&c);
+        return QUERY_MALLOC_ERR;
+    }
+    size_t cnt = c.entry_cnt;
+    if (q->limit >= 0 && cnt > (size_t)q->limit)
+    {
+        cnt = (size_t)q->limit;
+    }
+    print_result(&c, ob, cnt);
+    *row_cnt = cnt;
+    free_ctx(&c);
+    return QUERY_OK;
+}
+
+
+int run_query(struct product_data_wrapper pdw, struct quote_data_wrapper qdw,
+              const char *text)
+{
+    char err[QUERY_ERR_LEN];
+    char msg[MAX_LOG_MSG_STR_LEN];
+    struct query q;
+    if (query_parse(text, &q, err, QUERY_ERR_LEN) != QUERY_OK)
+    {
+        write_log(WARNING, err);
+        fprintf(stderr, "%s\n", err);
+        return QUERY_SYNTAX_ERR;
+    }
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct out_buf ob;
+    out_buf_init(&ob);
+    size_t row_cnt = 0;
+    if (query_execute(&q, pdw, qdw, &ob, &row_cnt) != QUERY_OK || ob.err)
+    {
+        out_buf_free(&ob);
+        snprintf(msg, MAX_LOG_MSG_STR_LEN, "Unable to allocate memory for "
+                 "query \"%.100s\".", text);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return QUERY_MALLOC_ERR;
+    }
+    out_buf_flush(&ob, stdout);
+    out_buf_free(&ob);
+    printf("%zu row(s).\n", row_cnt);
+    metrics_add(MET_QUERIES, 1);
+    metrics_add(MET_QUERY_ROWS, row_cnt);
+    
+    snprintf(msg, MAX_LOG_MSG_STR_LEN, "Query \"%.100s\" returned %zu row(s) "
+             "in %.3f ms.", text, row_cnt, elapsed_ms(&start));
+    write_log(INFO, msg);
+    return QUERY_OK;
+}
+
+
+int run_query_prompt(struct product_data_wrapper pdw,
+                     struct quote_data_wrapper qdw)
+{
+    printf("Enter query, for example:\n"
+           "SELECT name, retailer, price FROM quotes JOIN products "
+           "WHERE os = Android ORDER BY price LIMIT 5\n> ");
+    char *text = get_dynamic_input_string(stdin);
+    if (text == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    int return_val = QUERY_OK;
+    if (*text != '\0')
+    {
+        putchar('\n');
+        return_val = run_query(pdw, qdw, text);
+    }
+    acct_free(text);
+    return return_val == QUERY_MALLOC_ERR ? EXIT_FAILURE : EXIT_SUCCESS;
+}
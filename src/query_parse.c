@@ -0,0 +1,693 @@
+/*
+File:         query_parse.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Parsing queries over products and quotes. See query_parse in
+              query.h for the syntax.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <math.h>
+#include <main.h>
+#include <query.h>
+
+const struct query_field_desc query_fields[QF_CNT] =
+{
+    [QF_CODE] = {"code", QUERY_PRODUCTS, QT_DICT},
+    [QF_NAME] = {"name", QUERY_PRODUCTS, QT_STR},
+    [QF_OS] = {"os", QUERY_PRODUCTS, QT_STR},
+    [QF_RAM] = {"ram", QUERY_PRODUCTS, QT_INT},
+    [QF_SCREEN] = {"screen", QUERY_PRODUCTS, QT_FLOAT},
+    [QF_ID] = {"id", QUERY_QUOTES, QT_STR},
+    [QF_RETAILER] = {"retailer", QUERY_QUOTES, QT_DICT},
+    [QF_PRICE] = {"price", QUERY_QUOTES, QT_PRICE},
+    [QF_STOCK] = {"stock", QUERY_QUOTES, QT_INT}
+};
+
+static const char *const agg_names[] = {"", "count", "sum", "min", "max",
+                                        "avg"};
+
+// Fields selected by *, in this order
+static const enum query_fields product_star[] = {QF_CODE, QF_NAME, QF_OS,
+                                                 QF_RAM, QF_SCREEN};
+static const enum query_fields quote_star[] = {QF_ID, QF_CODE, QF_RETAILER,
+                                               QF_PRICE, QF_STOCK};
+static const enum query_fields join_star[] = {QF_CODE, QF_NAME, QF_OS, QF_RAM,
+                                              QF_SCREEN, QF_ID, QF_RETAILER,
+                                              QF_PRICE, QF_STOCK};
+
+enum token_types {TOK_END, TOK_WORD, TOK_STRING, TOK_COMMA, TOK_LPAREN,
+                  TOK_RPAREN, TOK_STAR, TOK_OP};
+
+struct token
+{
+    enum token_types type;
+    const char *start;
+    size_t len;
+    enum query_ops op;
+};
+
+struct parser
+{
+    const char *text;
+    const char *pos;
+    struct token tok;
+    char *err;
+    size_t err_len;
+};
+
+#define QUERY_SPECIAL_CHARS ",()*=!<>~'\""
+
+/*
+    Stores a syntax error with the column of the current token, if there is
+    one.
+*/
+static int syntax_error(struct parser *p, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static int syntax_error(struct parser *p, const char *fmt, ...)
+{
+    char detail[QUERY_ERR_LEN];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(detail, QUERY_ERR_LEN, fmt, args);
+    va_end(args);
+    if (p->tok.start == NULL)
+    {
+        snprintf(p->err, p->err_len, "Query error: %s", detail);
+    }
+    else
+    {
+        snprintf(p->err, p->err_len, "Query error at column %d: %s",
+                 (int)(p->tok.start - p->text) + 1, detail);
+    }
+    return QUERY_SYNTAX_ERR;
+}
+
+
+static int read_operator(struct parser *p)
+{
+    const char *s = p->pos;
+    p->tok.type = TOK_OP;
+    p->tok.len = 1;
+    if (*s == '=')
+    {
+        p->tok.op = QOP_EQ;
+    }
+    else if (*s == '~')
+    {
+        p->tok.op = QOP_CONTAINS;
+    }
+    else if (*s == '!' && *(s + 1) == '=')
+    {
+        p->tok.op = QOP_NE;
+        p->tok.len = 2;
+    }
+    else if (*s == '<')
+    {
+        p->tok.op = *(s + 1) == '=' ? QOP_LE : *(s + 1) == '>' ? QOP_NE
+                                                                : QOP_LT;
+        p->tok.len = *(s + 1) == '=' || *(s + 1) == '>' ? 2 : 1;
+    }
+    else if (*s == '>')
+    {
+        p->tok.op = *(s + 1) == '=' ? QOP_GE : QOP_GT;
+        p->tok.len = *(s + 1) == '=' ? 2 : 1;
+    }
+    else
+    {
+        return syntax_error(p, "unknown operator \"%c\".", *s);
+    }
+    return QUERY_OK;
+}
+
+
+/*
+    Moves to the next token. Quoted strings exclude the quotes.
+*/
+static int next_token(struct parser *p)
+{
+    while (*p->pos == ' ' || *p->pos == '\t' || *p->pos == '\n' ||
+           *p->pos == '\r')
+    {
+        p->pos++;
+    }
+    const char *s = p->pos;
+    p->tok.start = s;
+    p->tok.len = 1;
+    switch (*s)
+    {
+        case '\0':
+            p->tok.type = TOK_END;
+            p->tok.len = 0;
+            return QUERY_OK;
+        case ',':
+            p->tok.type = TOK_COMMA;
+            break;
+        case '(':
+            p->tok.type = TOK_LPAREN;
+            break;
+        case ')':
+            p->tok.type = TOK_RPAREN;
+            break;
+        case '*':
+            p->tok.type = TOK_STAR;
+            break;
+        case '\'':
+        case '"':
+        {
+            const char *end = strchr(s + 1, *s);
+            if (end == NULL)
+            {
+                return syntax_error(p, "string is not closed.");
+            }
+            p->tok.type = TOK_STRING;
+            p->tok.start = s + 1;
+            p->tok.len = (size_t)(end - s - 1);
+            p->pos = end + 1;
+            return QUERY_OK;
+        }
+        default:
+            if (strchr("=!<>~", *s) != NULL)
+            {
+                if (read_operator(p) != QUERY_OK)
+                {
+                    return QUERY_SYNTAX_ERR;
+                }
+                break;
+            }
+            p->tok.type = TOK_WORD;
+            p->tok.len = strcspn(s, " \t\r\n" QUERY_SPECIAL_CHARS);
+            break;
+    }
+    p->pos = s + p->tok.len;
+    return QUERY_OK;
+}
+
+
+static int is_word(struct parser *p, const char *word)
+{
+    return p->tok.type == TOK_WORD && p->tok.len == strlen(word) &&
+           strncasecmp(p->tok.start, word, p->tok.len) == 0;
+}
+
+
+/*
+    Checks for a keyword and moves past it.
+*/
+static int accept_word(struct parser *p, const char *word, int *found)
+{
+    *found = is_word(p, word);
+    return *found ? next_token(p) : QUERY_OK;
+}
+
+
+static int expect_word(struct parser *p, const char *word)
+{
+    if (!is_word(p, word))
+    {
+        return syntax_error(p, "expected %s, found \"%.*s\".", word,
+                            (int)p->tok.len, p->tok.start);
+    }
+    return next_token(p);
+}
+
+
+static int parse_field(struct parser *p, enum query_fields *field)
+{
+    for (int f = 0; f < QF_CNT; f++)
+    {
+        if (is_word(p, query_fields[f].name))
+        {
+            *field = (enum query_fields)f;
+            return next_token(p);
+        }
+    }
+    if (p->tok.type == TOK_END)
+    {
+        return syntax_error(p, "expected field name, found end of query.");
+    }
+    return syntax_error(p, "unknown field \"%.*s\".", (int)p->tok.len,
+                        p->tok.start);
+}
+
+
+static int is_numeric(enum query_fields field)
+{
+    enum query_types type = query_fields[field].type;
+    return type == QT_INT || type == QT_FLOAT || type == QT_PRICE;
+}
+
+
+/*
+    Parses a field or an aggregate like MIN(price) or COUNT(*).
+*/
+static int parse_item(struct parser *p, struct query_item *item)
+{
+    item->agg = QAGG_NONE;
+    item->star = 0;
+    for (int a = QAGG_COUNT; a <= QAGG_AVG; a++)
+    {
+        if (is_word(p, agg_names[a]) && *p->pos == '(')
+        {
+            item->agg = (enum query_aggs)a;
+            break;
+        }
+    }
+    if (item->agg == QAGG_NONE)
+    {
+        return parse_field(p, &item->field);
+    }
+    
+    if (next_token(p) != QUERY_OK || next_token(p) != QUERY_OK)
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    if (item->agg == QAGG_COUNT && p->tok.type == TOK_STAR)
+    {
+        item->star = 1;
+        item->field = QF_CODE;
+        if (next_token(p) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+    }
+    else
+    {
+        if (parse_field(p, &item->field) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        if (item->agg != QAGG_COUNT && !is_numeric(item->field))
+        {
+            return syntax_error(p, "%s of text field \"%s\".",
+                                agg_names[item->agg],
+                                query_fields[item->field].name);
+        }
+    }
+    if (p->tok.type != TOK_RPAREN)
+    {
+        return syntax_error(p, "expected \")\".");
+    }
+    return next_token(p);
+}
+
+
+static int add_star_items(struct parser *p, struct query *q)
+{
+    const enum query_fields *fields = product_star;
+    int cnt = (int)(sizeof(product_star) / sizeof(*product_star));
+    if (q->join)
+    {
+        fields = join_star;
+        cnt = (int)(sizeof(join_star) / sizeof(*join_star));
+    }
+    else if (q->from == QUERY_QUOTES)
+    {
+        fields = quote_star;
+        cnt = (int)(sizeof(quote_star) / sizeof(*quote_star));
+    }
+    if (q->item_cnt + cnt > QUERY_ITEMS_MAX)
+    {
+        return syntax_error(p, "too many columns (at most %d).",
+                            QUERY_ITEMS_MAX);
+    }
+    for (int i = 0; i < cnt; i++)
+    {
+        struct query_item *item = q->items + q->item_cnt++;
+        item->agg = QAGG_NONE;
+        item->field = *(fields + i);
+        item->star = 0;
+    }
+    return QUERY_OK;
+}
+
+
+/*
+    Parses the SELECT list. * is expanded after FROM is known, so its
+    position is returned in *star_at (-1 if none).
+*/
+static int parse_items(struct parser *p, struct query *q, int *star_at)
+{
+    *star_at = -1;
+    while (1)
+    {
+        if (p->tok.type == TOK_STAR)
+        {
+            if (*star_at >= 0)
+            {
+                return syntax_error(p, "* is selected twice.");
+            }
+            *star_at = q->item_cnt;
+            if (next_token(p) != QUERY_OK)
+            {
+                return QUERY_SYNTAX_ERR;
+            }
+        }
+        else
+        {
+            if (q->item_cnt >= QUERY_ITEMS_MAX)
+            {
+                return syntax_error(p, "too many columns (at most %d).",
+                                    QUERY_ITEMS_MAX);
+            }
+            if (parse_item(p, q->items + q->item_cnt) != QUERY_OK)
+            {
+                return QUERY_SYNTAX_ERR;
+            }
+            q->item_cnt++;
+        }
+        if (p->tok.type != TOK_COMMA)
+        {
+            return QUERY_OK;
+        }
+        if (next_token(p) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+    }
+}
+
+
+static int parse_table(struct parser *p, enum query_tables *table)
+{
+    if (is_word(p, "products"))
+    {
+        *table = QUERY_PRODUCTS;
+    }
+    else if (is_word(p, "quotes"))
+    {
+        *table = QUERY_QUOTES;
+    }
+    else
+    {
+        return syntax_error(p, "unknown table \"%.*s\" (products or quotes).",
+                            (int)p->tok.len, p->tok.start);
+    }
+    return next_token(p);
+}
+
+
+/*
+    Euros to whole cents, rounded half away from zero.
+*/
+static double to_cents(double eur)
+{
+    double cents = eur * 100.0;
+    if (cents > 1e15 || cents < -1e15)
+    {
+        return cents;
+    }
+    return (double)(long long)(cents + (cents < 0 ? -0.5 : 0.5));
+}
+
+
+/*
+    Parses the value of a filter. Prices are converted from euros to cents,
+    screen sizes are rounded like the floats they are compared with.
+*/
+static int parse_value(struct parser *p, struct query_pred *pred)
+{
+    if (p->tok.type != TOK_WORD && p->tok.type != TOK_STRING)
+    {
+        return syntax_error(p, "expected value for \"%s\".",
+                            query_fields[pred->field].name);
+    }
+    if (p->tok.len >= QUERY_VALUE_LEN)
+    {
+        return syntax_error(p, "value is too long (at most %d chars).",
+                            QUERY_VALUE_LEN - 1);
+    }
+    memcpy(pred->str, p->tok.start, p->tok.len);
+    *(pred->str + p->tok.len) = '\0';
+    
+    if (is_numeric(pred->field))
+    {
+        char *end;
+        pred->num = strtod(pred->str, &end);
+        if (*pred->str == '\0' || *end != '\0' || !isfinite(pred->num))
+        {
+            return syntax_error(p, "\"%s\" is not a number.", pred->str);
+        }
+        if (pred->op == QOP_CONTAINS)
+        {
+            return syntax_error(p, "~ can not be used with number field "
+                                "\"%s\".", query_fields[pred->field].name);
+        }
+        if (query_fields[pred->field].type == QT_PRICE)
+        {
+            pred->num = to_cents(pred->num);
+        }
+        else if (query_fields[pred->field].type == QT_FLOAT)
+        {
+            pred->num = (double)(float)pred->num;
+        }
+    }
+    return next_token(p);
+}
+
+
+static int parse_where(struct parser *p, struct query *q)
+{
+    int found = 1;
+    while (found)
+    {
+        if (q->pred_cnt >= QUERY_PREDS_MAX)
+        {
+            return syntax_error(p, "too many filters (at most %d).",
+                                QUERY_PREDS_MAX);
+        }
+        struct query_pred *pred = q->preds + q->pred_cnt;
+        if (parse_field(p, &pred->field) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        if (p->tok.type != TOK_OP)
+        {
+            return syntax_error(p, "expected operator after \"%s\".",
+                                query_fields[pred->field].name);
+        }
+        pred->op = p->tok.op;
+        if (next_token(p) != QUERY_OK || parse_value(p, pred) != QUERY_OK ||
+            accept_word(p, "and", &found) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        q->pred_cnt++;
+    }
+    return QUERY_OK;
+}
+
+
+static int same_item(struct query_item *a, struct query_item *b)
+{
+    return a->agg == b->agg && a->star == b->star &&
+           (a->star || a->field == b->field);
+}
+
+
+/*
+    Checks, that every field is in a table of the query and that columns fit
+    the grouping.
+*/
+static int check_field(struct parser *p, struct query *q,
+                       enum query_fields field)
+{
+    if (q->join || field == QF_CODE || query_fields[field].table == q->from)
+    {
+        return QUERY_OK;
+    }
+    return syntax_error(p, "field \"%s\" is in table %s, add JOIN %s.",
+                        query_fields[field].name,
+                        q->from == QUERY_PRODUCTS ? "quotes" : "products",
+                        q->from == QUERY_PRODUCTS ? "quotes" : "products");
+}
+
+
+static int check_query(struct parser *p, struct query *q)
+{
+    // Errors are about the whole query, not a position
+    p->tok.start = NULL;
+    for (int i = 0; i < q->item_cnt; i++)
+    {
+        struct query_item *item = q->items + i;
+        if ((!item->star && check_field(p, q, item->field) != QUERY_OK))
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        if (item->agg != QAGG_NONE)
+        {
+            q->has_aggs = 1;
+        }
+    }
+    for (int i = 0; i < q->pred_cnt; i++)
+    {
+        if (check_field(p, q, (q->preds + i)->field) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+    }
+    if ((q->group_by >= 0 &&
+         check_field(p, q, (enum query_fields)q->group_by) != QUERY_OK) ||
+        (q->order_set && !q->order.star &&
+         check_field(p, q, q->order.field) != QUERY_OK))
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    
+    if (!q->has_aggs && q->group_by < 0)
+    {
+        if (q->order_set && q->order.agg != QAGG_NONE)
+        {
+            return syntax_error(p, "ORDER BY aggregate without aggregates "
+                                "selected.");
+        }
+        return QUERY_OK;
+    }
+    // Grouped rows have only the group field and aggregates
+    for (int i = 0; i < q->item_cnt; i++)
+    {
+        struct query_item *item = q->items + i;
+        if (item->agg == QAGG_NONE &&
+            (q->group_by < 0 || (int)item->field != q->group_by))
+        {
+            return syntax_error(p, "field \"%s\" must be aggregated or used "
+                                "in GROUP BY.", query_fields[item->field].name);
+        }
+    }
+    if (q->order_set)
+    {
+        for (int i = 0; i < q->item_cnt; i++)
+        {
+            if (same_item(&q->order, q->items + i))
+            {
+                return QUERY_OK;
+            }
+        }
+        return syntax_error(p, "ORDER BY of a grouped query must be one of "
+                            "the selected columns.");
+    }
+    return QUERY_OK;
+}
+
+
+int query_parse(const char *text, struct query *q, char *err, size_t err_len)
+{
+    struct parser p = {text, text, {TOK_END, text, 0, QOP_EQ}, err, err_len};
+    memset(q, 0, sizeof(struct query));
+    q->group_by = -1;
+    q->limit = QUERY_NO_LIMIT;
+    *err = '\0';
+    
+    int star_at;
+    int found;
+    if (next_token(&p) != QUERY_OK || expect_word(&p, "select") != QUERY_OK ||
+        parse_items(&p, q, &star_at) != QUERY_OK ||
+        expect_word(&p, "from") != QUERY_OK ||
+        parse_table(&p, &q->from) != QUERY_OK ||
+        accept_word(&p, "join", &found) != QUERY_OK)
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    if (found)
+    {
+        enum query_tables other;
+        if (parse_table(&p, &other) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        if (other == q->from)
+        {
+            return syntax_error(&p, "table is joined with itself.");
+        }
+        q->join = 1;
+        q->from = QUERY_QUOTES;
+    }
+    
+    // * goes where it was in the SELECT list
+    if (star_at >= 0)
+    {
+        struct query_item after[QUERY_ITEMS_MAX];
+        int after_cnt = q->item_cnt - star_at;
+        memcpy(after, q->items + star_at,
+               (size_t)after_cnt * sizeof(struct query_item));
+        q->item_cnt = star_at;
+        if (add_star_items(&p, q) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        if (q->item_cnt + after_cnt > QUERY_ITEMS_MAX)
+        {
+            return syntax_error(&p, "too many columns (at most %d).",
+                                QUERY_ITEMS_MAX);
+        }
+        memcpy(q->items + q->item_cnt, after,
+               (size_t)after_cnt * sizeof(struct query_item));
+        q->item_cnt += after_cnt;
+    }
+    
+    if (accept_word(&p, "where", &found) != QUERY_OK ||
+        (found && parse_where(&p, q) != QUERY_OK) ||
+        accept_word(&p, "group", &found) != QUERY_OK)
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    if (found)
+    {
+        enum query_fields field;
+        if (expect_word(&p, "by") != QUERY_OK ||
+            parse_field(&p, &field) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        q->group_by = (int)field;
+    }
+    if (accept_word(&p, "order", &found) != QUERY_OK)
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    if (found)
+    {
+        int desc;
+        if (expect_word(&p, "by") != QUERY_OK ||
+            parse_item(&p, &q->order) != QUERY_OK ||
+            accept_word(&p, "asc", &found) != QUERY_OK ||
+            (!found && accept_word(&p, "desc", &desc) != QUERY_OK))
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+        q->order_set = 1;
+        q->order_desc = !found && desc;
+    }
+    if (accept_word(&p, "limit", &found) != QUERY_OK)
+    {
+        return QUERY_SYNTAX_ERR;
+    }
+    if (found)
+    {
+        char *end;
+        long limit = p.tok.type == TOK_WORD ? strtol(p.tok.start, &end, 10)
+                                            : -1;
+        if (p.tok.type != TOK_WORD || end != p.tok.start + p.tok.len ||
+            limit < 0)
+        {
+            return syntax_error(&p, "LIMIT must be a number of rows.");
+        }
+        q->limit = limit;
+        if (next_token(&p) != QUERY_OK)
+        {
+            return QUERY_SYNTAX_ERR;
+        }
+    }
+    if (p.tok.type != TOK_END)
+    {
+        return syntax_error(&p, "unexpected \"%.*s\".", (int)p.tok.len,
+                            p.tok.start);
+    }
+    return check_query(&p, q);
+}
@@ -0,0 +1,310 @@
+/*
+File:         quote_delta.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Applying files of quote changes (inserts, updates, deletes) to
+              loaded quotes without reading the whole quotes file again.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <csv_helper.h>
+#include <hash_index.h>
+#include <main.h>
+#include <data_stream.h>
+#include <data_read_write.h>
+#include <catalog.h>
+#include <watch_rules.h>
+#include <metrics.h>
+#include <quote_delta.h>
+
+int build_quote_id_index(struct quote_data_wrapper *qdw)
+{
+    hash_index_free(&qdw->id_index);
+    if (hash_index_init(&qdw->id_index, qdw->lines) != HASH_OK)
+    {
+        write_log(ERROR, "Unable to allocate memory for quote ID index.");
+        fprintf(stderr, "Unable to allocate memory for quote ID index.\n");
+        return EXIT_FAILURE;
+    }
+    
+    for (size_t i = 0; i < qdw->lines; i++)
+    {
+        char *q_id = (qdw->data + i)->p_id;
+        if (q_id == NULL || hash_index_get(&qdw->id_index, q_id) != HASH_NOT_FOUND)
+        {
+            continue; // First quote with the same ID stays indexed
+        }
+        if (hash_index_put(&qdw->id_index, q_id, (int64_t)i) != HASH_OK)
+        {
+            write_log(ERROR, "Unable to allocate memory for quote ID index.");
+            fprintf(stderr, "Unable to allocate memory for quote ID index.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int64_t find_quote_by_id(struct quote_data_wrapper qdw, char *q_id)
+{
+    return hash_index_get(&qdw.id_index, q_id);
+}
+
+
+static void free_quote_strings(struct quote_info *qi)
+{
+    acct_free(qi->p_id);
+    qi->p_id = NULL;
+}
+
+
+/*
+    ID of a quote, that was published, may still be used by readers of an
+    older catalog version, so it is retired instead of freed. Code and
+    retailer are dictionary IDs and need no freeing.
+*/
+static void retire_quote_strings(struct quote_info *qi)
+{
+    catalog_retire(qi->p_id);
+    qi->p_id = NULL;
+}
+
+
+/*
+    Adds a quote or replaces the quote with the same ID. The quote array grows
+    2*n, so adding is constant time on average.
+*/
+static int upsert_quote(struct quote_data_wrapper *qdw, struct quote_info qi,
+                        struct delta_summary *summary)
+{
+    int64_t idx = find_quote_by_id(*qdw, qi.p_id);
+    if (idx != HASH_NOT_FOUND)
+    {
+        struct quote_info *old = qdw->data + idx;
+        qi.shard = old->shard;
+        // Index key must point to a string, that stays alive. Put is the
+        // last step, that can fail, so a failed update leaves the key as is
+        if (watch_mark_code(old->code_id) == EXIT_FAILURE ||
+            watch_mark_code(qi.code_id) == EXIT_FAILURE ||
+            hash_index_put(&qdw->id_index, qi.p_id, idx) != HASH_OK)
+        {
+            return EXIT_FAILURE;
+        }
+        retire_quote_strings(old);
+        *old = qi;
+        summary->updated++;
+        metrics_add(MET_EDITS, 1);
+        return EXIT_SUCCESS;
+    }
+    
+    if (qdw->lines >= qdw->alloc_limit)
+    {
+        size_t new_limit = acct_grow_limit(qdw->lines, MIN_ALLOC_LINE_CNT,
+                                           qdw->data_struct_size);
+        if (new_limit != 0 && new_limit < MIN_ALLOC_LINE_CNT)
+        {
+            new_limit = MIN_ALLOC_LINE_CNT;
+        }
+        struct quote_info *p_temp = new_limit == 0 ? NULL :
+                                    acct_realloc(ALLOC_QUOTE_ARR, qdw->data,
+                                                 qdw->data_struct_size *
+                                                 new_limit);
+        if (p_temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        qdw->data = p_temp;
+        qdw->alloc_limit = new_limit;
+    }
+    
+    qi.shard = 0;
+    if (watch_mark_code(qi.code_id) == EXIT_FAILURE ||
+        hash_index_put(&qdw->id_index, qi.p_id, (int64_t)qdw->lines) !=
+        HASH_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    *(qdw->data + qdw->lines) = qi;
+    qdw->lines++;
+    summary->inserted++;
+    metrics_add(MET_EDITS, 1);
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Removes a quote by moving the last quote into its place.
+*/
+static int delete_quote(struct quote_data_wrapper *qdw, char *q_id,
+                        struct delta_summary *summary)
+{
+    int64_t idx = find_quote_by_id(*qdw, q_id);
+    if (idx == HASH_NOT_FOUND)
+    {
+        summary->missing++;
+        return EXIT_SUCCESS;
+    }
+    if (watch_mark_code((qdw->data + idx)->code_id) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    int64_t last = (int64_t)qdw->lines - 1;
+    char *moved_id = (qdw->data + last)->p_id;
+    if (idx != last && find_quote_by_id(*qdw, moved_id) == last &&
+        hash_index_put(&qdw->id_index, moved_id, idx) != HASH_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    hash_index_remove(&qdw->id_index, q_id);
+    retire_quote_strings(qdw->data + idx);
+    if (idx != last)
+    {
+        *(qdw->data + idx) = *(qdw->data + last);
+    }
+    qdw->lines--;
+    summary->deleted++;
+    metrics_add(MET_EDITS, 1);
+    return EXIT_SUCCESS;
+}
+
+
+int apply_quote_delta(char *f_name, struct quote_data_wrapper *qdw,
+                      struct delta_summary *summary)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    char *line_buffer;
+    memset(summary, 0, sizeof(struct delta_summary));
+    
+    FILE *p_file = open_data_file(f_name);
+    if (p_file == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    size_t line = 0;
+    int return_val;
+    enum read_errors err_code;
+    while (1)
+    {
+        return_val = read_line(p_file, &line_buffer);
+        if (return_val == EOF)
+        {
+            break;
+        }
+        else if (return_val == CSV_MALLOC_ERR || return_val == CSV_READ_ERR)
+        {
+            close_data_file(p_file);
+            return EXIT_FAILURE;
+        }
+        line++;
+        
+        // Operation is split off in place, the rest is a quotes file line
+        char *p_op = NULL;
+        char *p_rest = strchr(line_buffer, CSV_DELIMITER);
+        if (p_rest != NULL)
+        {
+            *p_rest = '\0';
+            p_rest++;
+            p_op = get_field(line_buffer, 1);
+        }
+        if (p_op == NULL)
+        {
+            err_code = READ_ERR_MSNG_DATA;
+        }
+        else if (*p_op == DELTA_OP_DELETE && *(p_op + 1) == '\0')
+        {
+            char *p_id = get_field(p_rest, 1);
+            err_code = p_id == NULL || *p_id == '\0' ? READ_ERR_MSNG_DATA
+                                                     : READ_OK;
+            if (err_code == READ_OK &&
+                delete_quote(qdw, p_id, summary) == EXIT_FAILURE)
+            {
+                err_code = READ_ERR_STR_MALLOC;
+            }
+        }
+        else if ((*p_op == DELTA_OP_INSERT || *p_op == DELTA_OP_UPDATE) &&
+                 *(p_op + 1) == '\0')
+        {
+            // Rest of the line has the same layout as a quotes file line
+            struct quote_info qte_buf;
+            err_code = get_quote_info(&qte_buf, p_rest);
+            if (err_code == READ_OK ||
+                print_read_error(err_code, f_name, line) == READ_ERR_NOT_FATAL)
+            {
+                if (upsert_quote(qdw, qte_buf, summary) == EXIT_FAILURE)
+                {
+                    free_quote_strings(&qte_buf);
+                    err_code = READ_ERR_STR_MALLOC;
+                }
+                else
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                free_quote_strings(&qte_buf);
+                close_data_file(p_file);
+                free_buffer_manually();
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            err_code = READ_ERR_DELTA_OP;
+        }
+        
+        if (err_code != READ_OK &&
+            print_read_error(err_code, f_name, line) == READ_ERR_FATAL)
+        {
+            close_data_file(p_file);
+            free_buffer_manually();
+            return EXIT_FAILURE;
+        }
+    }
+    if (close_data_file(p_file) != STREAM_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    snprintf(msg, MAX_ERR_MSG_LEN, "Applied quote changes from \"%s\": %zu "
+             "inserted, %zu updated, %zu deleted, %zu delete(s) of unknown "
+             "quotes.", f_name, summary->inserted, summary->updated,
+             summary->deleted, summary->missing);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
+
+
+int apply_quote_delta_prompt(struct quote_data_wrapper *qdw)
+{
+    printf("Enter name of quote changes file.\n> ");
+    
+    char *f_name = get_dynamic_input_string(stdin);
+    if (f_name == NULL)
+    {
+        return EDIT_MALLOC;
+    }
+    
+    struct delta_summary summary;
+    if (apply_quote_delta(f_name, qdw, &summary) == EXIT_FAILURE)
+    {
+        printf("Quote changes file was not fully applied.\n");
+    }
+    printf("\n%zu inserted, %zu updated, %zu deleted, %zu delete(s) of unknown "
+           "quotes.\n\n", summary.inserted, summary.updated, summary.deleted,
+           summary.missing);
+    acct_free(f_name);
+    
+    if (summary.inserted + summary.updated + summary.deleted == 0)
+    {
+        return EDIT_NO_MATCH;
+    }
+    return EDIT_OK;
+}
@@ -0,0 +1,359 @@
+/*
+File:         quote_shards.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Reading quotes from several files (shards) in parallel and
+              merging them into one quote data array.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <glob.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <data_read_write.h>
+#include <trace.h>
+#include <quote_shards.h>
+
+/*
+    Shared state of the shard reading threads. Every thread takes the next
+    unread shard until all shards are taken.
+*/
+struct shard_pool
+{
+    struct shard_job *jobs;
+    int job_cnt;
+    atomic_int next;
+};
+
+
+static int add_shard_name(char ***f_names, int *f_cnt, int *alloc_limit,
+                          char *name)
+{
+    if (*f_cnt >= *alloc_limit)
+    {
+        int new_limit = *alloc_limit ? *alloc_limit * 2 : SHARD_NAMES_MIN_ALLOC;
+        char **temp = acct_realloc(ALLOC_OTHER, *f_names, sizeof(char *) *
+                                   (size_t)new_limit);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        *f_names = temp;
+        *alloc_limit = new_limit;
+    }
+    
+    *(*f_names + *f_cnt) = dynamic_string(name, ALLOC_OTHER);
+    if (*(*f_names + *f_cnt) == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    (*f_cnt)++;
+    return EXIT_SUCCESS;
+}
+
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+static int expand_directory(char *dir_name, char ***f_names, int *f_cnt,
+                            int *alloc_limit)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    DIR *p_dir = opendir(dir_name);
+    if (p_dir == NULL)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to open quotes directory "
+                 "\"%s\".", dir_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    int first = *f_cnt;
+    char path[SHARD_PATH_MAX_LEN];
+    struct stat st;
+    struct dirent *entry;
+    while ((entry = readdir(p_dir)) != NULL)
+    {
+        if (*entry->d_name == '.')
+        {
+            continue;
+        }
+        if (snprintf(path, SHARD_PATH_MAX_LEN, "%s/%s", dir_name,
+                     entry->d_name) >= SHARD_PATH_MAX_LEN)
+        {
+            continue;
+        }
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            continue;
+        }
+        if (add_shard_name(f_names, f_cnt, alloc_limit, path) == EXIT_FAILURE)
+        {
+            closedir(p_dir);
+            return EXIT_FAILURE;
+        }
+    }
+    closedir(p_dir);
+    
+    // Directory order is not defined, merge order should be
+    qsort(*f_names + first, (size_t)(*f_cnt - first), sizeof(char *),
+          compare_names);
+    return EXIT_SUCCESS;
+}
+
+
+static int expand_glob(char *pattern, char ***f_names, int *f_cnt,
+                       int *alloc_limit)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    glob_t matches;
+    
+    int return_val = glob(pattern, 0, NULL, &matches);
+    if (return_val == GLOB_NOMATCH)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Quotes pattern \"%s\" matched no "
+                 "files.", pattern);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    else if (return_val != 0)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to expand quotes pattern "
+                 "\"%s\".", pattern);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    for (size_t i = 0; i < matches.gl_pathc; i++)
+    {
+        if (add_shard_name(f_names, f_cnt, alloc_limit,
+                           *(matches.gl_pathv + i)) == EXIT_FAILURE)
+        {
+            globfree(&matches);
+            return EXIT_FAILURE;
+        }
+    }
+    globfree(&matches);
+    return EXIT_SUCCESS;
+}
+
+
+int expand_quote_sources(char **sources, int src_cnt, char ***f_names,
+                         int *f_cnt)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    int alloc_limit = 0;
+    int return_val;
+    struct stat st;
+    
+    *f_names = NULL;
+    *f_cnt = 0;
+    
+    for (int i = 0; i < src_cnt; i++)
+    {
+        char *src = *(sources + i);
+        if (strpbrk(src, SHARD_GLOB_CHARS) != NULL)
+        {
+            return_val = expand_glob(src, f_names, f_cnt, &alloc_limit);
+        }
+        else if (stat(src, &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            return_val = expand_directory(src, f_names, f_cnt, &alloc_limit);
+        }
+        else
+        {
+            // Plain files are checked when they are opened
+            return_val = add_shard_name(f_names, f_cnt, &alloc_limit, src);
+        }
+        
+        if (return_val == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if (*f_cnt == 0)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "No quote files found.");
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    snprintf(msg, MAX_ERR_MSG_LEN, "Found %d quote file(s).", *f_cnt);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
+
+
+static void *read_shard_worker(void *arg)
+{
+    struct shard_pool *pool = arg;
+    int i;
+    
+    while ((i = atomic_fetch_add(&pool->next, 1)) < pool->job_cnt)
+    {
+        struct shard_job *job = pool->jobs + i;
+        job->status = read_data_quotes(job->f_name, &job->qdw);
+    }
+    return NULL;
+}
+
+
+static int merge_shards(struct shard_job *jobs, int job_cnt,
+                        struct quote_data_wrapper *qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    size_t total = 0;
+    for (int i = 0; i < job_cnt; i++)
+    {
+        total += (jobs + i)->qdw.lines;
+    }
+    if (total > SIZE_MAX / qdw->data_struct_size)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Too many quotes to merge: %zu.", total);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    struct quote_info *p_arr = acct_malloc(ALLOC_QUOTE_ARR,
+                                           qdw->data_struct_size *
+                                           (total ? total : 1));
+    if (p_arr == NULL)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate merged quote data "
+                 "array of length %zu", total);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    size_t count = 0;
+    for (int i = 0; i < job_cnt; i++)
+    {
+        struct quote_data_wrapper *part = &(jobs + i)->qdw;
+        for (size_t j = 0; j < part->lines; j++)
+        {
+            *(p_arr + count) = *(part->data + j);
+            (p_arr + count)->shard = i;
+            count++;
+        }
+        // Strings are now owned by the merged array
+        acct_free(part->data);
+        part->data = NULL;
+        part->lines = 0;
+    }
+    
+    qdw->data = p_arr;
+    qdw->lines = count;
+    return EXIT_SUCCESS;
+}
+
+
+int read_data_quote_shards(char **sources, int src_cnt,
+                           struct quote_data_wrapper *qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    char **f_names = NULL;
+    int f_cnt = 0;
+    
+    qdw->data = NULL;
+    qdw->lines = 0;
+    
+    if (expand_quote_sources(sources, src_cnt, &f_names, &f_cnt) == EXIT_FAILURE)
+    {
+        qdw->shard_names = f_names;
+        qdw->shard_cnt = f_cnt;
+        return EXIT_FAILURE;
+    }
+    qdw->shard_names = f_names;
+    qdw->shard_cnt = f_cnt;
+    
+    struct shard_job *jobs = acct_calloc(ALLOC_OTHER, (size_t)f_cnt,
+                                         sizeof(struct shard_job));
+    if (jobs == NULL)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for reading "
+                 "%d quote files.", f_cnt);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < f_cnt; i++)
+    {
+        (jobs + i)->f_name = *(f_names + i);
+        (jobs + i)->qdw.data_struct_size = qdw->data_struct_size;
+        (jobs + i)->status = EXIT_FAILURE;
+    }
+    
+    struct shard_pool pool = {.jobs = jobs, .job_cnt = f_cnt};
+    atomic_init(&pool.next, 0);
+    
+    // The calling thread is one of the readers, a single file starts none
+    int thread_cnt = f_cnt < SHARD_THREADS_MAX ? f_cnt : SHARD_THREADS_MAX;
+    pthread_t threads[SHARD_THREADS_MAX];
+    int started = 0;
+    for (; started < thread_cnt - 1; started++)
+    {
+        if (pthread_create(threads + started, NULL, read_shard_worker,
+                           &pool) != 0)
+        {
+            break;
+        }
+    }
+    // Also covers failing to start threads
+    read_shard_worker(&pool);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(*(threads + i), NULL);
+    }
+    
+    int return_val = EXIT_SUCCESS;
+    for (int i = 0; i < f_cnt; i++)
+    {
+        if ((jobs + i)->status == EXIT_FAILURE)
+        {
+            return_val = EXIT_FAILURE;
+        }
+    }
+    
+    uint64_t span = trace_begin();
+    int merged = merge_shards(jobs, f_cnt, qdw);
+    trace_end(span, TRACE_CAT_LOAD, "merge shards", (int64_t)qdw->lines);
+    if (merged == EXIT_FAILURE)
+    {
+        // Free what could not be merged
+        for (int i = 0; i < f_cnt; i++)
+        {
+            (jobs + i)->qdw.shard_names = NULL;
+            (jobs + i)->qdw.shard_cnt = 0;
+            free_quote_info(&(jobs + i)->qdw);
+        }
+        return_val = EXIT_FAILURE;
+    }
+    acct_free(jobs);
+    
+    if (return_val == EXIT_SUCCESS)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Merged %zu quote(s) from %d file(s).",
+                 qdw->lines, f_cnt);
+        write_log(INFO, msg);
+    }
+    return return_val;
+}
@@ -0,0 +1,210 @@
+/*
+File:         rcu.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Epoch based read-copy-update. Readers only publish the epoch
+              they started in, writers replace data and retire the old memory,
+              which is freed when all readers, that could see it, are done.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <alloc_acct.h>
+#include <rcu.h>
+
+static struct rcu_reader readers[RCU_READERS_MAX];
+static _Atomic uint64_t global_epoch = 1;
+
+static pthread_mutex_t retire_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct rcu_retired *retired = NULL;
+static int retired_cnt = 0;
+static int retired_limit = 0;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t reader_key;
+static _Thread_local struct rcu_reader *p_reader = NULL;
+
+
+static void release_reader(void *p)
+{
+    struct rcu_reader *reader = p;
+    atomic_store(&reader->epoch, RCU_QUIESCENT);
+    atomic_store(&reader->in_use, 0);
+}
+
+
+static void create_reader_key(void)
+{
+    pthread_key_create(&reader_key, release_reader);
+}
+
+
+/*
+    Claims a free reader slot for the calling thread. The slot is released by
+    the key destructor when the thread exits.
+*/
+static struct rcu_reader *register_reader(void)
+{
+    pthread_once(&key_once, create_reader_key);
+    while (1)
+    {
+        for (int i = 0; i < RCU_READERS_MAX; i++)
+        {
+            int expected = 0;
+            if (atomic_compare_exchange_strong(&(readers + i)->in_use,
+                                               &expected, 1))
+            {
+                (readers + i)->depth = 0;
+                pthread_setspecific(reader_key, readers + i);
+                return readers + i;
+            }
+        }
+        sched_yield();
+    }
+}
+
+
+void rcu_read_lock(void)
+{
+    if (p_reader == NULL)
+    {
+        p_reader = register_reader();
+    }
+    if (p_reader->depth++ == 0)
+    {
+        /*
+            Sequentially consistent store: a writer, that does not see this
+            epoch, has published its new pointer before any load in this
+            section.
+        */
+        atomic_store(&p_reader->epoch, atomic_load(&global_epoch));
+    }
+}
+
+
+void rcu_read_unlock(void)
+{
+    if (--p_reader->depth == 0)
+    {
+        atomic_store_explicit(&p_reader->epoch, RCU_QUIESCENT,
+                              memory_order_release);
+    }
+}
+
+
+/*
+    Smallest epoch of all running read sections. UINT64_MAX if there are none.
+*/
+static uint64_t oldest_reader_epoch(void)
+{
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < RCU_READERS_MAX; i++)
+    {
+        uint64_t epoch = atomic_load(&(readers + i)->epoch);
+        if (epoch != RCU_QUIESCENT && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+
+/*
+    Frees retired entries older than every running read section. Retire lock
+    must be held.
+*/
+static void reclaim_locked(void)
+{
+    uint64_t oldest = oldest_reader_epoch();
+    int kept = 0;
+    for (int i = 0; i < retired_cnt; i++)
+    {
+        struct rcu_retired *r = retired + i;
+        if (r->epoch < oldest)
+        {
+            r->free_fn(r->ptr);
+        }
+        else
+        {
+            *(retired + kept) = *r;
+            kept++;
+        }
+    }
+    retired_cnt = kept;
+}
+
+
+void rcu_reclaim(void)
+{
+    pthread_mutex_lock(&retire_lock);
+    reclaim_locked();
+    pthread_mutex_unlock(&retire_lock);
+}
+
+
+void rcu_synchronize(void)
+{
+    uint64_t target = atomic_fetch_add(&global_epoch, 1);
+    for (int i = 0; i < RCU_READERS_MAX; i++)
+    {
+        uint64_t epoch = atomic_load(&(readers + i)->epoch);
+        while (epoch != RCU_QUIESCENT && epoch <= target)
+        {
+            sched_yield();
+            epoch = atomic_load(&(readers + i)->epoch);
+        }
+    }
+    
+    // Every entry retired up to target is older than all running readers now
+    pthread_mutex_lock(&retire_lock);
+    reclaim_locked();
+    if (retired_cnt == 0)
+    {
+        acct_free(retired);
+        retired = NULL;
+        retired_limit = 0;
+    }
+    pthread_mutex_unlock(&retire_lock);
+}
+
+
+void rcu_retire(void *ptr, void (*free_fn)(void *))
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    
+    pthread_mutex_lock(&retire_lock);
+    if (retired_cnt >= retired_limit)
+    {
+        int new_limit = retired_limit == 0 ? RCU_RETIRE_MIN_ALLOC :
+                        retired_limit * 2;
+        struct rcu_retired *p_temp = acct_realloc(ALLOC_OTHER, retired,
+                                                  sizeof(struct rcu_retired) *
+                                                  (size_t)new_limit);
+        if (p_temp == NULL)
+        {
+            // No room to defer freeing, wait for readers instead
+            pthread_mutex_unlock(&retire_lock);
+            rcu_synchronize();
+            free_fn(ptr);
+            return;
+        }
+        retired = p_temp;
+        retired_limit = new_limit;
+    }
+    
+    /*
+        Readers, that start after the epoch is advanced, can not reach the
+        memory anymore.
+    */
+    struct rcu_retired r = {ptr, free_fn, atomic_fetch_add(&global_epoch, 1)};
+    *(retired + retired_cnt) = r;
+    retired_cnt++;
+    pthread_mutex_unlock(&retire_lock);
+}
@@ -0,0 +1,339 @@
+/*
+File:         record_schema.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Parse and write routines generated from the column tables in
+              record_schema.h, and mapping columns by a files header row.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <csv_helper.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_read_write.h>
+#include <record_schema.h>
+
+// Column names
+#define COLUMN_NAME(col, name, kind, member, arg1, arg2) name,
+
+static const char *const product_col_names[] = {PRODUCT_COLUMNS(COLUMN_NAME)};
+static const char *const quote_col_names[] = {QUOTE_COLUMNS(COLUMN_NAME)};
+
+// Setting fields before parsing, so a record can be freed after any error
+#define INIT_STR(rec, member, arg1, arg2) rec->member = NULL;
+#define INIT_STR_DICT(rec, member, arg1, arg2) rec->member = NULL;
+#define INIT_DICT(rec, member, arg1, arg2) rec->member = DICT_NO_ID;
+#define INIT_INT(rec, member, arg1, arg2) rec->member = 0;
+#define INIT_INT64(rec, member, arg1, arg2) rec->member = 0;
+#define INIT_FLOAT(rec, member, arg1, arg2) rec->member = 0.0f;
+
+#define INIT_COLUMN(col, name, kind, member, arg1, arg2)                       \
+    INIT_##kind(rec, member, arg1, arg2)
+
+// Parsing one field from p_field
+#define PARSE_STR(rec, member, arg1, arg2)                                     \
+    rec->member = dynamic_string(p_field, str_class);                          \
+    if (rec->member == NULL)                                                   \
+    {                                                                          \
+        return READ_ERR_STR_MALLOC;                                            \
+    }
+
+#define PARSE_STR_DICT(rec, member, arg1, arg2)                                \
+    rec->member = dynamic_string(p_field, str_class);                          \
+    if (rec->member == NULL)                                                   \
+    {                                                                          \
+        return READ_ERR_STR_MALLOC;                                            \
+    }                                                                          \
+    PARSE_DICT(rec, arg2, arg1, 0)
+
+#define PARSE_DICT(rec, member, arg1, arg2)                                    \
+    dict_status = intern_field(arg1, p_field, &rec->member);                   \
+    if (dict_status != READ_OK)                                                \
+    {                                                                          \
+        return dict_status;                                                    \
+    }
+
+#define PARSE_INT(rec, member, arg1, arg2)                                     \
+    if (sscanf(p_field, "%d", &rec->member) != 1)                              \
+    {                                                                          \
+        rec->member = 0;                                                       \
+        error_status = arg1;                                                   \
+    }                                                                          \
+    else if (rec->member < 0)                                                  \
+    {                                                                          \
+        rec->member = 0;                                                       \
+        error_status = arg2;                                                   \
+    }
+
+#define PARSE_INT64(rec, member, arg1, arg2)                                   \
+    if (parse_int64(p_field, &rec->member) != 1)                               \
+    {                                                                          \
+        rec->member = 0;                                                       \
+        error_status = arg1;                                                   \
+    }                                                                          \
+    else if (rec->member < 0)                                                  \
+    {                                                                          \
+        rec->member = 0;                                                       \
+        error_status = arg2;                                                   \
+    }
+
+#define PARSE_FLOAT(rec, member, arg1, arg2)                                   \
+    if (sscanf(p_field, "%f", &rec->member) != 1)                              \
+    {                                                                          \
+        rec->member = 0.0f;                                                    \
+        error_status = arg1;                                                   \
+    }                                                                          \
+    else if (rec->member < 0.0f)                                               \
+    {                                                                          \
+        rec->member = 0.0f;                                                    \
+        error_status = arg2;                                                   \
+    }
+
+#define PARSE_COLUMN(col, name, kind, member, arg1, arg2)                      \
+    if (*(col_map + col) >= field_cnt)                                         \
+    {                                                                          \
+        return READ_ERR_MSNG_DATA;                                             \
+    }                                                                          \
+    p_field = *(fields + *(col_map + col));                                    \
+    PARSE_##kind(rec, member, arg1, arg2)
+
+// Writing one field
+#define WRITE_STR(fp, rec, member, arg1) print_csv_field(fp, rec->member);
+#define WRITE_STR_DICT(fp, rec, member, arg1) print_csv_field(fp, rec->member);
+#define WRITE_DICT(fp, rec, member, arg1)                                      \
+    print_csv_field(fp, dict_string(arg1, rec->member));
+#define WRITE_INT(fp, rec, member, arg1) fprintf(fp, "%d", rec->member);
+#define WRITE_INT64(fp, rec, member, arg1)                                     \
+    fprintf(fp, "%" PRId64, rec->member);
+#define WRITE_FLOAT(fp, rec, member, arg1) fprintf(fp, "%.1f", rec->member);
+
+#define WRITE_COLUMN(col, name, kind, member, arg1, arg2)                      \
+    if (col != 0)                                                              \
+    {                                                                          \
+        fputc(CSV_DELIMITER, fp);                                              \
+    }                                                                          \
+    WRITE_##kind(fp, rec, member, arg1)
+
+#define WRITE_CASE(col, name, kind, member, arg1, arg2)                        \
+        case col:                                                              \
+            WRITE_##kind(fp, rec, member, arg1)                                \
+            break;
+
+/*
+    Reads a 64-bit integer like sscanf "%d" reads an int, but a value out of
+    range is an error instead of undefined. Returns 1 if a value was read.
+*/
+static int parse_int64(const char *str, int64_t *value)
+{
+    char *end;
+    errno = 0;
+    long long num = strtoll(str, &end, 10);
+    if (end == str || errno == ERANGE)
+    {
+        return 0;
+    }
+    *value = (int64_t)num;
+    return 1;
+}
+
+
+/*
+    Finds or adds the ID of a dictionary column. Returns READ_OK or the read
+    error matching the dictionary error.
+*/
+static int intern_field(enum dictionaries dict, const char *str, uint32_t *id)
+{
+    switch (dict_intern(dict, str, id))
+    {
+        case DICT_OK:
+            return READ_OK;
+            
+        case DICT_FULL:
+            return READ_ERR_DICT_FULL;
+            
+        default:
+            return READ_ERR_STR_MALLOC;
+    }
+}
+
+
+/*
+    Errors are checked in column order. Missing data and memory errors stop
+    parsing, for invalid values the last error is returned.
+*/
+static int parse_product(void *p_rec, char **fields, int field_cnt,
+                         const int *col_map)
+{
+    struct product_info *rec = p_rec;
+    enum alloc_classes str_class = product_schema.str_class;
+    char *p_field;
+    int error_status = READ_OK; // For non fatal errors
+    int dict_status;
+    
+    PRODUCT_COLUMNS(INIT_COLUMN)
+    PRODUCT_COLUMNS(PARSE_COLUMN)
+    return error_status;
+}
+
+
+static int parse_quote(void *p_rec, char **fields, int field_cnt,
+                       const int *col_map)
+{
+    struct quote_info *rec = p_rec;
+    enum alloc_classes str_class = quote_schema.str_class;
+    char *p_field;
+    int error_status = READ_OK; // For non fatal errors
+    int dict_status;
+    
+    QUOTE_COLUMNS(INIT_COLUMN)
+    rec->shard = 0;
+    QUOTE_COLUMNS(PARSE_COLUMN)
+    return error_status;
+}
+
+
+static void print_product_field(FILE *fp, const void *p_rec, int col)
+{
+    const struct product_info *rec = p_rec;
+    switch (col)
+    {
+        PRODUCT_COLUMNS(WRITE_CASE)
+        default:
+            break;
+    }
+}
+
+
+static void print_quote_field(FILE *fp, const void *p_rec, int col)
+{
+    const struct quote_info *rec = p_rec;
+    switch (col)
+    {
+        QUOTE_COLUMNS(WRITE_CASE)
+        default:
+            break;
+    }
+}
+
+
+const struct record_schema product_schema =
+{
+    .name = "Product",
+    .col_cnt = PRO_COL_CNT,
+    .col_names = product_col_names,
+    .record_size = sizeof(struct product_info),
+    .arr_class = ALLOC_PRODUCT_ARR,
+    .str_class = ALLOC_PRODUCT_STR,
+    .parse = parse_product,
+    .print_field = print_product_field
+};
+
+const struct record_schema quote_schema =
+{
+    .name = "Quote",
+    .col_cnt = QTE_COL_CNT,
+    .col_names = quote_col_names,
+    .record_size = sizeof(struct quote_info),
+    .arr_class = ALLOC_QUOTE_ARR,
+    .str_class = ALLOC_QUOTE_STR,
+    .parse = parse_quote,
+    .print_field = print_quote_field
+};
+
+
+void print_product_csv_line(FILE *fp, struct product_info pi)
+{
+    struct product_info *rec = &pi;
+    PRODUCT_COLUMNS(WRITE_COLUMN)
+    fputc('\n', fp);
+}
+
+
+void print_quote_csv_line(FILE *fp, struct quote_info qi)
+{
+    struct quote_info *rec = &qi;
+    QUOTE_COLUMNS(WRITE_COLUMN)
+    fputc('\n', fp);
+}
+
+
+void default_column_map(const struct record_schema *schema, int *col_map)
+{
+    for (int i = 0; i < schema->col_cnt; i++)
+    {
+        *(col_map + i) = i;
+    }
+}
+
+
+/*
+    Compares a header field to a column name. Case and trailing spaces of the
+    field are ignored.
+*/
+static int column_name_matches(const char *field, const char *name)
+{
+    size_t len = strlen(field);
+    while (len > 0 && *(field + len - 1) == ' ')
+    {
+        len--;
+    }
+    return len == strlen(name) && strncasecmp(field, name, len) == 0;
+}
+
+
+int find_column(const struct record_schema *schema, const char *name)
+{
+    for (int i = 0; i < schema->col_cnt; i++)
+    {
+        if (column_name_matches(name, *(schema->col_names + i)))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+int map_header_columns(const struct record_schema *schema, char **fields,
+                       int field_cnt, int *col_map, int *missing)
+{
+    int header_map[SCHEMA_COLS_MAX];
+    int found = 0;
+    *missing = -1;
+    
+    for (int i = 0; i < schema->col_cnt; i++)
+    {
+        *(header_map + i) = -1;
+        for (int j = 0; j < field_cnt; j++)
+        {
+            if (column_name_matches(*(fields + j), *(schema->col_names + i)))
+            {
+                *(header_map + i) = j;
+                found++;
+                break;
+            }
+        }
+        if (*(header_map + i) < 0 && *missing < 0)
+        {
+            *missing = i;
+        }
+    }
+    
+    if (found == schema->col_cnt)
+    {
+        memcpy(col_map, header_map, sizeof(int) * (size_t)schema->col_cnt);
+        return HEADER_FOUND;
+    }
+    // A data line can match a column name by chance, a header matches most
+    if (found * 2 > schema->col_cnt)
+    {
+        return HEADER_MISSING_COL;
+    }
+    return HEADER_NONE;
+}
@@ -0,0 +1,273 @@
+/*
+File:         report.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Report of every product with its quotes. Quotes are grouped by
+              product once and the report is formatted on several threads.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <dictionary.h>
+#include <data_printing.h>
+#include <out_buf.h>
+#include <report.h>
+#include <trace.h>
+
+/*
+    Shared state of the report threads for one round. Every thread takes the
+    next chunk of products until all chunks of the round are taken.
+*/
+struct report_pool
+{
+    struct product_data_wrapper pdw;
+    struct quote_data_wrapper qdw;
+    struct quote_groups *qg;
+    struct out_buf *bufs;
+    size_t first_product;
+    int chunk_cnt;
+    atomic_int next;
+};
+
+
+int build_quote_groups(struct quote_data_wrapper qdw, struct quote_groups *qg)
+{
+    qg->group_cnt = dict_size(DICT_CODE, NULL);
+    qg->first = acct_calloc(ALLOC_INDEX, (size_t)qg->group_cnt + 1,
+                            sizeof(size_t));
+    qg->quotes = acct_malloc(ALLOC_INDEX, sizeof(size_t) * (qdw.lines + 1));
+    if (qg->first == NULL || qg->quotes == NULL)
+    {
+        free_quote_groups(qg);
+        return EXIT_FAILURE;
+    }
+    
+    // Count quotes of every code, then turn counts into group ends
+    for (size_t i = 0; i < qdw.lines; i++)
+    {
+        uint32_t code_id = (qdw.data + i)->code_id;
+        if (code_id < qg->group_cnt)
+        {
+            (*(qg->first + code_id + 1))++;
+        }
+    }
+    for (uint32_t c = 0; c < qg->group_cnt; c++)
+    {
+        *(qg->first + c + 1) += *(qg->first + c);
+    }
+    
+    // Filling moves every start to the next groups start, shifted back after
+    for (size_t i = 0; i < qdw.lines; i++)
+    {
+        uint32_t code_id = (qdw.data + i)->code_id;
+        if (code_id < qg->group_cnt)
+        {
+            *(qg->quotes + *(qg->first + code_id)) = i;
+            (*(qg->first + code_id))++;
+        }
+    }
+    for (uint32_t c = qg->group_cnt; c > 0; c--)
+    {
+        *(qg->first + c) = *(qg->first + c - 1);
+    }
+    *qg->first = 0;
+    return EXIT_SUCCESS;
+}
+
+
+size_t *get_quote_group(struct quote_groups *qg, uint32_t code_id,
+                        size_t *cnt)
+{
+    if (code_id >= qg->group_cnt)
+    {
+        *cnt = 0;
+        return NULL;
+    }
+    *cnt = *(qg->first + code_id + 1) - *(qg->first + code_id);
+    return *cnt > 0 ? qg->quotes + *(qg->first + code_id) : NULL;
+}
+
+
+void free_quote_groups(struct quote_groups *qg)
+{
+    acct_free(qg->first);
+    acct_free(qg->quotes);
+    qg->first = NULL;
+    qg->quotes = NULL;
+    qg->group_cnt = 0;
+}
+
+
+void print_product_report(struct out_buf *ob, struct product_data_wrapper pdw,
+                          struct quote_data_wrapper qdw,
+                          struct quote_groups *qg, size_t i)
+{
+    size_t cnt;
+    size_t *group = get_quote_group(qg, (pdw.data + i)->code_id, &cnt);
+    print_product_specs(ob, *(pdw.data + i));
+    
+    if (cnt > 0)
+    {
+        buf_printf(ob, "\nQuotes:\n");
+        /*
+            This column is not part of quote data printing. Therefore, to have
+            the printing align when using both functions elsewhere, it is also
+            not included in table head printing.
+        */
+        buf_printf(ob, "\t%3s ", "Nr.");
+        print_quote_table_head(ob);
+    }
+    for (size_t nr = 1; nr <= cnt; nr++)
+    {
+        buf_printf(ob, "\t%3zu ", nr);
+        print_product_quote(ob, *(qdw.data + *(group + nr - 1)));
+    }
+    
+    if (cnt == 0)
+    {
+        buf_printf(ob, "\nNo quotes for %s available.\n\n",
+                   (pdw.data + i)->p_name);
+    }
+    buf_putc(ob, '\n');
+    
+    if (i + 1 != pdw.lines)
+    {
+        print_separator_line(ob);
+    }
+}
+
+
+static void *report_worker(void *arg)
+{
+    struct report_pool *pool = arg;
+    int c;
+    
+    while ((c = atomic_fetch_add(&pool->next, 1)) < pool->chunk_cnt)
+    {
+        size_t start = pool->first_product +
+                       (size_t)c * REPORT_CHUNK_PRODUCTS;
+        size_t end = start + REPORT_CHUNK_PRODUCTS;
+        if (end > pool->pdw.lines)
+        {
+            end = pool->pdw.lines;
+        }
+        uint64_t span = trace_begin();
+        for (size_t i = start; i < end; i++)
+        {
+            print_product_report(pool->bufs + c, pool->pdw, pool->qdw,
+                                 pool->qg, i);
+        }
+        trace_end(span, TRACE_CAT_DISPLAY, "render products",
+                  (int64_t)(end - start));
+    }
+    return NULL;
+}
+
+
+static int get_report_thread_cnt(void)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_cnt < 1)
+    {
+        return 1;
+    }
+    return cpu_cnt < REPORT_THREADS_MAX ? (int)cpu_cnt : REPORT_THREADS_MAX;
+}
+
+
+int print_catalog_report(FILE *fp, struct product_data_wrapper pdw,
+                         struct quote_data_wrapper qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    struct quote_groups qg;
+    int thread_cnt = get_report_thread_cnt();
+    int round_chunks = thread_cnt * REPORT_CHUNKS_PER_THREAD;
+    struct out_buf *bufs = acct_malloc(ALLOC_OTHER, sizeof(struct out_buf) *
+                                       (size_t)round_chunks);
+    uint64_t span = trace_begin();
+    int grouped = bufs != NULL && build_quote_groups(qdw, &qg) ==
+                  EXIT_SUCCESS;
+    trace_end(span, TRACE_CAT_DISPLAY, "group quotes", (int64_t)qdw.lines);
+    if (!grouped)
+    {
+        acct_free(bufs);
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for the "
+                 "report of %zu products.", pdw.lines);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    for (int c = 0; c < round_chunks; c++)
+    {
+        out_buf_init(bufs + c);
+    }
+    
+    struct report_pool pool = {.pdw = pdw, .qdw = qdw, .qg = &qg,
+                               .bufs = bufs};
+    pthread_t threads[REPORT_THREADS_MAX];
+    int return_val = EXIT_SUCCESS;
+    size_t round_products = (size_t)round_chunks * REPORT_CHUNK_PRODUCTS;
+    for (size_t first = 0; first < pdw.lines && return_val == EXIT_SUCCESS;
+         first += round_products)
+    {
+        size_t left = pdw.lines - first;
+        pool.first_product = first;
+        pool.chunk_cnt = left >= round_products ? round_chunks :
+                         (int)((left + REPORT_CHUNK_PRODUCTS - 1) /
+                               REPORT_CHUNK_PRODUCTS);
+        atomic_init(&pool.next, 0);
+        
+        // The calling thread is one of the workers
+        int started = 0;
+        for (; started < thread_cnt - 1 && started < pool.chunk_cnt - 1;
+             started++)
+        {
+            if (pthread_create(threads + started, NULL, report_worker,
+                               &pool) != 0)
+            {
+                break;
+            }
+        }
+        report_worker(&pool);
+        for (int i = 0; i < started; i++)
+        {
+            pthread_join(*(threads + i), NULL);
+        }
+        
+        // Written in product order, so output does not depend on threads
+        span = trace_begin();
+        for (int c = 0; c < pool.chunk_cnt; c++)
+        {
+            if ((bufs + c)->err)
+            {
+                return_val = EXIT_FAILURE;
+                break;
+            }
+            out_buf_flush(bufs + c, fp);
+        }
+        trace_end(span, TRACE_CAT_DISPLAY, "write output", TRACE_NO_CNT);
+    }
+    
+    for (int c = 0; c < round_chunks; c++)
+    {
+        out_buf_free(bufs + c);
+    }
+    acct_free(bufs);
+    free_quote_groups(&qg);
+    
+    if (return_val == EXIT_FAILURE)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for the "
+                 "report of %zu products. Report is incomplete.", pdw.lines);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+    }
+    return return_val;
+}
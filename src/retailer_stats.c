@@ -0,0 +1,239 @@
+/*
+File:         retailer_stats.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Per retailer aggregates of quotes, computed in parallel partial
+              aggregates that are merged.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <dictionary.h>
+#include <out_buf.h>
+#include <retailer_stats.h>
+
+/*
+    Range of quotes aggregated by one thread into its own array.
+*/
+struct stats_job
+{
+    struct quote_data_wrapper qdw;
+    size_t first;
+    size_t last;
+    struct retailer_stats *partial;
+    uint32_t retailer_cnt;
+};
+
+
+static void init_stats(struct retailer_stats *stats, uint32_t cnt)
+{
+    for (uint32_t r = 0; r < cnt; r++)
+    {
+        (stats + r)->retailer_id = r;
+        (stats + r)->quotes = 0;
+        (stats + r)->stock = 0;
+        (stats + r)->in_stock = 0;
+        (stats + r)->price_sum = 0;
+        (stats + r)->min_price = INT64_MAX;
+        (stats + r)->max_price = INT64_MIN;
+    }
+}
+
+
+static void *aggregate_worker(void *arg)
+{
+    struct stats_job *job = arg;
+    for (size_t i = job->first; i < job->last; i++)
+    {
+        struct quote_info *qi = job->qdw.data + i;
+        if (qi->retailer_id >= job->retailer_cnt)
+        {
+            continue;
+        }
+        struct retailer_stats *rs = job->partial + qi->retailer_id;
+        rs->quotes++;
+        rs->stock += qi->stock;
+        rs->in_stock += qi->stock > 0;
+        rs->price_sum += qi->price;
+        if (qi->price < rs->min_price)
+        {
+            rs->min_price = qi->price;
+        }
+        if (qi->price > rs->max_price)
+        {
+            rs->max_price = qi->price;
+        }
+    }
+    return NULL;
+}
+
+
+static void merge_stats(struct retailer_stats *dest, struct retailer_stats *src,
+                        uint32_t cnt)
+{
+    for (uint32_t r = 0; r < cnt; r++)
+    {
+        (dest + r)->quotes += (src + r)->quotes;
+        (dest + r)->stock += (src + r)->stock;
+        (dest + r)->in_stock += (src + r)->in_stock;
+        (dest + r)->price_sum += (src + r)->price_sum;
+        if ((src + r)->min_price < (dest + r)->min_price)
+        {
+            (dest + r)->min_price = (src + r)->min_price;
+        }
+        if ((src + r)->max_price > (dest + r)->max_price)
+        {
+            (dest + r)->max_price = (src + r)->max_price;
+        }
+    }
+}
+
+
+static int compare_retailer_names(const void *a, const void *b)
+{
+    const struct retailer_stats *ra = a;
+    const struct retailer_stats *rb = b;
+    return strcmp(dict_string(DICT_RETAILER, ra->retailer_id),
+                  dict_string(DICT_RETAILER, rb->retailer_id));
+}
+
+
+static int get_stats_thread_cnt(size_t quote_cnt)
+{
+    long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_cnt = cpu_cnt < 1 ? 1 : (cpu_cnt < STATS_THREADS_MAX ?
+                                        (int)cpu_cnt : STATS_THREADS_MAX);
+    size_t useful = quote_cnt / STATS_MIN_QUOTES_PER_THREAD;
+    if (useful < (size_t)thread_cnt)
+    {
+        thread_cnt = useful < 1 ? 1 : (int)useful;
+    }
+    return thread_cnt;
+}
+
+
+int aggregate_retailers(struct quote_data_wrapper qdw,
+                        struct retailer_stats **stats, uint32_t *cnt)
+{
+    uint32_t retailer_cnt = dict_size(DICT_RETAILER, NULL);
+    int thread_cnt = get_stats_thread_cnt(qdw.lines);
+    size_t partial_cnt = (size_t)thread_cnt * ((size_t)retailer_cnt + 1);
+    struct retailer_stats *partials =
+        acct_malloc(ALLOC_OTHER, sizeof(struct retailer_stats) * partial_cnt);
+    if (partials == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    struct stats_job jobs[STATS_THREADS_MAX];
+    pthread_t threads[STATS_THREADS_MAX];
+    size_t per_thread = qdw.lines / (size_t)thread_cnt;
+    for (int t = 0; t < thread_cnt; t++)
+    {
+        (jobs + t)->qdw = qdw;
+        (jobs + t)->first = (size_t)t * per_thread;
+        (jobs + t)->last = t == thread_cnt - 1 ? qdw.lines
+                                               : (size_t)(t + 1) * per_thread;
+        (jobs + t)->partial = partials + (size_t)t * retailer_cnt;
+        (jobs + t)->retailer_cnt = retailer_cnt;
+        init_stats((jobs + t)->partial, retailer_cnt);
+    }
+    
+    // Job 0 runs on the calling thread, also covers failing to start threads
+    int started = 1;
+    for (; started < thread_cnt; started++)
+    {
+        if (pthread_create(threads + started, NULL, aggregate_worker,
+                           jobs + started) != 0)
+        {
+            break;
+        }
+    }
+    aggregate_worker(jobs);
+    for (int t = 1; t < thread_cnt; t++)
+    {
+        if (t < started)
+        {
+            pthread_join(*(threads + t), NULL);
+        }
+        else
+        {
+            aggregate_worker(jobs + t);
+        }
+        merge_stats(partials, (jobs + t)->partial, retailer_cnt);
+    }
+    
+    // Only retailers with quotes are reported, packed to the start
+    uint32_t used = 0;
+    for (uint32_t r = 0; r < retailer_cnt; r++)
+    {
+        if ((partials + r)->quotes > 0)
+        {
+            *(partials + used) = *(partials + r);
+            used++;
+        }
+    }
+    qsort(partials, used, sizeof(struct retailer_stats),
+          compare_retailer_names);
+    *stats = partials;
+    *cnt = used;
+    return EXIT_SUCCESS;
+}
+
+
+void print_retailer_report(struct out_buf *ob, struct retailer_stats *stats,
+                           uint32_t cnt)
+{
+    buf_printf(ob, "%-14s | %6s | %7s | %8s | %9s | %9s | %9s\n", "Retailer",
+               "Quotes", "Stock", "In stock", "Min EUR", "Avg EUR", "Max EUR");
+    for (uint32_t r = 0; r < cnt; r++)
+    {
+        struct retailer_stats *rs = stats + r;
+        double avg = (double)rs->price_sum / (double)rs->quotes;
+        buf_printf(ob, "%-14s | %6lld | %7lld | %7.1f%% | %9.2f | %9.2f | "
+                   "%9.2f\n", dict_string(DICT_RETAILER, rs->retailer_id),
+                   (long long)rs->quotes, (long long)rs->stock,
+                   100.0 * (double)rs->in_stock / (double)rs->quotes,
+                   CNTS_TO_EUR((double)rs->min_price), avg / 100.0,
+                   CNTS_TO_EUR((double)rs->max_price));
+    }
+}
+
+
+int show_retailer_report(struct quote_data_wrapper qdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    struct retailer_stats *stats;
+    uint32_t cnt;
+    if (aggregate_retailers(qdw, &stats, &cnt) == EXIT_FAILURE)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Unable to allocate memory for the "
+                 "retailer report of %zu quotes.", qdw.lines);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    
+    struct out_buf ob = OUT_BUF_FILE(stdout);
+    if (cnt == 0)
+    {
+        printf("No quotes available.\n");
+    }
+    else
+    {
+        print_retailer_report(&ob, stats, cnt);
+    }
+    acct_free(stats);
+    snprintf(msg, MAX_ERR_MSG_LEN, "Displayed report of %u retailer(s) from "
+             "%zu quote(s).", cnt, qdw.lines);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+/*
+File:         trace.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Opt-in tracing of loading, display and saving. Every thread
+              records its spans into its own buffer, they are written as one
+              Chrome trace event JSON file at exit.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <main.h>
+#include <data_read_write.h>
+#include <latency.h>
+#include <trace.h>
+
+static int enabled = 0;
+static uint64_t base_time = 0;
+static FILE *trace_file = NULL;
+static char *trace_name = NULL;
+
+// Buffers of all threads, that have recorded spans
+static struct trace_buf *bufs = NULL;
+static pthread_mutex_t bufs_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local struct trace_buf *own = NULL;
+
+/*
+    Creates the buffer of the calling thread. Returns NULL on allocation error.
+*/
+static struct trace_buf *own_buffer(void)
+{
+    own = acct_calloc(ALLOC_OTHER, 1, sizeof(struct trace_buf));
+    if (own == NULL)
+    {
+        return NULL;
+    }
+    own->tid = (pid_t)syscall(SYS_gettid);
+    pthread_mutex_lock(&bufs_lock);
+    own->next = bufs;
+    bufs = own;
+    pthread_mutex_unlock(&bufs_lock);
+    return own;
+}
+
+
+uint64_t trace_begin(void)
+{
+    return enabled ? latency_now() : 0;
+}
+
+
+void trace_end(uint64_t start, const char *cat, const char *name, int64_t cnt)
+{
+    if (start == 0)
+    {
+        return;
+    }
+    uint64_t end = latency_now();
+    struct trace_buf *tb = own != NULL ? own : own_buffer();
+    if (tb == NULL)
+    {
+        return;
+    }
+    
+    // Allocate memory if necessary
+    if (tb->cnt >= tb->alloc_limit)
+    {
+        size_t new_limit = acct_grow_limit(tb->alloc_limit, TRACE_MIN_ALLOC,
+                                           sizeof(struct trace_event));
+        struct trace_event *temp = new_limit == 0 ? NULL :
+                                   acct_realloc(ALLOC_OTHER, tb->events,
+                                                sizeof(struct trace_event) *
+                                                new_limit);
+        if (temp == NULL)
+        {
+            tb->dropped++;
+            return;
+        }
+        tb->events = temp;
+        tb->alloc_limit = new_limit;
+        acct_set_unused(tb->events, sizeof(struct trace_event) *
+                                    (new_limit - tb->cnt));
+    }
+    *(tb->events + tb->cnt) = (struct trace_event){cat, name, start,
+                                                   end - start, cnt};
+    tb->cnt++;
+}
+
+
+static void print_event(FILE *fp, pid_t pid, pid_t tid, struct trace_event *te)
+{
+    fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,"
+            "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", te->name, te->cat, (int)pid,
+            (int)tid, (double)(te->start - base_time) / TRACE_NS_PER_US,
+            (double)te->dur / TRACE_NS_PER_US);
+    if (te->cnt != TRACE_NO_CNT)
+    {
+        fprintf(fp, ",\"args\":{\"count\":%lld}", (long long)te->cnt);
+    }
+    fputc('}', fp);
+}
+
+
+/*
+    Writes the spans of all threads and frees their buffers. Runs at exit,
+    when other threads have been joined.
+*/
+static void write_trace(void)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    pid_t pid = getpid();
+    size_t events = 0;
+    size_t dropped = 0;
+    enabled = 0;
+    
+    // Thread names come first, Perfetto names the tracks by them
+    fprintf(trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":"
+            "{\"name\":\"price_watch\"}}", (int)pid);
+    for (struct trace_buf *tb = bufs; tb != NULL; tb = tb->next)
+    {
+        fprintf(trace_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\","
+                "\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", (int)pid,
+                (int)tb->tid, tb->tid == pid ? "main" : "worker");
+    }
+    while (bufs != NULL)
+    {
+        struct trace_buf *tb = bufs;
+        for (size_t i = 0; i < tb->cnt; i++)
+        {
+            print_event(trace_file, pid, tb->tid, tb->events + i);
+        }
+        events += tb->cnt;
+        dropped += tb->dropped;
+        bufs = tb->next;
+        acct_free(tb->events);
+        acct_free(tb);
+    }
+    fprintf(trace_file, "\n]}\n");
+    
+    if (fclose(trace_file) != 0)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Writing trace file \"%s\" failed.",
+                 trace_name);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+    }
+    else
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Wrote %zu span(s) to trace file "
+                 "\"%s\", %zu dropped.", events, trace_name, dropped);
+        write_log(INFO, msg);
+    }
+    trace_file = NULL;
+    acct_free(trace_name);
+    trace_name = NULL;
+}
+
+
+int trace_open(char *f_name)
+{
+    // Name is kept for messages at exit, after arguments are gone
+    trace_name = acct_malloc(ALLOC_OTHER, strlen(f_name) + 1);
+    if (trace_name == NULL)
+    {
+        write_log(ERROR, "Unable to allocate memory for tracing.");
+        fprintf(stderr, "Unable to allocate memory for tracing.\n");
+        return EXIT_FAILURE;
+    }
+    strcpy(trace_name, f_name);
+    trace_file = open_file(f_name, "w");
+    if (trace_file == NULL)
+    {
+        acct_free(trace_name);
+        trace_name = NULL;
+        return EXIT_FAILURE;
+    }
+    base_time = latency_now();
+    enabled = 1;
+    atexit(write_trace);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,681 @@
+/*
+File:         watch_rules.c
+Author:       Anton Jaska
+Created:      2026.10.19
+Modified:     2026.10.19
+Description:  Price watch rules and alerts. Rules are indexed by product, when
+              quotes change only the rules of the changed products are
+              checked.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <alloc_acct.h>
+#include <log_handler.h>
+#include <csv_helper.h>
+#include <hash_index.h>
+#include <main.h>
+#include <data_stream.h>
+#include <data_read_write.h>
+#include <dictionary.h>
+#include <catalog.h>
+#include <report.h>
+#include <latency.h>
+#include <watch_rules.h>
+
+static struct watch_rules rules;
+static int enabled = 0;
+
+int watch_enabled(void)
+{
+    return enabled;
+}
+
+
+static void print_rule_error(char *f_name, size_t line, const char *field_name,
+                             const char *value)
+{
+    char err_msg[MAX_ERR_MSG_LEN];
+    snprintf(err_msg, MAX_ERR_MSG_LEN, "Watch rule %s \"%s\" at line: %zu in "
+             "file \"%s\" is not valid. Rule will not be used.", field_name,
+             value, line, f_name);
+    write_log(ERROR, err_msg);
+    fprintf(stderr, "%s\n", err_msg);
+}
+
+
+/*
+    Parses a rule line. Strings of the rule point into buf. Returns NULL if the
+    rule is valid, else the name of the first invalid field, whose value is
+    stored in *p_value.
+*/
+static const char *parse_rule(char *buf, struct watch_rule *wr,
+                              const char **p_value)
+{
+    char *fields[CSV_WATCH_FIELD_CNT];
+    int cnt = split_fields(buf, fields, CSV_WATCH_FIELD_CNT);
+    *p_value = cnt > 0 ? *fields : "";
+    
+    char *p_kind = *(fields + CSV_WATCH_FIELD_KIND - 1);
+    if (cnt < CSV_WATCH_FIELD_PRICE || *(p_kind + 1) != '\0' ||
+        (*p_kind != WATCH_BY_CODE && *p_kind != WATCH_BY_NAME))
+    {
+        return "kind";
+    }
+    wr->by_name = *p_kind == WATCH_BY_NAME;
+    
+    wr->target = *(fields + CSV_WATCH_FIELD_TARGET - 1);
+    if (*wr->target == '\0')
+    {
+        *p_value = wr->target;
+        return wr->by_name ? "product name" : "product code";
+    }
+    
+    char *p_field = *(fields + CSV_WATCH_FIELD_PRICE - 1);
+    char *end;
+    errno = 0;
+    long long price = strtoll(p_field, &end, 10);
+    if (end == p_field || *end != '\0' || errno == ERANGE || price < 0)
+    {
+        *p_value = p_field;
+        return "price";
+    }
+    wr->max_price = (int64_t)price;
+    
+    wr->retailer = NULL;
+    if (cnt >= CSV_WATCH_FIELD_RTLR &&
+        **(fields + CSV_WATCH_FIELD_RTLR - 1) != '\0')
+    {
+        wr->retailer = *(fields + CSV_WATCH_FIELD_RTLR - 1);
+    }
+    
+    wr->min_stock = WATCH_DEFAULT_MIN_STOCK;
+    p_field = cnt >= CSV_WATCH_FIELD_STOCK ?
+              *(fields + CSV_WATCH_FIELD_STOCK - 1) : "";
+    if (*p_field != '\0' &&
+        (sscanf(p_field, "%d", &wr->min_stock) != 1 || wr->min_stock < 0))
+    {
+        *p_value = p_field;
+        return "stock";
+    }
+    return NULL;
+}
+
+
+/*
+    Adds a parsed rule, its strings are copied. The rule becomes the first of
+    the chain of its target.
+*/
+static int add_rule(struct watch_rule wr)
+{
+    if (rules.rule_cnt >= rules.alloc_limit)
+    {
+        size_t new_limit = acct_grow_limit(rules.alloc_limit, WATCH_MIN_ALLOC,
+                                           sizeof(struct watch_rule));
+        struct watch_rule *temp = new_limit == 0 ? NULL :
+                                  acct_realloc(ALLOC_OTHER, rules.rules,
+                                               sizeof(struct watch_rule) *
+                                               new_limit);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        rules.rules = temp;
+        rules.alloc_limit = new_limit;
+    }
+    
+    wr.target = dynamic_string(wr.target, ALLOC_OTHER);
+    if (wr.target == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    if (wr.retailer != NULL)
+    {
+        wr.retailer = dynamic_string(wr.retailer, ALLOC_OTHER);
+        if (wr.retailer == NULL)
+        {
+            acct_free(wr.target);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    struct hash_index *hi = wr.by_name ? &rules.by_name : &rules.by_code;
+    int64_t idx = (int64_t)rules.rule_cnt;
+    wr.next = hash_index_get(hi, wr.target);
+    wr.alerts = NULL;
+    wr.alert_cnt = 0;
+    wr.alert_limit = 0;
+    *(rules.rules + idx) = wr;
+    if (hash_index_put(hi, wr.target, idx) != HASH_OK)
+    {
+        acct_free(wr.target);
+        acct_free(wr.retailer);
+        return EXIT_FAILURE;
+    }
+    rules.rule_cnt++;
+    return EXIT_SUCCESS;
+}
+
+
+int watch_mark_code(uint32_t code_id)
+{
+    if (!enabled || (code_id < rules.marked_len &&
+                     *(rules.marked + code_id)))
+    {
+        return EXIT_SUCCESS;
+    }
+    
+    if (code_id >= rules.marked_len)
+    {
+        size_t new_len = acct_grow_limit(rules.marked_len,
+                                         WATCH_CHANGED_MIN_ALLOC, 1);
+        if (new_len <= code_id)
+        {
+            new_len = (size_t)code_id + 1;
+        }
+        uint8_t *temp = acct_realloc(ALLOC_OTHER, rules.marked, new_len);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        memset(temp + rules.marked_len, 0, new_len - rules.marked_len);
+        rules.marked = temp;
+        rules.marked_len = new_len;
+    }
+    
+    if (rules.changed_cnt >= rules.changed_limit)
+    {
+        size_t new_limit = acct_grow_limit(rules.changed_limit,
+                                           WATCH_CHANGED_MIN_ALLOC,
+                                           sizeof(uint32_t));
+        uint32_t *temp = new_limit == 0 ? NULL :
+                         acct_realloc(ALLOC_OTHER, rules.changed,
+                                      sizeof(uint32_t) * new_limit);
+        if (temp == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        rules.changed = temp;
+        rules.changed_limit = new_limit;
+    }
+    *(rules.changed + rules.changed_cnt++) = code_id;
+    *(rules.marked + code_id) = 1;
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Marks the products a rule watches. A code is found in the code dictionary,
+    a name is looked up in every product.
+*/
+static int mark_rule_products(struct watch_rule *wr,
+                              struct product_data_wrapper pdw)
+{
+    if (!wr->by_name)
+    {
+        uint32_t code_id = dict_find(DICT_CODE, wr->target);
+        return code_id == DICT_NO_ID ? EXIT_SUCCESS : watch_mark_code(code_id);
+    }
+    for (size_t i = 0; i < pdw.lines; i++)
+    {
+        struct product_info *pi = pdw.data + i;
+        if (strcmp(pi->p_name, wr->target) == 0 &&
+            watch_mark_code(pi->code_id) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Marks the products of all rules with one pass over the rules and, if there
+    are rules by name, one pass over the products.
+*/
+static int mark_all_rules(struct product_data_wrapper pdw)
+{
+    for (size_t i = 0; i < rules.rule_cnt; i++)
+    {
+        struct watch_rule *wr = rules.rules + i;
+        if (!wr->by_name && mark_rule_products(wr, pdw) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (rules.by_name.count == 0)
+    {
+        return EXIT_SUCCESS;
+    }
+    for (size_t i = 0; i < pdw.lines; i++)
+    {
+        struct product_info *pi = pdw.data + i;
+        if (hash_index_get(&rules.by_name, pi->p_name) != HASH_NOT_FOUND &&
+            watch_mark_code(pi->code_id) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static int read_rules(char *f_name)
+{
+    char *line_buffer;
+    const char *value;
+    
+    // Rules are added from the menu to a file, that does not exist yet
+    if (access(f_name, F_OK) != 0 && errno == ENOENT)
+    {
+        char msg[MAX_ERR_MSG_LEN];
+        snprintf(msg, MAX_ERR_MSG_LEN, "Watch rules file \"%s\" does not "
+                 "exist, starting with no rules.", f_name);
+        write_log(INFO, msg);
+        return EXIT_SUCCESS;
+    }
+    
+    FILE *p_file = open_data_file(f_name);
+    if (p_file == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    
+    int return_val;
+    while (1)
+    {
+        return_val = read_line(p_file, &line_buffer);
+        if (return_val == EOF)
+        {
+            break;
+        }
+        else if (return_val == CSV_MALLOC_ERR || return_val == CSV_READ_ERR)
+        {
+            close_data_file(p_file);
+            return EXIT_FAILURE;
+        }
+        rules.line_cnt++;
+        
+        struct watch_rule wr;
+        const char *field_name = parse_rule(line_buffer, &wr, &value);
+        if (field_name != NULL)
+        {
+            print_rule_error(f_name, rules.line_cnt, field_name, value);
+            continue;
+        }
+        wr.line = rules.line_cnt;
+        if (add_rule(wr) == EXIT_FAILURE)
+        {
+            print_read_error(READ_ERR_STR_MALLOC, f_name, rules.line_cnt);
+            close_data_file(p_file);
+            free_buffer_manually();
+            return EXIT_FAILURE;
+        }
+    }
+    if (close_data_file(p_file) != STREAM_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int watch_load(char *f_rules, char *f_alerts, struct product_data_wrapper pdw)
+{
+    char msg[MAX_ERR_MSG_LEN];
+    memset(&rules, 0, sizeof(struct watch_rules));
+    
+    rules.f_rules = dynamic_string(f_rules, ALLOC_OTHER);
+    rules.f_alerts = dynamic_string(*f_alerts == '\0' ? WATCH_STDOUT : f_alerts,
+                                    ALLOC_OTHER);
+    if (rules.f_rules == NULL || rules.f_alerts == NULL ||
+        hash_index_init(&rules.by_code, 0) != HASH_OK ||
+        hash_index_init(&rules.by_name, 0) != HASH_OK)
+    {
+        write_log(ERROR, "Unable to allocate memory for watch rules.");
+        fprintf(stderr, "Unable to allocate memory for watch rules.\n");
+        watch_free();
+        return EXIT_FAILURE;
+    }
+    
+    if (read_rules(f_rules) == EXIT_FAILURE)
+    {
+        watch_free();
+        return EXIT_FAILURE;
+    }
+    
+    rules.alerts = strcmp(rules.f_alerts, WATCH_STDOUT) == 0 ? stdout :
+                   open_file(rules.f_alerts, "a");
+    if (rules.alerts == NULL)
+    {
+        watch_free();
+        return EXIT_FAILURE;
+    }
+    
+    enabled = 1;
+    if (mark_all_rules(pdw) == EXIT_FAILURE)
+    {
+        write_log(ERROR, "Unable to allocate memory for watch rules.");
+        fprintf(stderr, "Unable to allocate memory for watch rules.\n");
+        watch_free();
+        return EXIT_FAILURE;
+    }
+    
+    snprintf(msg, MAX_ERR_MSG_LEN, "Loaded %zu watch rule(s) from \"%s\" "
+             "(%zu by code, %zu by name).", rules.rule_cnt, f_rules,
+             rules.by_code.count, rules.by_name.count);
+    write_log(INFO, msg);
+    return EXIT_SUCCESS;
+}
+
+
+static void write_alert(struct watch_rule *wr, const char *name,
+                        struct quote_info *qi)
+{
+    fprintf(rules.alerts, "%zu%c", wr->line, CSV_DELIMITER);
+    print_csv_field(rules.alerts, dict_string(DICT_CODE, qi->code_id));
+    fputc(CSV_DELIMITER, rules.alerts);
+    print_csv_field(rules.alerts, name);
+    fputc(CSV_DELIMITER, rules.alerts);
+    print_csv_field(rules.alerts, qi->p_id);
+    fputc(CSV_DELIMITER, rules.alerts);
+    print_csv_field(rules.alerts, dict_string(DICT_RETAILER, qi->retailer_id));
+    fprintf(rules.alerts, "%c%lld%c%d\n", CSV_DELIMITER, (long long)qi->price,
+            CSV_DELIMITER, qi->stock);
+}
+
+
+/*
+    Finds the last alert of a rule for a product. Rules by code have at most
+    one, rules by name one for every product with the name.
+*/
+static struct watch_alert *find_alert(struct watch_rule *wr, uint32_t code_id)
+{
+    for (size_t i = 0; i < wr->alert_cnt; i++)
+    {
+        if ((wr->alerts + i)->code_id == code_id)
+        {
+            return wr->alerts + i;
+        }
+    }
+    return NULL;
+}
+
+
+static struct watch_alert *add_alert(struct watch_rule *wr, uint32_t code_id)
+{
+    if (wr->alert_cnt >= wr->alert_limit)
+    {
+        size_t new_limit = acct_grow_limit(wr->alert_limit,
+                                           WATCH_ALERTS_MIN_ALLOC,
+                                           sizeof(struct watch_alert));
+        struct watch_alert *temp = new_limit == 0 ? NULL :
+                                   acct_realloc(ALLOC_OTHER, wr->alerts,
+                                                sizeof(struct watch_alert) *
+                                                new_limit);
+        if (temp == NULL)
+        {
+            return NULL;
+        }
+        wr->alerts = temp;
+        wr->alert_limit = new_limit;
+    }
+    struct watch_alert *wa = wr->alerts + wr->alert_cnt++;
+    wa->code_id = code_id;
+    return wa;
+}
+
+
+/*
+    Finds the cheapest quote matching a rule among the quotes of one product.
+    Equal prices keep the first quote. Returns 1 if an alert was written, -1
+    on memory allocation error.
+*/
+static int check_rule(struct watch_rule *wr, uint32_t code_id,
+                      const char *name, struct quote_data_wrapper qdw,
+                      size_t *quotes, size_t cnt)
+{
+    uint32_t retailer_id = DICT_NO_ID;
+    if (wr->retailer != NULL)
+    {
+        retailer_id = dict_find(DICT_RETAILER, wr->retailer);
+        cnt = retailer_id == DICT_NO_ID ? 0 : cnt;
+    }
+    
+    struct quote_info *best = NULL;
+    for (size_t k = 0; k < cnt; k++)
+    {
+        struct quote_info *qi = qdw.data + *(quotes + k);
+        if (qi->price > wr->max_price || qi->stock < wr->min_stock ||
+            (wr->retailer != NULL && qi->retailer_id != retailer_id))
+        {
+            continue;
+        }
+        if (best == NULL || qi->price < best->price)
+        {
+            best = qi;
+        }
+    }
+    
+    struct watch_alert *wa = find_alert(wr, code_id);
+    if (best == NULL)
+    {
+        // Offer is gone, the next matching one is reported again
+        if (wa != NULL)
+        {
+            *wa = *(wr->alerts + wr->alert_cnt - 1);
+            wr->alert_cnt--;
+        }
+        return 0;
+    }
+    if (wa != NULL && wa->price == best->price &&
+        wa->retailer_id == best->retailer_id)
+    {
+        return 0;
+    }
+    if (wa == NULL && (wa = add_alert(wr, code_id)) == NULL)
+    {
+        return -1;
+    }
+    wa->price = best->price;
+    wa->retailer_id = best->retailer_id;
+    write_alert(wr, name, best);
+    return 1;
+}
+
+
+int watch_check_changes(void)
+{
+    if (!enabled || rules.changed_cnt == 0)
+    {
+        return EXIT_SUCCESS;
+    }
+    
+    struct latency_span span;
+    latency_begin(&span);
+    char msg[MAX_ERR_MSG_LEN];
+    size_t products = rules.changed_cnt;
+    size_t checked = 0;
+    size_t alerts = 0;
+    int return_val = EXIT_SUCCESS;
+    struct quote_groups *groups = NULL;
+    struct catalog_version *cv = catalog_read_begin();
+    for (size_t i = 0; i < rules.changed_cnt; i++)
+    {
+        uint32_t code_id = *(rules.changed + i);
+        *(rules.marked + code_id) = 0;
+        if (return_val == EXIT_FAILURE)
+        {
+            continue;
+        }
+        
+        const char *code = dict_string(DICT_CODE, code_id);
+        int64_t p = hash_index_get(&cv->products.code_index, code);
+        const char *name = p == HASH_NOT_FOUND ? "" :
+                           (cv->products.data + p)->p_name;
+        int64_t first[2] = {hash_index_get(&rules.by_code, code),
+                            p == HASH_NOT_FOUND ? HASH_NOT_FOUND :
+                            hash_index_get(&rules.by_name, name)};
+        if (*first == HASH_NOT_FOUND && *(first + 1) == HASH_NOT_FOUND)
+        {
+            continue;
+        }
+        
+        // Quotes are grouped only, when a changed product has rules
+        if (groups == NULL && (groups = catalog_quote_groups(cv)) == NULL)
+        {
+            return_val = EXIT_FAILURE;
+            continue;
+        }
+        size_t cnt;
+        size_t *quotes = get_quote_group(groups, code_id, &cnt);
+        for (int k = 0; k < 2 && return_val == EXIT_SUCCESS; k++)
+        {
+            for (int64_t r = *(first + k); r != HASH_NOT_FOUND;
+                 r = (rules.rules + r)->next)
+            {
+                int res = check_rule(rules.rules + r, code_id, name,
+                                     cv->quotes, quotes, cnt);
+                if (res < 0)
+                {
+                    return_val = EXIT_FAILURE;
+                    break;
+                }
+                alerts += (size_t)res;
+                checked++;
+            }
+        }
+    }
+    catalog_read_end();
+    rules.changed_cnt = 0;
+    
+    if (return_val == EXIT_FAILURE)
+    {
+        write_log(ERROR, "Unable to allocate memory for checking watch rules.");
+        fprintf(stderr, "Unable to allocate memory for checking watch "
+                "rules.\n");
+        return EXIT_FAILURE;
+    }
+    if (fflush(rules.alerts) != 0)
+    {
+        snprintf(msg, MAX_ERR_MSG_LEN, "Writing alerts to \"%s\" failed.",
+                 rules.f_alerts);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+    }
+    snprintf(msg, MAX_ERR_MSG_LEN, "Checked %zu watch rule(s) of %zu changed "
+             "product(s), %zu alert(s).", checked, products, alerts);
+    write_log(INFO, msg);
+    latency_end(&span, LAT_WATCH_CHECK);
+    return EXIT_SUCCESS;
+}
+
+
+/*
+    Appends a rule to the rules file, fields are written like saved data.
+*/
+static int save_rule(struct watch_rule *wr)
+{
+    FILE *p_file = open_file(rules.f_rules, "a");
+    if (p_file == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    fprintf(p_file, "%c%c", wr->by_name ? WATCH_BY_NAME : WATCH_BY_CODE,
+            CSV_DELIMITER);
+    print_csv_field(p_file, wr->target);
+    fprintf(p_file, "%c%lld%c", CSV_DELIMITER, (long long)wr->max_price,
+            CSV_DELIMITER);
+    print_csv_field(p_file, wr->retailer == NULL ? "" : wr->retailer);
+    fprintf(p_file, "%c%d\n", CSV_DELIMITER, wr->min_stock);
+    if (fclose(p_file) != 0)
+    {
+        char msg[MAX_ERR_MSG_LEN];
+        snprintf(msg, MAX_ERR_MSG_LEN, "Writing watch rules file \"%s\" "
+                 "failed.", rules.f_rules);
+        write_log(ERROR, msg);
+        fprintf(stderr, "%s\n", msg);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int watch_add_rule_prompt(void)
+{
+    printf("Enter watch rule: C; <code>; <max price in cents>; [retailer]; "
+           "[min stock]\nor N; <name>; ... for a product name.\n> ");
+           
+    char *input = get_dynamic_input_string(stdin);
+    if (input == NULL)
+    {
+        return EDIT_MALLOC;
+    }
+    
+    struct watch_rule wr;
+    const char *value;
+    const char *field_name = parse_rule(input, &wr, &value);
+    if (field_name != NULL)
+    {
+        printf("Watch rule %s \"%s\" is not valid.\n\n", field_name, value);
+        acct_free(input);
+        return EDIT_NO_MATCH;
+    }
+    if (save_rule(&wr) == EXIT_FAILURE)
+    {
+        printf("Watch rule was not saved.\n\n");
+        acct_free(input);
+        return EDIT_NO_MATCH;
+    }
+    wr.line = ++rules.line_cnt;
+    if (add_rule(wr) == EXIT_FAILURE)
+    {
+        acct_free(input);
+        return EDIT_MALLOC;
+    }
+    acct_free(input);
+    
+    struct watch_rule *added = rules.rules + rules.rule_cnt - 1;
+    struct catalog_version *cv = catalog_read_begin();
+    int return_val = mark_rule_products(added, cv->products);
+    catalog_read_end();
+    if (return_val == EXIT_FAILURE || watch_check_changes() == EXIT_FAILURE)
+    {
+        return EDIT_MALLOC;
+    }
+    
+    char msg[MAX_ERR_MSG_LEN];
+    snprintf(msg, MAX_ERR_MSG_LEN, "Added watch rule for product %s \"%s\" at "
+             "line %zu of \"%s\".", added->by_name ? "name" : "code",
+             added->target, added->line, rules.f_rules);
+    write_log(INFO, msg);
+    printf("%s\n\n", msg);
+    return EDIT_OK;
+}
+
+
+void watch_free(void)
+{
+    for (size_t i = 0; i < rules.rule_cnt; i++)
+    {
+        acct_free((rules.rules + i)->target);
+        acct_free((rules.rules + i)->retailer);
+        acct_free((rules.rules + i)->alerts);
+    }
+    acct_free(rules.rules);
+    hash_index_free(&rules.by_code);
+    hash_index_free(&rules.by_name);
+    acct_free(rules.marked);
+    acct_free(rules.changed);
+    if (rules.alerts != NULL && rules.alerts != stdout)
+    {
+        fclose(rules.alerts);
+    }
+    acct_free(rules.f_rules);
+    acct_free(rules.f_alerts);
+    memset(&rules, 0, sizeof(struct watch_rules));
+    enabled = 0;
+}
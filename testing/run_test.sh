@@ -12,6 +12,8 @@
 # Make sure the following files in ./ have the following permissions
 #	rm_last_endline.out	rwx
 
+# Trace file test checks the JSON with python3 (python3 -m json.tool)
+
 TEST_NUM=0
 
 print_success()
@@ -208,3 +210,294 @@ print_success $? "(Read line realloc error)"
 cd $BIN_DIR
 make fclean all &> /dev/null
 cd testing/
+
+
+# Tests 15- use regular build
+
+# Test 15 - Quotes from several files and a directory
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+DIR_QTE="$TEST_FILE_DIR""quote_shards"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $DIR_QTE "$TEST_FILE_DIR""quotes.csv" \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Quotes from several files)"
+
+
+# Test 16 - gzip compressed quotes file
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""compressed_quotes.csv.gz"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Compressed quotes file)"
+
+
+# Test 17 - Apply quote changes file (changes are saved to a copy)
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes_copy.csv"
+FILE_DELTA="$TEST_FILE_DIR""quote_changes.csv"
+
+cp "$TEST_FILE_DIR""quotes.csv" $FILE_QTE
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --delta_quotes $FILE_DELTA \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Apply quote changes file)"
+rm -f $FILE_QTE
+
+
+# Test 18 - Bulk edit products (changes are saved to a copy)
+FILE_PRO="$TEST_FILE_DIR""products_copy.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes.csv"
+FILE_BULK="$TEST_FILE_DIR""product_bulk_edit.csv"
+
+cp "$TEST_FILE_DIR""more_products.csv" $FILE_PRO
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --bulk_edit_products $FILE_BULK \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Bulk edit products)"
+rm -f $FILE_PRO
+
+
+# Test 19 - Data files with header rows (reordered and unknown columns),
+# edits are saved in the layout of the header
+FILE_PRO="$TEST_FILE_DIR""products_copy.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes_copy.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""header_edit_input"
+
+cp "$TEST_FILE_DIR""header_products.csv" $FILE_PRO
+cp "$TEST_FILE_DIR""header_quotes.csv" $FILE_QTE
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+RETURN_VAL=$?
+cmp -s $FILE_PRO "$TEST_FILE_DIR""header_products_expected.csv" || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+cmp -s $FILE_QTE "$TEST_FILE_DIR""header_quotes_expected.csv" || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Header rows)"
+rm -f $FILE_PRO $FILE_QTE
+
+
+# Test 20 - Quoted fields with delimiters and quotes (saved to copies)
+FILE_PRO="$TEST_FILE_DIR""products_copy.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes_copy.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+cp "$TEST_FILE_DIR""quoted_products.csv" $FILE_PRO
+cp "$TEST_FILE_DIR""quoted_quotes.csv" $FILE_QTE
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Quoted fields)"
+rm -f $FILE_PRO $FILE_QTE
+
+
+# Test 21 - Browse data by pages
+FILE_PRO="$TEST_FILE_DIR""more_products.csv"
+FILE_QTE="$TEST_FILE_DIR""more_quotes.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""browse_pages_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Browse data by pages)"
+
+
+# Test 22 - Export products with quotes as JSON
+FILE_PRO="$TEST_FILE_DIR""quoted_products.csv"
+FILE_QTE="$TEST_FILE_DIR""quoted_quotes.csv"
+FILE_EXPORT="$TEST_FILE_DIR""export.json"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+--export_json $FILE_EXPORT --export_format json &> /dev/null
+print_success $? "(JSON export)"
+rm -f $FILE_EXPORT
+
+
+# Test 23 - Retailer report
+FILE_PRO="$TEST_FILE_DIR""more_products.csv"
+FILE_QTE="$TEST_FILE_DIR""more_quotes.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""retailer_report_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Retailer report)"
+
+
+# Test 24 - Fuzzy product search
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""fuzzy_search_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Fuzzy product search)"
+
+
+# Test 25 - Queries
+FILE_PRO="$TEST_FILE_DIR""more_products.csv"
+FILE_QTE="$TEST_FILE_DIR""more_quotes.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""query_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+< $FILE_USER_INPUT &> /dev/null
+print_success $? "(Queries)"
+
+
+# Test 26 - Watch rules and alerts (rules and quotes are copies)
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes_copy.csv"
+FILE_WATCH="$TEST_FILE_DIR""watch_rules_copy.csv"
+FILE_ALERTS="$TEST_FILE_DIR""alerts.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""watch_rules_input"
+
+cp "$TEST_FILE_DIR""quotes.csv" $FILE_QTE
+cp "$TEST_FILE_DIR""watch_rules.csv" $FILE_WATCH
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --watch_rules $FILE_WATCH \
+--alerts_file $FILE_ALERTS < $FILE_USER_INPUT &> /dev/null
+print_success $? "(Watch rules and alerts)"
+rm -f $FILE_QTE $FILE_WATCH $FILE_ALERTS
+
+
+# Test 27 - Best price report
+FILE_PRO="$TEST_FILE_DIR""more_products.csv"
+FILE_QTE="$TEST_FILE_DIR""more_quotes.csv"
+FILE_BEST="$TEST_FILE_DIR""best_prices.csv"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+--best_price_report $FILE_BEST &> /dev/null
+print_success $? "(Best price report)"
+rm -f $FILE_BEST
+
+
+# Test 28 - Quote inside an unquoted field does not join the next line
+FILE_PRO="$TEST_FILE_DIR""inch_mark_products.csv"
+FILE_QTE="$TEST_FILE_DIR""inch_mark_quotes.csv"
+FILE_EXPORT="$TEST_FILE_DIR""export.json"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE \
+--export_json $FILE_EXPORT --export_format json &> /dev/null
+RETURN_VAL=$?
+grep -q '"code":"PHN06-3G3200M6I"' $FILE_EXPORT || RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Quote inside unquoted field)"
+rm -f $FILE_EXPORT
+
+
+# Test 29 - Bulk edit with a header row in product file column order
+FILE_PRO="$TEST_FILE_DIR""products_copy.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes.csv"
+FILE_BULK="$TEST_FILE_DIR""header_bulk_edit.csv"
+FILE_EXPECTED="$TEST_FILE_DIR""header_bulk_edit_expected.csv"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+cp "$TEST_FILE_DIR""products.csv" $FILE_PRO
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --bulk_edit_products $FILE_BULK \
+< $FILE_USER_INPUT &> /dev/null
+RETURN_VAL=$?
+cmp -s $FILE_PRO $FILE_EXPECTED || RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Bulk edit with header row)"
+rm -f $FILE_PRO
+
+
+# Test 30 - Price history round trip, lowest price of the latest snapshots
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_HIST="$TEST_FILE_DIR""price_history.bin"
+FILE_OUT="$TEST_FILE_DIR""lowest_price.out"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+rm -f $FILE_HIST
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes "$TEST_FILE_DIR""quotes.csv" \
+--history_file $FILE_HIST --history_add < $FILE_USER_INPUT &> /dev/null
+RETURN_VAL=$?
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes "$TEST_FILE_DIR""history_quotes.csv" \
+--history_file $FILE_HIST --history_add < $FILE_USER_INPUT &> /dev/null
+[ $? == $VALGRIND_ERR_CODE ] && RETURN_VAL=$VALGRIND_ERR_CODE
+FILE_USER_INPUT="$TEST_FILE_DIR""lowest_price_input"
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes "$TEST_FILE_DIR""quotes.csv" \
+--history_file $FILE_HIST < $FILE_USER_INPUT > $FILE_OUT 2> /dev/null
+[ $? == $VALGRIND_ERR_CODE ] && RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q "Price: 249.95" $FILE_OUT || RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q "Quote ID: sq-id0000" $FILE_OUT || RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q "Snapshot: 2 " $FILE_OUT || RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Price history and lowest price)"
+rm -f $FILE_HIST $FILE_OUT
+
+
+# Test 31 - Catalog updates between reads, data built for the first version
+# (quote groups) must not be seen after edits are published
+FILE_PRO="$TEST_FILE_DIR""products_copy.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes_copy.csv"
+FILE_METRICS="$TEST_FILE_DIR""metrics.prom"
+FILE_OUT="$TEST_FILE_DIR""catalog_update.out"
+FILE_USER_INPUT="$TEST_FILE_DIR""catalog_update_input"
+
+cp "$TEST_FILE_DIR""products.csv" $FILE_PRO
+cp "$TEST_FILE_DIR""quotes.csv" $FILE_QTE
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --metrics_file $FILE_METRICS \
+< $FILE_USER_INPUT > $FILE_OUT 2> /dev/null
+RETURN_VAL=$?
+grep -B 3 "Product code: oPhone8-2" $FILE_OUT | grep -q "RAM: *4000 MB" || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q "| PhoneHut *| *299.95 EUR |.*| sq-id0000" $FILE_OUT || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -qx "price_watch_catalog_version 3" $FILE_METRICS || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Catalog updates between reads)"
+rm -f $FILE_PRO $FILE_QTE $FILE_METRICS $FILE_OUT
+
+
+# Test 32 - Trace file is valid JSON with events of the run
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes.csv"
+FILE_TRACE="$TEST_FILE_DIR""trace.json"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --trace_file $FILE_TRACE \
+< $FILE_USER_INPUT &> /dev/null
+RETURN_VAL=$?
+python3 -m json.tool $FILE_TRACE &> /dev/null || RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q '"name":"load data","cat":"load","ph":"X"' $FILE_TRACE || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -q '"name":"display data","cat":"display","ph":"X"' $FILE_TRACE || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Trace file)"
+rm -f $FILE_TRACE
+
+
+# Test 33 - Metrics snapshot is written at exit
+FILE_PRO="$TEST_FILE_DIR""products.csv"
+FILE_QTE="$TEST_FILE_DIR""quotes.csv"
+FILE_METRICS="$TEST_FILE_DIR""metrics.prom"
+FILE_USER_INPUT="$TEST_FILE_DIR""print_all_data_user_input"
+
+rm -f $FILE_METRICS
+valgrind --error-exitcode=$VALGRIND_ERR_CODE ./"$BIN_DIR""$BIN_NAME" \
+--file_products $FILE_PRO --file_quotes $FILE_QTE --metrics_file $FILE_METRICS \
+< $FILE_USER_INPUT &> /dev/null
+RETURN_VAL=$?
+[ -f $FILE_METRICS ] && [ ! -e $FILE_METRICS.tmp ] || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -qx 'price_watch_rows_loaded_total{file="products"} 12' $FILE_METRICS || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -qx 'price_watch_rows_loaded_total{file="quotes"} 25' $FILE_METRICS || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+grep -qx "price_watch_catalog_version 1" $FILE_METRICS || \
+RETURN_VAL=$VALGRIND_ERR_CODE
+print_success $RETURN_VAL "(Metrics file)"
+rm -f $FILE_METRICS $FILE_METRICS.tmp